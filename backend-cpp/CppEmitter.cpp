@@ -1,10 +1,335 @@
 #include "CppEmitter.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <sstream>
 #include <unordered_set>
 #include <variant>
 
 namespace mana::backend {
 
+// Test harness appended to test binaries. Tests run in-process one after the
+// other; only #[should_panic] tests are forked, so the expected panic cannot
+// take the rest of the run down. Each test is bracketed by "@@mana-test"
+// marker lines on stdout, which the runner uses to attribute output and to
+// resume after a test crashes the process. #[bench] functions are measured by
+// the Bencher and reported on "@@mana-bench" lines.
+static const char* TEST_HARNESS = R"(
+// ---- mana test harness ----
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace mana_test {
+
+struct TestCase {
+    const char* name;
+    void (*fn)();
+    bool should_panic;
+};
+
+struct BenchCase {
+    const char* name;
+    void (*fn)();
+};
+
+struct Outcome {
+    bool panicked = false;
+    std::string message;
+};
+
+inline Outcome invoke(void (*fn)()) {
+    Outcome o;
+    try {
+        fn();
+    } catch (const std::exception& e) {
+        o.panicked = true;
+        o.message = e.what();
+    } catch (...) {
+        o.panicked = true;
+    }
+    if (o.panicked && o.message.empty()) o.message = "panicked";
+    return o;
+}
+
+inline void flush_all() {
+    std::cout.flush();
+    std::fflush(stdout);
+}
+
+// Runs a #[should_panic] test in a child process
+inline Outcome invoke_isolated(void (*fn)()) {
+#ifdef _WIN32
+    return invoke(fn);
+#else
+    flush_all();
+    pid_t pid = fork();
+    if (pid == 0) {
+        Outcome o = invoke(fn);
+        flush_all();
+        std::_Exit(o.panicked ? 101 : 0);
+    }
+    Outcome o;
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0) {
+        o.message = "cannot fork";
+        return o;
+    }
+    o.panicked = !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return o;
+#endif
+}
+
+inline std::atomic<long long> test_started_us{-1};
+inline std::atomic<const char*> test_running{nullptr};
+
+inline long long now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void start_watchdog(long long timeout_ms) {
+    std::thread([timeout_ms] {
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            long long started = test_started_us.load();
+            const char* name = test_running.load();
+            if (started >= 0 && name && now_us() - started > timeout_ms * 1000) {
+                std::printf("\n@@mana-test timeout %s\n", name);
+                std::fflush(stdout);
+                std::_Exit(124);
+            }
+        }
+    }).detach();
+}
+
+struct BenchStats {
+    double median_ns = 0, mean_ns = 0, stddev_ns = 0;
+    double ci_low_ns = 0, ci_high_ns = 0;  // 95% interval of the mean
+    unsigned long long iterations = 0;     // Per sample
+    size_t samples = 0, outliers = 0;
+};
+
+// Measures a routine. Warmup runs it in doubling batches, which also
+// estimates its cost; each of kSamples samples then runs enough iterations to
+// take measure_ms / kSamples. Samples outside the Tukey fences (1.5 IQR past
+// the quartiles) are dropped before the statistics are computed.
+class Bencher {
+public:
+    static constexpr size_t kSamples = 50;
+
+    Bencher(long long warmup_ms, long long measure_ms) : warmup_ms_(warmup_ms), measure_ms_(measure_ms) {}
+
+    template <typename F>
+    void iter(F&& routine) {
+        using clock = std::chrono::steady_clock;
+        auto ns_since = [](clock::time_point t) {
+            return std::chrono::duration<double, std::nano>(clock::now() - t).count();
+        };
+
+        unsigned long long batch = 1;
+        double per_iter_ns = 0;
+        auto warm_start = clock::now();
+        do {
+            auto t0 = clock::now();
+            for (unsigned long long n = 0; n < batch; ++n) routine();
+            double ns = ns_since(t0);
+            per_iter_ns = ns / static_cast<double>(batch);
+            if (ns * 2 < warmup_ms_ * 1e6) batch *= 2;
+        } while (ns_since(warm_start) < warmup_ms_ * 1e6);
+
+        double sample_ns = measure_ms_ * 1e6 / kSamples;
+        stats_ = BenchStats();
+        stats_.iterations = static_cast<unsigned long long>(std::max(1.0, sample_ns / std::max(per_iter_ns, 0.1)));
+
+        std::vector<double> samples;
+        samples.reserve(kSamples);
+        for (size_t s = 0; s < kSamples; ++s) {
+            auto t0 = clock::now();
+            for (unsigned long long n = 0; n < stats_.iterations; ++n) routine();
+            samples.push_back(ns_since(t0) / static_cast<double>(stats_.iterations));
+        }
+        summarize(samples);
+    }
+
+    const BenchStats& stats() const { return stats_; }
+
+private:
+    static double quantile(const std::vector<double>& sorted, double q) {
+        double pos = q * static_cast<double>(sorted.size() - 1);
+        size_t lo = static_cast<size_t>(pos);
+        size_t hi = std::min(lo + 1, sorted.size() - 1);
+        return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - static_cast<double>(lo));
+    }
+
+    void summarize(std::vector<double> samples) {
+        std::sort(samples.begin(), samples.end());
+        double q1 = quantile(samples, 0.25), q3 = quantile(samples, 0.75);
+        double lo = q1 - 1.5 * (q3 - q1), hi = q3 + 1.5 * (q3 - q1);
+        std::vector<double> kept;
+        for (double v : samples) {
+            if (v >= lo && v <= hi) kept.push_back(v);
+        }
+        stats_.samples = kept.size();
+        stats_.outliers = samples.size() - kept.size();
+
+        double sum = 0;
+        for (double v : kept) sum += v;
+        stats_.mean_ns = sum / static_cast<double>(kept.size());
+        double var = 0;
+        for (double v : kept) var += (v - stats_.mean_ns) * (v - stats_.mean_ns);
+        stats_.stddev_ns = kept.size() > 1 ? std::sqrt(var / static_cast<double>(kept.size() - 1)) : 0.0;
+        stats_.median_ns = quantile(kept, 0.5);
+        // Normal approximation; kSamples is large enough for it
+        double half = 1.96 * stats_.stddev_ns / std::sqrt(static_cast<double>(kept.size()));
+        stats_.ci_low_ns = stats_.mean_ns - half;
+        stats_.ci_high_ns = stats_.mean_ns + half;
+    }
+
+    double warmup_ms_;
+    double measure_ms_;
+    BenchStats stats_;
+};
+
+inline Outcome invoke_bench(Bencher& b, void (*fn)()) {
+    Outcome o;
+    try {
+        b.iter(fn);
+    } catch (const std::exception& e) {
+        o.panicked = true;
+        o.message = e.what();
+    } catch (...) {
+        o.panicked = true;
+        o.message = "panicked";
+    }
+    return o;
+}
+
+inline int run_benches(const std::vector<const BenchCase*>& selected, long long warmup_ms, long long measure_ms) {
+    int failed = 0;
+    for (const BenchCase* bench : selected) {
+        Bencher b(warmup_ms, measure_ms);
+        Outcome o = invoke_bench(b, bench->fn);
+        flush_all();
+        if (o.panicked) {
+            std::cout << "\n@@mana-bench fail " << bench->name << " panicked: " << o.message << "\n";
+            failed++;
+        } else {
+            const BenchStats& st = b.stats();
+            std::printf("\n@@mana-bench ok %s %.3f %.3f %.3f %.3f %.3f %llu %zu %zu\n", bench->name,
+                        st.median_ns, st.mean_ns, st.stddev_ns, st.ci_low_ns, st.ci_high_ns,
+                        st.iterations, st.samples, st.outliers);
+        }
+        flush_all();
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+inline int run(const TestCase* tests, size_t count, const BenchCase* benches, size_t bench_count,
+               int argc, char** argv) {
+    std::vector<const TestCase*> selected;
+    std::vector<const BenchCase*> selected_benches;
+    bool list = false;
+    bool list_benches = false;
+    long long timeout_ms = 0;
+    long long warmup_ms = 200;
+    long long measure_ms = 1000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--list") {
+            list = true;
+        } else if (arg == "--list-benches") {
+            list_benches = true;
+        } else if (arg == "--bench-all") {
+            for (size_t b = 0; b < bench_count; ++b) selected_benches.push_back(&benches[b]);
+        } else if (arg == "--bench" && i + 1 < argc) {
+            std::string name = argv[++i];
+            size_t b = 0;
+            while (b < bench_count && name != benches[b].name) ++b;
+            if (b == bench_count) {
+                std::cerr << "unknown benchmark: " << name << "\n";
+                return 2;
+            }
+            selected_benches.push_back(&benches[b]);
+        } else if (arg == "--warmup-ms" && i + 1 < argc) {
+            warmup_ms = std::atoll(argv[++i]);
+        } else if (arg == "--measure-ms" && i + 1 < argc) {
+            measure_ms = std::atoll(argv[++i]);
+        } else if (arg == "--run-all") {
+            for (size_t t = 0; t < count; ++t) selected.push_back(&tests[t]);
+        } else if (arg == "--run" && i + 1 < argc) {
+            std::string name = argv[++i];
+            size_t t = 0;
+            while (t < count && name != tests[t].name) ++t;
+            if (t == count) {
+                std::cerr << "unknown test: " << name << "\n";
+                return 2;
+            }
+            selected.push_back(&tests[t]);
+        } else if (arg == "--timeout-ms" && i + 1 < argc) {
+            timeout_ms = std::atoll(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " --list | --run-all | --run <test>... [--timeout-ms <n>]\n";
+            std::cerr << "       " << argv[0] << " --list-benches | --bench-all | --bench <name>..."
+                      << " [--warmup-ms <n>] [--measure-ms <n>]\n";
+            return 2;
+        }
+    }
+
+    if (list || list_benches) {
+        for (size_t t = 0; list && t < count; ++t) {
+            std::cout << tests[t].name << (tests[t].should_panic ? " should_panic" : "") << "\n";
+        }
+        for (size_t b = 0; list_benches && b < bench_count; ++b) {
+            std::cout << benches[b].name << "\n";
+        }
+        return 0;
+    }
+    if (!selected_benches.empty()) return run_benches(selected_benches, warmup_ms, measure_ms);
+
+    if (timeout_ms > 0) start_watchdog(timeout_ms);
+
+    int failed = 0;
+    for (const TestCase* test : selected) {
+        std::cout << "@@mana-test start " << test->name << "\n";
+        flush_all();
+        test_running = test->name;
+        long long start = now_us();
+        test_started_us = start;
+
+        Outcome o = test->should_panic ? invoke_isolated(test->fn) : invoke(test->fn);
+        bool ok = test->should_panic ? o.panicked : !o.panicked;
+        std::string message = test->should_panic ? "Expected panic but test passed" : "panicked: " + o.message;
+
+        test_started_us = -1;
+        long long elapsed = now_us() - start;
+        flush_all();
+        if (ok) {
+            std::cout << "\n@@mana-test ok " << test->name << " " << elapsed << "\n";
+        } else {
+            for (char& c : message) {
+                if (c == '\n' || c == '\r') c = ' ';
+            }
+            std::cout << "\n@@mana-test fail " << test->name << " " << elapsed << " " << message << "\n";
+            failed++;
+        }
+        flush_all();
+    }
+    return failed > 0 ? 1 : 0;
+}
+
+} // namespace mana_test
+)";
+
 using namespace mana::frontend;
 
 static int match_counter = 0;
@@ -12,8 +337,32 @@ static int try_counter = 0;
 static int destructure_counter = 0;
 static int while_let_counter = 0;
 
+// Value types implemented by mana_runtime.h that Mana code names directly
+static const std::unordered_set<std::string> runtime_types = {
+    "Rng", "Vec2", "Vec3", "Vec4", "Mat4", "Quat", "Arena", "ArenaString", "AllocStats"
+};
+
+// Struct, enum, trait and alias names declared by the module being emitted;
+// a user type shadows the runtime type of the same name
+static std::unordered_set<std::string> user_type_names;
+
+static bool is_runtime_type(const std::string& name) {
+    return runtime_types.count(name) && !user_type_names.count(name);
+}
+
+// Math free functions in mana_runtime.h (unless shadowed by a user fn)
+static const std::unordered_set<std::string> runtime_math_functions = {
+    "dot", "cross", "distance", "lerp", "reflect", "refract", "slerp",
+    "translate", "scale", "rotate_x", "rotate_y", "rotate_z", "rotate",
+    "perspective", "ortho", "look_at",
+    "transform_points", "transform_directions", "transform_vec4s",
+    // Batch kernels over Vec<f32> and slices
+    "sin_all", "cos_all", "exp_all", "log_all", "axpy", "sum", "min_all", "max_all"
+};
+
 static std::string map_type(const std::string& mana_type) {
     if (mana_type.empty() || mana_type == "void") return "void";
+    if (is_runtime_type(mana_type)) return "mana::" + mana_type;
     if (mana_type == "i32") return "int32_t";
     if (mana_type == "int") return "int64_t";  // int alias (vNext) -> i64
     if (mana_type == "i64") return "int64_t";
@@ -51,7 +400,8 @@ static std::string map_type(const std::string& mana_type) {
             if (i > 0) mapped_inner += ", ";
             mapped_inner += map_type(params[i]);
         }
-        if (base == "Result" || base == "Option" || base == "Vec" || base == "HashMap") {
+        if (base == "Result" || base == "Option" || base == "Vec" || base == "HashMap" ||
+            (base == "ArenaVec" && !user_type_names.count(base))) {
             return "mana::" + base + "<" + mapped_inner + ">";
         }
         return base + "<" + mapped_inner + ">";
@@ -123,6 +473,30 @@ static std::string map_type(const std::string& mana_type) {
     return mana_type;
 }
 
+std::string CppEmitter::cpp_type(const std::string& mana_type) {
+    return map_type(mana_type);
+}
+
+bool CppEmitter::is_local(const std::string& name) const {
+    for (const auto& scope : locals_) {
+        if (std::find(scope.begin(), scope.end(), name) != scope.end()) return true;
+    }
+    return false;
+}
+
+void CppEmitter::set_user_types(const AstModule* m) {
+    user_type_names.clear();
+    for (const auto& decl : m->decls) {
+        switch (decl->kind) {
+            case NodeKind::StructDecl: user_type_names.insert(static_cast<const AstStructDecl*>(decl.get())->name); break;
+            case NodeKind::EnumDecl: user_type_names.insert(static_cast<const AstEnumDecl*>(decl.get())->name); break;
+            case NodeKind::TraitDecl: user_type_names.insert(static_cast<const AstTraitDecl*>(decl.get())->name); break;
+            case NodeKind::TypeAliasDecl: user_type_names.insert(static_cast<const AstTypeAliasDecl*>(decl.get())->alias_name); break;
+            default: break;
+        }
+    }
+}
+
 static std::string escape_cpp_string(const std::string& s) {
     std::string result;
     for (char c : s) {
@@ -214,6 +588,18 @@ void CppEmitter::emit_expr(const AstExpr* e, std::ostream& out) {
                         break;
                     }
                 }
+                // Runtime value types: Rng::new(seed) -> mana::Rng(seed)
+                if (is_runtime_type(type_name)) {
+                    out << "mana::" << type_name;
+                    if (method != "new") out << "::" << method;
+                    out << "(";
+                    for (size_t i = 0; i < call->args.size(); ++i) {
+                        if (i > 0) out << ", ";
+                        emit_expr(static_cast<const AstExpr*>(call->args[i].get()), out);
+                    }
+                    out << ")";
+                    break;
+                }
                 // Check if this is an ADT enum variant constructor (e.g., Shape::Circle)
                 if (adt_enums_.count(type_name)) {
                     // Emit as variant constructor: Shape::Circle(...)
@@ -256,6 +642,15 @@ void CppEmitter::emit_expr(const AstExpr* e, std::ostream& out) {
             else if (fname == "sleep_ms") fname = "mana::sleep_ms";
             // Random functions
             else if (fname == "random_int") fname = "mana::random_int";
+            else if (fname == "random_float") fname = "mana::random_float";
+            else if (fname == "random_range") fname = "mana::random_range";
+            else if (fname == "seed_random") fname = "mana::seed_random";
+            else if (fname == "fill_random") fname = "mana::fill_random";
+            else if (fname == "alloc_stats") fname = "mana::alloc_stats";
+            else if (fname == "black_box") fname = "mana::black_box";
+            // Vector math and batch kernels: Vec3(x, y, z), dot(a, b), sin_all(xs)
+            else if (is_runtime_type(fname)) fname = "mana::" + fname;
+            else if (runtime_math_functions.count(fname) && !user_functions_.count(fname) && !is_local(fname)) fname = "mana::" + fname;
             // Path functions
             else if (fname == "path_join") fname = "mana::path_join";
             else if (fname == "path_parent") fname = "mana::path_parent";
@@ -475,6 +870,9 @@ void CppEmitter::emit_expr(const AstExpr* e, std::ostream& out) {
                         if (is_adt) {
                             // ADT enum - use tag comparison and data extraction
                             out << "        if (__match_value_" << mcnt << ".tag == " << enumPat->enum_name << "Tag::" << enumPat->variant_name << ") {\n";
+                            push_locals();
+                            for (const auto& b : enumPat->bindings) declare_local(b);
+                            for (const auto& fb : enumPat->field_bindings) declare_local(fb.second);
                             // Extract and bind data if pattern has bindings
                             if (!enumPat->bindings.empty()) {
                                 out << "            auto __data_" << mcnt << " = std::get<" << enumPat->enum_name << "_" << enumPat->variant_name << ">(__match_value_" << mcnt << ".data);\n";
@@ -500,6 +898,7 @@ void CppEmitter::emit_expr(const AstExpr* e, std::ostream& out) {
                             emit_expr(arm.result.get(), out);
                             out << ";\n";
                             out << "        }\n";
+                            pop_locals();
                         } else {
                             // Simple enum - use direct value comparison
                             out << "        if (__match_value_" << mcnt << " == " << enumPat->enum_name << "::" << enumPat->variant_name << ") ";
@@ -579,6 +978,8 @@ void CppEmitter::emit_expr(const AstExpr* e, std::ostream& out) {
             if (!cl->return_type.empty()) {
                 out << " -> " << map_type(cl->return_type);
             }
+            push_locals();
+            for (const auto& param : cl->params) declare_local(param.name);
             if (cl->has_block()) {
                 out << " {\n";
                 for (const auto& stmt : cl->body_block->statements) {
@@ -590,6 +991,7 @@ void CppEmitter::emit_expr(const AstExpr* e, std::ostream& out) {
                 emit_expr(cl->body_expr.get(), out);
                 out << "; }";
             }
+            pop_locals();
             break;
         }
         case NodeKind::TryExpr: {
@@ -718,6 +1120,7 @@ void CppEmitter::emit_expr(const AstExpr* e, std::ostream& out) {
             // Use is_ok()/unwrap() for Result, is_some()/unwrap() for Option
             out << "        if (__or_" << ocnt << ".is_ok()) return __or_" << ocnt << ".unwrap();\n";
             // Emit fallback
+            push_locals();
             if (oe->has_block()) {
                 for (const auto& stmt : oe->fallback_block->statements) {
                     emit_stmt(stmt.get(), out, 2);
@@ -730,6 +1133,7 @@ void CppEmitter::emit_expr(const AstExpr* e, std::ostream& out) {
                 emit_expr(oe->default_expr.get(), out);
                 out << ";\n";
             }
+            pop_locals();
             out << "    }()";
             break;
         }
@@ -797,13 +1201,19 @@ void CppEmitter::extract_try_exprs(const AstExpr* e, std::ostream& out, int ind)
 
 void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
     if (!s) return;
+    if (lines_ && s->kind != NodeKind::BlockStmt) {
+        map_line(s, out);
+        emit_breakpoints(s, out);
+    }
     switch (s->kind) {
         case NodeKind::BlockStmt: {
             auto blk = static_cast<const AstBlockStmt*>(s);
             out << "{\n";
+            push_locals();
             for (const auto& stmt : blk->statements) {
                 emit_stmt(stmt.get(), out, ind + 1);
             }
+            pop_locals();
             indent(out, ind);
             out << "}";
             break;
@@ -827,7 +1237,21 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
                         out << "__ds_" << dcnt << "[" << i << "]";
                     }
                     out << ";\n";
+                    declare_local(ds->bindings[i].name);
                 }
+            } else if (incremental_ && incremental_->session_lets.count(vd)) {
+                // The initializer still sees any earlier binding of the name
+                std::string global = incremental_->session_prefix + vd->name;
+                if (vd->init_expr) {
+                    extract_try_exprs(static_cast<const AstExpr*>(vd->init_expr.get()), out, ind);
+                    indent(out, ind);
+                    out << global << " = ";
+                    emit_expr(static_cast<const AstExpr*>(vd->init_expr.get()), out);
+                    out << ";\n";
+                }
+                indent(out, ind);
+                out << "auto& " << vd->name << " = " << global << ";\n";
+                declare_local(vd->name);
             } else {
                 if (vd->init_expr) {
                     extract_try_exprs(static_cast<const AstExpr*>(vd->init_expr.get()), out, ind);
@@ -844,6 +1268,8 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
                     emit_expr(static_cast<const AstExpr*>(vd->init_expr.get()), out);
                 }
                 out << ";\n";
+                // Declared after its initializer, which still sees any outer binding
+                declare_local(vd->name);
             }
             break;
         }
@@ -856,6 +1282,18 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
             } else {
                 out << as->target_name;
             }
+            // `x += y` is parsed as `x = x + y`; emit it as an in-place update
+            // so appending to a string does not copy it
+            if (auto bin = dynamic_cast<const AstBinaryExpr*>(as->value.get());
+                bin && bin->op == "+" && !as->is_complex_target() && !as->is_compound()) {
+                auto lhs = dynamic_cast<const AstIdentifierExpr*>(bin->left.get());
+                if (lhs && lhs->name == as->target_name) {
+                    out << " += ";
+                    emit_expr(static_cast<const AstExpr*>(bin->right.get()), out);
+                    out << ";\n";
+                    break;
+                }
+            }
             out << " " << as->op << " ";
             emit_expr(static_cast<const AstExpr*>(as->value.get()), out);
             out << ";\n";
@@ -873,16 +1311,19 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
                 out << "if (";
                 emit_expr(static_cast<const AstExpr*>(ifs->pattern_expr.get()), out);
                 out << "." << check_method << ") {\n";
+                push_locals();
                 if (!ifs->pattern_var.empty() && !unwrap_method.empty()) {
                     indent(out, ind + 1);
                     out << "auto " << ifs->pattern_var << " = ";
                     emit_expr(static_cast<const AstExpr*>(ifs->pattern_expr.get()), out);
                     out << "." << unwrap_method << ";\n";
+                    declare_local(ifs->pattern_var);
                 }
                 auto blk = static_cast<const AstBlockStmt*>(ifs->then_block.get());
                 for (const auto& stmt : blk->statements) {
                     emit_stmt(stmt.get(), out, ind + 1);
                 }
+                pop_locals();
                 indent(out, ind);
                 out << "}";
             } else {
@@ -914,14 +1355,17 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
                 out << ";\n";
                 indent(out, ind + 1);
                 out << "if (!__wl_" << wcnt << "." << check_method << ") break;\n";
+                push_locals();
                 if (!ws->pattern_var.empty()) {
                     indent(out, ind + 1);
                     out << "auto " << ws->pattern_var << " = __wl_" << wcnt << "." << unwrap_method << ";\n";
+                    declare_local(ws->pattern_var);
                 }
                 auto blk = static_cast<const AstBlockStmt*>(ws->body.get());
                 for (const auto& stmt : blk->statements) {
                     emit_stmt(stmt.get(), out, ind + 1);
                 }
+                pop_locals();
                 indent(out, ind);
                 out << "}\n";
             } else {
@@ -958,7 +1402,14 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
                 emit_expr(static_cast<const AstExpr*>(fin->iterable.get()), out);
                 out << ") ";
             }
+            push_locals();
+            if (fin->is_destructure) {
+                for (const auto& name : fin->var_names) declare_local(name);
+            } else {
+                declare_local(fin->var_name);
+            }
             emit_stmt(fin->body.get(), out, ind);
+            pop_locals();
             out << "\n";
             break;
         }
@@ -966,6 +1417,7 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
             auto fs = static_cast<const AstForStmt*>(s);
             indent(out, ind);
             out << "for (";
+            push_locals();
             if (fs->init) {
                 if (auto vd = dynamic_cast<const AstVarDeclStmt*>(fs->init.get())) {
                     if (!vd->type_name.empty()) out << map_type(vd->type_name) << " ";
@@ -975,6 +1427,7 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
                         out << " = ";
                         emit_expr(static_cast<const AstExpr*>(vd->init_expr.get()), out);
                     }
+                    declare_local(vd->name);
                 }
             }
             out << "; ";
@@ -990,6 +1443,7 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
             }
             out << ") ";
             emit_stmt(fs->body.get(), out, ind);
+            pop_locals();
             out << "\n";
             break;
         }
@@ -1037,18 +1491,26 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
             auto ss = static_cast<const AstScopeStmt*>(s);
             indent(out, ind);
             out << "{\n";
+            if (ss->is_region) {
+                // Region: every arena allocation in the block is released by ~Arena
+                indent(out, ind + 1);
+                out << "mana::Arena " << ss->name << ";\n";
+            }
             if (!ss->name.empty() && ss->init_expr) {
                 indent(out, ind + 1);
                 out << "auto " << ss->name << " = ";
                 emit_expr(static_cast<const AstExpr*>(ss->init_expr.get()), out);
                 out << ";\n";
             }
+            push_locals();
+            if (!ss->name.empty()) declare_local(ss->name);
             if (ss->body) {
                 auto blk = static_cast<const AstBlockStmt*>(ss->body.get());
                 for (const auto& stmt : blk->statements) {
                     emit_stmt(stmt.get(), out, ind + 1);
                 }
             }
+            pop_locals();
             indent(out, ind);
             out << "}\n";
             break;
@@ -1089,16 +1551,228 @@ void CppEmitter::emit_stmt(const AstStmt* s, std::ostream& out, int ind) {
     }
 }
 
+// Passes output through to the real stream, counting lines so that mapped
+// statements know which generated line they start on
+struct CppEmitter::OutputLines : std::streambuf {
+    OutputLines(std::streambuf* target, int first_line) : target(target), line(first_line) {}
+
+    std::streambuf* target;
+    int line;                   // Line being written, 1-based
+    bool at_line_start = true;
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+        char c = traits_type::to_char_type(ch);
+        return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (n <= 0) return 0;
+        line += static_cast<int>(std::count(s, s + n, '\n'));
+        at_line_start = s[n - 1] == '\n';
+        return target->sputn(s, n);
+    }
+
+    int sync() override { return target->pubsync(); }
+};
+
+void CppEmitter::set_source_map(SourceMap* map, const std::string& mana_file, const std::string& cpp_file,
+                                int first_line) {
+    source_map_ = map;
+    mana_file_ = mana_file;
+    cpp_file_ = cpp_file;
+    first_line_ = first_line;
+    if (map) map->cpp_file = cpp_file;
+}
+
+static std::string line_directive(int line, const std::string& file) {
+    std::string out = "#line " + std::to_string(line) + " \"";
+    for (char c : file) {
+        if (c == '\\' || c == '"') out += '\\';
+        out += c;
+    }
+    return out + "\"\n";
+}
+
+void CppEmitter::enter_decl(const AstDecl* d, const std::string& function) {
+    if (!lines_) return;
+    map_file_ = source_map_->add_file(d->source_file.empty() ? mana_file_ : d->source_file);
+    map_function_ = source_map_->add_function(function);
+}
+
+void CppEmitter::map_line(const AstNode* n, std::ostream& out) {
+    if (!lines_ || n->line <= 0) return;
+    // The compiler (and so the debug info) sees the statement at its Mana
+    // line. Straight-line code keeps the numbering of the directive before.
+    if (lines_->at_line_start &&
+        (!line_remapped_ || map_directive_file_ != map_file_ || lines_->line + map_line_delta_ != n->line)) {
+        out << line_directive(n->line, source_map_->files()[map_file_]);
+        line_remapped_ = true;
+        map_directive_file_ = map_file_;
+        map_line_delta_ = n->line - lines_->line;
+    }
+    source_map_->add(static_cast<uint32_t>(lines_->line), map_file_, static_cast<uint32_t>(n->line),
+                     static_cast<uint32_t>(n->column), map_function_);
+}
+
+void CppEmitter::end_mapped(std::ostream& out) {
+    if (!lines_) return;
+    source_map_->add_unmapped(static_cast<uint32_t>(lines_->line));
+    if (line_remapped_ && lines_->at_line_start) {
+        out << line_directive(lines_->line + 1, cpp_file_);
+        line_remapped_ = false;
+    }
+    map_function_ = 0;
+    break_pending_line_ = 0;
+}
+
+bool CppEmitter::parse_hit_condition(const std::string& text, HitOp& op, uint64_t& count) {
+    static const std::pair<const char*, HitOp> ops[] = {
+        {">=", HitOp::Ge}, {"<=", HitOp::Le}, {"==", HitOp::Eq},
+        {">", HitOp::Gt}, {"<", HitOp::Lt}, {"%", HitOp::Mod}, {"=", HitOp::Eq},
+    };
+    size_t i = text.find_first_not_of(" \t");
+    if (i == std::string::npos) {
+        op = HitOp::None;
+        count = 0;
+        return true;
+    }
+    op = HitOp::Ge;
+    for (const auto& [spelling, kind] : ops) {
+        size_t n = std::strlen(spelling);
+        if (text.compare(i, n, spelling) == 0) {
+            op = kind;
+            i += n;
+            break;
+        }
+    }
+    i = text.find_first_not_of(" \t", i);
+    if (i == std::string::npos) return false;
+    const char* end = text.data() + text.size();
+    auto [rest, ec] = std::from_chars(text.data() + i, end, count);
+    if (ec != std::errc() || rest == text.data() + i) return false;
+    for (; rest != end; ++rest) {
+        if (*rest != ' ' && *rest != '\t') return false;
+    }
+    return op != HitOp::Mod || count > 0;
+}
+
+void CppEmitter::bind_breakpoints(const AstModule* m) {
+    // The debugger binds against the map of the finished program; checks
+    // never add lines, so a pass without them produces the same map
+    SourceMap probe;
+    SourceMap* target = source_map_;
+    source_map_ = &probe;
+    breakpoints_by_line_.clear();
+    std::ostringstream discard;
+    emit_mapped(m, discard);
+    probe.finish();
+    source_map_ = target;
+
+    for (auto& bp : breakpoints_) {
+        int file = probe.file_index(bp.file);
+        auto found = file < 0 ? std::vector<const SourceMapEntry*>()
+                              : probe.find_original(static_cast<uint16_t>(file), static_cast<uint32_t>(bp.line));
+        bp.line = found.empty() ? 0 : static_cast<int>(found.front()->line);
+        if (bp.line > 0) breakpoints_by_line_[bp.line].push_back(&bp);
+    }
+}
+
+void CppEmitter::enter_breakpoint_scope(const AstNode* header) {
+    break_pending_line_ = header->line;
+    last_break_line_ = 0;
+}
+
+void CppEmitter::emit_breakpoints(const AstNode* n, std::ostream& out) {
+    // Checks go in front of the statement on its own line, so that they
+    // stay in statement context and leave the line numbering alone
+    if (breakpoints_by_line_.empty() || !lines_->at_line_start || n->line <= 0) return;
+    int lines[2] = {break_pending_line_, n->line};
+    break_pending_line_ = 0;
+    // Once per line: statements nested on it share the check
+    if (map_file_ == last_break_file_ && n->line == last_break_line_) lines[1] = 0;
+    if (lines[0] == lines[1]) lines[0] = 0;
+    last_break_file_ = map_file_;
+    last_break_line_ = n->line;
+
+    const std::string& file = source_map_->files()[map_file_];
+    for (int line : lines) {
+        auto it = line > 0 ? breakpoints_by_line_.find(line) : breakpoints_by_line_.end();
+        if (it == breakpoints_by_line_.end()) continue;
+        for (const Breakpoint* bp : it->second) {
+            if (bp->file != file) continue;
+            std::string check = "::mana::debug::brk(" + std::to_string(bp->id) + ");";
+            if (bp->hit_op != HitOp::None) {
+                static const char* const tests[] = {"", " >= ", " > ", " == ", " <= ", " < ", " % "};
+                std::string test = "++mana_bp_hits" + std::string(tests[static_cast<int>(bp->hit_op)]) +
+                                   std::to_string(bp->hit_count);
+                if (bp->hit_op == HitOp::Mod) test += " == 0";
+                check = "{ static uint64_t mana_bp_hits = 0; if (" + test + ") " + check + " }";
+            }
+            if (bp->condition) {
+                std::ostringstream cond;
+                emit_expr(bp->condition, cond);
+                std::string text = cond.str();
+                std::replace(text.begin(), text.end(), '\n', ' ');
+                check = "if (" + text + ") " + check;
+            }
+            out << check << " ";
+        }
+    }
+}
+
 void CppEmitter::emit(const AstModule* m, std::ostream& out, bool test_mode) {
     test_mode_ = test_mode;
+    if (!source_map_) {
+        emit_module(m, out);
+        return;
+    }
+    if (!breakpoints_.empty()) bind_breakpoints(m);
+    emit_mapped(m, out);
+}
+
+void CppEmitter::emit_mapped(const AstModule* m, std::ostream& out) {
+    OutputLines lines(out.rdbuf(), first_line_);
+    std::ostream counted(&lines);
+    lines_ = &lines;
+    line_remapped_ = false;
+    break_pending_line_ = 0;
+    last_break_line_ = 0;
+    map_file_ = source_map_->add_file(mana_file_);
+    emit_module(m, counted);
+    end_mapped(counted);
+    lines_ = nullptr;
+}
+
+void CppEmitter::emit_module(const AstModule* m, std::ostream& out) {
     match_counter = 0;
     try_counter = 0;
     destructure_counter = 0;
     while_let_counter = 0;
 
+    set_user_types(m);
+
     // Pre-pass: register all impl methods for method call resolution
     impl_methods_.clear();  // Clear for fresh compile
+    user_functions_.clear();
+    test_functions_.clear();
+    bench_functions_.clear();
     for (const auto& decl : m->decls) {
+        if (decl->kind == NodeKind::FunctionDecl) {
+            auto fd = static_cast<const AstFuncDecl*>(decl.get());
+            user_functions_.insert(fd->name);
+            if (fd->is_test && !fd->is_method() && !fd->is_generic() && fd->params.empty()) {
+                test_functions_.push_back(fd);
+            }
+            if (fd->is_bench && !fd->is_method() && !fd->is_generic() && fd->params.empty()) {
+                bench_functions_.push_back(fd);
+            }
+        }
+        if (decl->kind == NodeKind::GlobalVarDecl) {
+            auto gv = static_cast<const AstGlobalVarDecl*>(decl.get());
+            if (gv->var) user_functions_.insert(gv->var->name);
+        }
         if (decl->kind == NodeKind::ImplDecl) {
             auto impl = static_cast<const AstImplDecl*>(decl.get());
             for (const auto& method : impl->methods) {
@@ -1374,12 +2048,23 @@ void CppEmitter::emit(const AstModule* m, std::ostream& out, bool test_mode) {
     }
     out << "\n";
 
+    if (incremental_ && !incremental_->globals.empty()) {
+        out << incremental_->globals << "\n";
+    }
+
     // Emit function implementations
     for (const auto& decl : m->decls) {
         if (decl->kind == NodeKind::FunctionDecl) {
             auto fd = static_cast<const AstFuncDecl*>(decl.get());
             // Skip extern functions - they have no body (provided by headers/libraries)
             if (fd->is_extern) continue;
+            // Compiled by an earlier incremental unit; declared above
+            if (is_external(fd) && !fd->is_generic()) continue;
+            // Test binaries get the harness entry point instead of the program's main
+            if (test_mode_ && fd->name == "main" && !fd->is_method()) continue;
+            enter_decl(fd, fd->is_method() ? fd->receiver_type + "." + fd->name : fd->name);
+            map_line(fd, out);
+            enter_breakpoint_scope(fd);
             if (fd->is_generic()) {
                 out << "template<";
                 for (size_t i = 0; i < fd->type_params.size(); ++i) {
@@ -1412,6 +2097,8 @@ void CppEmitter::emit(const AstModule* m, std::ostream& out, bool test_mode) {
                 }
             }
             out << ") {\n";
+            push_locals();
+            for (const auto& param : fd->params) declare_local(param.name);
             if (fd->is_async) {
                 // Wrap body in std::async
                 out << "    return std::async(std::launch::async, [&]() {\n";
@@ -1440,10 +2127,18 @@ void CppEmitter::emit(const AstModule* m, std::ostream& out, bool test_mode) {
                     }
                 }
             }
+            pop_locals();
             out << "}\n\n";
+            end_mapped(out);
         } else if (decl->kind == NodeKind::ImplDecl) {
             auto impl = static_cast<const AstImplDecl*>(decl.get());
+            bool declare_only = is_external(impl);
             for (const auto& method : impl->methods) {
+                if (!declare_only) {
+                    enter_decl(impl, impl->type_name + "." + method->name);
+                    map_line(method.get(), out);
+                    enter_breakpoint_scope(method.get());
+                }
                 if (method->return_type.empty()) out << "void ";
                 else out << map_type(method->return_type) << " ";
                 out << impl->type_name << "_" << method->name << "(";
@@ -1462,17 +2157,28 @@ void CppEmitter::emit(const AstModule* m, std::ostream& out, bool test_mode) {
                         emit_expr(method->params[i].default_value.get(), out);
                     }
                 }
+                if (declare_only) {
+                    out << ");\n\n";
+                    continue;
+                }
                 out << ") {\n";
+                push_locals();
+                for (const auto& param : method->params) declare_local(param.name);
                 if (method->body) {
                     for (const auto& stmt : method->body->statements) {
                         emit_stmt(stmt.get(), out, 1);
                     }
                 }
+                pop_locals();
                 out << "}\n\n";
+                end_mapped(out);
             }
         } else if (decl->kind == NodeKind::GlobalVarDecl) {
             auto gv = static_cast<const AstGlobalVarDecl*>(decl.get());
-            if (gv->var) {
+            if (gv->var && is_external(gv) && gv->var->is_mutable) {
+                // Defined by an earlier incremental unit
+                out << "extern " << map_type(gv->var->type_name) << " " << gv->var->name << ";\n";
+            } else if (gv->var) {
                 if (gv->var->is_mutable) out << map_type(gv->var->type_name) << " " << gv->var->name;
                 else out << "const " << map_type(gv->var->type_name) << " " << gv->var->name;
                 if (gv->var->init_expr) {
@@ -1483,6 +2189,30 @@ void CppEmitter::emit(const AstModule* m, std::ostream& out, bool test_mode) {
             }
         }
     }
+
+    if (test_mode_) emit_test_main(out);
+}
+
+// Entry point of a test binary: tables of every #[test] and #[bench] plus the
+// TEST_HARNESS, driven by mana test (--run) and mana bench (--bench)
+void CppEmitter::emit_test_main(std::ostream& out) {
+    out << TEST_HARNESS;
+    out << "\nstatic const mana_test::TestCase mana_tests[] = {\n";
+    for (const auto* fd : test_functions_) {
+        out << "    {\"" << fd->name << "\", " << fd->name << ", " << (fd->should_panic ? "true" : "false") << "},\n";
+    }
+    out << "    {nullptr, nullptr, false}\n";
+    out << "};\n\n";
+    out << "static const mana_test::BenchCase mana_benches[] = {\n";
+    for (const auto* fd : bench_functions_) {
+        out << "    {\"" << fd->name << "\", " << fd->name << "},\n";
+    }
+    out << "    {nullptr, nullptr}\n";
+    out << "};\n\n";
+    out << "int main(int argc, char** argv) {\n";
+    out << "    return mana_test::run(mana_tests, " << test_functions_.size() << ", mana_benches, "
+        << bench_functions_.size() << ", argc, argv);\n";
+    out << "}\n";
 }
 
 } // namespace mana::backend
@@ -6,6 +6,7 @@
 #include "../frontend/AstExpressions.h"
 #include "../frontend/AstStatements.h"
 #include "../frontend/AstDeclarations.h"
+#include "SourceMap.h"
 
 namespace mana::backend {
 
@@ -13,18 +14,105 @@ namespace mana::backend {
     public:
         void emit(const mana::frontend::AstModule* m, std::ostream& out, bool test_mode = false);
 
+        // Incremental builds (mana repl), where each snippet becomes its own
+        // shared object loaded into one process. Declarations in `external`
+        // were compiled by an earlier unit and only get a declaration here.
+        // Each `let` in `session_lets` stores into the session global
+        // `<session_prefix><name>` and then binds the name to it.
+        struct IncrementalUnit {
+            std::unordered_set<const mana::frontend::AstDecl*> external;
+            std::unordered_set<const mana::frontend::AstVarDeclStmt*> session_lets;
+            std::string session_prefix;
+            std::string globals;  // Emitted after the forward declarations
+        };
+        void set_incremental(const IncrementalUnit* unit) { incremental_ = unit; }
+
+        // Debug builds: records where each statement's C++ lines came from
+        // in `map` and emits `#line` directives naming `mana_file` (imported
+        // declarations name their own file). `cpp_file` is named where
+        // generated code resumes, and `first_line` is the line of the output
+        // file that emit() starts writing at.
+        void set_source_map(SourceMap* map, const std::string& mana_file, const std::string& cpp_file,
+                            int first_line = 1);
+
+        // Breakpoints compiled into a debug build for mana-debug. Each binds
+        // as the debugger binds it, to the first line at or after `line`
+        // with code, and becomes an inline check before that line's first
+        // statement: the condition, then the hit count, then a trap that
+        // names the breakpoint. Needs set_source_map().
+        enum class HitOp : uint8_t { None, Ge, Gt, Eq, Le, Lt, Mod };
+        struct Breakpoint {
+            int id = 0;
+            std::string file;  // As the source map names it
+            int line = 0;      // Bound line after emit(); 0 if no code follows
+            const mana::frontend::AstExpr* condition = nullptr;  // None: always
+            HitOp hit_op = HitOp::None;
+            uint64_t hit_count = 0;
+        };
+        void set_breakpoints(std::vector<Breakpoint> breakpoints) { breakpoints_ = std::move(breakpoints); }
+        const std::vector<Breakpoint>& breakpoints() const { return breakpoints_; }
+        // Binds them as emit() does, so their lines can be read before emitting
+        void bind_breakpoints(const mana::frontend::AstModule* m);
+        // DAP hit conditions: "N" (at least N hits), ">= N", "> N", "== N",
+        // "<= N", "< N" or "% N" (every Nth hit)
+        static bool parse_hit_condition(const std::string& text, HitOp& op, uint64_t& count);
+
+        // C++ spelling of a Mana type name. Runtime types (Vec3, Rng, ...) are
+        // spelled mana:: unless the module declares a type of the same name;
+        // emit() records the module's types, set_user_types() does it early.
+        static std::string cpp_type(const std::string& mana_type);
+        static void set_user_types(const mana::frontend::AstModule* m);
+
     private:
+        void emit_module(const mana::frontend::AstModule* m, std::ostream& out);
+        void emit_mapped(const mana::frontend::AstModule* m, std::ostream& out);
         void emit_stmt(const mana::frontend::AstStmt* s, std::ostream& out, int ind);
         void emit_expr(const mana::frontend::AstExpr* e, std::ostream& out);
         void emit_capture_list(const mana::frontend::AstClosureExpr* cl, std::ostream& out);
         void indent(std::ostream& out, int n);
+        void emit_test_main(std::ostream& out);
         void extract_try_exprs(const mana::frontend::AstExpr* e, std::ostream& out, int ind);
         std::unordered_map<const mana::frontend::AstTryExpr*, int> try_expr_ids_;
         std::unordered_map<std::string, const mana::frontend::AstStructDecl*> struct_types_;  // For default values
         std::unordered_set<std::string> adt_enums_;  // Enums with data variants (ADT)
         std::unordered_set<std::string> impl_methods_;  // TypeName_methodName for impl blocks
+        std::unordered_set<std::string> user_functions_;  // Top-level fns and globals (shadow runtime builtins)
+        // Names bound in the enclosing blocks of the body being emitted,
+        // innermost block last; these shadow runtime builtins too
+        std::vector<std::vector<std::string>> locals_;
+        void push_locals() { locals_.emplace_back(); }
+        void pop_locals() { locals_.pop_back(); }
+        void declare_local(const std::string& name) { if (!locals_.empty()) locals_.back().push_back(name); }
+        bool is_local(const std::string& name) const;
         bool test_mode_ = false;
-        std::vector<std::string> test_function_names_;
+        const IncrementalUnit* incremental_ = nullptr;
+        bool is_external(const mana::frontend::AstDecl* d) const { return incremental_ && incremental_->external.count(d); }
+        std::vector<const mana::frontend::AstFuncDecl*> test_functions_;  // #[test] fns, in source order
+        std::vector<const mana::frontend::AstFuncDecl*> bench_functions_;  // #[bench] fns
+
+        // Source mapping (set_source_map)
+        struct OutputLines;  // Counts the lines written through it
+        SourceMap* source_map_ = nullptr;
+        OutputLines* lines_ = nullptr;
+        std::string mana_file_;
+        std::string cpp_file_;
+        int first_line_ = 1;
+        uint16_t map_file_ = 0;       // File of the declaration being emitted
+        uint32_t map_function_ = 0;
+        bool line_remapped_ = false;  // A #line directive is in effect
+        uint16_t map_directive_file_ = 0;  // File it names
+        int map_line_delta_ = 0;           // Mana line minus generated line under it
+        void enter_decl(const mana::frontend::AstDecl* d, const std::string& function);
+        void map_line(const mana::frontend::AstNode* n, std::ostream& out);
+        void end_mapped(std::ostream& out);
+
+        std::vector<Breakpoint> breakpoints_;
+        std::unordered_map<int, std::vector<const Breakpoint*>> breakpoints_by_line_;
+        int break_pending_line_ = 0;  // Bound to a function header; checked at its first statement
+        uint16_t last_break_file_ = 0;
+        int last_break_line_ = 0;
+        void enter_breakpoint_scope(const mana::frontend::AstNode* header);
+        void emit_breakpoints(const mana::frontend::AstNode* n, std::ostream& out);
     };
 
 } // namespace mana::backend
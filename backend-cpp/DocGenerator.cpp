@@ -1,9 +1,33 @@
 #include "DocGenerator.h"
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
 
 namespace mana::backend {
 
     using namespace mana::frontend;
 
+    namespace {
+
+        // Documented declarations in page order: type aliases, structs,
+        // enums, traits, then functions
+        std::vector<const AstDecl*> ordered_decls(const AstModule& mod) {
+            std::vector<const AstDecl*> groups[5];
+            for (const auto& decl : mod.decls) {
+                const AstDecl* d = decl.get();
+                if (dynamic_cast<const AstTypeAliasDecl*>(d)) groups[0].push_back(d);
+                else if (dynamic_cast<const AstStructDecl*>(d)) groups[1].push_back(d);
+                else if (dynamic_cast<const AstEnumDecl*>(d)) groups[2].push_back(d);
+                else if (dynamic_cast<const AstTraitDecl*>(d)) groups[3].push_back(d);
+                else if (dynamic_cast<const AstFuncDecl*>(d)) groups[4].push_back(d);
+            }
+            std::vector<const AstDecl*> decls;
+            for (const auto& group : groups) decls.insert(decls.end(), group.begin(), group.end());
+            return decls;
+        }
+
+    } // namespace
+
     std::string DocGenerator::generate(const AstModule& mod) {
         out_.str("");
         out_.clear();
@@ -83,56 +107,7 @@ namespace mana::backend {
         if (fn.is_async) out_ << "`async` ";
         out_ << "`fn " << fn.name << "`\n\n";
 
-        // Signature
-        out_ << "```mana\n";
-        if (fn.is_pub) out_ << "pub ";
-        if (fn.is_async) out_ << "async ";
-        out_ << "fn ";
-        if (!fn.receiver_type.empty()) {
-            out_ << fn.receiver_type << ".";
-        }
-        out_ << fn.name;
-
-        // Type parameters
-        if (!fn.type_params.empty()) {
-            out_ << "<";
-            for (size_t i = 0; i < fn.type_params.size(); ++i) {
-                if (i > 0) out_ << ", ";
-                out_ << fn.type_params[i];
-            }
-            out_ << ">";
-        }
-
-        // Parameters
-        out_ << "(";
-        for (size_t i = 0; i < fn.params.size(); ++i) {
-            if (i > 0) out_ << ", ";
-            out_ << fn.params[i].name << ": " << fn.params[i].type_name;
-            if (fn.params[i].has_default()) {
-                out_ << " = ...";
-            }
-        }
-        out_ << ")";
-
-        // Return type
-        if (!fn.return_type.empty() && fn.return_type != "void") {
-            out_ << " -> " << fn.return_type;
-        }
-
-        // Where clause
-        if (!fn.constraints.empty()) {
-            out_ << "\n    where ";
-            for (size_t i = 0; i < fn.constraints.size(); ++i) {
-                if (i > 0) out_ << ", ";
-                out_ << fn.constraints[i].type_param << ": ";
-                for (size_t j = 0; j < fn.constraints[i].traits.size(); ++j) {
-                    if (j > 0) out_ << " + ";
-                    out_ << fn.constraints[i].traits[j];
-                }
-            }
-        }
-
-        out_ << "\n```\n\n";
+        out_ << "```mana\n" << signature(fn) << "\n```\n\n";
 
         // Documentation comment
         if (fn.has_doc()) {
@@ -164,27 +139,7 @@ namespace mana::backend {
         if (s.is_pub) out_ << "`pub` ";
         out_ << "`struct " << s.name << "`\n\n";
 
-        // Signature
-        out_ << "```mana\n";
-        if (s.is_pub) out_ << "pub ";
-        out_ << "struct " << s.name;
-
-        if (!s.type_params.empty()) {
-            out_ << "<";
-            for (size_t i = 0; i < s.type_params.size(); ++i) {
-                if (i > 0) out_ << ", ";
-                out_ << s.type_params[i];
-            }
-            out_ << ">";
-        }
-
-        out_ << " {\n";
-        for (const auto& f : s.fields) {
-            out_ << "    " << f.name << ": " << f.type_name;
-            if (f.default_value) out_ << " = ...";
-            out_ << ",\n";
-        }
-        out_ << "}\n```\n\n";
+        out_ << "```mana\n" << signature(s) << "\n```\n\n";
 
         // Documentation comment
         if (s.has_doc()) {
@@ -211,32 +166,7 @@ namespace mana::backend {
         if (e.is_pub) out_ << "`pub` ";
         out_ << "`enum " << e.name << "`\n\n";
 
-        // Signature
-        out_ << "```mana\n";
-        if (e.is_pub) out_ << "pub ";
-        out_ << "enum " << e.name << " {\n";
-        for (const auto& v : e.variants) {
-            out_ << "    " << v.name;
-            if (v.is_tuple_variant()) {
-                out_ << "(";
-                for (size_t i = 0; i < v.tuple_types.size(); ++i) {
-                    if (i > 0) out_ << ", ";
-                    out_ << v.tuple_types[i];
-                }
-                out_ << ")";
-            } else if (v.is_struct_variant()) {
-                out_ << " { ";
-                for (size_t i = 0; i < v.struct_fields.size(); ++i) {
-                    if (i > 0) out_ << ", ";
-                    out_ << v.struct_fields[i].name << ": " << v.struct_fields[i].type_name;
-                }
-                out_ << " }";
-            } else if (v.has_value) {
-                out_ << " = " << v.value;
-            }
-            out_ << ",\n";
-        }
-        out_ << "}\n```\n\n";
+        out_ << "```mana\n" << signature(e) << "\n```\n\n";
 
         // Documentation comment
         if (e.has_doc()) {
@@ -277,34 +207,7 @@ namespace mana::backend {
         if (t.is_pub) out_ << "`pub` ";
         out_ << "`trait " << t.name << "`\n\n";
 
-        // Signature
-        out_ << "```mana\n";
-        if (t.is_pub) out_ << "pub ";
-        out_ << "trait " << t.name << " {\n";
-
-        // Associated types
-        for (const auto& at : t.associated_types) {
-            out_ << "    type " << at.name << ";\n";
-        }
-
-        // Methods
-        for (const auto& m : t.methods) {
-            out_ << "    fn " << m.name << "(";
-            for (size_t i = 0; i < m.params.size(); ++i) {
-                if (i > 0) out_ << ", ";
-                out_ << m.params[i].name << ": " << m.params[i].type_name;
-            }
-            out_ << ")";
-            if (!m.return_type.empty() && m.return_type != "void") {
-                out_ << " -> " << m.return_type;
-            }
-            if (m.has_default()) {
-                out_ << " { ... }";
-            }
-            out_ << "\n";
-        }
-
-        out_ << "}\n```\n\n";
+        out_ << "```mana\n" << signature(t) << "\n```\n\n";
 
         // Documentation comment
         if (t.has_doc()) {
@@ -339,11 +242,7 @@ namespace mana::backend {
         if (t.is_pub) out_ << "`pub` ";
         out_ << "`type " << t.alias_name << "`\n\n";
 
-        // Signature
-        out_ << "```mana\n";
-        if (t.is_pub) out_ << "pub ";
-        out_ << "type " << t.alias_name << " = " << t.target_type << ";\n";
-        out_ << "```\n\n";
+        out_ << "```mana\n" << signature(t) << "\n```\n\n";
 
         // Documentation comment
         if (t.has_doc()) {
@@ -353,6 +252,355 @@ namespace mana::backend {
         out_ << "---\n\n";
     }
 
+    std::string DocGenerator::signature(const AstFuncDecl& fn) {
+        std::ostringstream out;
+        if (fn.is_pub) out << "pub ";
+        if (fn.is_async) out << "async ";
+        out << "fn ";
+        if (!fn.receiver_type.empty()) {
+            out << fn.receiver_type << ".";
+        }
+        out << fn.name;
+
+        // Type parameters
+        if (!fn.type_params.empty()) {
+            out << "<";
+            for (size_t i = 0; i < fn.type_params.size(); ++i) {
+                if (i > 0) out << ", ";
+                out << fn.type_params[i];
+            }
+            out << ">";
+        }
+
+        // Parameters
+        out << "(";
+        for (size_t i = 0; i < fn.params.size(); ++i) {
+            if (i > 0) out << ", ";
+            out << fn.params[i].name << ": " << fn.params[i].type_name;
+            if (fn.params[i].has_default()) {
+                out << " = ...";
+            }
+        }
+        out << ")";
+
+        // Return type
+        if (!fn.return_type.empty() && fn.return_type != "void") {
+            out << " -> " << fn.return_type;
+        }
+
+        // Where clause
+        if (!fn.constraints.empty()) {
+            out << "\n    where ";
+            for (size_t i = 0; i < fn.constraints.size(); ++i) {
+                if (i > 0) out << ", ";
+                out << fn.constraints[i].type_param << ": ";
+                for (size_t j = 0; j < fn.constraints[i].traits.size(); ++j) {
+                    if (j > 0) out << " + ";
+                    out << fn.constraints[i].traits[j];
+                }
+            }
+        }
+        return out.str();
+    }
+
+    std::string DocGenerator::signature(const AstStructDecl& s) {
+        std::ostringstream out;
+        if (s.is_pub) out << "pub ";
+        out << "struct " << s.name;
+
+        if (!s.type_params.empty()) {
+            out << "<";
+            for (size_t i = 0; i < s.type_params.size(); ++i) {
+                if (i > 0) out << ", ";
+                out << s.type_params[i];
+            }
+            out << ">";
+        }
+
+        out << " {\n";
+        for (const auto& f : s.fields) {
+            out << "    " << f.name << ": " << f.type_name;
+            if (f.default_value) out << " = ...";
+            out << ",\n";
+        }
+        out << "}";
+        return out.str();
+    }
+
+    std::string DocGenerator::signature(const AstEnumDecl& e) {
+        std::ostringstream out;
+        if (e.is_pub) out << "pub ";
+        out << "enum " << e.name << " {\n";
+        for (const auto& v : e.variants) {
+            out << "    " << v.name;
+            if (v.is_tuple_variant()) {
+                out << "(";
+                for (size_t i = 0; i < v.tuple_types.size(); ++i) {
+                    if (i > 0) out << ", ";
+                    out << v.tuple_types[i];
+                }
+                out << ")";
+            } else if (v.is_struct_variant()) {
+                out << " { ";
+                for (size_t i = 0; i < v.struct_fields.size(); ++i) {
+                    if (i > 0) out << ", ";
+                    out << v.struct_fields[i].name << ": " << v.struct_fields[i].type_name;
+                }
+                out << " }";
+            } else if (v.has_value) {
+                out << " = " << v.value;
+            }
+            out << ",\n";
+        }
+        out << "}";
+        return out.str();
+    }
+
+    std::string DocGenerator::signature(const AstTraitDecl& t) {
+        std::ostringstream out;
+        if (t.is_pub) out << "pub ";
+        out << "trait " << t.name << " {\n";
+
+        // Associated types
+        for (const auto& at : t.associated_types) {
+            out << "    type " << at.name << ";\n";
+        }
+
+        // Methods
+        for (const auto& m : t.methods) {
+            out << "    fn " << m.name << "(";
+            for (size_t i = 0; i < m.params.size(); ++i) {
+                if (i > 0) out << ", ";
+                out << m.params[i].name << ": " << m.params[i].type_name;
+            }
+            out << ")";
+            if (!m.return_type.empty() && m.return_type != "void") {
+                out << " -> " << m.return_type;
+            }
+            if (m.has_default()) {
+                out << " { ... }";
+            }
+            out << "\n";
+        }
+        out << "}";
+        return out.str();
+    }
+
+    std::string DocGenerator::signature(const AstTypeAliasDecl& t) {
+        std::string out = t.is_pub ? "pub " : "";
+        return out + "type " + t.alias_name + " = " + t.target_type + ";";
+    }
+
+    std::vector<DocItem> DocGenerator::collect_items(const AstModule& mod) {
+        std::vector<DocItem> items;
+        std::unordered_set<std::string> anchors;
+        auto add = [&](const AstDecl& decl, const char* kind, const std::string& name, std::string sig) {
+            DocItem item;
+            item.kind = kind;
+            item.name = name;
+            item.anchor = std::string(kind) + "." + name;
+            // Overloads share a name; later ones get a numbered anchor
+            for (int n = 2; !anchors.insert(item.anchor).second; ++n) {
+                item.anchor = std::string(kind) + "." + name + "-" + std::to_string(n);
+            }
+            item.signature = std::move(sig);
+
+            // Summary: the first sentence of the first paragraph
+            const std::string& doc = decl.doc_comment;
+            size_t end = doc.find("\n\n");
+            if (end == std::string::npos) end = doc.size();
+            for (size_t i = 0; i + 1 < end; ++i) {
+                if (doc[i] == '.' && (doc[i + 1] == ' ' || doc[i + 1] == '\n')) {
+                    end = i + 1;
+                    break;
+                }
+            }
+            item.summary = doc.substr(0, end);
+            std::replace(item.summary.begin(), item.summary.end(), '\n', ' ');
+            items.push_back(std::move(item));
+        };
+
+        for (const AstDecl* decl : ordered_decls(mod)) {
+            if (auto t = dynamic_cast<const AstTypeAliasDecl*>(decl)) {
+                add(*t, "type", t->alias_name, signature(*t));
+            } else if (auto st = dynamic_cast<const AstStructDecl*>(decl)) {
+                add(*st, "struct", st->name, signature(*st));
+            } else if (auto e = dynamic_cast<const AstEnumDecl*>(decl)) {
+                add(*e, "enum", e->name, signature(*e));
+            } else if (auto tr = dynamic_cast<const AstTraitDecl*>(decl)) {
+                add(*tr, "trait", tr->name, signature(*tr));
+            } else if (auto fn = dynamic_cast<const AstFuncDecl*>(decl)) {
+                add(*fn, "fn", fn->receiver_type.empty() ? fn->name : fn->receiver_type + "." + fn->name, signature(*fn));
+            }
+        }
+        return items;
+    }
+
+    std::string DocGenerator::generate_html(const AstModule& mod, const DocLinkResolver& link) {
+        std::ostringstream out;
+        std::string title = escape_html(mod.name);
+        out << "<!DOCTYPE html>\n<html lang=\"en\">\n<head>\n<meta charset=\"utf-8\">\n"
+            << "<title>" << title << " - Mana docs</title>\n"
+            << "<link rel=\"stylesheet\" href=\"style.css\">\n"
+            << "<script src=\"search-index.js\" defer></script>\n"
+            << "<script src=\"search.js\" defer></script>\n</head>\n<body>\n"
+            << "<nav><a href=\"index.html\">Index</a>"
+            << "<input id=\"search\" type=\"search\" placeholder=\"Search\" autocomplete=\"off\">"
+            << "<ul id=\"results\"></ul></nav>\n<main>\n"
+            << "<h1>Module <code>" << title << "</code></h1>\n";
+
+        std::vector<DocItem> items = collect_items(mod);
+        std::vector<const AstDecl*> decls = ordered_decls(mod);
+
+        const char* section = nullptr;
+        for (size_t i = 0; i < items.size(); ++i) {
+            const DocItem& item = items[i];
+            const char* heading = item.kind == "type" ? "Type Aliases" : item.kind == "struct" ? "Structs"
+                                : item.kind == "enum" ? "Enums" : item.kind == "trait" ? "Traits" : "Functions";
+            if (heading != section) {
+                section = heading;
+                out << "<h2>" << heading << "</h2>\n";
+            }
+            out << "<section class=\"item\" id=\"" << escape_html(item.anchor) << "\">\n"
+                << "<h3><a href=\"#" << escape_html(item.anchor) << "\">" << item.kind << " "
+                << escape_html(item.name) << "</a></h3>\n"
+                << "<pre><code>" << linked_html(item.signature, link) << "</code></pre>\n";
+            if (decls[i]->has_doc()) {
+                out << "<div class=\"doc\">" << doc_html(decls[i]->doc_comment, link) << "</div>\n";
+            }
+            out << "</section>\n";
+        }
+
+        out << "</main>\n</body>\n</html>\n";
+        return out.str();
+    }
+
+    std::string DocGenerator::linked_html(const std::string& code, const DocLinkResolver& link) {
+        static const std::unordered_set<std::string> keywords = {
+            "pub", "async", "fn", "struct", "enum", "trait", "type", "where", "mut", "ref", "self", "Self",
+        };
+        std::string out;
+        size_t i = 0;
+        while (i < code.size()) {
+            unsigned char c = static_cast<unsigned char>(code[i]);
+            if (!std::isalpha(c) && c != '_') {
+                out += escape_html(std::string(1, code[i++]));
+                continue;
+            }
+            size_t start = i;
+            while (i < code.size() && (std::isalnum(static_cast<unsigned char>(code[i])) || code[i] == '_')) ++i;
+            std::string word = code.substr(start, i - start);
+            std::string target = keywords.count(word) ? std::string() : link(word);
+            if (target.empty()) {
+                out += word;
+            } else {
+                out += "<a href=\"" + escape_html(target) + "\">" + word + "</a>";
+            }
+        }
+        return out;
+    }
+
+    std::string DocGenerator::inline_html(const std::string& line, const DocLinkResolver& link) {
+        // `code` spans are kept; [Name], [`Name`] and [module::Name] link to
+        // the item that documents Name, and stay plain text if nothing does
+        std::string out;
+        size_t pos = 0;
+        while (pos < line.size()) {
+            size_t next = line.find_first_of("`[", pos);
+            out += escape_html(line.substr(pos, next == std::string::npos ? std::string::npos : next - pos));
+            if (next == std::string::npos) break;
+            pos = next;
+            if (line[pos] == '`') {
+                size_t end = line.find('`', pos + 1);
+                if (end == std::string::npos) {
+                    out += escape_html(line.substr(pos));
+                    break;
+                }
+                out += "<code>" + escape_html(line.substr(pos + 1, end - pos - 1)) + "</code>";
+                pos = end + 1;
+                continue;
+            }
+            size_t close = line.find(']', pos + 1);
+            std::string name = close == std::string::npos ? std::string() : line.substr(pos + 1, close - pos - 1);
+            bool code = name.size() > 2 && name.front() == '`' && name.back() == '`';
+            if (code) name = name.substr(1, name.size() - 2);
+            // A name, or a module-qualified one like geo::Point
+            bool ident = true;
+            for (size_t start = 0;;) {
+                size_t sep = name.find("::", start);
+                std::string part = name.substr(start, sep == std::string::npos ? std::string::npos : sep - start);
+                ident = !part.empty() && !std::isdigit(static_cast<unsigned char>(part[0])) &&
+                        std::all_of(part.begin(), part.end(), [](char c) {
+                            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+                        });
+                if (!ident || sep == std::string::npos) break;
+                start = sep + 2;
+            }
+            // [text](url) is a Markdown link, not a reference to an item
+            bool markdown_link = close != std::string::npos && close + 1 < line.size() && line[close + 1] == '(';
+            std::string target = ident && !markdown_link ? link(name) : std::string();
+            if (target.empty()) {
+                out += '[';
+                pos++;
+                continue;
+            }
+            std::string text = code ? "<code>" + escape_html(name) + "</code>" : escape_html(name);
+            out += "<a href=\"" + escape_html(target) + "\">" + text + "</a>";
+            pos = close + 1;
+        }
+        return out;
+    }
+
+    std::string DocGenerator::doc_html(const std::string& doc, const DocLinkResolver& link) {
+        // Blank lines separate paragraphs, "# " lines are headings, ``` fences
+        // enclose code blocks, and spans are rendered by inline_html
+        std::string out;
+        bool in_paragraph = false;
+        bool in_block = false;
+        auto close_paragraph = [&]() {
+            if (in_paragraph) out += "</p>\n";
+            in_paragraph = false;
+        };
+        std::istringstream lines(doc);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (line.compare(0, 3, "```") == 0) {
+                close_paragraph();
+                out += in_block ? "</code></pre>\n" : "<pre><code>";
+                in_block = !in_block;
+            } else if (in_block) {
+                out += escape_html(line) + "\n";
+            } else if (line.find_first_not_of(" \t") == std::string::npos) {
+                close_paragraph();
+            } else if (line.compare(0, 2, "# ") == 0) {
+                close_paragraph();
+                out += "<h4>" + escape_html(line.substr(2)) + "</h4>\n";
+            } else {
+                out += in_paragraph ? "\n" : "<p>";
+                in_paragraph = true;
+                out += inline_html(line, link);
+            }
+        }
+        close_paragraph();
+        if (in_block) out += "</code></pre>\n";
+        return out;
+    }
+
+    std::string DocGenerator::escape_html(const std::string& s) {
+        std::string result;
+        result.reserve(s.size());
+        for (char c : s) {
+            switch (c) {
+                case '&': result += "&amp;"; break;
+                case '<': result += "&lt;"; break;
+                case '>': result += "&gt;"; break;
+                case '"': result += "&quot;"; break;
+                default: result += c; break;
+            }
+        }
+        return result;
+    }
+
     std::string DocGenerator::escape_markdown(const std::string& s) {
         std::string result;
         for (char c : s) {
@@ -1,6 +1,8 @@
 #pragma once
+#include <functional>
 #include <string>
 #include <sstream>
+#include <vector>
 #include "../frontend/AstModule.h"
 #include "../frontend/AstDecl.h"
 #include "../frontend/AstStatements.h"
@@ -8,11 +10,41 @@
 
 namespace mana::backend {
 
-    // Documentation generator that produces Markdown documentation from AST
+    // A documented declaration, as listed in the search index
+    struct DocItem {
+        std::string kind;       // fn, struct, enum, trait, type
+        std::string name;
+        std::string anchor;     // Fragment id on the module's page
+        std::string signature;
+        std::string summary;    // First sentence of the doc comment
+    };
+
+    // Resolves a name used in a signature, or a doc comment reference that
+    // may be module-qualified ("geo::Point"), to "page.html#anchor"; empty if
+    // nothing documents it
+    using DocLinkResolver = std::function<std::string(const std::string& name)>;
+
+    // Documentation generator that produces Markdown or HTML documentation from AST
     class DocGenerator {
     public:
         std::string generate(const mana::frontend::AstModule& mod);
 
+        // HTML page for a module, one section per item of collect_items().
+        // Names in signatures and [Name] references in doc comments are
+        // linked through `link`.
+        std::string generate_html(const mana::frontend::AstModule& mod, const DocLinkResolver& link);
+
+        static std::vector<DocItem> collect_items(const mana::frontend::AstModule& mod);
+
+        // Signatures as shown in the generated code blocks
+        static std::string signature(const mana::frontend::AstFuncDecl& fn);
+        static std::string signature(const mana::frontend::AstStructDecl& s);
+        static std::string signature(const mana::frontend::AstEnumDecl& e);
+        static std::string signature(const mana::frontend::AstTraitDecl& t);
+        static std::string signature(const mana::frontend::AstTypeAliasDecl& t);
+
+        static std::string escape_html(const std::string& s);
+
     private:
         std::stringstream out_;
 
@@ -24,6 +56,9 @@ namespace mana::backend {
         void emit_type_alias(const mana::frontend::AstTypeAliasDecl& t);
 
         std::string escape_markdown(const std::string& s);
+        static std::string linked_html(const std::string& code, const DocLinkResolver& link);
+        static std::string doc_html(const std::string& doc, const DocLinkResolver& link);
+        static std::string inline_html(const std::string& line, const DocLinkResolver& link);
     };
 
 } // namespace mana::backend
@@ -0,0 +1,215 @@
+#include "SourceMap.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace mana::backend {
+
+    namespace {
+
+        void put_u32(std::string& out, uint32_t v) {
+            for (int i = 0; i < 4; ++i) out += static_cast<char>((v >> (8 * i)) & 0xff);
+        }
+
+        void put_u16(std::string& out, uint16_t v) {
+            out += static_cast<char>(v & 0xff);
+            out += static_cast<char>(v >> 8);
+        }
+
+        void put_string(std::string& out, const std::string& s) {
+            put_u32(out, static_cast<uint32_t>(s.size()));
+            out += s;
+        }
+
+        // Bounds-checked reader over the loaded file
+        struct Reader {
+            const std::string& data;
+            size_t pos = 0;
+            bool ok = true;
+
+            uint32_t u32() {
+                if (pos + 4 > data.size()) { ok = false; return 0; }
+                uint32_t v = 0;
+                for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+                pos += 4;
+                return v;
+            }
+
+            uint16_t u16() {
+                if (pos + 2 > data.size()) { ok = false; return 0; }
+                uint16_t v = static_cast<uint16_t>(static_cast<unsigned char>(data[pos]) |
+                                                   static_cast<unsigned char>(data[pos + 1]) << 8);
+                pos += 2;
+                return v;
+            }
+
+            std::string string() {
+                uint32_t size = u32();
+                if (!ok || pos + size > data.size()) { ok = false; return {}; }
+                std::string s = data.substr(pos, size);
+                pos += size;
+                return s;
+            }
+        };
+
+    } // namespace
+
+    SourceMap::SourceMap() {
+        functions_.push_back("");
+    }
+
+    uint16_t SourceMap::add_file(const std::string& path) {
+        auto it = file_ids_.find(path);
+        if (it != file_ids_.end()) return it->second;
+        uint16_t id = static_cast<uint16_t>(files_.size());
+        files_.push_back(path);
+        file_ids_.emplace(path, id);
+        return id;
+    }
+
+    uint32_t SourceMap::add_function(const std::string& name) {
+        auto it = function_ids_.find(name);
+        if (it != function_ids_.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(functions_.size());
+        functions_.push_back(name);
+        function_ids_.emplace(name, id);
+        return id;
+    }
+
+    void SourceMap::add(uint32_t cpp_line, uint16_t file, uint32_t line, uint32_t column, uint32_t function) {
+        if (!entries_.empty()) {
+            SourceMapEntry& last = entries_.back();
+            // Still the same source line: the run just continues
+            if (last.line == line && last.file == file && last.function == function) return;
+            // Nothing was written for the previous entry; the outer statement keeps the line
+            if (last.cpp_line == cpp_line) {
+                if (last.line != 0) return;
+                entries_.pop_back();
+            }
+        } else if (line == 0) {
+            return;
+        }
+        SourceMapEntry entry;
+        entry.cpp_line = cpp_line;
+        entry.line = line;
+        entry.column = static_cast<uint16_t>(std::min<uint32_t>(column, 0xffff));
+        entry.file = file;
+        entry.function = function;
+        entries_.push_back(entry);
+    }
+
+    void SourceMap::offset(int32_t lines) {
+        for (auto& e : entries_) e.cpp_line = static_cast<uint32_t>(static_cast<int64_t>(e.cpp_line) + lines);
+    }
+
+    void SourceMap::finish() {
+        by_line_.clear();
+        for (uint32_t i = 0; i < entries_.size(); ++i) {
+            if (entries_[i].line != 0) by_line_.push_back(i);
+        }
+        std::sort(by_line_.begin(), by_line_.end(), [this](uint32_t a, uint32_t b) {
+            const SourceMapEntry& x = entries_[a];
+            const SourceMapEntry& y = entries_[b];
+            if (x.file != y.file) return x.file < y.file;
+            if (x.line != y.line) return x.line < y.line;
+            return x.cpp_line < y.cpp_line;
+        });
+    }
+
+    bool SourceMap::write(const std::string& path) {
+        finish();
+        std::string out = "MMAP";
+        put_u32(out, kVersion);
+        put_u32(out, static_cast<uint32_t>(files_.size()));
+        put_u32(out, static_cast<uint32_t>(functions_.size()));
+        put_u32(out, static_cast<uint32_t>(entries_.size()));
+        put_string(out, cpp_file);
+        for (const auto& f : files_) put_string(out, f);
+        for (const auto& f : functions_) put_string(out, f);
+        for (const auto& e : entries_) {
+            put_u32(out, e.cpp_line);
+            put_u32(out, e.line);
+            put_u16(out, e.column);
+            put_u16(out, e.file);
+            put_u32(out, e.function);
+        }
+        put_u32(out, static_cast<uint32_t>(by_line_.size()));
+        for (uint32_t i : by_line_) put_u32(out, i);
+
+        std::ofstream file(path, std::ios::binary);
+        return file && file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    }
+
+    bool SourceMap::load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (data.compare(0, 4, "MMAP") != 0) return false;
+
+        Reader in{data, 4};
+        if (in.u32() != kVersion) return false;
+        uint32_t file_count = in.u32();
+        uint32_t function_count = in.u32();
+        uint32_t entry_count = in.u32();
+        // Reject counts the file cannot hold before allocating for them
+        if (!in.ok || file_count > 0xffff || entry_count > data.size() / 16 || function_count > data.size() / 4) return false;
+
+        SourceMap map;
+        map.functions_.clear();
+        map.cpp_file = in.string();
+        for (uint32_t i = 0; i < file_count && in.ok; ++i) map.add_file(in.string());
+        for (uint32_t i = 0; i < function_count && in.ok; ++i) {
+            map.functions_.push_back(in.string());
+            map.function_ids_.emplace(map.functions_.back(), i);
+        }
+        map.entries_.resize(entry_count);
+        for (auto& e : map.entries_) {
+            e.cpp_line = in.u32();
+            e.line = in.u32();
+            e.column = in.u16();
+            e.file = in.u16();
+            e.function = in.u32();
+            if (e.file >= file_count && e.line != 0) in.ok = false;
+            if (e.function >= function_count) in.ok = false;
+        }
+        uint32_t index_count = in.u32();
+        if (!in.ok || index_count > entry_count) return false;
+        map.by_line_.resize(index_count);
+        for (auto& i : map.by_line_) {
+            i = in.u32();
+            if (i >= entry_count) in.ok = false;
+        }
+        if (!in.ok || map.functions_.empty()) return false;
+        *this = std::move(map);
+        return true;
+    }
+
+    const SourceMapEntry* SourceMap::find_generated(uint32_t cpp_line) const {
+        auto it = std::upper_bound(entries_.begin(), entries_.end(), cpp_line,
+                                   [](uint32_t l, const SourceMapEntry& e) { return l < e.cpp_line; });
+        if (it == entries_.begin()) return nullptr;
+        --it;
+        return it->line == 0 ? nullptr : &*it;
+    }
+
+    std::vector<const SourceMapEntry*> SourceMap::find_original(uint16_t file, uint32_t line) const {
+        auto less = [this](uint32_t i, std::pair<uint16_t, uint32_t> key) {
+            const SourceMapEntry& e = entries_[i];
+            return e.file != key.first ? e.file < key.first : e.line < key.second;
+        };
+        auto it = std::lower_bound(by_line_.begin(), by_line_.end(), std::make_pair(file, line), less);
+        std::vector<const SourceMapEntry*> found;
+        if (it == by_line_.end() || entries_[*it].file != file) return found;
+        uint32_t bound = entries_[*it].line;
+        for (; it != by_line_.end() && entries_[*it].file == file && entries_[*it].line == bound; ++it) {
+            found.push_back(&entries_[*it]);
+        }
+        return found;
+    }
+
+    int SourceMap::file_index(const std::string& path) const {
+        auto it = file_ids_.find(path);
+        return it == file_ids_.end() ? -1 : it->second;
+    }
+
+} // namespace mana::backend
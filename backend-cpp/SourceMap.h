@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mana::backend {
+
+    // Where a run of generated C++ lines came from. The run starts at
+    // `cpp_line` and lasts until the next entry's cpp_line; a run with
+    // line 0 is generated code with no Mana source.
+    struct SourceMapEntry {
+        uint32_t cpp_line = 0;
+        uint32_t line = 0;
+        uint16_t column = 0;
+        uint16_t file = 0;      // Index into SourceMap::files()
+        uint32_t function = 0;  // Index into SourceMap::functions(); 0 = none
+    };
+
+    // Mana <-> C++ line mapping recorded by CppEmitter as it writes. Both
+    // directions are binary searches: entries are kept in generated order,
+    // and an index orders them by (file, line) for breakpoints.
+    //
+    // On disk (".manamap") it is a little-endian binary file:
+    //   "MMAP" u32 version, u32 counts of files, functions and entries,
+    //   length-prefixed strings (the C++ file, then files and functions),
+    //   16-byte entries, then the u32 index
+    // so loading is a straight read with no sorting.
+    class SourceMap {
+    public:
+        SourceMap();
+
+        std::string cpp_file;  // Path of the generated C++ file
+
+        // Building; entries must arrive in increasing cpp_line order
+        uint16_t add_file(const std::string& path);
+        uint32_t add_function(const std::string& name);
+        void add(uint32_t cpp_line, uint16_t file, uint32_t line, uint32_t column, uint32_t function);
+        // Ends the mapped region started by the last entry
+        void add_unmapped(uint32_t cpp_line) { add(cpp_line, 0, 0, 0, 0); }
+        // Shifts every generated line, for text later prepended to the C++
+        void offset(int32_t lines);
+        // Builds the (file, line) index; done by write() and load()
+        void finish();
+
+        bool write(const std::string& path);
+        bool load(const std::string& path);
+
+        // Entry covering a generated line; nullptr outside mapped code
+        const SourceMapEntry* find_generated(uint32_t cpp_line) const;
+        // Code a breakpoint on `line` binds to: every entry of the first
+        // line at or after it in `file` that has code, in generated order
+        std::vector<const SourceMapEntry*> find_original(uint16_t file, uint32_t line) const;
+
+        int file_index(const std::string& path) const;  // -1 if not mapped
+        const std::vector<std::string>& files() const { return files_; }
+        const std::vector<std::string>& functions() const { return functions_; }
+        const std::vector<SourceMapEntry>& entries() const { return entries_; }
+
+        static constexpr uint32_t kVersion = 1;
+
+    private:
+        std::vector<std::string> files_;
+        std::vector<std::string> functions_;  // [0] is ""
+        std::vector<SourceMapEntry> entries_;
+        std::vector<uint32_t> by_line_;       // Entry indices ordered by (file, line, cpp_line)
+        std::unordered_map<std::string, uint16_t> file_ids_;
+        std::unordered_map<std::string, uint32_t> function_ids_;
+    };
+
+} // namespace mana::backend
@@ -0,0 +1,339 @@
+// Throughput benchmarks for the compiler itself: lexer, parser, import
+// resolution, semantic analysis, middle-end passes and CppEmitter.
+// Each workload is a synthetic program generated at scale; every stage is
+// timed separately so a slowdown points at the file that caused it.
+// Build: cmake --build build --target mana_compiler_bench
+// Usage: mana_compiler_bench [--scale <f>] [--repeat <n>] [--only <workload>] [--json <file>]
+#include "../frontend/Lexer.h"
+#include "../frontend/Parser.h"
+#include "../frontend/Semantic.h"
+#include "../frontend/AstModule.h"
+#include "../frontend/Imports.h"
+#include "../middle/ForLowering.h"
+#include "../middle/DeadCodeElimination.h"
+#include "../middle/Inlining.h"
+#include "../backend-cpp/CppEmitter.h"
+#include "../tools/json/Json.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace mana::frontend;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Workload {
+    std::string name;
+    std::string source;
+    // Extra files for `import "name";`, written next to the main file
+    std::vector<std::pair<std::string, std::string>> files;
+};
+
+size_t scaled(size_t n, double scale) {
+    return std::max<size_t>(1, static_cast<size_t>(static_cast<double>(n) * scale));
+}
+
+// 10k small functions, each calling the one before it
+Workload many_functions(double scale) {
+    size_t count = scaled(10000, scale);
+    std::ostringstream out;
+    out << "module many_functions;\n\n";
+    for (size_t i = 0; i < count; ++i) {
+        out << "fn f" << i << "(a: i32, b: i32) -> i32 {\n";
+        out << "    let x: i32 = a * " << (i % 7 + 1) << " + b;\n";
+        out << "    let mut y: i32 = x - " << i % 13 << ";\n";
+        out << "    if y > 100 {\n        y = y / 2;\n    }\n";
+        if (i > 0) out << "    return f" << i - 1 << "(y, a) + 1;\n";
+        else out << "    return y;\n";
+        out << "}\n\n";
+    }
+    out << "fn main() -> i32 {\n    println(f" << count - 1 << "(1, 2));\n    return 0;\n}\n";
+    return {"many_functions", out.str(), {}};
+}
+
+// Long operator chains and deeply parenthesized expressions
+Workload deep_expressions(double scale) {
+    size_t functions = scaled(200, scale);
+    const int chain = 400;
+    const int depth = 150;
+    std::ostringstream out;
+    out << "module deep_expressions;\n\n";
+    for (size_t f = 0; f < functions; ++f) {
+        out << "fn chain" << f << "(x: i32) -> i32 {\n    return x";
+        for (int i = 0; i < chain; ++i) out << (i % 3 == 0 ? " + " : i % 3 == 1 ? " * " : " - ") << (i % 9 + 1);
+        out << ";\n}\n\n";
+        out << "fn nested" << f << "(x: i32) -> i32 {\n    return ";
+        for (int i = 0; i < depth; ++i) out << "(x + ";
+        out << "1";
+        for (int i = 0; i < depth; ++i) out << ") * 2";
+        out << ";\n}\n\n";
+    }
+    out << "fn main() -> i32 {\n    println(chain0(1) + nested0(1));\n    return 0;\n}\n";
+    return {"deep_expressions", out.str(), {}};
+}
+
+// Enums with hundreds of variants, matched arm by arm
+Workload wide_match(double scale) {
+    size_t enums = scaled(20, scale);
+    const int variants = 300;
+    std::ostringstream out;
+    out << "module wide_match;\n\n";
+    for (size_t e = 0; e < enums; ++e) {
+        out << "enum Op" << e << " {\n";
+        for (int v = 0; v < variants; ++v) out << "    V" << v << ",\n";
+        out << "}\n\n";
+        out << "fn eval" << e << "(op: Op" << e << ", x: i32) -> i32 {\n    return match op {\n";
+        for (int v = 0; v < variants; ++v) out << "        Op" << e << "::V" << v << " => x + " << v << ",\n";
+        out << "    };\n}\n\n";
+        out << "fn classify" << e << "(n: i32) -> string {\n    return match n {\n";
+        for (int v = 0; v < variants; ++v) out << "        " << v << " => \"v" << v << "\",\n";
+        out << "        _ => \"other\",\n    };\n}\n\n";
+    }
+    out << "fn main() -> i32 {\n    println(eval0(Op0::V1, 2));\n    return 0;\n}\n";
+    return {"wide_match", out.str(), {}};
+}
+
+// Generic functions and structs instantiated at several types
+Workload generics(double scale) {
+    size_t count = scaled(1000, scale);
+    std::ostringstream out;
+    out << "module generics;\n\n";
+    for (size_t i = 0; i < count; ++i) {
+        out << "struct Box" << i << "<T> {\n    value: T,\n}\n\n";
+        out << "fn id" << i << "<T>(x: T) -> T {\n    return x;\n}\n\n";
+        out << "fn first" << i << "<T, U>(a: T, b: U) -> T {\n    return a;\n}\n\n";
+        out << "fn use" << i << "() -> i32 {\n";
+        out << "    let a: i32 = id" << i << "(" << i << ");\n";
+        out << "    let s: string = id" << i << "(\"s" << i << "\");\n";
+        out << "    let f: bool = id" << i << "(true);\n";
+        out << "    let b = Box" << i << " { value: a };\n";
+        out << "    let p: i32 = first" << i << "(a, s);\n";
+        out << "    return b.value;\n}\n\n";
+    }
+    out << "fn main() -> i32 {\n    println(use0());\n    return 0;\n}\n";
+    return {"generics", out.str(), {}};
+}
+
+// A main file importing hundreds of modules
+Workload many_imports(double scale) {
+    size_t modules = scaled(200, scale);
+    const int functions = 40;
+    Workload w;
+    w.name = "many_imports";
+    std::ostringstream main;
+    main << "module many_imports;\n\n";
+    for (size_t m = 0; m < modules; ++m) {
+        std::ostringstream mod;
+        mod << "module mod" << m << ";\n\n";
+        for (int f = 0; f < functions; ++f) {
+            mod << "pub fn m" << m << "_f" << f << "(x: i32) -> i32 {\n    return x + " << f << ";\n}\n\n";
+        }
+        w.files.emplace_back("mod" + std::to_string(m), mod.str());
+        main << "import \"mod" << m << "\";\n";
+    }
+    main << "\nfn main() -> i32 {\n    let mut total: i32 = 0;\n";
+    for (size_t m = 0; m < modules; ++m) main << "    total = total + m" << m << "_f" << m % functions << "(1);\n";
+    main << "    println(total);\n    return 0;\n}\n";
+    w.source = main.str();
+    return w;
+}
+
+const char* const kStages[] = {"lex", "parse", "imports", "sema", "for_lowering", "dce", "inlining", "emit"};
+
+struct StageTimes {
+    std::map<std::string, std::vector<double>> ms;  // Stage -> one entry per repeat
+};
+
+struct Result {
+    std::string name;
+    size_t source_bytes = 0;
+    size_t tokens = 0;
+    size_t decls = 0;
+    size_t cpp_bytes = 0;
+    size_t errors = 0;
+    std::string first_error;
+    StageTimes times;
+};
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void run_once(const Workload& w, const fs::path& dir, Result& result) {
+    using clock = std::chrono::steady_clock;
+    DiagnosticEngine diag;
+
+    auto t = clock::now();
+    Lexer lex(w.source);
+    auto tokens = lex.tokenize();
+    result.times.ms["lex"].push_back(elapsed_ms(t));
+
+    t = clock::now();
+    Parser parser(tokens, diag);
+    auto module = parser.parse_module();
+    result.times.ms["parse"].push_back(elapsed_ms(t));
+
+    t = clock::now();
+    if (!w.files.empty()) {
+        std::unordered_set<std::string> seen;
+        splice_file_imports(module.get(), dir, diag, seen);
+    }
+    result.times.ms["imports"].push_back(elapsed_ms(t));
+
+    t = clock::now();
+    SemanticAnalyzer sema(diag);
+    sema.analyze(module.get());
+    result.times.ms["sema"].push_back(elapsed_ms(t));
+
+    t = clock::now();
+    mana::middle::ForLowering::run(module.get());
+    result.times.ms["for_lowering"].push_back(elapsed_ms(t));
+
+    t = clock::now();
+    mana::middle::DeadCodeElimination::run(module.get());
+    result.times.ms["dce"].push_back(elapsed_ms(t));
+
+    t = clock::now();
+    mana::middle::Inlining::run(module.get());
+    result.times.ms["inlining"].push_back(elapsed_ms(t));
+
+    t = clock::now();
+    std::ostringstream cpp;
+    mana::backend::CppEmitter emitter;
+    emitter.emit(module.get(), cpp);
+    result.times.ms["emit"].push_back(elapsed_ms(t));
+
+    result.source_bytes = w.source.size();
+    for (const auto& f : w.files) result.source_bytes += f.second.size();
+    result.tokens = tokens.size();
+    result.decls = module ? module->decls.size() : 0;
+    result.cpp_bytes = cpp.str().size();
+    result.errors = diag.errors().size();
+    if (!diag.errors().empty()) result.first_error = diag.errors().front().message;
+}
+
+double min_of(const std::vector<double>& v) {
+    return v.empty() ? 0.0 : *std::min_element(v.begin(), v.end());
+}
+
+double median_of(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t mid = v.size() / 2;
+    return v.size() % 2 ? v[mid] : (v[mid - 1] + v[mid]) / 2.0;
+}
+
+void report(const Result& r) {
+    std::cout << r.name << " (" << r.source_bytes / 1024 << " KiB, " << r.tokens << " tokens, "
+              << r.decls << " decls)\n";
+    double total = 0.0;
+    for (const char* stage : kStages) {
+        const auto& v = r.times.ms.at(stage);
+        double best = min_of(v);
+        total += best;
+        std::cout << "  " << std::left << std::setw(14) << stage
+                  << std::right << std::setw(10) << std::fixed << std::setprecision(2) << best << " ms"
+                  << std::setw(10) << median_of(v) << " ms median\n";
+    }
+    std::cout << "  " << std::left << std::setw(14) << "total" << std::right << std::setw(10) << total << " ms\n";
+    if (r.errors > 0) {
+        std::cout << "  (" << r.errors << " diagnostics; first: " << r.first_error << ")\n";
+    }
+}
+
+std::string to_json(const std::vector<Result>& results, double scale, int repeat) {
+    std::string out;
+    mana::json::Writer w(out);
+    w.begin_object().key("scale").value(scale).key("repeat").value(repeat).key("workloads").begin_array();
+    for (const auto& r : results) {
+        w.begin_object()
+            .key("name").value(r.name)
+            .key("source_bytes").value(static_cast<uint64_t>(r.source_bytes))
+            .key("tokens").value(static_cast<uint64_t>(r.tokens))
+            .key("decls").value(static_cast<uint64_t>(r.decls))
+            .key("cpp_bytes").value(static_cast<uint64_t>(r.cpp_bytes))
+            .key("errors").value(static_cast<uint64_t>(r.errors))
+            .key("stages").begin_object();
+        double total = 0.0;
+        for (const char* stage : kStages) {
+            const auto& v = r.times.ms.at(stage);
+            total += min_of(v);
+            w.key(stage).begin_object().key("min_ms").value(min_of(v)).key("median_ms").value(median_of(v)).end_object();
+        }
+        w.end_object().key("total_ms").value(total).end_object();
+    }
+    w.end_array().end_object();
+    return out + "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double scale = 1.0;
+    int repeat = 3;
+    std::string only;
+    std::string json_path;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = std::strtod(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--scale <f>] [--repeat <n>] [--only <workload>] [--json <file>]\n";
+            return 1;
+        }
+    }
+    if (scale <= 0.0) scale = 1.0;
+
+    std::vector<Workload (*)(double)> generators = {many_functions, deep_expressions, wide_match, generics, many_imports};
+
+    fs::path dir = fs::temp_directory_path() / "mana_compiler_bench";
+    fs::create_directories(dir);
+
+    std::cout << "Mana compiler benchmarks (scale " << scale << ", best of " << repeat << ")\n\n";
+
+    std::vector<Result> results;
+    bool clean = true;
+    for (auto generate : generators) {
+        Workload w = generate(scale);
+        if (!only.empty() && w.name != only) continue;
+        for (const auto& f : w.files) {
+            std::ofstream(dir / (f.first + ".mana")) << f.second;
+        }
+
+        Result r;
+        r.name = w.name;
+        for (int i = 0; i < repeat; ++i) run_once(w, dir, r);
+        report(r);
+        std::cout << "\n";
+        // A workload with diagnostics stopped short of the full pipeline
+        if (r.errors > 0) clean = false;
+        results.push_back(std::move(r));
+    }
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        if (!out) {
+            std::cerr << "error: cannot write " << json_path << "\n";
+            return 1;
+        }
+        out << to_json(results, scale, repeat);
+    }
+    return clean ? 0 : 1;
+}
@@ -0,0 +1,336 @@
+// Benchmarks for the package resolver (tools/pkg/Resolver) on synthetic
+// dependency graphs of thousands of packages. Metadata is served by an
+// in-process mock registry that counts requests and can add a round-trip
+// delay per batch, as the parallel fetcher in `mana install` sees it.
+// Every solution is checked against the constraints it must satisfy.
+// Build: cmake --build build --target mana_resolver_bench
+// Usage: mana_resolver_bench [--scale <f>] [--repeat <n>] [--latency-ms <n>] [--only <workload>] [--json <file>]
+#include "../tools/pkg/Resolver.h"
+#include "../tools/json/Json.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace mana::pkg;
+
+namespace {
+
+struct Registry {
+    std::unordered_map<std::string, RegistryPackage> packages;
+    std::vector<Dependency> root;
+    bool solvable = true;
+};
+
+struct Workload {
+    std::string name;
+    Registry registry;
+};
+
+size_t scaled(size_t n, double scale) {
+    return std::max<size_t>(1, static_cast<size_t>(static_cast<double>(n) * scale));
+}
+
+std::string pkg_name(size_t i) {
+    return "p" + std::to_string(i);
+}
+
+Dependency requirement(const std::string& name, const std::string& constraint) {
+    Dependency dep;
+    dep.name = name;
+    dep.version = constraint;
+    dep.source = "registry";
+    return dep;
+}
+
+// Versions 1.0.0 .. 1.k.0 and 2.0.0 .. 2.k.0
+std::vector<std::string> version_list(int per_major) {
+    std::vector<std::string> versions;
+    for (int major = 1; major <= 2; ++major) {
+        for (int minor = 0; minor < per_major; ++minor) {
+            versions.push_back(std::to_string(major) + "." + std::to_string(minor) + ".0");
+        }
+    }
+    return versions;
+}
+
+// A layered graph in which one hidden assignment is a solution. Each
+// package depends on a few later ones; the hidden version's requirements
+// admit the hidden versions of its dependencies, other versions ask for a
+// random major, so greedy newest-first choices run into conflicts.
+Registry layered(size_t count, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::string> versions = version_list(3);
+    std::vector<size_t> hidden(count);
+    for (auto& h : hidden) h = rng() % versions.size();
+
+    Registry reg;
+    for (size_t i = 0; i < count; ++i) {
+        RegistryPackage pkg;
+        pkg.name = pkg_name(i);
+        pkg.versions = versions;
+        pkg.latest_version = versions.back();
+
+        size_t fanout = i + 1 < count ? 2 + rng() % 3 : 0;
+        std::vector<size_t> deps;
+        for (size_t k = 0; k < fanout; ++k) {
+            size_t span = std::min<size_t>(count - i - 1, 50);
+            deps.push_back(i + 1 + rng() % span);
+        }
+        std::sort(deps.begin(), deps.end());
+        deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+
+        for (size_t v = 0; v < versions.size(); ++v) {
+            auto& list = pkg.dependencies[versions[v]];
+            for (size_t d : deps) {
+                int major = v == hidden[i] ? (hidden[d] < 3 ? 1 : 2) : 1 + static_cast<int>(rng() % 2);
+                list.push_back(requirement(pkg_name(d), "^" + std::to_string(major) + ".0"));
+            }
+        }
+        reg.packages.emplace(pkg.name, std::move(pkg));
+    }
+    for (size_t i = 0; i < std::min<size_t>(count, 8); ++i) {
+        reg.root.push_back(requirement(pkg_name(i), versions[hidden[i]]));
+    }
+    return reg;
+}
+
+// Wide, conflict-free graph: every requirement admits the newest version
+Workload wide(double scale) {
+    size_t count = scaled(5000, scale);
+    std::mt19937 rng(7);
+    std::vector<std::string> versions = version_list(4);
+    Registry reg;
+    for (size_t i = 0; i < count; ++i) {
+        RegistryPackage pkg;
+        pkg.name = pkg_name(i);
+        pkg.versions = versions;
+        pkg.latest_version = versions.back();
+        size_t fanout = i + 1 < count ? 1 + rng() % 4 : 0;
+        for (const auto& v : versions) {
+            auto& list = pkg.dependencies[v];
+            for (size_t k = 0; k < fanout; ++k) {
+                size_t d = i + 1 + rng() % std::min<size_t>(count - i - 1, 200);
+                list.push_back(requirement(pkg_name(d), k % 2 ? "^2.0" : ">=1.1.0"));
+            }
+        }
+        reg.packages.emplace(pkg.name, std::move(pkg));
+    }
+    reg.root.push_back(requirement(pkg_name(0), "*"));
+    return {"wide", std::move(reg)};
+}
+
+// Random layered graph that needs backtracking to find the hidden solution
+Workload conflicts(double scale) {
+    return {"conflicts", layered(scaled(2000, scale), 42)};
+}
+
+// Two long chains that end in incompatible requirements on one package;
+// resolution fails and the explanation has to trace both chains
+Workload unsatisfiable(double scale) {
+    size_t length = scaled(1000, scale);
+    Registry reg;
+    auto add = [&](const std::string& name, const std::vector<std::string>& versions,
+                   const std::vector<Dependency>& deps) {
+        RegistryPackage pkg;
+        pkg.name = name;
+        pkg.versions = versions;
+        pkg.latest_version = versions.back();
+        for (const auto& v : versions) pkg.dependencies[v] = deps;
+        reg.packages.emplace(name, std::move(pkg));
+    };
+    for (const char* side : {"left", "right"}) {
+        for (size_t i = 0; i < length; ++i) {
+            std::string next = i + 1 < length ? std::string(side) + std::to_string(i + 1) : "shared";
+            std::string constraint = i + 1 < length ? "^1.0" : (side[0] == 'l' ? "^1.0" : "^2.0");
+            add(side + std::to_string(i), {"1.0.0", "1.1.0"}, {requirement(next, constraint)});
+        }
+    }
+    add("shared", {"1.0.0", "1.5.0", "2.0.0"}, {});
+    reg.root = {requirement("left0", "*"), requirement("right0", "*")};
+    reg.solvable = false;
+    return {"unsatisfiable", std::move(reg)};
+}
+
+// Every requirement in the solution is met and nothing required is missing
+bool validate(const Registry& reg, const std::vector<ResolvedDep>& solution, std::string& problem) {
+    std::map<std::string, std::string> chosen;
+    for (const auto& dep : solution) chosen[dep.name] = dep.version;
+    auto satisfied = [&](const std::vector<Dependency>& deps) {
+        for (const auto& dep : deps) {
+            auto it = chosen.find(dep.name);
+            if (it == chosen.end() || !version_matches(dep.version, it->second)) {
+                problem = dep.name + " " + dep.version + (it == chosen.end() ? " missing" : " != " + it->second);
+                return false;
+            }
+        }
+        return true;
+    };
+    if (!satisfied(reg.root)) return false;
+    for (const auto& dep : solution) {
+        if (!satisfied(reg.packages.at(dep.name).dependencies.at(dep.version))) return false;
+    }
+    return true;
+}
+
+struct Result {
+    std::string name;
+    size_t registry_packages = 0;
+    bool solved = false;
+    bool correct = true;
+    std::string problem;
+    size_t selected = 0;
+    size_t explanation_lines = 0;
+    ResolverStats stats;
+    size_t requests = 0;
+    std::vector<double> ms;
+};
+
+void run_once(const Workload& w, int latency_ms, Result& result) {
+    std::atomic<size_t> requests{0};
+    Resolver resolver([&](const std::vector<std::string>& names,
+                          std::vector<std::optional<RegistryPackage>>& out) {
+        // One round trip per batch: the real fetcher issues a batch in parallel
+        if (latency_ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(latency_ms));
+        for (size_t i = 0; i < names.size(); ++i) {
+            ++requests;
+            auto it = w.registry.packages.find(names[i]);
+            if (it != w.registry.packages.end()) out[i] = it->second;
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    bool solved = resolver.resolve("bench", w.registry.root);
+    result.ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    result.name = w.name;
+    result.registry_packages = w.registry.packages.size();
+    result.solved = solved;
+    result.stats = resolver.stats();
+    result.requests = requests;
+    result.selected = resolver.solution().size();
+    result.explanation_lines = static_cast<size_t>(std::count(resolver.error().begin(), resolver.error().end(), '\n'));
+    if (solved != w.registry.solvable) {
+        result.correct = false;
+        result.problem = solved ? "expected no solution" : "no solution found: " + resolver.error();
+    } else if (solved && !validate(w.registry, resolver.solution(), result.problem)) {
+        result.correct = false;
+    }
+}
+
+double min_of(const std::vector<double>& v) {
+    return v.empty() ? 0.0 : *std::min_element(v.begin(), v.end());
+}
+
+double median_of(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t mid = v.size() / 2;
+    return v.size() % 2 ? v[mid] : (v[mid - 1] + v[mid]) / 2.0;
+}
+
+void report(const Result& r) {
+    std::cout << r.name << " (" << r.registry_packages << " packages in the registry)\n";
+    std::cout << "  " << std::left << std::setw(14) << "resolve" << std::right << std::setw(10)
+              << std::fixed << std::setprecision(2) << min_of(r.ms) << " ms" << std::setw(10)
+              << median_of(r.ms) << " ms median\n";
+    std::cout << "  " << (r.solved ? std::to_string(r.selected) + " selected" : "no solution, " +
+                          std::to_string(r.explanation_lines) + " lines of explanation")
+              << "; " << r.requests << " requests in " << r.stats.fetch_batches << " batches; "
+              << r.stats.decisions << " decisions, " << r.stats.conflicts << " conflicts, "
+              << r.stats.learned << " learned\n";
+    if (!r.correct) std::cout << "  WRONG: " << r.problem << "\n";
+}
+
+std::string to_json(const std::vector<Result>& results, double scale, int repeat, int latency_ms) {
+    std::string out;
+    mana::json::Writer w(out);
+    w.begin_object().key("scale").value(scale).key("repeat").value(repeat)
+        .key("latency_ms").value(latency_ms).key("workloads").begin_array();
+    for (const auto& r : results) {
+        w.begin_object()
+            .key("name").value(r.name)
+            .key("registry_packages").value(static_cast<uint64_t>(r.registry_packages))
+            .key("solved").value(r.solved)
+            .key("correct").value(r.correct)
+            .key("selected").value(static_cast<uint64_t>(r.selected))
+            .key("requests").value(static_cast<uint64_t>(r.requests))
+            .key("fetch_batches").value(static_cast<uint64_t>(r.stats.fetch_batches))
+            .key("decisions").value(static_cast<uint64_t>(r.stats.decisions))
+            .key("conflicts").value(static_cast<uint64_t>(r.stats.conflicts))
+            .key("learned").value(static_cast<uint64_t>(r.stats.learned))
+            .key("min_ms").value(min_of(r.ms))
+            .key("median_ms").value(median_of(r.ms))
+            .end_object();
+    }
+    w.end_array().end_object();
+    return out + "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double scale = 1.0;
+    int repeat = 3;
+    int latency_ms = 0;
+    std::string only;
+    std::string json_path;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = std::strtod(argv[++i], nullptr);
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--latency-ms") == 0 && i + 1 < argc) {
+            latency_ms = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--scale <f>] [--repeat <n>] [--latency-ms <n>] [--only <workload>] [--json <file>]\n";
+            return 1;
+        }
+    }
+    if (scale <= 0.0) scale = 1.0;
+
+    std::vector<Workload (*)(double)> generators = {wide, conflicts, unsatisfiable};
+
+    std::cout << "Mana resolver benchmarks (scale " << scale << ", best of " << repeat;
+    if (latency_ms > 0) std::cout << ", " << latency_ms << " ms per fetch batch";
+    std::cout << ")\n\n";
+
+    std::vector<Result> results;
+    bool correct = true;
+    for (auto generate : generators) {
+        Workload w = generate(scale);
+        if (!only.empty() && w.name != only) continue;
+        Result r;
+        for (int i = 0; i < repeat; ++i) run_once(w, latency_ms, r);
+        report(r);
+        std::cout << "\n";
+        if (!r.correct) correct = false;
+        results.push_back(std::move(r));
+    }
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        if (!out) {
+            std::cerr << "error: cannot write " << json_path << "\n";
+            return 1;
+        }
+        out << to_json(results, scale, repeat, latency_ms);
+    }
+    return correct ? 0 : 1;
+}
@@ -0,0 +1,346 @@
+// Micro-benchmarks for the header-only C++ runtime (backend-cpp/mana_runtime.h).
+// Build: cmake --build build --target mana_runtime_bench
+// Usage: mana_runtime_bench [--iterations <n>]
+#include "mana_runtime.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// Keeps the optimizer from discarding benchmark results
+volatile uint64_t g_sink = 0;
+
+template <typename F>
+double ns_per_op(size_t ops, F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ops);
+}
+
+void report(const std::string& name, double ns) {
+    std::cout << "  " << std::left << std::setw(36) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(3) << ns << " ns/op"
+              << std::setw(12) << std::setprecision(1) << (1000.0 / ns) << " M/s\n";
+}
+
+void bench_random(size_t n) {
+    std::cout << "random (" << n << " samples)\n";
+
+    report("std::rand() % range", ns_per_op(n, [&] {
+        std::srand(42);
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; ++i) acc += 1 + std::rand() % 100;
+        g_sink = acc;
+    }));
+
+    report("mana::random_int (thread_rng)", ns_per_op(n, [&] {
+        mana::seed_random(42);
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; ++i) acc += static_cast<uint64_t>(mana::random_int(1, 100));
+        g_sink = acc;
+    }));
+
+    report("Rng::next_int", ns_per_op(n, [&] {
+        mana::Rng rng(42);
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; ++i) acc += static_cast<uint64_t>(rng.next_int(1, 100));
+        g_sink = acc;
+    }));
+
+    report("Rng::next_float", ns_per_op(n, [&] {
+        mana::Rng rng(42);
+        float acc = 0.0f;
+        for (size_t i = 0; i < n; ++i) acc += rng.next_float();
+        g_sink = static_cast<uint64_t>(acc);
+    }));
+
+    mana::Vec<float> buffer(n, 0.0f);
+    report("Rng::fill (bulk floats)", ns_per_op(n, [&] {
+        mana::Rng rng(42);
+        rng.fill(buffer);
+        g_sink = static_cast<uint64_t>(buffer[n / 2] * 1000.0f);
+    }));
+}
+
+// Reference scalar kernel (the triple loop examples/graphics used before Mat4)
+void scalar_mat4_multiply(float* result, const float* a, const float* b) {
+    float temp[16];
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            temp[col * 4 + row] = 0.0f;
+            for (int k = 0; k < 4; k++) temp[col * 4 + row] += a[k * 4 + row] * b[col * 4 + k];
+        }
+    }
+    for (int i = 0; i < 16; i++) result[i] = temp[i];
+}
+
+void bench_vector_math(size_t n) {
+    std::cout << "vector math (" << n << " ops)\n";
+
+    const mana::Mat4 step = mana::rotate_y(0.001f) * mana::translate(mana::Vec3(0.01f, 0.0f, 0.0f));
+
+    report("scalar mat4 multiply (triple loop)", ns_per_op(n, [&] {
+        mana::Mat4 acc = mana::Mat4::identity();
+        for (size_t i = 0; i < n; ++i) scalar_mat4_multiply(acc.m, acc.m, step.m);
+        g_sink = static_cast<uint64_t>(acc.m[12] * 1000.0f);
+    }));
+
+    report("Mat4 * Mat4", ns_per_op(n, [&] {
+        mana::Mat4 acc = mana::Mat4::identity();
+        for (size_t i = 0; i < n; ++i) acc = acc * step;
+        g_sink = static_cast<uint64_t>(acc.m[12] * 1000.0f);
+    }));
+
+    report("Mat4 * Vec4", ns_per_op(n, [&] {
+        mana::Vec4 v(1.0f, 2.0f, 3.0f, 1.0f);
+        for (size_t i = 0; i < n; ++i) v = step * v;
+        g_sink = static_cast<uint64_t>(v.x * 1000.0f);
+    }));
+
+    report("Quat * Quat", ns_per_op(n, [&] {
+        const mana::Quat dq = mana::Quat::from_axis_angle(mana::Vec3::up(), 0.001f);
+        mana::Quat q;
+        for (size_t i = 0; i < n; ++i) q = q * dq;
+        g_sink = static_cast<uint64_t>(q.w * 1000.0f);
+    }));
+
+    // Batch transforms over a vertex-buffer sized array
+    const size_t count = 4096;
+    const size_t rounds = n / count > 0 ? n / count : 1;
+    mana::Vec<mana::Vec3> points(count, mana::Vec3(1.0f, 2.0f, 3.0f));
+    mana::Vec<mana::Vec3> out3(count, mana::Vec3());
+    mana::Vec<mana::Vec4> vecs(count, mana::Vec4(1.0f, 2.0f, 3.0f, 1.0f));
+    mana::Vec<mana::Vec4> out4(count, mana::Vec4());
+
+    report("transform_point (per element)", ns_per_op(rounds * count, [&] {
+        for (size_t r = 0; r < rounds; ++r)
+            for (size_t i = 0; i < count; ++i) out3[i] = step.transform_point(points[i]);
+        g_sink = static_cast<uint64_t>(out3[count / 2].x * 1000.0f);
+    }));
+
+    report("transform_points (batch)", ns_per_op(rounds * count, [&] {
+        for (size_t r = 0; r < rounds; ++r)
+            mana::transform_points(step, points.begin(), out3.begin(), count);
+        g_sink = static_cast<uint64_t>(out3[count / 2].x * 1000.0f);
+    }));
+
+    report("transform_vec4s (batch)", ns_per_op(rounds * count, [&] {
+        for (size_t r = 0; r < rounds; ++r)
+            mana::transform_vec4s(step, vecs.begin(), out4.begin(), count);
+        g_sink = static_cast<uint64_t>(out4[count / 2].x * 1000.0f);
+    }));
+}
+
+void bench_batch_math(size_t n) {
+    std::cout << "batch math (" << n << " elements)\n";
+
+    // L1-resident arrays, reused across rounds
+    const size_t count = 4096;
+    const size_t rounds = n / count > 0 ? n / count : 1;
+    const size_t ops = rounds * count;
+    mana::Vec<float> xs(count, 0.0f);
+    mana::Vec<float> ys(count, 0.0f);
+    mana::Vec<float> out(count, 0.0f);
+    for (size_t i = 0; i < count; ++i) {
+        xs[i] = -10.0f + 20.0f * static_cast<float>(i) / static_cast<float>(count);
+        ys[i] = 0.5f + static_cast<float>(i % 97);
+    }
+
+    report("std::sin loop", ns_per_op(ops, [&] {
+        for (size_t r = 0; r < rounds; ++r)
+            for (size_t i = 0; i < count; ++i) out[i] = std::sin(xs[i]);
+        g_sink = static_cast<uint64_t>(out[count / 3] * 1000.0f);
+    }));
+    report("sin_all", ns_per_op(ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) mana::sin_all(xs.begin(), out.begin(), count);
+        g_sink = static_cast<uint64_t>(out[count / 3] * 1000.0f);
+    }));
+
+    report("std::exp loop", ns_per_op(ops, [&] {
+        for (size_t r = 0; r < rounds; ++r)
+            for (size_t i = 0; i < count; ++i) out[i] = std::exp(xs[i]);
+        g_sink = static_cast<uint64_t>(out[count / 3] * 1000.0f);
+    }));
+    report("exp_all", ns_per_op(ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) mana::exp_all(xs.begin(), out.begin(), count);
+        g_sink = static_cast<uint64_t>(out[count / 3] * 1000.0f);
+    }));
+
+    report("std::log loop", ns_per_op(ops, [&] {
+        for (size_t r = 0; r < rounds; ++r)
+            for (size_t i = 0; i < count; ++i) out[i] = std::log(ys[i]);
+        g_sink = static_cast<uint64_t>(out[count / 3] * 1000.0f);
+    }));
+    report("log_all", ns_per_op(ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) mana::log_all(ys.begin(), out.begin(), count);
+        g_sink = static_cast<uint64_t>(out[count / 3] * 1000.0f);
+    }));
+
+    report("sum loop", ns_per_op(ops, [&] {
+        float acc = 0.0f;
+        for (size_t r = 0; r < rounds; ++r)
+            for (size_t i = 0; i < count; ++i) acc += ys[i];
+        g_sink = static_cast<uint64_t>(acc);
+    }));
+    report("sum", ns_per_op(ops, [&] {
+        float acc = 0.0f;
+        for (size_t r = 0; r < rounds; ++r) {
+            ys[0] = static_cast<float>(r);  // defeat hoisting the pure call
+            acc += mana::sum(ys);
+        }
+        g_sink = static_cast<uint64_t>(acc);
+    }));
+
+    report("dot loop", ns_per_op(ops, [&] {
+        float acc = 0.0f;
+        for (size_t r = 0; r < rounds; ++r)
+            for (size_t i = 0; i < count; ++i) acc += xs[i] * ys[i];
+        g_sink = static_cast<uint64_t>(acc);
+    }));
+    report("dot", ns_per_op(ops, [&] {
+        float acc = 0.0f;
+        for (size_t r = 0; r < rounds; ++r) {
+            ys[0] = static_cast<float>(r);  // defeat hoisting the pure call
+            acc += mana::dot(xs, ys);
+        }
+        g_sink = static_cast<uint64_t>(acc);
+    }));
+
+    report("axpy", ns_per_op(ops, [&] {
+        for (size_t r = 0; r < rounds; ++r) mana::axpy(1e-6f, xs, out);
+        g_sink = static_cast<uint64_t>(out[count / 3] * 1000.0f);
+    }));
+
+    report("max_all", ns_per_op(ops, [&] {
+        float acc = 0.0f;
+        for (size_t r = 0; r < rounds; ++r) {
+            ys[0] = static_cast<float>(r);  // defeat hoisting the pure call
+            acc += mana::max_all(ys);
+        }
+        g_sink = static_cast<uint64_t>(acc);
+    }));
+}
+
+// Per-request pattern: a handful of short-lived vectors and strings, then drop everything
+void bench_arena(size_t n) {
+    const size_t requests = n / 100 > 0 ? n / 100 : 1;
+    std::cout << "arena (" << requests << " requests x 8 vectors + 8 strings)\n";
+
+    report("heap Vec<i32> + std::string", ns_per_op(requests, [&] {
+        uint64_t acc = 0;
+        for (size_t r = 0; r < requests; ++r) {
+            for (int k = 0; k < 8; ++k) {
+                mana::Vec<int32_t> v;
+                for (int i = 0; i < 16; ++i) v.push(i + k);
+                std::string s = "request-";
+                s += std::to_string(r);
+                acc += v.len() + s.size();
+            }
+        }
+        g_sink = acc;
+    }));
+
+    report("Arena ArenaVec<i32> + ArenaString", ns_per_op(requests, [&] {
+        mana::Arena arena(64 * 1024);
+        uint64_t acc = 0;
+        for (size_t r = 0; r < requests; ++r) {
+            for (int k = 0; k < 8; ++k) {
+                mana::ArenaVec<int32_t> v = arena.vec();
+                for (int i = 0; i < 16; ++i) v.push(i + k);
+                mana::ArenaString s = arena.string("request-");
+                s.push_str(std::to_string(r));
+                acc += v.len() + s.len();
+            }
+            arena.reset();
+        }
+        g_sink = acc;
+    }));
+}
+
+// The --allocator backends called directly, since a benchmark binary can only
+// replace operator new once. Each op is one allocation and one free of a mixed size.
+void bench_allocator(size_t n) {
+    std::cout << "global allocators (" << n << " alloc/free pairs, 16-2048 bytes, 64 live)\n";
+
+    constexpr size_t live = 64;
+    auto size_of = [](size_t i) { return 16 + (i * 2654435761u) % 2033; };
+
+    report("std::malloc / std::free", ns_per_op(n, [&] {
+        void* slots[live] = {};
+        for (size_t i = 0; i < n; ++i) {
+            size_t k = i % live;
+            std::free(slots[k]);
+            slots[k] = std::malloc(size_of(i));
+        }
+        for (void* p : slots) std::free(p);
+        g_sink = n;
+    }));
+
+    // Bump never frees, so its cost is mostly first-touch page faults; keep it bounded
+    const size_t rounds = n < 200'000 ? n : 200'000;
+    report("bump (--allocator=bump, fresh memory)", ns_per_op(rounds, [&] {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < rounds; ++i) {
+            void* p = mana::alloc_detail::bump_alloc(size_of(i), 16);
+            acc += mana::alloc_detail::bump_free(p);
+        }
+        g_sink = acc;
+    }));
+
+    report("size classes (mimalloc-style)", ns_per_op(n, [&] {
+        void* slots[live] = {};
+        size_t usable = 0;
+        for (size_t i = 0; i < n; ++i) {
+            size_t k = i % live;
+            if (slots[k]) mana::alloc_detail::class_free(slots[k]);
+            slots[k] = mana::alloc_detail::class_alloc(size_of(i), 16, usable);
+        }
+        for (void* p : slots) {
+            if (p) mana::alloc_detail::class_free(p);
+        }
+        g_sink = usable;
+    }));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = 10'000'000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--iterations <n>]\n";
+            return 1;
+        }
+    }
+    if (iterations == 0) iterations = 1;
+
+    std::cout << "Mana runtime benchmarks";
+#if defined(__AVX2__) && defined(__FMA__)
+    std::cout << " (AVX2+FMA)";
+#elif defined(__AVX2__)
+    std::cout << " (AVX2)";
+#elif defined(__AVX__)
+    std::cout << " (AVX)";
+#elif MANA_SIMD_SSE
+    std::cout << " (SSE)";
+#endif
+    std::cout << "\n\n";
+
+    bench_random(iterations);
+    std::cout << "\n";
+    bench_vector_math(iterations);
+    std::cout << "\n";
+    bench_batch_math(iterations);
+    std::cout << "\n";
+    bench_arena(iterations);
+    std::cout << "\n";
+    bench_allocator(iterations);
+    return 0;
+}
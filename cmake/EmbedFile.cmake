@@ -0,0 +1,27 @@
+# Writes INPUT to OUTPUT as a NUL-terminated char array named NAME, so a file
+# can be compiled into an executable from its one copy in the source tree.
+#
+#   cmake -DINPUT=<file> -DOUTPUT=<header> -DNAME=<identifier> -P EmbedFile.cmake
+#
+# A byte array rather than a raw string literal: MSVC caps string literals
+# at 64 KiB, and the text may contain any delimiter.
+
+file(READ "${INPUT}" content HEX)
+
+# 16 bytes per line
+set(line_pattern "")
+foreach(i RANGE 1 32)
+    string(APPEND line_pattern "[0-9a-f]")
+endforeach()
+string(REGEX REPLACE "(${line_pattern})" "\\1\n" content "${content}")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," content "${content}")
+
+get_filename_component(input_name "${INPUT}" NAME)
+file(WRITE "${OUTPUT}.tmp"
+    "// Generated from ${input_name} by cmake/EmbedFile.cmake; do not edit\n"
+    "#pragma once\n\n"
+    "static const char ${NAME}[] = {\n${content}0x00\n};\n")
+
+# Only touch OUTPUT when it changed, so dependents are not rebuilt needlessly
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
@@ -3,6 +3,7 @@
 #include <sstream>
 #include <cstdlib>
 #include <filesystem>
+#include <algorithm>
 #include <unordered_set>
 
 #include "../frontend/Lexer.h"
@@ -10,6 +11,7 @@
 #include "../frontend/Semantic.h"
 #include "../frontend/AstPrinter.h"
 #include "../frontend/AstDeclarations.h"
+#include "../frontend/Imports.h"
 #include "../backend-cpp/CppEmitter.h"
 #include "../backend-cpp/DocGenerator.h"
 #include "../frontend/Cache.h"
@@ -17,537 +19,131 @@
 #include "../middle/DeadCodeElimination.h"
 #include "../middle/Inlining.h"
 #include "../tools/fmt/Formatter.h"
+#include "../tools/fmt/FormatRunner.h"
+#include "../tools/lint/Linter.h"
+#include "../tools/doc/DocRunner.h"
 #include "../tools/repl/Repl.h"
 #include "../tools/pkg/PackageManager.h"
 #include "../tools/test/TestRunner.h"
+#include "../tools/test/BenchRunner.h"
+// MANA_RUNTIME_H: backend-cpp/mana_runtime.h, embedded at build time
+#include "mana_runtime_embedded.h"
 
 using namespace mana::frontend;
 using namespace mana::backend;
 namespace fs = std::filesystem;
 
-// Forward declaration for recursive import resolution
-static bool resolve_imports(AstModule* module, const fs::path& base_dir,
-                           DiagnosticEngine& diag,
-                           std::unordered_set<std::string>& imported_files);
-
-static std::unique_ptr<AstModule> parse_file(const std::string& filepath, DiagnosticEngine& diag) {
-    std::ifstream in(filepath);
+// Breakpoints for --breakpoints, as mana-debug writes them: one per line,
+// tab-separated id, file, line, hit condition and condition (a Mana
+// expression). One whose condition does not parse is skipped with a
+// warning, and check_breakpoint_conditions() drops those that do not
+// type-check.
+static bool load_breakpoints(const std::string& path, std::vector<CppEmitter::Breakpoint>& breakpoints,
+                             std::vector<std::unique_ptr<AstExpr>>& conditions) {
+    std::ifstream in(path);
     if (!in) {
-        diag.error("cannot open imported file: " + filepath, 0, 0);
-        return nullptr;
-    }
-    std::stringstream buffer;
-    buffer << in.rdbuf();
-    std::string source = buffer.str();
-
-    Lexer lex(source);
-    auto tokens = lex.tokenize();
-
-    Parser parser(tokens, diag);
-    return parser.parse_module();
-}
-
-static bool resolve_imports(AstModule* module, const fs::path& base_dir,
-                           DiagnosticEngine& diag,
-                           std::unordered_set<std::string>& imported_files) {
-    std::vector<std::unique_ptr<AstDecl>> imported_decls;
-
-    for (auto& decl : module->decls) {
-        if (auto* imp = dynamic_cast<AstImportDecl*>(decl.get())) {
-            if (imp->is_file_import) {
-                // Resolve file path relative to current file
-                fs::path import_path = base_dir / (imp->path + ".mana");
-                std::string canonical = fs::weakly_canonical(import_path).string();
-
-                // Skip if already imported (avoid circular imports)
-                if (imported_files.count(canonical)) continue;
-                imported_files.insert(canonical);
-
-                // Parse the imported file
-                auto imported_module = parse_file(canonical, diag);
-                if (!imported_module || diag.has_errors()) {
-                    return false;
-                }
-
-                // Recursively resolve imports in the imported file
-                if (!resolve_imports(imported_module.get(), import_path.parent_path(), diag, imported_files)) {
-                    return false;
-                }
-
-                // Import all declarations (both public and private)
-                // Visibility is enforced at semantic analysis, not import time
-                // This allows public functions to call private helpers
-                std::string module_name = imported_module->name.empty() ? canonical : imported_module->name;
-                for (auto& imported_decl : imported_module->decls) {
-                    // Don't re-import import or use declarations
-                    if (dynamic_cast<AstImportDecl*>(imported_decl.get())) continue;
-                    if (dynamic_cast<AstUseDecl*>(imported_decl.get())) continue;
-
-                    // Track source module for all imported declarations
-                    imported_decl->source_module = module_name;
-                    imported_decls.push_back(std::move(imported_decl));
-                }
+        std::cerr << "error: cannot open breakpoints file: " << path << "\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while (fields.size() < 4) {
+            size_t tab = line.find('\t', start);
+            if (tab == std::string::npos) break;
+            fields.push_back(line.substr(start, tab - start));
+            start = tab + 1;
+        }
+        fields.push_back(line.substr(start));  // The condition may hold tabs
+        if (fields.size() < 3) continue;
+
+        CppEmitter::Breakpoint bp;
+        bp.id = std::atoi(fields[0].c_str());
+        bp.file = fs::weakly_canonical(fields[1]).string();
+        bp.line = std::atoi(fields[2].c_str());
+        if (bp.id <= 0 || bp.line <= 0) continue;
+        std::string where = "breakpoint " + fields[0] + " (" + fields[1] + ":" + fields[2] + ")";
+        if (fields.size() > 3 && !CppEmitter::parse_hit_condition(fields[3], bp.hit_op, bp.hit_count)) {
+            std::cerr << "warning: " << where << ": invalid hit condition '" << fields[3] << "', skipped\n";
+            continue;
+        }
+        if (fields.size() > 4 && fields[4].find_first_not_of(" \t") != std::string::npos) {
+            DiagnosticEngine diag;
+            diag.set_source("<condition>", fields[4]);
+            Lexer lex(fields[4]);
+            auto tokens = lex.tokenize();
+            Parser parser(tokens, diag);
+            auto condition = parser.parse_standalone_expression();
+            if (!condition || diag.has_errors()) {
+                std::cerr << "warning: " << where << ": invalid condition '" << fields[4] << "', skipped\n";
+                continue;
             }
-            // Standard library imports handled separately
+            bp.condition = condition.get();
+            conditions.push_back(std::move(condition));
         }
+        breakpoints.push_back(std::move(bp));
     }
-
-    // Add imported declarations to the beginning of the module (in correct order)
-    // We need to insert them in order, so insert from the end to the beginning
-    for (auto it = imported_decls.rbegin(); it != imported_decls.rend(); ++it) {
-        module->decls.insert(module->decls.begin(), std::move(*it));
-    }
-
     return true;
 }
 
-// Embedded runtime header content
-static const char* MANA_RUNTIME_H = R"(#pragma once
-#include <utility>
-#include <cstdio>
-#include <cstdint>
-#include <string>
-#include <stdexcept>
-#include <vector>
-#include <iostream>
-#include <cctype>
-
-namespace mana {
-    template <typename F>
-    struct Defer {
-        F fn;
-        explicit Defer(F f) : fn(std::move(f)) {}
-        ~Defer() { fn(); }
-        Defer(const Defer&) = delete;
-        Defer& operator=(const Defer&) = delete;
-    };
-
-    template <typename F>
-    Defer<F> defer(F f) { return Defer<F>(std::move(f)); }
-
-    template <typename T>
-    inline void drop(T&) {}
-
-    // Forward declaration for None
-    struct None_t {};
-    inline constexpr None_t None{};
-
-    // Option<T> - represents an optional value
-    template <typename T>
-    class Option {
-        bool has_value_;
-        alignas(T) unsigned char storage_[sizeof(T)];
-
-        T* ptr() { return reinterpret_cast<T*>(storage_); }
-        const T* ptr() const { return reinterpret_cast<const T*>(storage_); }
-
-    public:
-        Option() : has_value_(false) {}
-        Option(None_t) : has_value_(false) {}  // Allow implicit conversion from None
-        Option(T value) : has_value_(true) { new (storage_) T(std::move(value)); }
-        Option(const Option& other) : has_value_(other.has_value_) {
-            if (has_value_) new (storage_) T(*other.ptr());
-        }
-        Option(Option&& other) noexcept : has_value_(other.has_value_) {
-            if (has_value_) { new (storage_) T(std::move(*other.ptr())); other.has_value_ = false; }
-        }
-        ~Option() { if (has_value_) ptr()->~T(); }
-
-        Option& operator=(const Option& other) {
-            if (this != &other) {
-                if (has_value_) ptr()->~T();
-                has_value_ = other.has_value_;
-                if (has_value_) new (storage_) T(*other.ptr());
-            }
-            return *this;
-        }
-        Option& operator=(Option&& other) noexcept {
-            if (this != &other) {
-                if (has_value_) ptr()->~T();
-                has_value_ = other.has_value_;
-                if (has_value_) { new (storage_) T(std::move(*other.ptr())); other.has_value_ = false; }
-            }
-            return *this;
-        }
+// Drops breakpoints whose condition does not type-check where it runs, as
+// bound by CppEmitter::bind_breakpoints(). Conditions pair with the
+// breakpoints that have one, in order. The bound lines are only known once
+// the lowered module has been laid out, so the source is parsed and analyzed
+// again, each condition checked in the scope of its line.
+static void check_breakpoint_conditions(std::vector<CppEmitter::Breakpoint>& breakpoints,
+                                        const std::vector<std::unique_ptr<AstExpr>>& conditions,
+                                        const std::string& source, const fs::path& input_path) {
+    std::string main_file = fs::weakly_canonical(input_path).string();
+    std::vector<SemanticAnalyzer::ScopedCondition> checks;
+    size_t next = 0;
+    for (const auto& bp : breakpoints) {
+        if (!bp.condition) continue;
+        SemanticAnalyzer::ScopedCondition check;
+        check.file = bp.file;
+        check.line = bp.line;
+        check.expr = conditions[next++].get();
+        check.checked = bp.line <= 0;  // Unbound: never emitted
+        checks.push_back(std::move(check));
+    }
+    if (checks.empty()) return;
 
-        bool is_some() const { return has_value_; }
-        bool is_none() const { return !has_value_; }
-        explicit operator bool() const { return has_value_; }
-
-        T& unwrap() {
-            if (!has_value_) throw std::runtime_error("unwrap called on None");
-            return *ptr();
-        }
-        const T& unwrap() const {
-            if (!has_value_) throw std::runtime_error("unwrap called on None");
-            return *ptr();
-        }
-        T unwrap_or(T default_val) const {
-            return has_value_ ? *ptr() : default_val;
-        }
-
-        // For ? operator support
-        bool __is_err() const { return !has_value_; }
-        T __unwrap_ok() { return std::move(*ptr()); }
-    };
-
-    // Wrapper for Some to enable implicit conversion to Option<T>
-    template <typename T>
-    struct SomeWrapper {
-        T value;
-        explicit SomeWrapper(T v) : value(std::move(v)) {}
-        operator Option<T>() const { return Option<T>(value); }
-    };
-
-    template <typename T>
-    SomeWrapper<T> Some(T value) { return SomeWrapper<T>(std::move(value)); }
-
-    template <typename T>
-    Option<T> make_none() { return Option<T>(); }
-
-    // Result<T, E> - represents either success (Ok) or failure (Err)
-    template <typename T, typename E = std::string>
-    class Result {
-        bool is_ok_;
-        union {
-            T ok_value_;
-            E err_value_;
-        };
-
-    public:
-        Result(const Result& other) : is_ok_(other.is_ok_) {
-            if (is_ok_) new (&ok_value_) T(other.ok_value_);
-            else new (&err_value_) E(other.err_value_);
-        }
-        Result(Result&& other) noexcept : is_ok_(other.is_ok_) {
-            if (is_ok_) new (&ok_value_) T(std::move(other.ok_value_));
-            else new (&err_value_) E(std::move(other.err_value_));
-        }
-        ~Result() {
-            if (is_ok_) ok_value_.~T();
-            else err_value_.~E();
-        }
-
-        Result& operator=(const Result& other) {
-            if (this != &other) {
-                this->~Result();
-                is_ok_ = other.is_ok_;
-                if (is_ok_) new (&ok_value_) T(other.ok_value_);
-                else new (&err_value_) E(other.err_value_);
-            }
-            return *this;
-        }
-
-        // Factory functions
-        static Result Ok(T value) {
-            Result r;
-            r.is_ok_ = true;
-            new (&r.ok_value_) T(std::move(value));
-            return r;
-        }
-        static Result Err(E error) {
-            Result r;
-            r.is_ok_ = false;
-            new (&r.err_value_) E(std::move(error));
-            return r;
-        }
-
-        bool is_ok() const { return is_ok_; }
-        bool is_err() const { return !is_ok_; }
-        explicit operator bool() const { return is_ok_; }
-
-        T& unwrap() {
-            if (!is_ok_) throw std::runtime_error("unwrap called on Err");
-            return ok_value_;
-        }
-        const T& unwrap() const {
-            if (!is_ok_) throw std::runtime_error("unwrap called on Err");
-            return ok_value_;
-        }
-        T unwrap_or(T default_val) const {
-            return is_ok_ ? ok_value_ : default_val;
-        }
-        E& unwrap_err() {
-            if (is_ok_) throw std::runtime_error("unwrap_err called on Ok");
-            return err_value_;
-        }
+    DiagnosticEngine diag;
+    Lexer lex(source);
+    auto tokens = lex.tokenize();
+    Parser parser(tokens, diag);
+    auto module = parser.parse_module();
+    std::unordered_set<std::string> imported_files = {main_file};
+    if (!module || !splice_file_imports(module.get(), input_path.parent_path(), diag, imported_files)) return;
+    SemanticAnalyzer sema(diag);
+    sema.set_scoped_conditions(&checks, main_file);
+    sema.analyze(module.get());
 
-        // For ? operator support
-        bool __is_err() const { return !is_ok_; }
-        T __unwrap_ok() { return std::move(ok_value_); }
-        E __unwrap_err() { return std::move(err_value_); }
-
-    private:
-        Result() {}
-    };
-
-    // Wrapper types for Ok and Err to enable implicit conversion to Result<T, E>
-    template <typename T>
-    struct OkWrapper {
-        T value;
-        explicit OkWrapper(T v) : value(std::move(v)) {}
-        template <typename E>
-        operator Result<T, E>() const { return Result<T, E>::Ok(value); }
-    };
-
-    template <typename E>
-    struct ErrWrapper {
-        E value;
-        explicit ErrWrapper(E v) : value(std::move(v)) {}
-        template <typename T>
-        operator Result<T, E>() const { return Result<T, E>::Err(value); }
-    };
-
-    // Specialization for const char* to allow conversion to Result<T, std::string>
-    template <>
-    struct ErrWrapper<const char*> {
-        const char* value;
-        explicit ErrWrapper(const char* v) : value(v) {}
-        template <typename T>
-        operator Result<T, std::string>() const { return Result<T, std::string>::Err(std::string(value)); }
-    };
-
-    template <typename T>
-    OkWrapper<T> Ok(T value) { return OkWrapper<T>(std::move(value)); }
-
-    template <typename E>
-    ErrWrapper<E> Err(E error) { return ErrWrapper<E>(std::move(error)); }
-
-    inline void print(int32_t v) { std::printf("%d", v); }
-    inline void print(int64_t v) { std::printf("%lld", (long long)v); }
-    inline void print(size_t v) { std::printf("%zu", v); }
-    inline void print(float v) { std::printf("%g", v); }
-    inline void print(bool v) { std::printf("%s", v ? "true" : "false"); }
-    inline void print(const char* v) { std::printf("%s", v); }
-    inline void print(const std::string& v) { std::printf("%s", v.c_str()); }
-
-    inline void println() { std::printf("\n"); }
-    inline void println(int32_t v) { std::printf("%d\n", v); }
-    inline void println(int64_t v) { std::printf("%lld\n", (long long)v); }
-    inline void println(size_t v) { std::printf("%zu\n", v); }
-    inline void println(float v) { std::printf("%g\n", v); }
-    inline void println(double v) { std::printf("%g\n", v); }
-    inline void println(bool v) { std::printf("%s\n", v ? "true" : "false"); }
-    inline void println(const char* v) { std::printf("%s\n", v); }
-    inline void println(const std::string& v) { std::printf("%s\n", v.c_str()); }
-
-    // Range type for iteration
-    template <typename T>
-    struct Range {
-        T start;
-        T end_;
-        bool inclusive;
-
-        struct Iterator {
-            T current;
-            T end_;
-            bool inclusive;
-
-            Iterator(T c, T e, bool inc) : current(c), end_(e), inclusive(inc) {}
-
-            T operator*() const { return current; }
-            Iterator& operator++() { ++current; return *this; }
-            bool operator!=(const Iterator& other) const {
-                if (inclusive) return current <= other.end_;
-                return current < other.end_;
+    std::vector<CppEmitter::Breakpoint> kept;
+    next = 0;
+    for (auto& bp : breakpoints) {
+        const Diagnostic* error = nullptr;
+        if (bp.condition) {
+            for (const auto& d : checks[next].errors) {
+                if (d.kind == DiagKind::Error) {
+                    error = &d;
+                    break;
+                }
             }
-        };
-
-        Iterator begin() const { return Iterator(start, end_, inclusive); }
-        Iterator end() const { return Iterator(inclusive ? end_ + 1 : end_, end_, inclusive); }
-    };
-
-    // ========== Standard Library ==========
-
-    // Vec<T> - Dynamic array type
-    template <typename T>
-    class Vec {
-        std::vector<T> data_;
-    public:
-        Vec() = default;
-        Vec(std::initializer_list<T> init) : data_(init) {}
-        Vec(size_t count, const T& value) : data_(count, value) {}
-
-        void push(T value) { data_.push_back(std::move(value)); }
-        Option<T> pop() {
-            if (data_.empty()) return Option<T>();
-            T val = std::move(data_.back());
-            data_.pop_back();
-            return Option<T>(std::move(val));
-        }
-
-        T& operator[](size_t index) { return data_[index]; }
-        const T& operator[](size_t index) const { return data_[index]; }
-
-        T& at(size_t index) {
-            if (index >= data_.size()) throw std::runtime_error("index out of bounds");
-            return data_[index];
+            next++;
         }
-
-        size_t len() const { return data_.size(); }
-        bool is_empty() const { return data_.empty(); }
-        void clear() { data_.clear(); }
-        void reserve(size_t cap) { data_.reserve(cap); }
-
-        T* begin() { return data_.data(); }
-        T* end() { return data_.data() + data_.size(); }
-        const T* begin() const { return data_.data(); }
-        const T* end() const { return data_.data() + data_.size(); }
-    };
-
-    // String functions
-    inline size_t len(const std::string& s) { return s.size(); }
-    inline bool is_empty(const std::string& s) { return s.empty(); }
-
-    inline std::string to_string(int32_t v) { return std::to_string(v); }
-    inline std::string to_string(int64_t v) { return std::to_string(v); }
-    inline std::string to_string(size_t v) { return std::to_string(v); }
-    inline std::string to_string(float v) { return std::to_string(v); }
-    inline std::string to_string(double v) { return std::to_string(v); }
-    inline std::string to_string(bool v) { return v ? "true" : "false"; }
-    inline std::string to_string(const std::string& v) { return v; }
-
-    inline bool starts_with(const std::string& s, const std::string& prefix) {
-        if (prefix.size() > s.size()) return false;
-        return s.compare(0, prefix.size(), prefix) == 0;
-    }
-
-    inline bool ends_with(const std::string& s, const std::string& suffix) {
-        if (suffix.size() > s.size()) return false;
-        return s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
-    }
-
-    inline bool contains(const std::string& s, const std::string& sub) {
-        return s.find(sub) != std::string::npos;
-    }
-
-    inline std::string trim(const std::string& s) {
-        size_t start = 0;
-        while (start < s.size() && std::isspace(s[start])) start++;
-        size_t end = s.size();
-        while (end > start && std::isspace(s[end - 1])) end--;
-        return s.substr(start, end - start);
-    }
-
-    inline std::string substr(const std::string& s, size_t start, size_t len) {
-        return s.substr(start, len);
-    }
-
-    inline std::string replace(const std::string& s, const std::string& old_str, const std::string& new_str) {
-        std::string result = s;
-        size_t pos = 0;
-        while ((pos = result.find(old_str, pos)) != std::string::npos) {
-            result.replace(pos, old_str.length(), new_str);
-            pos += new_str.length();
-        }
-        return result;
-    }
-
-    inline std::string to_uppercase(const std::string& s) {
-        std::string result = s;
-        for (char& c : result) {
-            c = std::toupper(static_cast<unsigned char>(c));
-        }
-        return result;
-    }
-
-    inline std::string to_lowercase(const std::string& s) {
-        std::string result = s;
-        for (char& c : result) {
-            c = std::tolower(static_cast<unsigned char>(c));
-        }
-        return result;
-    }
-
-    inline Vec<std::string> split(const std::string& s, const std::string& delimiter) {
-        Vec<std::string> result;
-        if (delimiter.empty()) {
-            result.push(s);
-            return result;
-        }
-        size_t start = 0;
-        size_t end = s.find(delimiter);
-        while (end != std::string::npos) {
-            result.push(s.substr(start, end - start));
-            start = end + delimiter.length();
-            end = s.find(delimiter, start);
+        if (error) {
+            std::cerr << "warning: breakpoint " << bp.id << " (" << bp.file << ":" << bp.line
+                      << "): invalid condition: " << error->message << ", skipped\n";
+            continue;
         }
-        result.push(s.substr(start));
-        return result;
-    }
-
-    inline std::string join(const Vec<std::string>& vec, const std::string& delimiter) {
-        std::string result;
-        bool first = true;
-        for (size_t i = 0; i < vec.len(); ++i) {
-            if (!first) result += delimiter;
-            result += vec[i];
-            first = false;
-        }
-        return result;
-    }
-
-    inline std::string repeat(const std::string& s, size_t count) {
-        std::string result;
-        result.reserve(s.size() * count);
-        for (size_t i = 0; i < count; ++i) {
-            result += s;
-        }
-        return result;
-    }
-
-    inline std::string reverse(const std::string& s) {
-        return std::string(s.rbegin(), s.rend());
-    }
-
-    // Math functions
-    template <typename T>
-    inline T abs(T x) { return x < 0 ? -x : x; }
-
-    template <typename T>
-    inline T min(T a, T b) { return a < b ? a : b; }
-
-    template <typename T>
-    inline T max(T a, T b) { return a > b ? a : b; }
-
-    template <typename T>
-    inline T clamp(T x, T lo, T hi) { return x < lo ? lo : (x > hi ? hi : x); }
-
-    // I/O functions
-    inline std::string read_line() {
-        std::string line;
-        std::getline(std::cin, line);
-        return line;
-    }
-
-    inline Option<int32_t> parse_int(const std::string& s) {
-        try {
-            size_t pos;
-            int32_t result = std::stoi(s, &pos);
-            if (pos == s.size()) return Option<int32_t>(result);
-            return Option<int32_t>();
-        } catch (...) {
-            return Option<int32_t>();
-        }
-    }
-
-    inline Option<float> parse_float(const std::string& s) {
-        try {
-            size_t pos;
-            float result = std::stof(s, &pos);
-            if (pos == s.size()) return Option<float>(result);
-            return Option<float>();
-        } catch (...) {
-            return Option<float>();
-        }
-    }
-
-    // Assert function
-    inline void assert_true(bool condition, const char* msg = "assertion failed") {
-        if (!condition) throw std::runtime_error(msg);
+        kept.push_back(std::move(bp));
     }
+    breakpoints = std::move(kept);
 }
-)";
 
 static void print_usage() {
     std::cerr << "Mana Compiler v1.2.5\n\n";
@@ -556,17 +152,33 @@ static void print_usage() {
     std::cerr << "  build          Build the current project\n";
     std::cerr << "  run            Build and run the project\n";
     std::cerr << "  test           Run tests\n";
+    std::cerr << "  bench          Run #[bench] functions\n";
     std::cerr << "  new <name>     Create a new project\n";
     std::cerr << "  fmt <files>    Format source files\n";
+    std::cerr << "  lint <files>   Lint source files (mana lint --help)\n";
+    std::cerr << "  doc [paths]    Generate HTML documentation for a project\n";
     std::cerr << "  repl           Start interactive REPL\n";
     std::cerr << "  add <pkg>      Add a dependency\n";
     std::cerr << "  remove <pkg>   Remove a dependency\n";
+    std::cerr << "  install        Install dependencies pinned in mana.lock\n";
+    std::cerr << "  update         Re-resolve dependencies and rewrite mana.lock\n";
     std::cerr << "  <file>         Compile a single file\n\n";
     std::cerr << "Formatter options (mana fmt):\n";
     std::cerr << "  --check        Check if files are formatted\n";
     std::cerr << "  -w, --write    Write formatted output back to files\n";
     std::cerr << "  --tabs         Use tabs instead of spaces\n";
-    std::cerr << "  --indent <n>   Set indent width (default: 4)\n\n";
+    std::cerr << "  --indent <n>   Set indent width (default: 4)\n";
+    std::cerr << "  -j <n>         Format on n workers (0 = one per core)\n";
+    std::cerr << "  --no-cache     Re-check files already known to be formatted\n\n";
+    std::cerr << "Documentation options (mana doc):\n";
+    std::cerr << "  --out <dir>    Output directory (default: build/doc)\n";
+    std::cerr << "  -j <n>         Document on n workers (0 = one per core)\n";
+    std::cerr << "  --no-cache     Re-render modules that have not changed\n\n";
+    std::cerr << "Test options (mana test):\n";
+    std::cerr << "  -j <n>         Build and run tests on n workers (0 = one per core)\n";
+    std::cerr << "  --shard <i/n>  Run only the i-th of n slices of the test list\n";
+    std::cerr << "  --timeout <s>  Per-test timeout in seconds (default: 60)\n";
+    std::cerr << "  --format <f>   pretty, json or junit\n\n";
     std::cerr << "Compiler options:\n";
     std::cerr << "  -o <file>      Output executable name\n";
     std::cerr << "  -c             Compile only (generate .cpp, don't link)\n";
@@ -574,7 +186,14 @@ static void print_usage() {
     std::cerr << "  --ast          Print AST to stdout\n";
     std::cerr << "  --doc          Generate Markdown documentation\n";
     std::cerr << "  --no-cache     Disable incremental compilation\n";
+    std::cerr << "  --test         Build a test binary (--list, --run <name>, --run-all) instead of main\n";
+    std::cerr << "  -g, --debug    Debug build: #line directives, a .manamap source map and debug info\n";
+    std::cerr << "  --breakpoints <file>\n";
+    std::cerr << "                 Debug build with mana-debug's breakpoints compiled in as checks\n";
     std::cerr << "  --clear-cache  Clear compilation cache\n";
+    std::cerr << "  --allocator=<system|bump|mimalloc-style>\n";
+    std::cerr << "                 Global allocator linked into the program (default: system)\n";
+    std::cerr << "  --alloc-stats  Count allocations for alloc_stats() and report them at exit\n";
     std::cerr << "  -v, --version  Show version\n";
     std::cerr << "  -h, --help     Show this help\n";
 }
@@ -589,7 +208,7 @@ int main(int argc, char** argv) {
 
     // Handle subcommands
     if (first_arg == "repl") {
-        mana::repl::Repl repl;
+        mana::repl::Repl repl({MANA_RUNTIME_H, ""});
         repl.run();
         return 0;
     }
@@ -618,140 +237,206 @@ int main(int argc, char** argv) {
     }
 
     if (first_arg == "test") {
-        mana::pkg::PackageManager pkg;
-        return pkg.test();
+        mana::test::TestConfig config;
+        config.compiler = argv[0];
+        std::vector<std::string> paths;
+
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+                config.jobs = std::stoi(argv[++i]);
+            } else if (arg.rfind("-j", 0) == 0 && arg.size() > 2) {
+                config.jobs = std::stoi(arg.substr(2));
+            } else if (arg == "--shard" && i + 1 < argc) {
+                std::string spec = argv[++i];
+                size_t slash = spec.find('/');
+                int index = slash == std::string::npos ? 0 : std::atoi(spec.substr(0, slash).c_str());
+                int count = slash == std::string::npos ? 0 : std::atoi(spec.substr(slash + 1).c_str());
+                if (count < 1 || index < 1 || index > count) {
+                    std::cerr << "error: --shard expects i/n with 1 <= i <= n\n";
+                    return 1;
+                }
+                config.shard_index = index - 1;
+                config.shard_count = count;
+            } else if (arg == "--timeout" && i + 1 < argc) {
+                config.timeout = std::chrono::milliseconds(static_cast<long long>(std::stod(argv[++i]) * 1000));
+            } else if (arg == "--filter" && i + 1 < argc) {
+                config.filter = argv[++i];
+            } else if (arg == "--format" && i + 1 < argc) {
+                config.output_format = argv[++i];
+            } else if (arg == "--fail-fast") {
+                config.fail_fast = true;
+            } else if (arg == "--show-output") {
+                config.show_output = true;
+            } else if (arg[0] != '-') {
+                paths.push_back(arg);
+            } else {
+                std::cerr << "Usage: mana test [options] [files or directories...]\n";
+                std::cerr << "\nOptions:\n";
+                std::cerr << "  -j <n>            Build and run tests on n workers (0 = one per core)\n";
+                std::cerr << "  --shard <i/n>     Run only the i-th of n slices of the test list\n";
+                std::cerr << "  --timeout <secs>  Fail a test that runs longer (default: 60, 0 = none)\n";
+                std::cerr << "  --filter <regex>  Only run tests whose name matches\n";
+                std::cerr << "  --format <fmt>    pretty, json or junit\n";
+                std::cerr << "  --fail-fast       Stop at the first failure\n";
+                std::cerr << "  --show-output     Show output of passing tests too\n";
+                return 1;
+            }
+        }
+
+        // Default to the project's source and test directories
+        if (paths.empty()) {
+            for (const char* dir : {"src", "tests"}) {
+                if (fs::is_directory(dir)) paths.push_back(dir);
+            }
+            if (paths.empty()) paths.push_back(".");
+        }
+
+        mana::test::TestRunner runner(config);
+        for (const auto& path : paths) {
+            if (fs::is_directory(path)) runner.add_directory(path);
+            else runner.add_file(path);
+        }
+        if (config.output_format == "json") {
+            runner.set_reporter(std::make_unique<mana::test::JsonReporter>(std::cout));
+        } else if (config.output_format == "junit") {
+            runner.set_reporter(std::make_unique<mana::test::JUnitReporter>(std::cout));
+        }
+        return runner.run();
+    }
+
+    if (first_arg == "bench") {
+        mana::test::BenchConfig config;
+        config.build.compiler = argv[0];
+        config.build.optimize = "-O2";
+        config.build.build_dir = ".mana_cache/bench";
+        std::vector<std::string> paths;
+
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+                config.build.jobs = std::stoi(argv[++i]);
+            } else if (arg.rfind("-j", 0) == 0 && arg.size() > 2) {
+                config.build.jobs = std::stoi(arg.substr(2));
+            } else if (arg == "--filter" && i + 1 < argc) {
+                config.build.filter = argv[++i];
+            } else if (arg == "--baseline" && i + 1 < argc) {
+                config.baseline = argv[++i];
+            } else if (arg == "--save-baseline" && i + 1 < argc) {
+                config.save_baseline = argv[++i];
+            } else if (arg == "--threshold" && i + 1 < argc) {
+                config.threshold = std::stod(argv[++i]);
+            } else if (arg == "--warmup" && i + 1 < argc) {
+                config.warmup = std::chrono::milliseconds(std::stoll(argv[++i]));
+            } else if (arg == "--measure" && i + 1 < argc) {
+                config.measure = std::chrono::milliseconds(std::stoll(argv[++i]));
+            } else if (arg[0] != '-') {
+                paths.push_back(arg);
+            } else {
+                std::cerr << "Usage: mana bench [options] [files or directories...]\n";
+                std::cerr << "\nOptions:\n";
+                std::cerr << "  -j <n>                  Build n files at once (benchmarks always run one at a time)\n";
+                std::cerr << "  --filter <regex>        Only run benchmarks whose name matches\n";
+                std::cerr << "  --save-baseline <file>  Write results as JSON\n";
+                std::cerr << "  --baseline <file>       Compare against saved results\n";
+                std::cerr << "  --threshold <pct>       Slowdown that fails the run (default: 5)\n";
+                std::cerr << "  --warmup <ms>           Warmup per benchmark (default: 200)\n";
+                std::cerr << "  --measure <ms>          Measurement time per benchmark (default: 1000)\n";
+                return 1;
+            }
+        }
+
+        if (paths.empty()) {
+            for (const char* dir : {"benches", "src"}) {
+                if (fs::is_directory(dir)) paths.push_back(dir);
+            }
+            if (paths.empty()) paths.push_back(".");
+        }
+
+        mana::test::TestRunner files(config.build);
+        for (const auto& path : paths) {
+            if (fs::is_directory(path)) files.add_directory(path);
+            else files.add_file(path);
+        }
+        mana::test::BenchRunner runner(config);
+        return runner.run(files.files());
     }
 
     if (first_arg == "fmt") {
         // Parse fmt options
-        bool check_mode = false;
-        bool write_mode = false;
         std::vector<std::string> files;
-        mana::fmt::FormatConfig config;
+        mana::fmt::FormatRunConfig config;
 
         for (int i = 2; i < argc; i++) {
             std::string arg = argv[i];
             if (arg == "--check") {
-                check_mode = true;
+                config.mode = mana::fmt::FormatMode::Check;
             } else if (arg == "-w" || arg == "--write") {
-                write_mode = true;
+                config.mode = mana::fmt::FormatMode::Write;
             } else if (arg == "--tabs") {
-                config.use_tabs = true;
+                config.style.use_tabs = true;
             } else if (arg == "--indent" && i + 1 < argc) {
-                config.indent_width = std::stoi(argv[++i]);
+                config.style.indent_width = std::stoi(argv[++i]);
             } else if (arg == "--no-trailing-commas") {
-                config.trailing_commas = false;
+                config.style.trailing_commas = false;
+            } else if (arg == "-j" && i + 1 < argc) {
+                config.jobs = std::stoi(argv[++i]);
+            } else if (arg == "--no-cache") {
+                config.use_cache = false;
             } else if (arg[0] != '-') {
                 files.push_back(arg);
             }
         }
 
         if (files.empty()) {
-            std::cerr << "Usage: mana fmt [options] <files...>\n";
+            std::cerr << "Usage: mana fmt [options] <files or directories...>\n";
             std::cerr << "\nOptions:\n";
             std::cerr << "  --check           Check if files are formatted (exit 1 if not)\n";
             std::cerr << "  -w, --write       Write formatted output back to files\n";
             std::cerr << "  --tabs            Use tabs instead of spaces\n";
             std::cerr << "  --indent <n>      Set indent width (default: 4)\n";
             std::cerr << "  --no-trailing-commas  Don't add trailing commas\n";
+            std::cerr << "  -j <n>            Format on n workers (0 = one per core)\n";
+            std::cerr << "  --no-cache        Re-check files already known to be formatted\n";
             return 1;
         }
 
-        // Expand directories to .mana files
-        std::vector<std::string> all_files;
-        for (const auto& path : files) {
-            if (fs::is_directory(path)) {
-                for (const auto& entry : fs::recursive_directory_iterator(path)) {
-                    if (entry.path().extension() == ".mana") {
-                        all_files.push_back(entry.path().string());
-                    }
-                }
-            } else if (path == ".") {
-                for (const auto& entry : fs::recursive_directory_iterator(".")) {
-                    if (entry.path().extension() == ".mana") {
-                        all_files.push_back(entry.path().string());
-                    }
-                }
-            } else {
-                all_files.push_back(path);
-            }
-        }
-
-        int exit_code = 0;
-        int formatted_count = 0;
-        int unchanged_count = 0;
-
-        for (const auto& file : all_files) {
-            std::ifstream in(file);
-            if (!in) {
-                std::cerr << "Cannot open: " << file << "\n";
-                exit_code = 1;
-                continue;
-            }
-            std::stringstream buffer;
-            buffer << in.rdbuf();
-            std::string original = buffer.str();
-            in.close();
-
-            Lexer lex(original);
-            auto tokens = lex.tokenize();
-            DiagnosticEngine diag;
-            Parser parser(tokens, diag);
-            auto module = parser.parse_module();
-
-            if (diag.has_errors()) {
-                std::cerr << file << ": parse error\n";
-                for (const auto& e : diag.errors()) {
-                    std::cerr << "  " << e.message << "\n";
-                }
-                exit_code = 1;
-                continue;
-            }
-
-            mana::fmt::Formatter formatter(config);
-            std::string formatted = formatter.format(module.get());
+        mana::fmt::FormatRunner runner(config);
+        return runner.run(files);
+    }
 
-            if (formatted == original) {
-                unchanged_count++;
-                continue;
-            }
+    if (first_arg == "doc") {
+        std::vector<std::string> paths;
+        mana::doc::DocConfig config;
 
-            formatted_count++;
-
-            if (check_mode) {
-                std::cerr << file << " would be reformatted\n";
-                exit_code = 1;
-            } else if (write_mode) {
-                std::ofstream out(file);
-                if (!out) {
-                    std::cerr << "Cannot write: " << file << "\n";
-                    exit_code = 1;
-                    continue;
-                }
-                out << formatted;
-                std::cout << "Formatted: " << file << "\n";
-            } else {
-                // Default: print to stdout (for single file)
-                if (all_files.size() == 1) {
-                    std::cout << formatted;
-                } else {
-                    std::cout << "=== " << file << " ===\n" << formatted << "\n";
-                }
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if ((arg == "-o" || arg == "--out") && i + 1 < argc) {
+                config.out_dir = argv[++i];
+            } else if (arg == "-j" && i + 1 < argc) {
+                config.jobs = std::stoi(argv[++i]);
+            } else if (arg == "--no-cache") {
+                config.use_cache = false;
+            } else if (arg == "-h" || arg == "--help") {
+                std::cerr << "Usage: mana doc [options] [files or directories...]\n";
+                std::cerr << "\nDocuments src/ (or the current directory) when no paths are given.\n";
+                std::cerr << "\nOptions:\n";
+                std::cerr << "  -o, --out <dir>   Output directory (default: build/doc)\n";
+                std::cerr << "  -j <n>            Document on n workers (0 = one per core)\n";
+                std::cerr << "  --no-cache        Re-render modules that have not changed\n";
+                return 0;
+            } else if (arg[0] != '-') {
+                paths.push_back(arg);
             }
         }
+        if (paths.empty()) paths.push_back(fs::is_directory("src") ? "src" : ".");
 
-        if (check_mode) {
-            if (exit_code == 0) {
-                std::cout << "All " << all_files.size() << " files are formatted.\n";
-            } else {
-                std::cerr << formatted_count << " file(s) would be reformatted.\n";
-            }
-        } else if (write_mode) {
-            std::cout << formatted_count << " file(s) formatted, "
-                      << unchanged_count << " unchanged.\n";
-        }
+        mana::doc::DocRunner runner(config);
+        return runner.run(paths);
+    }
 
-        return exit_code;
+    if (first_arg == "lint") {
+        return mana::lint::run_lint(argc - 1, argv + 1);
     }
 
     if (first_arg == "add" && argc >= 3) {
@@ -764,6 +449,22 @@ int main(int argc, char** argv) {
         return pkg.remove(argv[2]);
     }
 
+    if (first_arg == "install" || first_arg == "update") {
+        mana::pkg::PackageManager pkg;
+        mana::pkg::InstallOptions options;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+                options.jobs = std::stoi(argv[++i]);
+            } else if (arg == "--frozen") {
+                options.frozen = true;
+            } else if (arg == "--registry" && i + 1 < argc) {
+                pkg.set_registry_url(argv[++i]);
+            }
+        }
+        return first_arg == "install" ? pkg.install(options) : pkg.update(options);
+    }
+
     std::string input_file;
     std::string output_file;
     bool compile_only = false;
@@ -772,6 +473,11 @@ int main(int argc, char** argv) {
     bool gen_doc = false;
     bool use_cache = true;
     bool clear_cache = false;
+    int allocator = 0;  // MANA_ALLOCATOR: 0 = system, 1 = bump, 2 = mimalloc-style
+    bool alloc_stats = false;
+    bool test_mode = false;
+    bool debug_info = false;
+    std::string breakpoints_file;
 
     // Parse arguments
     for (int i = 1; i < argc; ++i) {
@@ -788,8 +494,26 @@ int main(int argc, char** argv) {
             gen_doc = true;
         } else if (arg == "--no-cache") {
             use_cache = false;
+        } else if (arg == "--test") {
+            test_mode = true;
+        } else if (arg == "-g" || arg == "--debug") {
+            debug_info = true;
+        } else if (arg == "--breakpoints" && i + 1 < argc) {
+            breakpoints_file = argv[++i];
+            debug_info = true;
         } else if (arg == "--clear-cache") {
             clear_cache = true;
+        } else if (arg.rfind("--allocator=", 0) == 0) {
+            std::string name = arg.substr(12);
+            if (name == "system") allocator = 0;
+            else if (name == "bump") allocator = 1;
+            else if (name == "mimalloc-style") allocator = 2;
+            else {
+                std::cerr << "error: unknown allocator '" << name << "' (expected system, bump or mimalloc-style)\n";
+                return 1;
+            }
+        } else if (arg == "--alloc-stats") {
+            alloc_stats = true;
         } else if (arg == "-v" || arg == "--version") {
             std::cout << "mana 1.0.0" << std::endl;
             return 0;
@@ -860,7 +584,7 @@ int main(int argc, char** argv) {
     fs::path input_path(input_file);
     std::unordered_set<std::string> imported_files;
     imported_files.insert(fs::weakly_canonical(input_path).string());
-    if (!resolve_imports(module.get(), input_path.parent_path(), diag, imported_files)) {
+    if (!splice_file_imports(module.get(), input_path.parent_path(), diag, imported_files)) {
         diag.print_all(std::cerr);
         return 1;
     }
@@ -907,8 +631,38 @@ int main(int argc, char** argv) {
         std::cout << "\n";
     }
 
+    // Test builds emit a different entry point, and debug builds need the
+    // source map written alongside the code, so both bypass the cache
+    if (test_mode || debug_info) use_cache = false;
+
+    // Determine output paths
+    fs::path base_name = input_path.stem();
+    fs::path output_dir = input_path.parent_path();
+    // Test builds keep their generated files next to the binary, so that
+    // concurrent builds of one source directory never share a runtime header
+    if (test_mode && !output_file.empty()) output_dir = fs::path(output_file).parent_path();
+    if (output_dir.empty()) output_dir = ".";
+
+    fs::path cpp_file = output_dir / (base_name.string() + ".cpp");
+    fs::path runtime_file = output_dir / "mana_runtime.h";
+
+#ifdef _WIN32
+    fs::path exe_file = output_file.empty()
+        ? output_dir / (base_name.string() + ".exe")
+        : fs::path(output_file);
+#else
+    fs::path exe_file = output_file.empty()
+        ? output_dir / base_name
+        : fs::path(output_file);
+#endif
+
+    std::string prelude;
+    if (allocator != 0) prelude += "#define MANA_ALLOCATOR " + std::to_string(allocator) + "\n";
+    if (alloc_stats) prelude += "#define MANA_ALLOC_STATS 1\n";
+
     // Check cache for incremental compilation
     std::string cpp_code;
+    SourceMap source_map;
     bool cache_hit = false;
     if (use_cache) {
         auto cached = cache.get_cached_cpp(input_file);
@@ -923,7 +677,28 @@ int main(int argc, char** argv) {
     if (!cache_hit) {
         std::ostringstream cpp_stream;
         CppEmitter emit;
-        emit.emit(module.get(), cpp_stream);
+        if (debug_info) {
+            // The written file starts with a comment line, then the prelude
+            int first_line = 2 + static_cast<int>(std::count(prelude.begin(), prelude.end(), '\n'));
+            emit.set_source_map(&source_map, fs::weakly_canonical(input_path).string(),
+                                fs::weakly_canonical(cpp_file).string(), first_line);
+        }
+        std::vector<CppEmitter::Breakpoint> breakpoints;
+        std::vector<std::unique_ptr<AstExpr>> conditions;
+        if (!breakpoints_file.empty()) {
+            if (!load_breakpoints(breakpoints_file, breakpoints, conditions)) return 1;
+            emit.set_breakpoints(std::move(breakpoints));
+            if (!conditions.empty()) {
+                emit.bind_breakpoints(module.get());
+                breakpoints = emit.breakpoints();
+                check_breakpoint_conditions(breakpoints, conditions, source, input_path);
+                emit.set_breakpoints(std::move(breakpoints));
+            }
+        }
+        emit.emit(module.get(), cpp_stream, test_mode);
+        for (const auto& bp : emit.breakpoints()) {
+            if (bp.line == 0) std::cerr << "warning: breakpoint " << bp.id << " has no code at or after its line\n";
+        }
         cpp_code = cpp_stream.str();
 
         // Store in cache
@@ -932,6 +707,9 @@ int main(int argc, char** argv) {
         }
     }
 
+    // Allocator selection goes ahead of the runtime include and stays out of the cache
+    cpp_code = prelude + cpp_code;
+
     // Emit C++ to stdout if requested
     if (emit_cpp) {
         // (header already included by emitter)
@@ -939,24 +717,6 @@ int main(int argc, char** argv) {
         return 0;
     }
 
-    // Determine output paths
-    fs::path base_name = input_path.stem();
-    fs::path output_dir = input_path.parent_path();
-    if (output_dir.empty()) output_dir = ".";
-
-    fs::path cpp_file = output_dir / (base_name.string() + ".cpp");
-    fs::path runtime_file = output_dir / "mana_runtime.h";
-
-#ifdef _WIN32
-    fs::path exe_file = output_file.empty()
-        ? output_dir / (base_name.string() + ".exe")
-        : fs::path(output_file);
-#else
-    fs::path exe_file = output_file.empty()
-        ? output_dir / base_name
-        : fs::path(output_file);
-#endif
-
     // Write runtime header
     {
         std::ofstream runtime_out(runtime_file);
@@ -978,6 +738,12 @@ int main(int argc, char** argv) {
         cpp_out << cpp_code;
     }
 
+    fs::path map_file = fs::path(cpp_file).replace_extension(".manamap");
+    if (debug_info && !source_map.write(map_file.string())) {
+        std::cerr << "error: cannot write source map: " << map_file << "\n";
+        return 1;
+    }
+
     std::cout << "Generated: " << cpp_file.string() << "\n";
 
     if (compile_only) {
@@ -995,13 +761,20 @@ int main(int argc, char** argv) {
         cmake_out << "cmake_minimum_required(VERSION 3.16)\n";
         cmake_out << "project(" << base_name.string() << ")\n";
         cmake_out << "set(CMAKE_CXX_STANDARD 20)\n";
+        if (debug_info) cmake_out << "set(CMAKE_BUILD_TYPE Debug)\n";
         cmake_out << "add_executable(" << base_name.string() << " " << base_name.string() << ".cpp)\n";
     }
 
     // Build with cmake
     fs::path build_dir = output_dir / "build";
-    std::string cmake_config = "cmake -B \"" + build_dir.string() + "\" -S \"" + output_dir.string() + "\" >nul 2>&1";
-    std::string cmake_build = "cmake --build \"" + build_dir.string() + "\" --config Release >nul 2>&1";
+#ifdef _WIN32
+    const std::string quiet = " >nul 2>&1";
+#else
+    const std::string quiet = " >/dev/null 2>&1";
+#endif
+    std::string cmake_config = "cmake -B \"" + build_dir.string() + "\" -S \"" + output_dir.string() + "\"" + quiet;
+    std::string config_name = debug_info ? "Debug" : "Release";
+    std::string cmake_build = "cmake --build \"" + build_dir.string() + "\" --config " + config_name + quiet;
 
     std::cout << "Compiling...\n";
     int result = std::system(cmake_config.c_str());
@@ -1017,7 +790,7 @@ int main(int argc, char** argv) {
     }
 
 #ifdef _WIN32
-    fs::path built_exe = build_dir / "Release" / (base_name.string() + ".exe");
+    fs::path built_exe = build_dir / config_name / (base_name.string() + ".exe");
 #else
     fs::path built_exe = build_dir / base_name;
 #endif
@@ -1026,12 +799,23 @@ int main(int argc, char** argv) {
     if (!output_file.empty()) {
         try {
             fs::copy_file(built_exe, exe_file, fs::copy_options::overwrite_existing);
+            // mana-debug looks for the source map next to the program; with
+            // `-o <dir>/<stem>` it was written there already
+            fs::path exe_map = exe_file.string() + ".manamap";
+            std::error_code ec;
+            if (debug_info && !fs::equivalent(map_file, exe_map, ec)) {
+                fs::copy_file(map_file, exe_map, fs::copy_options::overwrite_existing);
+            }
             std::cout << "Success: " << exe_file.string() << "\n";
         } catch (const fs::filesystem_error& e) {
             std::cerr << "error: cannot copy executable: " << e.what() << "\n";
             return 1;
         }
     } else {
+        if (debug_info) {
+            std::error_code ec;
+            fs::copy_file(map_file, built_exe.string() + ".manamap", fs::copy_options::overwrite_existing, ec);
+        }
         std::cout << "Success: " << built_exe.string() << "\n";
     }
 
@@ -218,6 +218,13 @@ inline void mana_glUniformMatrix4fv(int32_t location, int64_t matrixPtr) {
     glUniformMatrix4fv(location, 1, GL_FALSE, matrix);
 }
 
+#ifdef MANA_VECTOR_MATH
+// Matrix uniform from a runtime Mat4 (column-major, no pointer round-trip)
+inline void mana_glUniformMat4(int32_t location, const mana::Mat4& m) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, m.data());
+}
+#endif
+
 // ============================================================================
 // 3D Setup functions
 // ============================================================================
@@ -300,6 +307,10 @@ inline void mana_mat4_identity(float* m) {
 
 // Matrix multiplication: result = a * b
 inline void mana_mat4_multiply(float* result, const float* a, const float* b) {
+#ifdef MANA_VECTOR_MATH
+    // SIMD path from the runtime's vector math library
+    mana::mat4_multiply(result, a, b);
+#else
     float temp[16];
     for (int row = 0; row < 4; row++) {
         for (int col = 0; col < 4; col++) {
@@ -310,6 +321,7 @@ inline void mana_mat4_multiply(float* result, const float* a, const float* b) {
         }
     }
     for (int i = 0; i < 16; i++) result[i] = temp[i];
+#endif
 }
 
 // Perspective projection matrix
@@ -19,6 +19,7 @@
 #include <memory>
 #include <algorithm>
 #include <ctime>
+#include <random>
 
 namespace mana {
     template <typename F>
@@ -658,12 +659,8 @@ namespace mana {
     // ========== Random numbers ==========
 
     inline int32_t random_int(int32_t min_val, int32_t max_val) {
-        static bool seeded = false;
-        if (!seeded) {
-            std::srand(static_cast<unsigned>(std::time(nullptr)));
-            seeded = true;
-        }
-        return min_val + (std::rand() % (max_val - min_val + 1));
+        thread_local std::mt19937_64 engine(std::random_device{}());
+        return std::uniform_int_distribution<int32_t>(min_val, max_val)(engine);
     }
 
     // ========== Additional utilities ==========
@@ -1,6 +1,7 @@
 #pragma once
 #include <ctime>
 #include <cstdlib>
+#include <random>
 #include <regex>
 #include <map>
 #include <sstream>
@@ -401,16 +402,19 @@ inline Result<Vec<std::string>, std::string> file_read_lines(const std::string&
 
 // ========== Random ==========
 
+// Per-thread engine: thread-safe without locking, and the distributions
+// below sample without modulo bias.
+inline std::mt19937_64& random_engine() {
+    thread_local std::mt19937_64 engine(std::random_device{}());
+    return engine;
+}
+
 inline int32_t random_int(int32_t min_val, int32_t max_val) {
-    static bool seeded = false;
-    if (!seeded) { std::srand(static_cast<unsigned>(std::time(nullptr))); seeded = true; }
-    return min_val + std::rand() % (max_val - min_val + 1);
+    return std::uniform_int_distribution<int32_t>(min_val, max_val)(random_engine());
 }
 
 inline float random_float() {
-    static bool seeded = false;
-    if (!seeded) { std::srand(static_cast<unsigned>(std::time(nullptr))); seeded = true; }
-    return static_cast<float>(std::rand()) / RAND_MAX;
+    return std::uniform_real_distribution<float>(0.0f, 1.0f)(random_engine());
 }
 
 // ========== Sleep ==========
@@ -35,7 +35,15 @@ namespace mana::frontend {
 
     struct AstDecl : AstNode {
         std::string source_module;  // Module this declaration came from (for imports)
+        std::string source_file;    // File it was parsed from, if imported (for source maps)
         std::string doc_comment;    // Documentation comment (/// comment text)
+        // Source extent, from the first keyword (after doc comments and
+        // attributes) to just past the last token; set by the parser for
+        // top-level declarations, 1-based like line/column
+        int start_line = 0;
+        int start_column = 0;
+        int end_line = 0;
+        int end_column = 0;
 
         explicit AstDecl(NodeKind kind, int line = 0, int column = 0)
             : AstNode(kind, line, column) {
@@ -87,6 +95,10 @@ namespace mana::frontend {
         bool is_async = false;  // async fn
         bool is_static = false;  // static fn (no self parameter)
         bool is_test = false;  // #[test] fn
+        bool is_bench = false;  // #[bench] fn: the body is one iteration of a benchmark
+        bool should_panic = false;  // #[should_panic]: the test passes only if it panics
+        bool is_ignored = false;  // #[ignore] / #[ignore = "reason"]
+        std::string ignore_reason;
         bool is_extern = false;  // extern fn (FFI declaration)
         bool has_self = false;  // method has 'self' parameter
 
@@ -109,6 +109,7 @@ namespace mana::frontend {
         std::string name;
         std::unique_ptr<AstNode> init_expr;
         std::unique_ptr<AstStmt> body;
+        bool is_region = false;  // scope name { ... }: `name` is an Arena freed at scope exit
         AstScopeStmt(int line = 0, int column = 0) : AstStmt(NodeKind::ScopeStmt, line, column) {}
         explicit AstScopeStmt(std::unique_ptr<AstStmt> b, int line = 0, int column = 0) : AstStmt(NodeKind::ScopeStmt, line, column), body(std::move(b)) {}
     };
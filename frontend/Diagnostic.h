@@ -72,6 +72,8 @@ namespace mana::frontend {
 
         void print_all(std::ostream& out) const;
         void clear() { diags_.clear(); }
+        // Drops what was recorded after the first `count`, for parses that backtrack
+        void truncate(size_t count) { if (count < diags_.size()) diags_.resize(count); }
 
         // Accessors for tools
         const std::vector<Diagnostic>& all() const { return diags_; }
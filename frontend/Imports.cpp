@@ -0,0 +1,83 @@
+#include "Imports.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include <fstream>
+#include <sstream>
+
+namespace mana::frontend {
+
+    namespace fs = std::filesystem;
+
+    static bool splice(AstModule* module, const fs::path& base_dir, DiagnosticEngine& diag,
+                       std::unordered_set<std::string>& seen, const FileImportOptions& options, bool top) {
+        std::vector<std::unique_ptr<AstDecl>> imported_decls;
+
+        for (auto& decl : module->decls) {
+            auto* imp = dynamic_cast<AstImportDecl*>(decl.get());
+            // Standard library imports are handled separately
+            if (!imp || !imp->is_file_import) continue;
+
+            // Resolve file path relative to the importing file
+            fs::path import_path = base_dir / (imp->path + ".mana");
+            std::string canonical = fs::weakly_canonical(import_path).string();
+
+            // Skip if already imported (avoid circular imports)
+            if (!seen.insert(canonical).second) continue;
+
+            std::ifstream in(canonical, std::ios::binary);
+            if (!in) {
+                if (options.skip_broken) continue;
+                diag.error("cannot open imported file: " + canonical, imp->line, imp->column);
+                return false;
+            }
+            std::ostringstream buffer;
+            buffer << in.rdbuf();
+            std::string source = buffer.str();
+            if (options.on_read) options.on_read(canonical, source);
+
+            Lexer lexer(source);
+            auto tokens = lexer.tokenize();
+            DiagnosticEngine scratch;
+            DiagnosticEngine& file_diag = options.skip_broken ? scratch : diag;
+            Parser parser(tokens, file_diag);
+            auto imported_module = parser.parse_module();
+            if (!imported_module || file_diag.has_errors()) {
+                if (options.skip_broken) continue;
+                return false;
+            }
+
+            // Recursively resolve imports in the imported file
+            if (!splice(imported_module.get(), import_path.parent_path(), diag, seen, options, false)) {
+                return false;
+            }
+
+            // Import all declarations (both public and private); this allows
+            // public functions to call private helpers
+            std::string module_name = imported_module->name.empty() ? canonical : imported_module->name;
+            std::vector<const AstDecl*> spliced;
+            for (auto& imported_decl : imported_module->decls) {
+                // Don't re-import import or use declarations
+                if (dynamic_cast<AstImportDecl*>(imported_decl.get())) continue;
+                if (dynamic_cast<AstUseDecl*>(imported_decl.get())) continue;
+
+                // Track source module for all imported declarations
+                imported_decl->source_module = module_name;
+                if (imported_decl->source_file.empty()) imported_decl->source_file = canonical;
+                spliced.push_back(imported_decl.get());
+                imported_decls.push_back(std::move(imported_decl));
+            }
+            if (top && options.on_import) options.on_import(*imp, spliced);
+        }
+
+        // Add imported declarations to the beginning of the module, in order
+        module->decls.insert(module->decls.begin(), std::make_move_iterator(imported_decls.begin()),
+                             std::make_move_iterator(imported_decls.end()));
+        return true;
+    }
+
+    bool splice_file_imports(AstModule* module, const fs::path& base_dir, DiagnosticEngine& diag,
+                             std::unordered_set<std::string>& seen, const FileImportOptions& options) {
+        return splice(module, base_dir, diag, seen, options, true);
+    }
+
+} // namespace mana::frontend
@@ -0,0 +1,33 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "AstModule.h"
+#include "AstDecl.h"
+#include "Diagnostic.h"
+
+namespace mana::frontend {
+
+    // What callers other than the compiler want to see of file imports
+    struct FileImportOptions {
+        // An imported file that cannot be read or parsed is left out instead
+        // of failing the splice; its parse errors go to a scratch engine
+        bool skip_broken = false;
+        // Each imported file's canonical path and text, as it is read
+        std::function<void(const std::string& path, const std::string& source)> on_read;
+        // Each `import "file"` of the module passed in (not of the files it
+        // pulls in), with the declarations it spliced, transitive ones included
+        std::function<void(const AstImportDecl& import, const std::vector<const AstDecl*>& decls)> on_import;
+    };
+
+    // Splices the declarations of the module's `import "file"` targets in
+    // front of its own, resolving paths against base_dir and recursing into
+    // each imported file. `seen` holds canonical paths already spliced, which
+    // are skipped (add the root file to break cycles through it). Declarations
+    // keep their visibility; it is enforced by the semantic analyzer.
+    bool splice_file_imports(AstModule* module, const std::filesystem::path& base_dir, DiagnosticEngine& diag,
+                             std::unordered_set<std::string>& seen, const FileImportOptions& options = {});
+
+} // namespace mana::frontend
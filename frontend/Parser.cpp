@@ -1,4 +1,5 @@
 #include "Parser.h"
+#include <cstdint>
 
 namespace mana::frontend {
 
@@ -41,6 +42,19 @@ namespace mana::frontend {
         match(TokenKind::Semicolon);
     }
 
+    // Error recovery for list loops: when an iteration comes back to the token
+    // the previous one started on, nothing was consumed (the error is already
+    // reported), so skip that token instead of parsing it again forever
+    bool Parser::skip_stalled(size_t& mark) {
+        if (current_ != mark) {
+            mark = current_;
+            return false;
+        }
+        advance();
+        mark = current_;
+        return true;
+    }
+
     void Parser::synchronize() {
         advance();
         while (!is_at_end()) {
@@ -100,23 +114,54 @@ namespace mana::frontend {
     std::unique_ptr<AstModule> Parser::parse_module() {
         expect(TokenKind::KwModule, "expected 'module'");
         expect(TokenKind::Identifier, "expected module name");
-        Token name = previous();
+        // Both expects fail without consuming on a file with no header
+        Token name = current_ > 0 ? previous() : peek();
         optional_semicolon();  // vNext: semicolons optional
 
         auto mod = std::make_unique<AstModule>(name.lexeme, name.line, name.column);
 
+        size_t mark = SIZE_MAX;
         while (!is_at_end()) {
+            if (skip_stalled(mark)) continue;
+            size_t first = current_;
             auto d = parse_declaration();
             if (!d) {
                 synchronize();
                 continue;
             }
+            // Skip doc comments and #[...] attributes, which are not part of the extent
+            size_t head = first;
+            while (head < current_) {
+                if (tokens_[head].kind == TokenKind::DocComment) {
+                    head++;
+                } else if (tokens_[head].kind == TokenKind::Hash) {
+                    while (head < current_ && tokens_[head].kind != TokenKind::RBracket) head++;
+                    head++;
+                } else {
+                    break;
+                }
+            }
+            if (head < current_) {
+                const Token& last = previous();
+                d->start_line = tokens_[head].line;
+                d->start_column = tokens_[head].column;
+                d->end_line = last.line;
+                d->end_column = last.column + static_cast<int>(last.lexeme.size());
+            }
             mod->decls.push_back(std::move(d));
         }
 
         return mod;
     }
 
+    std::unique_ptr<AstExpr> Parser::parse_standalone_expression() {
+        auto expr = parse_expression();
+        if (expr && !is_at_end()) {
+            diag_.error("unexpected tokens after expression", peek().line, peek().column);
+        }
+        return expr;
+    }
+
     // ---------------- declarations ----------------
 
     std::unique_ptr<AstDecl> Parser::parse_declaration() {
@@ -129,17 +174,40 @@ namespace mana::frontend {
 
         if (match(TokenKind::KwImport)) return parse_import_decl();
 
-        // Handle #[test] attribute
+        // Handle #[test], #[bench], #[should_panic] and #[ignore] / #[ignore = "reason"]
         bool is_test = false;
-        if (match(TokenKind::Hash)) {
+        bool is_bench = false;
+        bool should_panic = false;
+        bool is_ignored = false;
+        std::string ignore_reason;
+        while (match(TokenKind::Hash)) {
             expect(TokenKind::LBracket, "expected '[' after '#'");
             expect(TokenKind::Identifier, "expected attribute name");
             std::string attr_name = previous().lexeme;
             if (attr_name == "test") {
                 is_test = true;
+            } else if (attr_name == "bench") {
+                is_bench = true;
+            } else if (attr_name == "should_panic") {
+                should_panic = true;
+            } else if (attr_name == "ignore") {
+                is_ignored = true;
+                if (match(TokenKind::Assign)) {
+                    expect(TokenKind::StringLiteral, "expected string after 'ignore ='");
+                    ignore_reason = previous().lexeme;
+                }
             }
             expect(TokenKind::RBracket, "expected ']' after attribute");
         }
+        auto with_attributes = [&](std::unique_ptr<AstDecl> decl) {
+            if (auto fn = dynamic_cast<AstFuncDecl*>(decl.get())) {
+                fn->is_bench = is_bench;
+                fn->should_panic = should_panic;
+                fn->is_ignored = is_ignored;
+                fn->ignore_reason = ignore_reason;
+            }
+            return decl;
+        };
 
         // Handle pub modifier - can apply to use, fn, struct, enum, trait, type
         bool is_pub = match(TokenKind::KwPub);
@@ -153,7 +221,7 @@ namespace mana::frontend {
         // Handle extern fn (FFI declaration)
         if (match(TokenKind::KwExtern)) {
             expect(TokenKind::KwFn, "expected 'fn' after 'extern'");
-            auto decl = parse_function_decl(is_pub, false, is_test, true);
+            auto decl = with_attributes(parse_function_decl(is_pub, false, is_test, true));
             if (decl) decl->doc_comment = doc_comment;
             return decl;
         }
@@ -162,12 +230,12 @@ namespace mana::frontend {
         bool is_async = match(TokenKind::KwAsync);
         if (is_async) {
             expect(TokenKind::KwFn, "expected 'fn' after 'async'");
-            auto decl = parse_function_decl(is_pub, true, is_test);
+            auto decl = with_attributes(parse_function_decl(is_pub, true, is_test));
             if (decl) decl->doc_comment = doc_comment;
             return decl;
         }
         if (match(TokenKind::KwFn)) {
-            auto decl = parse_function_decl(is_pub, false, is_test);
+            auto decl = with_attributes(parse_function_decl(is_pub, false, is_test));
             if (decl) decl->doc_comment = doc_comment;
             return decl;
         }
@@ -233,7 +301,13 @@ namespace mana::frontend {
 
         expect(TokenKind::LBrace, "expected '{' after struct name");
 
+        size_t mark = SIZE_MAX;
         while (!check(TokenKind::RBrace) && !is_at_end()) {
+            if (skip_stalled(mark)) continue;
+            // Doc comments on fields are allowed but not kept
+            while (match(TokenKind::DocComment)) {}
+            if (check(TokenKind::RBrace)) break;
+            size_t field_start = current_;
             expect(TokenKind::Identifier, "expected field name");
             Token field_name = previous();
             expect(TokenKind::Colon, "expected ':' after field name");
@@ -259,6 +333,7 @@ namespace mana::frontend {
                     diag_.error("expected ',' or '}' after field", peek().line, peek().column);
                 }
             }
+            if (current_ == field_start) advance();  // Nothing parsed; skip the token rather than loop
         }
 
         expect(TokenKind::RBrace, "expected '}' after struct fields");
@@ -276,7 +351,12 @@ namespace mana::frontend {
         e->declared_as_variant = declared_as_variant;
         int next_value = 0;
 
+        size_t mark = SIZE_MAX;
         while (!check(TokenKind::RBrace) && !is_at_end()) {
+            if (skip_stalled(mark)) continue;
+            while (match(TokenKind::DocComment)) {}
+            if (check(TokenKind::RBrace)) break;
+            size_t variant_start = current_;
             expect(TokenKind::Identifier, "expected variant name");
             Token variant_name = previous();
 
@@ -299,7 +379,9 @@ namespace mana::frontend {
                 expect(TokenKind::RParen, "expected ')' after tuple variant types");
             } else if (match(TokenKind::LBrace)) {
                 // Struct variant: Variant { field: Type, ... }
+                size_t field_mark = SIZE_MAX;
                 while (!check(TokenKind::RBrace) && !is_at_end()) {
+                    if (skip_stalled(field_mark)) continue;
                     expect(TokenKind::Identifier, "expected field name in struct variant");
                     std::string field_name = previous().lexeme;
                     int field_line = previous().line;
@@ -338,6 +420,7 @@ namespace mana::frontend {
             } else {
                 match(TokenKind::Comma); // allow trailing comma
             }
+            if (current_ == variant_start) advance();  // Nothing parsed; skip the token rather than loop
         }
 
         expect(TokenKind::RBrace, "expected '}' after enum variants");
@@ -435,7 +518,9 @@ namespace mana::frontend {
 
         expect(TokenKind::LBrace, "expected '{' after trait name");
 
+        size_t mark = SIZE_MAX;
         while (!check(TokenKind::RBrace) && !is_at_end()) {
+            if (skip_stalled(mark)) continue;
             // Parse associated type: type Item;
             if (match(TokenKind::KwType)) {
                 expect(TokenKind::Identifier, "expected associated type name");
@@ -540,7 +625,9 @@ namespace mana::frontend {
 
         expect(TokenKind::LBrace, "expected '{' after impl");
 
+        size_t mark = SIZE_MAX;
         while (!check(TokenKind::RBrace) && !is_at_end()) {
+            if (skip_stalled(mark)) continue;
             // Parse associated type assignment: type Item = ConcreteType;
             if (match(TokenKind::KwType)) {
                 expect(TokenKind::Identifier, "expected associated type name");
@@ -826,7 +913,9 @@ namespace mana::frontend {
         expect(TokenKind::LBrace, "expected '{'");
         auto b = std::make_unique<AstBlockStmt>(previous().line, previous().column);
 
+        size_t mark = SIZE_MAX;
         while (!check(TokenKind::RBrace) && !is_at_end()) {
+            if (skip_stalled(mark)) continue;
             auto st = parse_statement();
             if (!st) {
                 // Error recovery: skip to next statement boundary
@@ -982,6 +1071,7 @@ std::unique_ptr<AstStmt> Parser::parse_statement() {
         // Check for member access or index assignment: expr.member = value or expr[index] = value
         if (check(TokenKind::Identifier)) {
             size_t saved = current_;
+            size_t saved_diags = diag_.all().size();
             auto lhs = parse_postfix();  // Parse left-hand side with member access
 
             if (match(TokenKind::Assign)) {
@@ -998,8 +1088,10 @@ std::unique_ptr<AstStmt> Parser::parse_statement() {
                 return a;
             }
 
-            // Not an assignment, restore and fall through to expression statement
+            // Not an assignment, restore and fall through to expression statement;
+            // it parses the same tokens again and reports their errors itself
             current_ = saved;
+            diag_.truncate(saved_diags);
         }
 
         return parse_expression_statement();
@@ -1178,9 +1270,27 @@ std::unique_ptr<AstStmt> Parser::parse_statement() {
     }
 
     std::unique_ptr<AstStmt> Parser::parse_scope_statement() {
+        // Plain scope: scope { ... }
+        if (check(TokenKind::LBrace)) {
+            auto b = parse_block();
+            auto s = std::make_unique<AstScopeStmt>(b ? b->line : peek().line, b ? b->column : peek().column);
+            s->body = std::move(b);
+            return s;
+        }
+
         expect(TokenKind::Identifier, "expected scope name");
         Token name = previous();
-        expect(TokenKind::Assign, "expected '='");
+
+        // Region: scope arena { ... } - allocations from `arena` are freed at the closing brace
+        if (check(TokenKind::LBrace)) {
+            auto s = std::make_unique<AstScopeStmt>(name.line, name.column);
+            s->name = name.lexeme;
+            s->is_region = true;
+            s->body = parse_block();
+            return s;
+        }
+
+        expect(TokenKind::Assign, "expected '=' or '{' after scope name");
         auto init = parse_expression();
         optional_semicolon();  // vNext: semicolons optional
 
@@ -2322,7 +2432,9 @@ std::unique_ptr<AstStmt> Parser::parse_statement() {
 
         expect(TokenKind::LBrace, "expected '{' after match value");
 
+        size_t mark = SIZE_MAX;
         while (!check(TokenKind::RBrace) && !is_at_end()) {
+            if (skip_stalled(mark)) continue;
             AstMatchArm arm;
             arm.line = peek().line;
             arm.column = peek().column;
@@ -2375,7 +2487,9 @@ std::unique_ptr<AstStmt> Parser::parse_statement() {
                     } else if (match(TokenKind::LBrace)) {
                         // Struct destructuring: Enum::Variant { field: x }
                         enum_pat->is_tuple_pattern = false;
+                        size_t field_mark = SIZE_MAX;
                         while (!check(TokenKind::RBrace) && !is_at_end()) {
+                            if (skip_stalled(field_mark)) continue;
                             expect(TokenKind::Identifier, "expected field name in pattern");
                             std::string field_name = previous().lexeme;
                             std::string binding_name = field_name;  // Default: field name is binding
@@ -15,6 +15,8 @@ namespace mana::frontend {
         Parser(const std::vector<Token>& tokens, DiagnosticEngine& diag);
 
         std::unique_ptr<AstModule> parse_module();
+        // A lone expression making up the whole input (breakpoint conditions)
+        std::unique_ptr<AstExpr> parse_standalone_expression();
 
     private:
         const std::vector<Token>& tokens_;
@@ -33,6 +35,7 @@ namespace mana::frontend {
         void optional_semicolon();  // Consume semicolon if present (vNext: semicolons optional)
         void synchronize();
         void synchronize_statement();  // Synchronize within a block
+        bool skip_stalled(size_t& mark);  // Skip a token a list loop failed to consume
 
         // Decls
         std::unique_ptr<AstDecl> parse_declaration();
@@ -21,6 +21,41 @@ namespace mana::frontend {
         return operator_traits.count(name) > 0;
     }
 
+    // Value types provided by the runtime's vector math library
+    static bool is_vector_math_type(const Type& t) {
+        static const std::unordered_set<std::string> vector_math_types = {
+            "Vec2", "Vec3", "Vec4", "Mat4", "Quat"
+        };
+        return t.kind == TypeKind::Struct && vector_math_types.count(t.struct_name) > 0;
+    }
+
+    // Return type of a method on a vector math type (unknown if not listed)
+    static Type vector_math_method_type(const std::string& type_name, const std::string& method) {
+        if (method == "length" || method == "length_squared" ||
+            method == "determinant" || method == "get")
+            return Type::f32();
+        if (method == "normalized" || method == "transposed" ||
+            method == "inverse" || method == "conjugate")
+            return Type::struct_(type_name);
+        if (method == "to_mat4") return Type::struct_("Mat4");
+        if (method == "transform_point" || method == "transform_direction" ||
+            method == "xyz" || method == "rgb")
+            return Type::struct_("Vec3");
+        if (method == "xy" || method == "xz") return Type::struct_("Vec2");
+        if (method == "column" || method == "row") return Type::struct_("Vec4");
+        return Type::unknown();
+    }
+
+    // Whether a vector math type has a component field with this name
+    static bool is_vector_math_component(const std::string& type_name, const std::string& member) {
+        size_t arity = 0;
+        if (type_name == "Vec2") arity = 2;
+        else if (type_name == "Vec3") arity = 3;
+        else if (type_name == "Vec4" || type_name == "Quat") arity = 4;
+        static const std::string components = "xyzw";
+        return member.size() == 1 && components.find(member[0]) < arity;
+    }
+
     SemanticAnalyzer::SemanticAnalyzer(DiagnosticEngine& diag)
         : diag_(diag) {
     }
@@ -189,7 +224,78 @@ namespace mana::frontend {
         
         // Random functions
         builtin_functions_["random_int"] = true;
+        builtin_functions_["random_float"] = true;
+        builtin_functions_["random_range"] = true;
+        builtin_functions_["seed_random"] = true;
+        builtin_functions_["fill_random"] = true;
         declare("random_int", { "random_int", Type::i32(), false });
+        declare("random_float", { "random_float", Type::f32(), false });
+        declare("random_range", { "random_range", Type::f32(), false });
+        declare("seed_random", { "seed_random", Type::void_(), false });
+        declare("fill_random", { "fill_random", Type::void_(), false });
+        // Static calls are looked up as Type_method
+        declare("Rng_new", { "Rng_new", Type::unknown(), false });
+        declare("Rng_from_entropy", { "Rng_from_entropy", Type::unknown(), false });
+        declare("Arena_new", { "Arena_new", Type::struct_("Arena"), false });
+
+        // Benchmark helper: returns its argument unchanged, hidden from the optimizer
+        builtin_functions_["black_box"] = true;
+        declare("black_box", { "black_box", Type::unknown(), false });
+
+        // Allocation statistics (counted with mana --alloc-stats)
+        builtin_functions_["alloc_stats"] = true;
+        declare("alloc_stats", { "alloc_stats", Type::struct_("AllocStats"), false });
+
+        // Vector math types: Vec3(x, y, z), Vec3::up(), Mat4::identity(), ...
+        for (const char* t : { "Vec2", "Vec3", "Vec4", "Mat4", "Quat" }) {
+            builtin_functions_[t] = true;
+            declare(t, { t, Type::struct_(t), false });
+        }
+        for (const char* s : { "Vec2_zero", "Vec2_one", "Vec2_up", "Vec2_right" })
+            declare(s, { s, Type::struct_("Vec2"), false });
+        for (const char* s : { "Vec3_zero", "Vec3_one", "Vec3_up", "Vec3_forward", "Vec3_right" })
+            declare(s, { s, Type::struct_("Vec3"), false });
+        for (const char* s : { "Vec4_zero", "Vec4_one" })
+            declare(s, { s, Type::struct_("Vec4"), false });
+        for (const char* s : { "Mat4_identity", "Mat4_from_columns" })
+            declare(s, { s, Type::struct_("Mat4"), false });
+        for (const char* s : { "Quat_identity", "Quat_from_axis_angle", "Quat_from_euler", "Quat_look_rotation" })
+            declare(s, { s, Type::struct_("Quat"), false });
+
+        // Vector math functions (lerp, cross and reflect are typed from their arguments)
+        for (const char* f : { "dot", "cross", "distance", "lerp", "reflect", "refract", "slerp",
+                               "translate", "scale", "rotate_x", "rotate_y", "rotate_z", "rotate",
+                               "perspective", "ortho", "look_at",
+                               "transform_points", "transform_directions", "transform_vec4s" }) {
+            builtin_functions_[f] = true;
+        }
+        declare("dot", { "dot", Type::f32(), false });
+        declare("distance", { "distance", Type::f32(), false });
+        declare("cross", { "cross", Type::unknown(), false });
+        declare("lerp", { "lerp", Type::unknown(), false });
+        declare("reflect", { "reflect", Type::unknown(), false });
+        declare("refract", { "refract", Type::struct_("Vec3"), false });
+        declare("slerp", { "slerp", Type::struct_("Quat"), false });
+        for (const char* f : { "translate", "scale", "rotate_x", "rotate_y", "rotate_z", "rotate",
+                               "perspective", "ortho", "look_at" }) {
+            declare(f, { f, Type::struct_("Mat4"), false });
+        }
+        declare("transform_points", { "transform_points", Type::unknown(), false });
+        declare("transform_directions", { "transform_directions", Type::unknown(), false });
+        declare("transform_vec4s", { "transform_vec4s", Type::unknown(), false });
+
+        // Batch math kernels over Vec<f32> and slices (dot is declared above)
+        for (const char* f : { "sin_all", "cos_all", "exp_all", "log_all", "axpy", "sum", "min_all", "max_all" }) {
+            builtin_functions_[f] = true;
+        }
+        declare("sin_all", { "sin_all", Type::unknown(), false });
+        declare("cos_all", { "cos_all", Type::unknown(), false });
+        declare("exp_all", { "exp_all", Type::unknown(), false });
+        declare("log_all", { "log_all", Type::unknown(), false });
+        declare("axpy", { "axpy", Type::void_(), false });
+        declare("sum", { "sum", Type::f32(), false });
+        declare("min_all", { "min_all", Type::f32(), false });
+        declare("max_all", { "max_all", Type::f32(), false });
         
         // Path functions
         builtin_functions_["path_join"] = true;
@@ -242,9 +348,89 @@ namespace mana::frontend {
         check_unused_variables();
 
         pop_scope();
+        if (semantic_info_) semantic_info_->sort();
+    }
+
+    void SemanticAnalyzer::begin_session() {
+        scopes_.clear();
+        push_scope();
+        register_builtins();
+    }
+
+    void SemanticAnalyzer::analyze_incremental(AstModule* module) {
+        // Same passes as analyze(), but the global scope stays open and unused
+        // variables are not reported (later snippets may still use them)
+        for (auto& d : module->decls)
+            register_declaration(d.get());
+        for (auto& d : module->decls)
+            visit_decl(d.get());
+        fold_constants_in_module(module);
+    }
+
+    void SemanticAnalyzer::declare_session_variable(const std::string& name, const std::string& type_name, bool is_mutable) {
+        // A new `let` of the same name replaces the old binding
+        scopes_.front()[name] = Symbol{ name, parse_type_name(type_name), is_mutable };
+    }
+
+    void SemanticAnalyzer::record_token(int line, int column, size_t length, SemanticKind kind, uint8_t modifiers) {
+        if (!semantic_info_ || line <= 0 || length == 0) return;
+        semantic_info_->tokens.push_back({ line, column, static_cast<uint16_t>(std::min<size_t>(length, 0xFFFF)), kind, modifiers });
+    }
+
+    void SemanticAnalyzer::record_hint(int line, int column, SemanticHintKind kind, std::string label) {
+        if (!semantic_info_ || line <= 0) return;
+        semantic_info_->hints.push_back({ line, column, kind, std::move(label) });
+    }
+
+    void SemanticAnalyzer::record_symbol(Symbol& sym, SemanticKind kind, int line, int column) {
+        if (!semantic_info_ || !record_symbols_ || line <= 0) return;
+        SemanticSymbol info;
+        info.name = sym.name;
+        info.kind = kind;
+        info.line = line;
+        info.column = column;
+        info.is_mutable = sym.is_mutable;
+        info.is_public = sym.is_public;
+        info.is_global = scopes_.size() == 1;
+        if (kind != SemanticKind::Function) {
+            if (const Symbol* outer = lookup(sym.name)) {
+                if (outer->info_index >= 0 && semantic_info_->symbols[outer->info_index].kind != SemanticKind::Function) {
+                    info.shadows = outer->info_index;
+                }
+            }
+        }
+        sym.info_index = static_cast<int>(semantic_info_->symbols.size());
+        semantic_info_->symbols.push_back(std::move(info));
+    }
+
+    void SemanticAnalyzer::record_name(const std::string& name, const Symbol& sym, int line, int column, bool is_write) {
+        if (!semantic_info_) return;
+        if (sym.info_index >= 0) {
+            auto& info = semantic_info_->symbols[sym.info_index];
+            (is_write ? info.writes : info.reads)++;
+        }
+        SemanticKind kind = SemanticKind::Variable;
+        uint8_t modifiers = 0;
+        if (struct_types_.count(name)) {
+            kind = SemanticKind::Struct;
+        } else if (enum_types_.count(name)) {
+            kind = SemanticKind::Enum;
+        } else if (builtin_functions_.count(name)) {
+            kind = SemanticKind::Function;
+            modifiers |= SemanticDefaultLibrary;
+        } else if (func_decls_.count(name) || sym.type.kind == TypeKind::Function) {
+            kind = sym.is_parameter ? SemanticKind::Parameter : SemanticKind::Function;
+        } else if (sym.is_parameter) {
+            kind = SemanticKind::Parameter;
+        }
+        if (!sym.is_mutable && (kind == SemanticKind::Variable || kind == SemanticKind::Parameter)) {
+            modifiers |= SemanticReadonly;
+        }
+        record_token(line, column, name.size(), kind, modifiers);
     }
 
     void SemanticAnalyzer::register_declaration(AstDecl* d) {
+        record_symbols_ = d->source_module.empty();
         // Register function declarations (signature only, not body)
         if (auto fn = dynamic_cast<AstFuncDecl*>(d)) {
             Symbol sym;
@@ -258,13 +444,26 @@ namespace mana::frontend {
             for (const auto& c : fn->constraints) {
                 sym.constraints.push_back({c.type_param, c.traits});
             }
+            if (!fn->is_method()) record_symbol(sym, SemanticKind::Function, fn->line, fn->column);
 
-            declare(fn->name, sym);
+            if (!declare(fn->name, sym) && builtin_functions_.count(fn->name)) {
+                // User functions shadow runtime builtins of the same name
+                scopes_.back()[fn->name] = sym;
+                builtin_functions_.erase(fn->name);
+            }
             func_decls_[fn->name] = fn;
 
             if (fn->is_test) {
                 test_functions_.push_back(fn);
             }
+            if (fn->is_bench) {
+                // The harness calls the body once per iteration
+                if (!fn->params.empty() || fn->is_method() || fn->is_generic()) {
+                    diag_.error("#[bench] function '" + fn->name + "' must be a plain function with no parameters",
+                                fn->line, fn->column);
+                }
+                bench_functions_.push_back(fn);
+            }
             return;
         }
 
@@ -278,6 +477,7 @@ namespace mana::frontend {
             sym.source_module = s->source_module;
             declare(s->name, sym);
             struct_types_[s->name] = s;
+            record_token(s->line, s->column, s->name.size(), SemanticKind::Struct, SemanticDeclaration);
             return;
         }
 
@@ -291,6 +491,7 @@ namespace mana::frontend {
             sym.source_module = e->source_module;
             declare(e->name, sym);
             enum_types_[e->name] = e;
+            record_token(e->line, e->column, e->name.size(), SemanticKind::Enum, SemanticDeclaration);
             return;
         }
 
@@ -314,6 +515,10 @@ namespace mana::frontend {
 
     void SemanticAnalyzer::pop_scope() {
         scopes_.pop_back();
+        // Regions end with the scope that holds their arena
+        while (!regions_.empty() && regions_.back().scope_depth > scopes_.size()) {
+            regions_.pop_back();
+        }
     }
 
     bool SemanticAnalyzer::declare(const std::string& name, const Symbol& sym) {
@@ -331,6 +536,85 @@ namespace mana::frontend {
         return nullptr;
     }
 
+    size_t SemanticAnalyzer::scope_depth_of(const std::string& name) {
+        for (size_t i = scopes_.size(); i > 0; --i) {
+            if (scopes_[i - 1].count(name)) return i;
+        }
+        return 0;
+    }
+
+    // Region whose arena owns the storage `e` refers to ("" if none). is_ref is
+    // set when `e` is a reference into the region rather than an arena container.
+    std::string SemanticAnalyzer::region_of(AstExpr* e, bool& is_ref) {
+        is_ref = false;
+        if (regions_.empty() || !e) return "";
+        if (auto id = dynamic_cast<AstIdentifierExpr*>(e)) {
+            auto* sym = lookup(id->name);
+            if (!sym) return "";
+            is_ref = sym->is_region_ref;
+            return sym->region;
+        }
+        if (auto u = dynamic_cast<AstUnaryExpr*>(e)) {
+            if (u->op != "&" && u->op != "&mut") return "";
+            // &v[i] and &v.field point into v's storage
+            AstExpr* target = static_cast<AstExpr*>(u->right.get());
+            while (true) {
+                if (auto idx = dynamic_cast<AstIndexExpr*>(target)) target = idx->base.get();
+                else if (auto mem = dynamic_cast<AstMemberAccessExpr*>(target)) target = mem->object.get();
+                else break;
+            }
+            bool inner_ref = false;
+            std::string region = region_of(target, inner_ref);
+            is_ref = !region.empty();
+            return region;
+        }
+        // arena.vec() and arena.string(s) create containers owned by the arena
+        if (auto m = dynamic_cast<AstMethodCallExpr*>(e)) {
+            auto obj = dynamic_cast<AstIdentifierExpr*>(m->object.get());
+            if (obj && (m->method_name == "vec" || m->method_name == "string")) {
+                auto* sym = lookup(obj->name);
+                if (sym) return sym->region;
+            }
+        }
+        return "";
+    }
+
+    // References and arena handles (Arena, ArenaVec, ArenaString) can point into a
+    // region; plain values copied out of one cannot. Arena containers have no
+    // Type of their own yet, so an unknown type counts as a handle.
+    bool SemanticAnalyzer::may_hold_region_storage(const Type& t) {
+        switch (t.kind) {
+            case TypeKind::Pointer:
+            case TypeKind::Reference:
+            case TypeKind::MutReference:
+            case TypeKind::Unknown:
+                return true;
+            case TypeKind::Struct:
+                return t.struct_name == "Arena" || t.struct_name == "ArenaString" ||
+                       t.struct_name.rfind("ArenaVec", 0) == 0;
+            default:
+                return false;
+        }
+    }
+
+    // Rejects storing a reference or handle into region memory in a variable that
+    // outlives the region. Only those are ever bound to a region, so region_of()
+    // finds nothing for a value copied out of one.
+    void SemanticAnalyzer::check_region_escape(AstExpr* value, const std::string& target, int line, int col) {
+        bool is_ref = false;
+        std::string region = region_of(value, is_ref);
+        if (region.empty()) return;
+        for (auto r = regions_.rbegin(); r != regions_.rend(); ++r) {
+            if (r->name != region) continue;
+            size_t depth = scope_depth_of(target);
+            if (depth < r->scope_depth || (depth == r->scope_depth && r->declared_before.count(target))) {
+                diag_.error("reference into region '" + region + "' escapes through '" + target +
+                            "', which outlives the region", line, col);
+            }
+            return;
+        }
+    }
+
     bool SemanticAnalyzer::check_visibility(const Symbol* sym, int line, int col) {
         if (!sym) return true;  // Not found is handled elsewhere
 
@@ -512,6 +796,9 @@ namespace mana::frontend {
         if (struct_types_.count(base_name)) return Type::struct_(name);
         // Check if it's an enum type
         if (enum_types_.count(base_name)) return Type::enum_(name);
+        // Runtime vector math types
+        if (is_vector_math_type(Type::struct_(base_name))) return Type::struct_(base_name);
+        if (base_name == "AllocStats") return Type::struct_(base_name);
         return Type::unknown();
     }
 
@@ -519,6 +806,10 @@ namespace mana::frontend {
         return t.kind == TypeKind::I32 || t.kind == TypeKind::F32;
     }
 
+    bool SemanticAnalyzer::is_runtime_math_type(const Type& t) const {
+        return is_vector_math_type(t) && !struct_types_.count(t.struct_name);
+    }
+
     bool SemanticAnalyzer::always_returns(const AstStmt* stmt) {
         if (!stmt) return false;
 
@@ -582,6 +873,8 @@ namespace mana::frontend {
     // -------- declarations --------
 
     void SemanticAnalyzer::visit_decl(AstDecl* d) {
+        record_symbols_ = d->source_module.empty();
+        current_file_ = d->source_file.empty() ? main_file_ : d->source_file;
         // Handle use declarations - register imported symbols
         if (auto use = dynamic_cast<AstUseDecl*>(d)) {
             // For now, just record the import - in a full implementation
@@ -636,8 +929,15 @@ namespace mana::frontend {
                 declare("self", { "self", receiver, true });
             }
 
+            if (!fn->is_method()) {
+                record_token(fn->line, fn->column, fn->name.size(), SemanticKind::Function, SemanticDeclaration);
+            }
             for (auto& p : fn->params) {
-                declare(p.name, { p.name, parse_type_name(p.type_name), true });
+                Symbol param{ p.name, parse_type_name(p.type_name), true };
+                param.is_parameter = true;
+                record_symbol(param, SemanticKind::Parameter, p.line, p.column);
+                declare(p.name, param);
+                record_token(p.line, p.column, p.name.size(), SemanticKind::Parameter, SemanticDeclaration);
             }
 
             current_return_type_ = parse_type_name(fn->return_type);
@@ -660,7 +960,9 @@ namespace mana::frontend {
         if (auto g = dynamic_cast<AstGlobalVarDecl*>(d)) {
             auto* v = g->var.get();
             Type t = parse_type_name(v->type_name);
-            declare(v->name, { v->name, t, true });
+            Symbol sym{ v->name, t, true };
+            record_symbol(sym, SemanticKind::Variable, v->line, v->column);
+            declare(v->name, sym);
             if (v->init_expr)
                 visit_expr(static_cast<AstExpr*>(v->init_expr.get()));
             return;
@@ -767,8 +1069,13 @@ namespace mana::frontend {
                     declare("self", { "self", receiver, true });
                 }
 
+                record_token(method->line, method->column, method->name.size(), SemanticKind::Method, SemanticDeclaration);
                 for (auto& p : method->params) {
-                    declare(p.name, { p.name, parse_type_name(p.type_name), true });
+                    Symbol param{ p.name, parse_type_name(p.type_name), true };
+                    param.is_parameter = true;
+                    record_symbol(param, SemanticKind::Parameter, p.line, p.column);
+                    declare(p.name, param);
+                    record_token(p.line, p.column, p.name.size(), SemanticKind::Parameter, SemanticDeclaration);
                 }
 
                 current_return_type_ = sym.type;
@@ -793,7 +1100,22 @@ namespace mana::frontend {
 
     // -------- statements --------
 
+    void SemanticAnalyzer::check_scoped_conditions(const AstStmt* s) {
+        for (auto& c : *scoped_conditions_) {
+            if (c.checked || c.line != s->line || c.file != current_file_) continue;
+            c.checked = true;
+            size_t before = diag_.all().size();
+            Type t = visit_expr(c.expr);
+            if (diag_.all().size() == before && t.kind != TypeKind::Bool) {
+                diag_.error("breakpoint condition must be bool, got " + t.name(), c.expr->line, c.expr->column);
+            }
+            c.errors.assign(diag_.all().begin() + static_cast<std::ptrdiff_t>(before), diag_.all().end());
+            diag_.truncate(before);
+        }
+    }
+
     void SemanticAnalyzer::visit_stmt(AstStmt* s) {
+        if (scoped_conditions_) check_scoped_conditions(s);
         if (auto b = dynamic_cast<AstBlockStmt*>(s)) {
             push_scope();
             bool has_terminator = false;
@@ -830,16 +1152,41 @@ namespace mana::frontend {
                     t = rhs;
                     // Update the AST node's type for code generation
                     v->type_name = infer_type_name(rhs);
+                    if (rhs.kind != TypeKind::Unknown) {
+                        record_hint(s->line, s->column + static_cast<int>(v->name.size()), SemanticHintKind::Type, ": " + rhs.name());
+                    }
                 }
                 else if (t != rhs && rhs.kind != TypeKind::Unknown && t.kind != TypeKind::Unknown) {
                     diag_.error("type mismatch in variable initialization: expected " + t.name() + ", got " + rhs.name(), s->line, s->column);
                 }
             }
             // Track mutability from the variable declaration
-            declare(v->name, { v->name, t, v->is_mutable });
+            Symbol sym{ v->name, t, v->is_mutable };
+            if (t.kind == TypeKind::Struct && t.struct_name == "Arena") {
+                // An Arena local is a region that ends with its scope; locals
+                // declared before it in that scope are destroyed after it
+                RegionInfo region{ v->name, scopes_.size(), {} };
+                for (const auto& [name, _] : scopes_.back()) region.declared_before.insert(name);
+                regions_.push_back(std::move(region));
+                sym.region = v->name;
+                sym.is_region_ref = true;
+            } else if (!regions_.empty() && v->init_expr) {
+                // arena.vec(), &x and copies of such handles bind the variable to the
+                // region; a value copied out of it does not
+                bool is_ref = false;
+                std::string region = region_of(static_cast<AstExpr*>(v->init_expr.get()), is_ref);
+                if (!region.empty() && (is_ref || may_hold_region_storage(t))) {
+                    sym.region = region;
+                    sym.is_region_ref = is_ref;
+                }
+            }
+            record_symbol(sym, SemanticKind::Variable, s->line, s->column);
+            declare(v->name, sym);
             // Track for unused variable warning
             variable_used_[v->name] = false;
             variable_location_[v->name] = {s->line, s->column};
+            record_token(s->line, s->column, v->name.size(), SemanticKind::Variable,
+                         SemanticDeclaration | (v->is_mutable ? 0 : SemanticReadonly));
             return;
         }
 
@@ -862,11 +1209,25 @@ namespace mana::frontend {
                     diag_.error("cannot assign to immutable variable '" + a->target_name + "'", s->line, s->column);
                     return;
                 }
+                record_name(a->target_name, *sym, s->line, s->column, true);
                 target_type = sym->type;
             }
             Type rhs = visit_expr(static_cast<AstExpr*>(a->value.get()));
             if (rhs != target_type && rhs.kind != TypeKind::Unknown && target_type.kind != TypeKind::Unknown)
                 diag_.error("type mismatch in assignment: expected " + target_type.name() + ", got " + rhs.name(), s->line, s->column);
+            if (!regions_.empty()) {
+                // Find the variable that ends up holding the value (x, x.field, x[i])
+                std::string target = a->target_name;
+                AstExpr* t = static_cast<AstExpr*>(a->target_expr.get());
+                while (t) {
+                    if (auto id = dynamic_cast<AstIdentifierExpr*>(t)) { target = id->name; break; }
+                    if (auto ma = dynamic_cast<AstMemberAccessExpr*>(t)) t = ma->object.get();
+                    else if (auto ix = dynamic_cast<AstIndexExpr*>(t)) t = ix->base.get();
+                    else break;
+                }
+                if (!target.empty())
+                    check_region_escape(static_cast<AstExpr*>(a->value.get()), target, s->line, s->column);
+            }
             return;
         }
 
@@ -1002,6 +1363,10 @@ namespace mana::frontend {
                 // Allow unknown types (e.g., from method calls like unwrap())
                 if (v != current_return_type_ && v.kind != TypeKind::Unknown && current_return_type_.kind != TypeKind::Unknown)
                     diag_.error("return type mismatch: expected " + current_return_type_.name() + ", got " + v.name(), s->line, s->column);
+                bool is_ref = false;
+                std::string region = region_of(static_cast<AstExpr*>(r->value.get()), is_ref);
+                if (!region.empty() && (is_ref || may_hold_region_storage(v)))
+                    diag_.error("cannot return a value allocated in region '" + region + "': the region is freed when it ends", s->line, s->column);
             }
             return;
         }
@@ -1011,6 +1376,22 @@ namespace mana::frontend {
             return;
         }
 
+        if (auto sc = dynamic_cast<AstScopeStmt*>(s)) {
+            if (!sc->body) return;
+            push_scope();
+            if (sc->is_region) {
+                // The region's arena; anything allocated from it dies at the closing brace
+                Symbol arena{ sc->name, Type::struct_("Arena"), false };
+                arena.region = sc->name;
+                arena.is_region_ref = true;
+                declare(sc->name, arena);
+                regions_.push_back({ sc->name, scopes_.size(), {} });
+            }
+            visit_stmt(sc->body.get());
+            pop_scope();
+            return;
+        }
+
         if (auto e = dynamic_cast<AstExprStmt*>(s)) {
             visit_expr(static_cast<AstExpr*>(e->expr.get()));
             return;
@@ -1123,6 +1504,7 @@ namespace mana::frontend {
                 return Type::unknown();
             }
             mark_variable_used(id->name);
+            record_name(id->name, *sym, e->line, e->column);
             return sym->type;
         }
 
@@ -1130,11 +1512,21 @@ namespace mana::frontend {
             Type L = visit_expr(static_cast<AstExpr*>(b->left.get()));
             Type R = visit_expr(static_cast<AstExpr*>(b->right.get()));
 
-            // Comparison operators always return bool
+            // Comparison operators always return bool. Strings only compare
+            // with strings; the other scalars convert among themselves in C++.
             if (b->op == "==" || b->op == "!=" ||
                 b->op == "<" || b->op == "<=" ||
-                b->op == ">" || b->op == ">=")
+                b->op == ">" || b->op == ">=") {
+                auto scalar = [](const Type& t) {
+                    return t.kind == TypeKind::I32 || t.kind == TypeKind::F32 ||
+                           t.kind == TypeKind::Bool || t.kind == TypeKind::String;
+                };
+                if (scalar(L) && scalar(R) && (L.kind == TypeKind::String) != (R.kind == TypeKind::String)) {
+                    diag_.error("cannot compare " + L.name() + " with " + R.name() + " using '" + b->op + "'",
+                                e->line, e->column);
+                }
                 return Type::boolean();
+            }
 
             // Boolean operators: && and || require bool operands
             if (b->op == "&&" || b->op == "||") {
@@ -1157,6 +1549,22 @@ namespace mana::frontend {
             if (b->op == "+" && L.kind == TypeKind::String && R.kind == TypeKind::String)
                 return Type::string();
 
+            // Vector math: component-wise +/-, scaling by a scalar, Mat4/Quat products
+            if (is_runtime_math_type(L) || is_runtime_math_type(R)) {
+                const std::string& ln = L.struct_name;
+                const std::string& rn = R.struct_name;
+                if ((b->op == "+" || b->op == "-") && L == R && ln != "Mat4" && ln != "Quat")
+                    return L;
+                if (b->op == "*") {
+                    if (is_runtime_math_type(L) && is_numeric(R) && ln != "Mat4" && ln != "Quat") return L;
+                    if (is_numeric(L) && is_runtime_math_type(R) && rn != "Mat4" && rn != "Quat") return R;
+                    if (ln == "Mat4" && (rn == "Mat4" || rn == "Vec4")) return R;
+                    if (ln == "Quat" && (rn == "Quat" || rn == "Vec3")) return R;
+                }
+                if (b->op == "/" && is_runtime_math_type(L) && is_numeric(R) && ln != "Mat4" && ln != "Quat")
+                    return L;
+            }
+
             diag_.error("invalid binary operator operands: cannot apply '" + b->op + "' to " + L.name() + " and " + R.name(), e->line, e->column);
             return Type::unknown();
         }
@@ -1200,6 +1608,7 @@ namespace mana::frontend {
             // Check visibility - reject private symbols from other modules
             if (sym) {
                 check_visibility(sym, e->line, e->column);
+                if (pos == std::string::npos) record_name(c->func_name, *sym, e->line, e->column);
             }
             if (!sym) {
                 // Check if this is an enum variant constructor (EnumName::VariantName)
@@ -1309,12 +1718,33 @@ namespace mana::frontend {
                 c->arg_names.clear();  // Clear names after reordering
             }
             
+            // Parameter-name hints for positional arguments whose node starts at
+            // the argument's first token; an argument spelled like its parameter
+            // needs no hint
+            if (semantic_info_ && !has_named_args && func_decls_.count(lookup_name)) {
+                auto* fn = func_decls_[lookup_name];
+                for (size_t i = 0; i < c->args.size() && i < fn->params.size(); ++i) {
+                    auto* arg = c->args[i].get();
+                    if (!arg) continue;
+                    auto* id = dynamic_cast<AstIdentifierExpr*>(arg);
+                    if (id && id->name == fn->params[i].name) continue;
+                    if (id || dynamic_cast<AstLiteralExpr*>(arg) || dynamic_cast<AstCallExpr*>(arg)) {
+                        record_hint(arg->line, arg->column, SemanticHintKind::Parameter, fn->params[i].name + ":");
+                    }
+                }
+            }
+
             // Collect argument types for generic constraint checking
             std::vector<Type> arg_types;
             for (auto& a : c->args) {
                 if (a) arg_types.push_back(visit_expr(static_cast<AstExpr*>(a.get())));
             }
 
+            // black_box(x) is the identity, typed like its argument
+            if (c->func_name == "black_box" && builtin_functions_.count("black_box") && arg_types.size() == 1) {
+                return arg_types[0];
+            }
+
             // Infer generic type arguments from argument types
             std::unordered_map<std::string, Type> type_bindings;
             if (func_decls_.count(lookup_name)) {
@@ -1395,6 +1825,15 @@ namespace mana::frontend {
                     return parse_type_name(ret_type);
                 }
             }
+            // Overloaded vector math builtins are typed from their first argument
+            if (builtin_functions_.count(lookup_name) && !arg_types.empty()) {
+                if (lookup_name == "lerp" && is_numeric(arg_types[0])) return Type::f32();
+                if (is_runtime_math_type(arg_types[0])) {
+                    if (lookup_name == "lerp" || lookup_name == "reflect") return arg_types[0];
+                    if (lookup_name == "cross")
+                        return arg_types[0].struct_name == "Vec2" ? Type::f32() : arg_types[0];
+                }
+            }
             return sym->type;
         }
 
@@ -1468,6 +1907,28 @@ namespace mana::frontend {
                 if (a) visit_expr(static_cast<AstExpr*>(a.get()));
             }
 
+            // A handle from a temporary arena dangles once the statement ends
+            if ((m->method_name == "vec" || m->method_name == "string") &&
+                obj_type.kind == TypeKind::Struct && obj_type.struct_name == "Arena" &&
+                !dynamic_cast<AstIdentifierExpr*>(m->object.get()) &&
+                !dynamic_cast<AstMemberAccessExpr*>(m->object.get())) {
+                diag_.error("cannot allocate from a temporary Arena: it is freed at the end of the statement; "
+                            "bind it to a variable first", e->line, e->column);
+            }
+
+            // Storing a region reference in a longer-lived container: outer.push(&x)
+            if (!regions_.empty() && (m->method_name == "push" || m->method_name == "insert" || m->method_name == "set")) {
+                if (auto obj = dynamic_cast<AstIdentifierExpr*>(m->object.get())) {
+                    for (auto& a : m->args) {
+                        if (a) check_region_escape(static_cast<AstExpr*>(a.get()), obj->name, e->line, e->column);
+                    }
+                }
+            }
+
+            if (is_runtime_math_type(obj_type)) {
+                return vector_math_method_type(obj_type.struct_name, m->method_name);
+            }
+
             // Handle common Result/Option methods
             if (m->method_name == "is_ok" || m->method_name == "is_err" ||
                 m->method_name == "is_some" || m->method_name == "is_none") {
@@ -1503,6 +1964,17 @@ namespace mana::frontend {
                         }
                     }
                     diag_.error("unknown struct member '" + m->member_name + "' on type " + obj_type.name(), e->line, e->column);
+                } else if (is_vector_math_type(obj_type)) {
+                    if (is_vector_math_component(obj_type.struct_name, m->member_name))
+                        return Type::f32();
+                    diag_.error("unknown struct member '" + m->member_name + "' on type " + obj_type.name(), e->line, e->column);
+                } else if (obj_type.struct_name == "AllocStats") {
+                    if (m->member_name == "enabled") return Type::boolean();
+                    if (m->member_name == "allocations" || m->member_name == "frees" ||
+                        m->member_name == "bytes_allocated" || m->member_name == "bytes_live" ||
+                        m->member_name == "peak_bytes" || m->member_name == "bytes_reserved")
+                        return Type::i64();
+                    diag_.error("unknown struct member '" + m->member_name + "' on type AllocStats", e->line, e->column);
                 }
             }
             return Type::unknown();
@@ -1899,7 +2371,9 @@ namespace mana::frontend {
                 Type param_type = param.type_name.empty()
                     ? Type::unknown()  // Type will be inferred
                     : parse_type_name(param.type_name);
-                declare(param.name, { param.name, param_type, true });
+                Symbol closure_param{ param.name, param_type, true };
+                closure_param.is_parameter = true;
+                declare(param.name, closure_param);
                 
                 if (i > 0) param_types += ", ";
                 param_types += param_type.name();
@@ -1987,6 +2461,13 @@ namespace mana::frontend {
             return Type::unknown();
         }
 
+        if (auto r = dynamic_cast<AstRangeExpr*>(e)) {
+            // Bounds are read even though the range itself has no first-class type
+            if (r->start) visit_expr(r->start.get());
+            if (r->end) visit_expr(r->end.get());
+            return Type::unknown();
+        }
+
         if (auto nc = dynamic_cast<AstNullCoalesceExpr*>(e)) {
             // Null coalescing: opt ?? default
             // Visit both expressions
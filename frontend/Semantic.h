@@ -9,6 +9,7 @@
 #include "Diagnostic.h"
 #include "Type.h"
 #include "Symbol.h"
+#include "SemanticInfo.h"
 
 namespace mana::frontend {
 
@@ -18,8 +19,40 @@ namespace mana::frontend {
 
         void analyze(AstModule* module);
 
+        // Record resolved names and inferred types for editor tooling (mana-lsp)
+        void set_semantic_info(SemanticInfo* out) { semantic_info_ = out; }
+
+        // Incremental analysis (mana repl). begin_session() opens the global
+        // scope once; each analyze_incremental() call then registers and checks
+        // only the new module's declarations against everything accepted so
+        // far. Copy the analyzer to try a snippet and keep the copy on success.
+        void begin_session();
+        void analyze_incremental(AstModule* module);
+        // A variable that outlives the snippet that declared it
+        void declare_session_variable(const std::string& name, const std::string& type_name, bool is_mutable);
+
+        // Breakpoint conditions (mana -g --breakpoints), each checked as a
+        // bool in the scope it runs in: just before the first statement that
+        // starts on its bound line. Its diagnostics go to `errors`, not the
+        // engine. One whose line no statement starts on stays unchecked.
+        struct ScopedCondition {
+            std::string file;  // Canonical path; declarations name theirs in source_file
+            int line = 0;
+            AstExpr* expr = nullptr;
+            bool checked = false;
+            std::vector<Diagnostic> errors;
+        };
+        void set_scoped_conditions(std::vector<ScopedCondition>* conditions, const std::string& main_file) {
+            scoped_conditions_ = conditions;
+            main_file_ = main_file;
+        }
+
     private:
         DiagnosticEngine& diag_;
+        std::vector<ScopedCondition>* scoped_conditions_ = nullptr;
+        std::string main_file_;
+        std::string current_file_;  // File of the declaration being analyzed
+        void check_scoped_conditions(const AstStmt* s);
 
         std::vector<std::unordered_map<std::string, Symbol>> scopes_;
         std::unordered_map<std::string, AstStructDecl*> struct_types_;
@@ -27,6 +60,7 @@ namespace mana::frontend {
         std::unordered_map<std::string, AstTraitDecl*> trait_types_;
         std::unordered_map<std::string, AstFuncDecl*> func_decls_;  // For named argument validation
         std::vector<AstFuncDecl*> test_functions_;  // Functions marked with #[test]
+        std::vector<AstFuncDecl*> bench_functions_;  // Functions marked with #[bench]
         std::unordered_map<std::string, std::string> type_aliases_;  // alias -> target type
         std::vector<std::string> imported_modules_;  // Modules imported via 'use'
         Type current_return_type_ = Type::unknown();
@@ -52,6 +86,26 @@ namespace mana::frontend {
         bool check_trait_bounds(const std::string& type_param, const Type& concrete_type,
                                const std::vector<std::string>& required_traits, int line, int col);
 
+        // Arena regions (scope name { ... } and Arena locals) and escape checking
+        struct RegionInfo {
+            std::string name;
+            size_t scope_depth;  // scopes_.size() inside the region
+            std::set<std::string> declared_before;  // Locals of that scope that outlive an Arena local
+        };
+        std::vector<RegionInfo> regions_;
+        size_t scope_depth_of(const std::string& name);
+        std::string region_of(AstExpr* e, bool& is_ref);
+        static bool may_hold_region_storage(const Type& t);
+        void check_region_escape(AstExpr* value, const std::string& target, int line, int col);
+
+        // Editor support: filled only when set_semantic_info() was called
+        SemanticInfo* semantic_info_ = nullptr;
+        void record_token(int line, int column, size_t length, SemanticKind kind, uint8_t modifiers = 0);
+        void record_hint(int line, int column, SemanticHintKind kind, std::string label);
+        void record_name(const std::string& name, const Symbol& sym, int line, int column, bool is_write = false);
+        void record_symbol(Symbol& sym, SemanticKind kind, int line, int column);
+        bool record_symbols_ = true;  // Off inside declarations spliced in from imports
+
         // built-ins
         void register_builtins();
         std::unordered_map<std::string, bool> builtin_functions_;
@@ -66,6 +120,7 @@ namespace mana::frontend {
         Type parse_type_name(const std::string& name);
         std::string infer_type_name(const Type& t);  // Convert Type back to string for AST
         bool is_numeric(const Type& t);
+        bool is_runtime_math_type(const Type& t) const;  // Vec3 etc., unless a user struct shadows it
         bool always_returns(const AstStmt* stmt);  // Check if statement always returns
 
         // "Did you mean?" suggestions
@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mana::frontend {
+
+    // What a resolved name refers to. Editors map these to highlight groups.
+    enum class SemanticKind : uint8_t {
+        Variable, Parameter, Function, Method, Struct, Enum, EnumMember, Type, Property, Namespace
+    };
+
+    enum SemanticModifier : uint8_t {
+        SemanticDeclaration = 1 << 0,
+        SemanticReadonly = 1 << 1,        // Immutable binding
+        SemanticDefaultLibrary = 1 << 2,  // Builtin function or type
+    };
+
+    // One resolved name; positions are 1-based like the AST
+    struct SemanticToken {
+        int line = 0;
+        int column = 0;
+        uint16_t length = 0;
+        SemanticKind kind = SemanticKind::Variable;
+        uint8_t modifiers = 0;
+    };
+
+    enum class SemanticHintKind : uint8_t { Type = 1, Parameter = 2 };
+
+    // Text the analyzer inferred, shown inline by the editor: ": i32" after an
+    // untyped `let`, or "count:" before a positional argument
+    struct SemanticHint {
+        int line = 0;
+        int column = 0;  // Hint is drawn before this column
+        SemanticHintKind kind = SemanticHintKind::Type;
+        std::string label;
+    };
+
+    // A declared function, parameter or `let`/`const` binding and how often
+    // it was resolved afterwards; read by mana lint
+    struct SemanticSymbol {
+        std::string name;
+        SemanticKind kind = SemanticKind::Variable;  // Variable, Parameter or Function
+        int line = 0;
+        int column = 0;
+        bool is_mutable = true;
+        bool is_public = false;
+        bool is_global = false;  // Declared at module scope
+        int reads = 0;
+        int writes = 0;          // Assignments, including compound ones
+        int shadows = -1;        // Index of the outer variable or parameter this one hides
+    };
+
+    // Per-document results recorded by SemanticAnalyzer when requested
+    // (set_semantic_info). Tokens and hints are sorted by position after
+    // analysis; symbols stay in declaration order.
+    struct SemanticInfo {
+        std::vector<SemanticToken> tokens;
+        std::vector<SemanticHint> hints;
+        std::vector<SemanticSymbol> symbols;
+
+        void sort() {
+            auto before = [](const auto& a, const auto& b) {
+                return a.line < b.line || (a.line == b.line && a.column < b.column);
+            };
+            std::sort(tokens.begin(), tokens.end(), before);
+            // Names can be visited twice (e.g. reordered arguments); keep one
+            tokens.erase(std::unique(tokens.begin(), tokens.end(), [](const SemanticToken& a, const SemanticToken& b) {
+                return a.line == b.line && a.column == b.column;
+            }), tokens.end());
+            std::stable_sort(hints.begin(), hints.end(), before);
+        }
+    };
+
+} // namespace mana::frontend
@@ -13,6 +13,10 @@ namespace mana::frontend {
         std::string source_module;      // Module this symbol came from (empty = current module)
         std::vector<std::string> type_params;  // Generic type parameters (for functions/structs)
         std::vector<std::pair<std::string, std::vector<std::string>>> constraints;  // Type param -> required traits
+        std::string region{};           // Arena region owning this value's storage (empty = none)
+        bool is_region_ref = false;     // Holds a reference into the region rather than an arena container
+        bool is_parameter = false;      // Function or lambda parameter
+        int info_index = -1;            // Entry in SemanticInfo::symbols, when recording
     };
 
 } // namespace mana::frontend
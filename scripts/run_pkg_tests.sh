@@ -0,0 +1,153 @@
+#!/bin/bash
+
+# Mana Package Manager Test Script
+# Usage: run_pkg_tests.sh [options]
+# Options:
+#   -k, --keep       Keep the scratch project and store
+#
+# Installs from the file:// registry in tests/pkg/registry (MANA_REGISTRY)
+# into a scratch project with its own HOME, so the content-addressed store
+# starts empty: install -> mana.lock -> reinstall from the store. Then
+# lockfiles whose names or checksums point outside deps/ and the store.
+#
+# The fixture archives are deterministic tarballs of a package.toml and a
+# .mana file, made with
+#   tar --sort=name --mtime=@0 --owner=0 --group=0 --numeric-owner -C <src> -cf - . | gzip -n
+# and their sha256 is listed in the package's index.json.
+
+echo ""
+echo "=== Mana Package Manager Tests ==="
+echo ""
+
+KEEP=""
+for arg in "$@"; do
+    case $arg in
+        -k|--keep)
+            KEEP="-k"
+            ;;
+    esac
+done
+
+# Check if compiler exists
+if [ ! -f "build/mana" ]; then
+    echo "Error: Compiler not found at build/mana"
+    echo "Please build the compiler first: ./scripts/build.sh release"
+    exit 1
+fi
+
+MANA="$(pwd)/build/mana"
+REGISTRY="file://$(pwd)/tests/pkg/registry"
+WORK="$(pwd)/build/pkg_temp"
+
+rm -rf "$WORK"
+mkdir -p "$WORK/home" "$WORK/app"
+export HOME="$WORK/home"
+
+PASSED=0
+FAILED=0
+
+check() {
+    if eval "$2"; then
+        echo "  PASS  $1"
+        PASSED=$((PASSED + 1))
+    else
+        echo "  FAIL  $1"
+        FAILED=$((FAILED + 1))
+    fi
+}
+
+cd "$WORK/app"
+cat > package.toml <<'EOF'
+[package]
+name = "app"
+version = "0.1.0"
+
+[dependencies]
+greet = "^1.0.0"
+EOF
+
+echo "Fresh install..."
+OUT=$(MANA_REGISTRY="$REGISTRY" "$MANA" install 2>&1)
+STATUS=$?
+echo "$OUT" | sed 's/^/    /'
+check "install succeeds" '[ $STATUS -eq 0 ]'
+check "downloads greet and colors" 'echo "$OUT" | grep -q "(2 downloaded, 0 from store)"'
+check "picks the newest matching greet" 'grep -A1 "name = \"greet\"" mana.lock | grep -q "version = \"1.1.0\""'
+check "locks the archive checksum" 'grep -q "checksum = \"sha256:1a04307cf3b01fa4efcbbdbfdb947bde3433baeea7a9869c6141a2da77f6229d\"" mana.lock'
+check "locks the transitive dependency" 'grep -q "dependencies = \[\"colors ^0.2.0\"\]" mana.lock'
+check "links packages into deps/" '[ -f deps/greet/greet.mana ] && [ -f deps/colors/colors.mana ]'
+
+echo ""
+echo "Reinstall from the store..."
+LOCK=$(cat mana.lock)
+rm -rf deps
+# An unreachable registry proves nothing is fetched
+OUT=$(MANA_REGISTRY="file://$WORK/no-registry" "$MANA" install --frozen 2>&1)
+STATUS=$?
+echo "$OUT" | sed 's/^/    /'
+check "frozen install succeeds" '[ $STATUS -eq 0 ]'
+check "installs everything from the store" 'echo "$OUT" | grep -q "(0 downloaded, 2 from store)"'
+check "leaves mana.lock unchanged" '[ "$(cat mana.lock)" == "$LOCK" ]'
+check "relinks packages into deps/" '[ -f deps/greet/greet.mana ] && [ -f deps/colors/colors.mana ]'
+
+echo ""
+echo "Poisoned lockfiles..."
+mkdir -p src
+echo 'fn main() -> i32 { return 0; }' > src/main.mana
+GREET_SUM="sha256:1a04307cf3b01fa4efcbbdbfdb947bde3433baeea7a9869c6141a2da77f6229d"
+COLORS_SUM="sha256:45c8972fa1fa3f4ac47aaa681c951daa2bd264257598d635f34b0798a5b98ace"
+
+# A name that would make deps/<name> the project's src/
+cat > mana.lock <<EOF
+version = 1
+
+[[package]]
+name = "../src"
+version = "0.2.0"
+source = ""
+checksum = "$COLORS_SUM"
+
+[[package]]
+name = "greet"
+version = "1.1.0"
+source = ""
+checksum = "$GREET_SUM"
+dependencies = ["../src ^0.2.0"]
+EOF
+OUT=$(MANA_REGISTRY="file://$WORK/no-registry" "$MANA" install --frozen 2>&1)
+STATUS=$?
+echo "$OUT" | sed 's/^/    /'
+check "rejects a package name outside deps/" '[ $STATUS -ne 0 ] && echo "$OUT" | grep -q "invalid package name"'
+check "leaves the project untouched" '[ -f src/main.mana ]'
+
+# A checksum that would make the store entry the cache directory itself
+cat > mana.lock <<EOF
+version = 1
+
+[[package]]
+name = "colors"
+version = "0.2.0"
+source = ""
+checksum = "sha256:../.."
+
+[[package]]
+name = "greet"
+version = "1.1.0"
+source = ""
+checksum = "$GREET_SUM"
+dependencies = ["colors ^0.2.0"]
+EOF
+OUT=$(MANA_REGISTRY="file://$WORK/no-registry" "$MANA" install --frozen 2>&1)
+STATUS=$?
+echo "$OUT" | sed 's/^/    /'
+check "rejects a checksum outside the store" '[ $STATUS -ne 0 ] && echo "$OUT" | grep -q "invalid checksum"'
+check "leaves deps/ untouched" '[ -f deps/colors/colors.mana ]'
+
+cd - > /dev/null
+if [ "$KEEP" != "-k" ]; then
+    rm -rf "$WORK" 2>/dev/null
+fi
+
+echo ""
+echo "Passed: $PASSED, Failed: $FAILED"
+[ $FAILED -eq 0 ]
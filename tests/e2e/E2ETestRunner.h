@@ -7,12 +7,21 @@
 #include <regex>
 #include <chrono>
 #include <cstdlib>
+#include <cstdint>
+#include <cstdio>
 #include <filesystem>
+#include <algorithm>
+#include <mutex>
+#include "../../tools/common/FileUtil.h"
+#include "../../tools/common/Parallel.h"
 
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <sys/wait.h>
 #endif
 
@@ -43,6 +52,10 @@ struct E2ETestResult {
     std::string expected_output;
     int exit_code;
     std::chrono::milliseconds duration;
+    std::chrono::milliseconds compile_duration{0};  // mana -> C++
+    std::chrono::milliseconds cpp_duration{0};      // C++ -> executable
+    std::chrono::milliseconds run_duration{0};
+    bool cached = false;                             // Build reused from a previous run
 };
 
 struct E2ETestSummary {
@@ -60,14 +73,23 @@ public:
         std::string mana_compiler;      // Path to mana.exe
         std::string cpp_compiler;       // Path to C++ compiler (cl, g++, clang++)
         std::string runtime_header;     // Path to mana_runtime.h
-        std::string output_dir;         // Directory for compiled files
+        std::string output_dir;         // Directory for compiled files, one subdirectory per test
         int timeout_seconds = 30;       // Default timeout
+        int jobs = 0;                   // Tests run at once; 0 = one per hardware thread
         bool verbose = false;           // Verbose output
         bool keep_artifacts = false;    // Keep compiled files after test
+        bool use_cache = true;          // Reuse builds whose inputs are unchanged (keeps artifacts)
     };
 
     explicit E2ETestRunner(const Config& config) : config_(config) {}
 
+    static std::string read_file(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+
     // Parse expectations from a test file
     std::vector<Expectation> parse_expectations(const std::string& file_path) {
         std::vector<Expectation> expectations;
@@ -138,6 +160,38 @@ public:
         return expectations;
     }
 
+    // Extra compiler options from "// mana-flags: <options>" lines, such as
+    // --allocator=bump; they are part of the source, so the build key covers them
+    std::string parse_mana_flags(const std::string& file_path) {
+        std::string flags;
+        std::ifstream in(file_path);
+        std::string line;
+        while (std::getline(in, line)) {
+            size_t pos = line.find("// mana-flags:");
+            if (pos == std::string::npos) continue;
+            std::string value = line.substr(pos + 14);
+            size_t start = value.find_first_not_of(" \t");
+            if (start == std::string::npos) continue;
+            flags += " " + value.substr(start);
+        }
+        return flags;
+    }
+
+    // "// mana-build: cli" builds the test the way users do, with
+    // `mana <file> -o <exe>`, so the executable uses the runtime header the
+    // compiler writes out instead of backend-cpp/mana_runtime.h
+    bool parse_cli_build(const std::string& file_path) {
+        std::ifstream in(file_path);
+        std::string line;
+        while (std::getline(in, line)) {
+            size_t pos = line.find("// mana-build:");
+            if (pos != std::string::npos && line.find("cli", pos + 14) != std::string::npos) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     // Build expected output from Output expectations
     std::string build_expected_output(const std::vector<Expectation>& expectations) {
         std::string output;
@@ -234,19 +288,79 @@ public:
         CloseHandle(pi.hProcess);
         CloseHandle(pi.hThread);
 #else
-        // Unix implementation using popen
-        FILE* pipe = popen((cmd + " 2>&1").c_str(), "r");
-        if (!pipe) {
-            result.stderr_output = "Failed to run command";
+        // Separate stdout/stderr pipes, drained together so neither fills up;
+        // the command runs in its own process group so a timeout kills it whole
+        int out_pipe[2], err_pipe[2];
+        if (pipe(out_pipe) != 0) {
+            result.stderr_output = "Failed to create pipes";
             return result;
         }
+        if (pipe(err_pipe) != 0) {
+            close(out_pipe[0]);
+            close(out_pipe[1]);
+            result.stderr_output = "Failed to create pipes";
+            return result;
+        }
+        // Tests start processes from several threads; keep other children's
+        // pipe ends out of this one
+        for (int fd : {out_pipe[0], out_pipe[1], err_pipe[0], err_pipe[1]}) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
 
+        pid_t pid = fork();
+        if (pid < 0) {
+            for (int fd : {out_pipe[0], out_pipe[1], err_pipe[0], err_pipe[1]}) close(fd);
+            result.stderr_output = "Failed to run command";
+            return result;
+        }
+        if (pid == 0) {
+            setpgid(0, 0);
+            dup2(out_pipe[1], STDOUT_FILENO);
+            dup2(err_pipe[1], STDERR_FILENO);
+            execl("/bin/sh", "sh", "-c", cmd.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        setpgid(pid, pid);
+        close(out_pipe[1]);
+        close(err_pipe[1]);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_sec);
+        struct pollfd fds[2] = {{out_pipe[0], POLLIN, 0}, {err_pipe[0], POLLIN, 0}};
+        std::string* sinks[2] = {&result.stdout_output, &result.stderr_output};
+        int open_fds = 2;
         char buffer[4096];
-        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            result.stdout_output += buffer;
+        while (open_fds > 0) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                result.timed_out = true;
+                kill(-pid, SIGKILL);
+                break;
+            }
+            if (poll(fds, 2, static_cast<int>(remaining)) < 0) break;
+            for (int i = 0; i < 2; i++) {
+                if (fds[i].fd < 0 || !(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+                ssize_t n = read(fds[i].fd, buffer, sizeof(buffer));
+                if (n > 0) {
+                    sinks[i]->append(buffer, static_cast<size_t>(n));
+                } else {
+                    close(fds[i].fd);
+                    fds[i].fd = -1;
+                    open_fds--;
+                }
+            }
+        }
+        for (auto& f : fds) {
+            if (f.fd >= 0) close(f.fd);
         }
 
-        result.exit_code = WEXITSTATUS(pclose(pipe));
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (WIFEXITED(status)) {
+            result.exit_code = WEXITSTATUS(status);
+        } else if (WIFSIGNALED(status)) {
+            result.exit_code = 128 + WTERMSIG(status);
+        }
 #endif
 
         return result;
@@ -273,7 +387,7 @@ public:
         result.passed = false;
         result.exit_code = -1;
 
-        auto start = std::chrono::high_resolution_clock::now();
+        auto start = std::chrono::steady_clock::now();
 
         // Extract test name from file path
         std::filesystem::path p(test_file);
@@ -285,8 +399,7 @@ public:
         if (expectations.empty()) {
             result.message = "No expectations found in test file";
             result.passed = false;
-            auto end = std::chrono::high_resolution_clock::now();
-            result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+            result.duration = elapsed_since(start);
             return result;
         }
 
@@ -303,81 +416,44 @@ public:
             }
         }
 
-        // Step 1: Compile Mana to C++
-        std::string base_name = result.name;
-        std::string cpp_file = config_.output_dir + "/" + base_name + ".cpp";
-        std::string exe_file = config_.output_dir + "/" + base_name;
+        // Each test builds in its own directory, so parallel tests never share files
+        std::filesystem::path test_dir = std::filesystem::path(config_.output_dir) / result.name;
+        std::filesystem::create_directories(test_dir);
+        std::string cpp_file = (test_dir / (result.name + ".cpp")).string();
+        std::string exe_file = (test_dir / result.name).string();
 #ifdef _WIN32
         exe_file += ".exe";
 #endif
-
-        std::string mana_cmd = config_.mana_compiler + " \"" + test_file + "\" --emit-cpp -o \"" + cpp_file + "\"";
-        if (config_.verbose) {
-            std::cout << "  [MANA] " << mana_cmd << "\n";
-        }
-
-        auto mana_result = run_command(mana_cmd, config_.timeout_seconds);
-
-        if (mana_result.exit_code != 0) {
-            if (expect_compile_error) {
-                // Check if the error message matches
-                if (expected_compile_error_msg.empty() ||
-                    mana_result.stderr_output.find(expected_compile_error_msg) != std::string::npos ||
-                    mana_result.stdout_output.find(expected_compile_error_msg) != std::string::npos) {
-                    result.passed = true;
-                    result.message = "Compile error as expected";
-                } else {
-                    result.passed = false;
-                    result.message = "Compile error but message didn't match";
-                    result.actual_output = mana_result.stderr_output + mana_result.stdout_output;
-                }
-            } else {
-                result.message = "Mana compilation failed: " + mana_result.stderr_output;
-                result.actual_output = mana_result.stdout_output + mana_result.stderr_output;
+        std::string key_file = (test_dir / "inputs.key").string();
+
+        // Builds are reused when the source, its expectations and the toolchain
+        // are unchanged. Expected compile errors are always rechecked.
+        std::string key = build_key(test_file, expectations);
+        bool use_cache = config_.use_cache && !expect_compile_error;
+        if (use_cache && std::filesystem::exists(exe_file) && read_file(key_file) == key) {
+            result.cached = true;
+        } else {
+            // Forget the old key first, so a failed rebuild is never reused
+            std::filesystem::remove(key_file);
+            if (!build(test_file, parse_mana_flags(test_file), parse_cli_build(test_file), cpp_file, exe_file,
+                       expect_compile_error, expected_compile_error_msg, result)) {
+                result.duration = elapsed_since(start);
+                return result;
+            }
+            if (use_cache) {
+                std::ofstream(key_file, std::ios::binary) << key;
             }
-            auto end = std::chrono::high_resolution_clock::now();
-            result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-            return result;
-        }
-
-        if (expect_compile_error) {
-            result.passed = false;
-            result.message = "Expected compile error but compilation succeeded";
-            auto end = std::chrono::high_resolution_clock::now();
-            result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-            return result;
-        }
-
-        // Step 2: Compile C++ to executable
-        std::string cpp_cmd;
-#ifdef _WIN32
-        // Use MSVC cl.exe
-        cpp_cmd = config_.cpp_compiler + " /nologo /EHsc /std:c++17 /Fe\"" + exe_file + "\" \"" + cpp_file + "\" /I\"" + std::filesystem::path(config_.runtime_header).parent_path().string() + "\"";
-#else
-        // Use g++ or clang++
-        cpp_cmd = config_.cpp_compiler + " -std=c++17 -o \"" + exe_file + "\" \"" + cpp_file + "\" -I\"" + std::filesystem::path(config_.runtime_header).parent_path().string() + "\"";
-#endif
-
-        if (config_.verbose) {
-            std::cout << "  [C++] " << cpp_cmd << "\n";
-        }
-
-        auto cpp_result = run_command(cpp_cmd, config_.timeout_seconds);
-        if (cpp_result.exit_code != 0) {
-            result.message = "C++ compilation failed: " + cpp_result.stderr_output;
-            result.actual_output = cpp_result.stdout_output + cpp_result.stderr_output;
-            auto end = std::chrono::high_resolution_clock::now();
-            result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-            return result;
         }
 
         // Step 3: Run the executable
         std::string run_cmd = "\"" + exe_file + "\"";
         if (config_.verbose) {
-            std::cout << "  [RUN] " << run_cmd << "\n";
+            std::cout << "  [RUN] " + run_cmd + "\n";
         }
 
+        auto run_start = std::chrono::steady_clock::now();
         auto run_result = run_command(run_cmd, config_.timeout_seconds);
+        result.run_duration = elapsed_since(run_start);
         result.exit_code = run_result.exit_code;
         result.actual_output = normalize_output(run_result.stdout_output);
 
@@ -385,6 +461,11 @@ public:
         bool all_passed = true;
         std::vector<std::string> failures;
 
+        if (run_result.timed_out) {
+            all_passed = false;
+            failures.push_back(timeout_message("Run"));
+        }
+
         for (const auto& exp : expectations) {
             switch (exp.type) {
                 case ExpectType::Output: {
@@ -436,18 +517,12 @@ public:
             }
         }
 
-        // Cleanup
-        if (!config_.keep_artifacts) {
-            std::filesystem::remove(cpp_file);
-            std::filesystem::remove(exe_file);
-#ifdef _WIN32
-            // Also remove .obj file
-            std::filesystem::remove(config_.output_dir + "/" + base_name + ".obj");
-#endif
+        // Cleanup; cached builds stay for the next run
+        if (!config_.keep_artifacts && !config_.use_cache) {
+            std::filesystem::remove_all(test_dir);
         }
 
-        auto end = std::chrono::high_resolution_clock::now();
-        result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        result.duration = elapsed_since(start);
         return result;
     }
 
@@ -459,7 +534,7 @@ public:
         summary.failed = 0;
         summary.skipped = 0;
 
-        auto start = std::chrono::high_resolution_clock::now();
+        auto start = std::chrono::steady_clock::now();
 
         // Find all .mana files in test directory
         std::vector<std::string> test_files;
@@ -472,61 +547,35 @@ public:
         // Sort for consistent ordering
         std::sort(test_files.begin(), test_files.end());
 
-        std::cout << "\nRunning " << test_files.size() << " end-to-end tests\n\n";
-
-        for (const auto& test_file : test_files) {
-            summary.total++;
-            auto result = run_test(test_file);
-            summary.results.push_back(result);
-
-            // Print result
-            std::string status;
-#ifdef _WIN32
-            HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-            if (result.passed) {
-                SetConsoleTextAttribute(hConsole, FOREGROUND_GREEN);
-                status = "PASS";
-                summary.passed++;
-            } else {
-                SetConsoleTextAttribute(hConsole, FOREGROUND_RED);
-                status = "FAIL";
-                summary.failed++;
-            }
-            std::cout << "[" << status << "]";
-            SetConsoleTextAttribute(hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
-#else
-            if (result.passed) {
-                status = "\033[32mPASS\033[0m";
-                summary.passed++;
-            } else {
-                status = "\033[31mFAIL\033[0m";
-                summary.failed++;
-            }
-            std::cout << "[" << status << "]";
-#endif
-            std::cout << " " << result.name << " (" << result.duration.count() << "ms)\n";
-
-            if (!result.passed && !result.message.empty()) {
-                std::cout << "       " << result.message << "\n";
-                if (config_.verbose && !result.actual_output.empty()) {
-                    std::cout << "       Actual output:\n";
-                    std::istringstream iss(result.actual_output);
-                    std::string line;
-                    while (std::getline(iss, line)) {
-                        std::cout << "         " << line << "\n";
-                    }
-                    if (!result.expected_output.empty()) {
-                        std::cout << "       Expected output:\n";
-                        std::istringstream ess(result.expected_output);
-                        while (std::getline(ess, line)) {
-                            std::cout << "         " << line << "\n";
-                        }
-                    }
-                }
+        // Hash the toolchain once; every test's build key includes it
+        toolchain_hash_ = tools::hash_bytes(read_file(config_.mana_compiler));
+        toolchain_hash_ = tools::hash_bytes(config_.cpp_compiler, toolchain_hash_);
+        toolchain_hash_ = tools::hash_bytes(read_file(config_.runtime_header), toolchain_hash_);
+
+        unsigned jobs = static_cast<unsigned>(std::min<size_t>(tools::job_count(config_.jobs), test_files.size()));
+
+        std::cout << "\nRunning " << test_files.size() << " end-to-end tests (" << jobs << " job"
+                  << (jobs != 1 ? "s" : "") << ")\n\n";
+
+        // Tests finish in any order but are reported in file order
+        std::vector<E2ETestResult> results(test_files.size());
+        std::vector<bool> done(test_files.size(), false);
+        size_t next_report = 0;
+        std::mutex report_mutex;
+        tools::parallel_for(test_files.size(), jobs, [&](size_t i) {
+            E2ETestResult result = run_test(test_files[i]);
+            std::lock_guard<std::mutex> lock(report_mutex);
+            results[i] = std::move(result);
+            done[i] = true;
+            while (next_report < results.size() && done[next_report]) {
+                report_result(results[next_report++], summary);
             }
-        }
+        });
+
+        summary.total = static_cast<int>(results.size());
+        summary.results = std::move(results);
 
-        auto end = std::chrono::high_resolution_clock::now();
+        auto end = std::chrono::steady_clock::now();
         summary.total_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
 
         // Print summary
@@ -552,7 +601,12 @@ public:
 #endif
         }
         std::cout << "\n";
+        int cached = 0;
+        for (const auto& r : summary.results) {
+            if (r.cached) cached++;
+        }
         std::cout << "  " << summary.passed << " passed, " << summary.failed << " failed";
+        if (cached > 0) std::cout << ", " << cached << " cached build" << (cached != 1 ? "s" : "");
         std::cout << " (" << summary.total_duration.count() << "ms)\n\n";
 
         return summary;
@@ -560,6 +614,204 @@ public:
 
 private:
     Config config_;
+    uint64_t toolchain_hash_ = 0;
+
+    // Print one finished test and count it
+    void report_result(const E2ETestResult& result, E2ETestSummary& summary) {
+        // Print result
+        std::string status;
+#ifdef _WIN32
+        HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+        if (result.passed) {
+            SetConsoleTextAttribute(hConsole, FOREGROUND_GREEN);
+            status = "PASS";
+            summary.passed++;
+        } else {
+            SetConsoleTextAttribute(hConsole, FOREGROUND_RED);
+            status = "FAIL";
+            summary.failed++;
+        }
+        std::cout << "[" << status << "]";
+        SetConsoleTextAttribute(hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+#else
+        if (result.passed) {
+            status = "\033[32mPASS\033[0m";
+            summary.passed++;
+        } else {
+            status = "\033[31mFAIL\033[0m";
+            summary.failed++;
+        }
+        std::cout << "[" << status << "]";
+#endif
+        std::cout << " " << result.name << " (" << result.duration.count() << "ms: ";
+        if (result.cached) {
+            std::cout << "cached build";
+        } else {
+            std::cout << "mana " << result.compile_duration.count() << "ms, c++ " << result.cpp_duration.count() << "ms";
+        }
+        std::cout << ", run " << result.run_duration.count() << "ms)\n";
+
+        if (!result.passed && !result.message.empty()) {
+            std::cout << "       " << result.message << "\n";
+            if (config_.verbose && !result.actual_output.empty()) {
+                std::cout << "       Actual output:\n";
+                std::istringstream iss(result.actual_output);
+                std::string line;
+                while (std::getline(iss, line)) {
+                    std::cout << "         " << line << "\n";
+                }
+                if (!result.expected_output.empty()) {
+                    std::cout << "       Expected output:\n";
+                    std::istringstream ess(result.expected_output);
+                    while (std::getline(ess, line)) {
+                        std::cout << "         " << line << "\n";
+                    }
+                }
+            }
+        }
+    }
+
+    // Steps 1 and 2: Mana to C++, then C++ to an executable (one step for
+    // CLI builds). Returns false when the test is decided here (including
+    // an expected compile error).
+    bool build(const std::string& test_file, const std::string& mana_flags, bool cli,
+               const std::string& cpp_file, const std::string& exe_file,
+               bool expect_compile_error, const std::string& expected_compile_error_msg,
+               E2ETestResult& result) {
+        // --emit-cpp prints the program; --no-cache keeps parallel builds
+        // away from the shared incremental cache
+        std::string mana_cmd = config_.mana_compiler + " \"" + test_file + "\" --emit-cpp --no-cache" + mana_flags;
+        if (cli) {
+            // mana -o writes its C++, runtime header and CMake build next to
+            // the source, so it builds a copy in the test's own directory
+            std::filesystem::path source = std::filesystem::path(exe_file).parent_path() /
+                                           std::filesystem::path(test_file).filename();
+            std::error_code ec;
+            std::filesystem::copy_file(test_file, source, std::filesystem::copy_options::overwrite_existing, ec);
+            if (ec) {
+                result.message = "Cannot copy " + test_file + ": " + ec.message();
+                return false;
+            }
+            mana_cmd = config_.mana_compiler + " \"" + source.string() + "\" --no-cache" + mana_flags +
+                       " -o \"" + exe_file + "\"";
+        }
+        if (config_.verbose) {
+            std::cout << "  [MANA] " + mana_cmd + "\n";
+        }
+
+        auto compile_start = std::chrono::steady_clock::now();
+        auto mana_result = run_command(mana_cmd, config_.timeout_seconds);
+        result.compile_duration = elapsed_since(compile_start);
+
+        if (mana_result.timed_out) {
+            result.message = timeout_message("Mana compilation");
+            result.actual_output = mana_result.stdout_output + mana_result.stderr_output;
+            return false;
+        }
+        if (mana_result.exit_code != 0) {
+            if (expect_compile_error) {
+                // Check if the error message matches
+                if (expected_compile_error_msg.empty() ||
+                    mana_result.stderr_output.find(expected_compile_error_msg) != std::string::npos ||
+                    mana_result.stdout_output.find(expected_compile_error_msg) != std::string::npos) {
+                    result.passed = true;
+                    result.message = "Compile error as expected";
+                } else {
+                    result.passed = false;
+                    result.message = "Compile error but message didn't match";
+                    result.actual_output = mana_result.stderr_output + mana_result.stdout_output;
+                }
+            } else {
+                result.message = "Mana compilation failed: " + mana_result.stderr_output;
+                result.actual_output = mana_result.stdout_output + mana_result.stderr_output;
+            }
+            return false;
+        }
+
+        if (expect_compile_error) {
+            result.passed = false;
+            result.message = "Expected compile error but compilation succeeded";
+            return false;
+        }
+
+        if (cli) {
+            return true;
+        }
+
+        std::ofstream(cpp_file, std::ios::binary) << mana_result.stdout_output;
+
+        std::string cpp_cmd;
+#ifdef _WIN32
+        // Use MSVC cl.exe; objects go next to the executable
+        cpp_cmd = config_.cpp_compiler + " /nologo /EHsc /std:c++17 /Fe\"" + exe_file + "\" /Fo\"" + std::filesystem::path(exe_file).parent_path().generic_string() + "/\" \"" + cpp_file + "\" /I\"" + std::filesystem::path(config_.runtime_header).parent_path().string() + "\"";
+#else
+        // Use g++ or clang++
+        cpp_cmd = config_.cpp_compiler + " -std=c++17 -o \"" + exe_file + "\" \"" + cpp_file + "\" -I\"" + std::filesystem::path(config_.runtime_header).parent_path().string() + "\"";
+#endif
+
+        if (config_.verbose) {
+            std::cout << "  [C++] " + cpp_cmd + "\n";
+        }
+
+        auto cpp_start = std::chrono::steady_clock::now();
+        auto cpp_result = run_command(cpp_cmd, config_.timeout_seconds);
+        result.cpp_duration = elapsed_since(cpp_start);
+        if (cpp_result.timed_out) {
+            result.message = timeout_message("C++ compilation");
+            result.actual_output = cpp_result.stdout_output + cpp_result.stderr_output;
+            return false;
+        }
+        if (cpp_result.exit_code != 0) {
+            result.message = "C++ compilation failed: " + cpp_result.stderr_output;
+            result.actual_output = cpp_result.stdout_output + cpp_result.stderr_output;
+            return false;
+        }
+        return true;
+    }
+
+    // Identifies a test's build: source text (with the files it imports),
+    // parsed expectations and the toolchain (compiler binary, C++ compiler,
+    // runtime header)
+    std::string build_key(const std::string& test_file, const std::vector<Expectation>& expectations) const {
+        std::vector<std::string> seen;
+        uint64_t h = hash_source(test_file, toolchain_hash_, seen);
+        for (const auto& exp : expectations) {
+            h = tools::hash_bytes(std::to_string(static_cast<int>(exp.type)) + ":" + exp.value + "\n", h);
+        }
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(h));
+        return hex;
+    }
+
+    // Hashes a source file and, recursively, every `import "<path>";` in it
+    static uint64_t hash_source(const std::string& file, uint64_t h, std::vector<std::string>& seen) {
+        std::string canonical = std::filesystem::weakly_canonical(file).string();
+        if (std::find(seen.begin(), seen.end(), canonical) != seen.end()) return h;
+        seen.push_back(canonical);
+
+        std::string source = read_file(file);
+        h = tools::hash_bytes(source, h);
+        static const std::regex import_re(R"re(^\s*import\s+"([^"]+)"\s*;)re");
+        std::filesystem::path dir = std::filesystem::path(file).parent_path();
+        std::istringstream lines(source);
+        std::string line;
+        std::smatch m;
+        while (std::getline(lines, line)) {
+            if (std::regex_search(line, m, import_re)) {
+                h = hash_source((dir / (m[1].str() + ".mana")).string(), h, seen);
+            }
+        }
+        return h;
+    }
+
+    // A step killed at the timeout has cut-off output, so the message names it
+    std::string timeout_message(const std::string& step) const {
+        return step + " timed out after " + std::to_string(config_.timeout_seconds * 1000LL) + " ms";
+    }
+
+    static std::chrono::milliseconds elapsed_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    }
 };
 
 } // namespace mana::e2e
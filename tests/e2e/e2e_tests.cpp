@@ -30,6 +30,12 @@ int main(int argc, char* argv[]) {
             config.verbose = true;
         } else if (arg == "-k" || arg == "--keep") {
             config.keep_artifacts = true;
+        } else if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+            config.jobs = std::atoi(argv[++i]);
+        } else if (arg == "--no-cache") {
+            config.use_cache = false;
+        } else if (arg == "--timeout" && i + 1 < argc) {
+            config.timeout_seconds = std::atoi(argv[++i]);
         } else if (arg == "--compiler" && i + 1 < argc) {
             config.mana_compiler = argv[++i];
         } else if (arg == "--cpp" && i + 1 < argc) {
@@ -41,6 +47,9 @@ int main(int argc, char* argv[]) {
             std::cout << "Options:\n";
             std::cout << "  -v, --verbose       Show detailed output\n";
             std::cout << "  -k, --keep          Keep compiled artifacts\n";
+            std::cout << "  -j, --jobs <n>      Tests to run at once (default: one per core)\n";
+            std::cout << "  --no-cache          Rebuild every test, even if unchanged\n";
+            std::cout << "  --timeout <sec>     Per-step timeout (default: 30)\n";
             std::cout << "  --compiler <path>   Path to mana compiler\n";
             std::cout << "  --cpp <compiler>    C++ compiler to use\n";
             std::cout << "  --dir <path>        Test directory\n";
@@ -0,0 +1,48 @@
+// Parser tests for tools/json: numbers read back through Value::as_int.
+#include "json/Json.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+using mana::json::Document;
+
+static int failures = 0;
+
+// Parses {"n": <number>} and checks n.as_int(-1)
+static void check_int(const std::string& number, int64_t expected) {
+    std::string buffer = "{\"n\":" + number + "}";
+    Document doc;
+    if (!doc.parse(buffer)) {
+        std::cout << "FAIL " << number << ": " << doc.error() << "\n";
+        ++failures;
+        return;
+    }
+    int64_t got = doc.root()["n"].as_int(-1);
+    if (got != expected) {
+        std::cout << "FAIL " << number << ": as_int gave " << got << ", expected " << expected << "\n";
+        ++failures;
+    }
+}
+
+int main() {
+    std::cout << "\n=== Mana JSON Parser Tests ===\n";
+
+    check_int("0", 0);
+    check_int("42", 42);
+    check_int("-17", -17);
+    check_int("9223372036854775807", INT64_MAX);
+    check_int("-9223372036854775808", INT64_MIN);
+    check_int("2.9", 2);
+    check_int("-2.9", -2);
+    check_int("1e3", 1000);
+
+    // No int64 value: the fallback comes back
+    check_int("9223372036854775808", -1);
+    check_int("-10000000000000000000", -1);
+    check_int("1e300", -1);
+    check_int("-1e300", -1);
+    check_int("1e400", -1);  // strtod gives infinity
+
+    std::cout << (failures == 0 ? "All JSON tests passed\n" : "Some JSON tests failed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// File helpers shared by the tools' caches and file walks (fmt, lint, doc,
+// the LSP workspace index, pkg) and the E2E runner. Header-only, so the
+// standalone test runners can use them without linking anything.
+namespace mana::tools {
+
+    // 64-bit FNV-1a: enough to tell whether a file or a build's inputs
+    // changed. Pass a previous result as `h` to hash several pieces as one.
+    inline uint64_t hash_bytes(const std::string& data, uint64_t h = 14695981039346656037ull) {
+        for (unsigned char c : data) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    // Hidden directories (.git, .mana_cache, ...) are never searched for sources
+    inline bool is_hidden_dir(const std::filesystem::directory_entry& entry) {
+        std::string name = entry.path().filename().string();
+        std::error_code ec;
+        return name.size() > 1 && name[0] == '.' && entry.is_directory(ec);
+    }
+
+    // The .mana files under each path (directories recursively, files as
+    // given), sorted and without duplicates
+    inline std::vector<std::string> collect_mana_files(const std::vector<std::string>& paths) {
+        namespace fs = std::filesystem;
+        std::vector<std::string> files;
+        for (const auto& path : paths) {
+            std::error_code ec;
+            if (!fs::is_directory(path, ec)) {
+                files.push_back(path);
+                continue;
+            }
+            fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, ec), end;
+            for (; !ec && it != end; it.increment(ec)) {
+                if (is_hidden_dir(*it)) {
+                    it.disable_recursion_pending();
+                    continue;
+                }
+                if (it->is_regular_file(ec) && it->path().extension() == ".mana") {
+                    files.push_back(it->path().string());
+                }
+            }
+        }
+        std::sort(files.begin(), files.end());
+        files.erase(std::unique(files.begin(), files.end()), files.end());
+        return files;
+    }
+
+    // Replaces `path` with `content` by writing a temporary file next to it
+    // and renaming it over, so a concurrent reader never sees a partial file.
+    // Creates missing parent directories.
+    inline bool write_file_atomic(const std::filesystem::path& path, const std::string& content) {
+        namespace fs = std::filesystem;
+        static std::atomic<unsigned> counter{0};
+        std::error_code ec;
+        if (path.has_parent_path()) fs::create_directories(path.parent_path(), ec);
+
+        // Unique per process and per call, so concurrent writers never share one
+        fs::path tmp = path;
+        tmp += ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+               "-" + std::to_string(counter++);
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            out.write(content.data(), static_cast<std::streamsize>(content.size()));
+            if (!out) {
+                out.close();
+                fs::remove(tmp, ec);
+                return false;
+            }
+        }
+        fs::rename(tmp, path, ec);
+        if (ec) {
+            fs::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace mana::tools
@@ -0,0 +1,59 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// The worker pool behind every `--jobs` option (fmt, lint, doc, test, pkg,
+// the LSP workspace index) and the E2E runner. Header-only, like
+// FileUtil.h, so the standalone test runners can use it.
+namespace mana::tools {
+
+    // Threads for a --jobs value: the value itself when positive, otherwise
+    // one per core
+    inline unsigned job_count(int jobs) {
+        if (jobs > 0) return static_cast<unsigned>(jobs);
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Calls fn(i) for every i in [0, count) on up to `jobs` threads, the
+    // calling one included, each pulling the next index. If a call throws,
+    // no further indices are started and the first exception is rethrown
+    // once every thread has finished. When no more threads can be started,
+    // the ones already running do all the work.
+    template <typename Fn>
+    void parallel_for(size_t count, unsigned jobs, Fn&& fn) {
+        std::atomic<size_t> next{0};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        auto work = [&] {
+            for (size_t i; (i = next.fetch_add(1)) < count;) {
+                try {
+                    fn(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                    next = count;
+                }
+            }
+        };
+
+        size_t workers = std::min<size_t>(std::max(jobs, 1u), count);
+        std::vector<std::thread> pool;
+        for (size_t w = 1; w < workers; ++w) {
+            try {
+                pool.emplace_back(work);
+            } catch (const std::system_error&) {
+                break;
+            }
+        }
+        work();
+        for (auto& t : pool) t.join();
+        if (error) std::rethrow_exception(error);
+    }
+
+} // namespace mana::tools
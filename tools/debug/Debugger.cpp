@@ -3,6 +3,13 @@
 #include <sstream>
 #include <cstring>
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -26,6 +33,8 @@ Debugger::Debugger()
     , m_nextBreakpointId(1)
     , m_nextWatchId(1)
     , m_nextVariableRef(1)
+    , m_hasSourceMap(false)
+    , m_launchPending(false)
     , m_stopOnEntry(true)
     , m_enableLogging(false)
 #ifdef _WIN32
@@ -44,22 +53,58 @@ Debugger::~Debugger() {
 }
 
 void Debugger::run() {
+    // Requests are read on a thread of their own, so that the program's
+    // stops are reported while the client is quiet. The inbox outlives
+    // this object: the reader may still be blocked on stdin at exit.
+    struct Inbox {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<std::string> messages;
+        bool closed = false;
+    };
+    auto inbox = std::make_shared<Inbox>();
+    std::thread([inbox] {
+        std::string message;
+        while (readMessage(message)) {
+            std::lock_guard<std::mutex> lock(inbox->mutex);
+            inbox->messages.push_back(std::move(message));
+            inbox->ready.notify_one();
+        }
+        std::lock_guard<std::mutex> lock(inbox->mutex);
+        inbox->closed = true;
+        inbox->ready.notify_one();
+    }).detach();
+
     while (m_running) {
-        auto msg = readMessage();
-        if (msg) {
-            processMessage(*msg);
-        } else {
-            break;
+        {
+            std::unique_lock<std::mutex> lock(inbox->mutex);
+            auto pending = [&inbox] { return !inbox->messages.empty() || inbox->closed; };
+            // A running program is polled for stops in between
+            if (m_process.running()) {
+                inbox->ready.wait_for(lock, std::chrono::milliseconds(10), pending);
+            } else {
+                inbox->ready.wait(lock, pending);
+            }
+            if (!inbox->messages.empty()) {
+                m_buffer = std::move(inbox->messages.front());
+                inbox->messages.pop_front();
+            } else if (inbox->closed) {
+                break;
+            } else {
+                m_buffer.clear();
+            }
         }
+        if (!m_buffer.empty()) processMessage(m_buffer);
+        pollProcess();
     }
 }
 
-std::optional<std::string> Debugger::readMessage() {
+bool Debugger::readMessage(std::string& out) {
     // Read Content-Length header
     std::string header;
     while (true) {
         int c = std::cin.get();
-        if (c == EOF) return std::nullopt;
+        if (c == EOF) return false;
         if (c == '\r') {
             c = std::cin.get(); // consume \n
             if (std::cin.peek() == '\r') {
@@ -77,16 +122,15 @@ std::optional<std::string> Debugger::readMessage() {
     size_t contentLength = 0;
     size_t pos = header.find("Content-Length:");
     if (pos != std::string::npos) {
-        contentLength = std::stoul(header.substr(pos + 15));
+        contentLength = static_cast<size_t>(std::strtoull(header.c_str() + pos + 15, nullptr, 10));
     }
 
-    if (contentLength == 0) return std::nullopt;
+    if (contentLength == 0) return false;
 
     // Read content
-    std::string content(contentLength, '\0');
-    std::cin.read(&content[0], contentLength);
-
-    return content;
+    out.resize(contentLength);
+    std::cin.read(&out[0], static_cast<std::streamsize>(contentLength));
+    return static_cast<size_t>(std::cin.gcount()) == contentLength;
 }
 
 void Debugger::writeMessage(const std::string& json) {
@@ -96,52 +140,41 @@ void Debugger::writeMessage(const std::string& json) {
 
 void Debugger::sendResponse(int requestSeq, const std::string& command,
                            bool success, const std::string& body) {
-    std::ostringstream ss;
-    ss << "{\"seq\":" << (++m_seq)
-       << ",\"type\":\"response\""
-       << ",\"request_seq\":" << requestSeq
-       << ",\"success\":" << (success ? "true" : "false")
-       << ",\"command\":\"" << command << "\""
-       << ",\"body\":" << body << "}";
-    writeMessage(ss.str());
+    m_output.clear();
+    json::Writer w(m_output);
+    w.begin_object()
+        .key("seq").value(++m_seq)
+        .key("type").value("response")
+        .key("request_seq").value(requestSeq)
+        .key("success").value(success)
+        .key("command").value(command)
+        .key("body").raw(body)
+    .end_object();
+    writeMessage(m_output);
 }
 
 void Debugger::sendEvent(const std::string& event, const std::string& body) {
-    std::ostringstream ss;
-    ss << "{\"seq\":" << (++m_seq)
-       << ",\"type\":\"event\""
-       << ",\"event\":\"" << event << "\""
-       << ",\"body\":" << body << "}";
-    writeMessage(ss.str());
-}
-
-void Debugger::processMessage(const std::string& json) {
-    // Parse request
-    std::string type = getJsonString(json, "type");
-    std::string command = getJsonString(json, "command");
-    int seq = getJsonInt(json, "seq");
-
-    // Extract arguments
-    size_t argsPos = json.find("\"arguments\":");
-    std::string args = "{}";
-    if (argsPos != std::string::npos) {
-        size_t start = json.find('{', argsPos);
-        if (start != std::string::npos) {
-            int depth = 0;
-            size_t end = start;
-            for (size_t i = start; i < json.length(); ++i) {
-                if (json[i] == '{') depth++;
-                else if (json[i] == '}') {
-                    depth--;
-                    if (depth == 0) {
-                        end = i;
-                        break;
-                    }
-                }
-            }
-            args = json.substr(start, end - start + 1);
-        }
+    m_output.clear();
+    json::Writer w(m_output);
+    w.begin_object()
+        .key("seq").value(++m_seq)
+        .key("type").value("event")
+        .key("event").value(event)
+        .key("body").raw(body)
+    .end_object();
+    writeMessage(m_output);
+}
+
+void Debugger::processMessage(std::string& message) {
+    // Strings are unescaped in place; args stay valid until the next read
+    if (!m_message.parse(message)) {
+        logDebug("Malformed message: " + m_message.error());
+        return;
     }
+    json::Value root = m_message.root();
+    std::string command(root["command"].as_string());
+    int seq = static_cast<int>(root["seq"].as_int());
+    json::Value args = root["arguments"];
 
     // Dispatch to handler
     if (command == "initialize") handleInitialize(seq, args);
@@ -194,46 +227,143 @@ std::string Debugger::buildCapabilities() {
         "\"supportsTerminateThreadsRequest\":false,"
         "\"supportsSetExpression\":true,"
         "\"supportsTerminateRequest\":true,"
-        "\"supportsDataBreakpoints\":false,"
+        "\"supportsDataBreakpoints\":" + std::string(TracedProcess::supportsWatchpoints() ? "true" : "false") + ","
+        "\"supportsDataBreakpointBytes\":true,"
         "\"supportsReadMemoryRequest\":false,"
         "\"supportsDisassembleRequest\":false,"
         "\"supportsCancelRequest\":false,"
         "\"supportsBreakpointLocationsRequest\":true,"
         "\"supportsClipboardContext\":true,"
-        "\"supportsSteppingGranularity\":true"
+        "\"supportsSteppingGranularity\":false"
         "}";
 }
 
-void Debugger::handleInitialize(int seq, const std::string& args) {
+void Debugger::handleInitialize(int seq, const json::Value& args) {
     m_initialized = true;
     sendResponse(seq, "initialize", true, buildCapabilities());
     sendEvent("initialized");
 }
 
-void Debugger::handleLaunch(int seq, const std::string& args) {
-    m_programPath = getJsonString(args, "program");
-    m_workingDir = getJsonString(args, "cwd");
+void Debugger::handleLaunch(int seq, const json::Value& args) {
+    m_programPath = std::string(args["program"].as_string());
+    m_workingDir = std::string(args["cwd"].as_string());
+    m_stopOnEntry = args["stopOnEntry"].as_bool(m_stopOnEntry);
+    m_programArgs.clear();
+    for (json::Value arg : args["args"]) {
+        m_programArgs.emplace_back(arg.as_string());
+    }
+
+    m_sourceMapFile = std::string(args["sourceMap"].as_string());
+    // Debug build mode: the program is built from `source` with `mana -g`
+    // once configuration is done and every breakpoint is known
+    m_buildSource = std::string(args["source"].as_string());
+    m_compiler = std::string(args["mana"].as_string("mana"));
+    if (!m_buildSource.empty()) {
+        m_launchPending = true;
+        sendResponse(seq, "launch", true);
+        return;
+    }
 
-    bool success = launchProcess(m_programPath, m_programArgs);
+    bool success = startProgram();
     sendResponse(seq, "launch", success);
+}
+
+bool Debugger::startProgram() {
+    m_launchPending = false;
+    if (!m_buildSource.empty() && !buildProgram()) return false;
+
+    // Written next to the program by `mana -g`
+    m_hasSourceMap = loadSourceMap(m_sourceMapFile.empty() ? m_programPath + ".manamap" : m_sourceMapFile);
+    if (!launchProcess(m_programPath, m_programArgs)) return false;
+
+    // Breakpoints set before the map was loaded are bound now
+    if (m_hasSourceMap) {
+        for (auto& bp : m_breakpoints) {
+            int line = bp.line;
+            bool verified = bp.verified;
+            if (bindBreakpoint(bp) == verified && bp.line == line) continue;
+            sendBreakpointChanged(bp);
+        }
+    }
+    // The compiler bound them the same way
+    if (!m_buildSource.empty()) m_compiledBreakpoints = m_breakpoints;
+
+    std::string body;
+    json::Writer(body).begin_object()
+        .key("name").value(m_programPath)
+        .key("startMethod").value("launch")
+    .end_object();
+    sendEvent("process", body);
+    return true;
+}
+
+// One field of a .manabp line
+static std::string breakpointField(std::string text) {
+    std::replace_if(text.begin(), text.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+    return text;
+}
 
-    if (success) {
-        sendEvent("process", "{\"name\":\"" + m_programPath + "\",\"startMethod\":\"launch\"}");
+bool Debugger::buildProgram() {
+    // Read by `mana --breakpoints`
+    std::string bpFile = m_programPath + ".manabp";
+    {
+        std::ofstream out(bpFile);
+        if (!out) return false;
+        out << "# mana-debug breakpoints: id, file, line, hit condition, condition\n";
+        for (const auto& bp : m_breakpoints) {
+            if (!bp.logMessage.empty()) continue;  // Log points never stop
+            out << bp.id << '\t' << breakpointField(bp.source) << '\t' << bp.line << '\t'
+                << breakpointField(bp.hitCondition) << '\t' << breakpointField(bp.condition) << '\n';
+        }
     }
+
+    std::string command = "\"" + m_compiler + "\" --breakpoints \"" + bpFile + "\" -o \"" + m_programPath +
+                          "\" \"" + m_buildSource + "\" 2>&1";
+#ifdef _WIN32
+    FILE* pipe = _popen(command.c_str(), "r");
+#else
+    FILE* pipe = popen(command.c_str(), "r");
+#endif
+    if (!pipe) return false;
+
+    // Compiler output goes to the debug console. A breakpoint whose
+    // condition does not parse or type-check where it is bound is reported
+    // there as a warning and left out of the build
+    std::string output;
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), pipe)) > 0) {
+        output.append(chunk, n);
+    }
+#ifdef _WIN32
+    int status = _pclose(pipe);
+#else
+    int status = pclose(pipe);
+#endif
+    if (!output.empty()) {
+        std::string body;
+        json::Writer(body).begin_object()
+            .key("category").value("console")
+            .key("output").value(output)
+        .end_object();
+        sendEvent("output", body);
+    }
+    return status == 0;
 }
 
-void Debugger::handleAttach(int seq, const std::string& args) {
+void Debugger::handleAttach(int seq, const json::Value& args) {
     sendResponse(seq, "attach", false, "{\"message\":\"Attach not supported\"}");
 }
 
-void Debugger::handleDisconnect(int seq, const std::string& args) {
+void Debugger::handleDisconnect(int seq, const json::Value& args) {
     terminateProcess();
     sendResponse(seq, "disconnect", true);
     m_running = false;
 }
 
-void Debugger::handleSetBreakpoints(int seq, const std::string& args) {
-    std::string source = getJsonString(args, "source");
+void Debugger::handleSetBreakpoints(int seq, const json::Value& args) {
+    json::Value sourceArg = args["source"];
+    std::string source(sourceArg["path"].as_string(sourceArg["name"].as_string()));
 
     // Clear existing breakpoints for this source
     m_breakpoints.erase(
@@ -241,75 +371,117 @@ void Debugger::handleSetBreakpoints(int seq, const std::string& args) {
             [&source](const Breakpoint& bp) { return bp.source == source; }),
         m_breakpoints.end());
 
-    // Parse and add new breakpoints
-    std::ostringstream bpsJson;
-    bpsJson << "{\"breakpoints\":[";
-
-    // Simple parsing of breakpoints array
-    size_t bpStart = args.find("\"breakpoints\":");
-    if (bpStart != std::string::npos) {
-        size_t arrStart = args.find('[', bpStart);
-        size_t arrEnd = args.find(']', arrStart);
-        if (arrStart != std::string::npos && arrEnd != std::string::npos) {
-            std::string bpArray = args.substr(arrStart + 1, arrEnd - arrStart - 1);
-
-            bool first = true;
-            size_t pos = 0;
-            while ((pos = bpArray.find("\"line\":", pos)) != std::string::npos) {
-                int line = std::stoi(bpArray.substr(pos + 7));
-
-                Breakpoint bp;
-                bp.id = m_nextBreakpointId++;
-                bp.source = source;
-                bp.line = line;
-                bp.verified = true;
-                m_breakpoints.push_back(bp);
-
-                if (!first) bpsJson << ",";
-                bpsJson << "{\"id\":" << bp.id
-                       << ",\"verified\":true"
-                       << ",\"line\":" << bp.line << "}";
-                first = false;
-                pos += 7;
+    std::string body;
+    json::Writer w(body);
+    w.begin_object().key("breakpoints").begin_array();
+
+    for (json::Value item : args["breakpoints"]) {
+        Breakpoint bp;
+        bp.id = m_nextBreakpointId++;
+        bp.source = source;
+        bp.line = static_cast<int>(item["line"].as_int());
+        bindBreakpoint(bp);
+        bp.condition = std::string(item["condition"].as_string());
+        bp.hitCondition = std::string(item["hitCondition"].as_string());
+        bp.logMessage = std::string(item["logMessage"].as_string());
+        bp.hitCount = 0;
+        bp.enabled = true;
+        const char* message = bp.verified ? nullptr : "No code at or after this line";
+        // A built program only stops at the checks compiled into it
+        if (bp.verified && !m_buildSource.empty() && m_process.alive()) {
+            if (const Breakpoint* compiled = findCompiledBreakpoint(bp)) {
+                bp.id = compiled->id;
+            } else {
+                bp.verified = false;
+                message = "Restart the session to compile this breakpoint into the program";
             }
         }
+        m_breakpoints.push_back(bp);
+
+        w.begin_object()
+            .key("id").value(bp.id)
+            .key("verified").value(bp.verified)
+            .key("line").value(bp.line);
+        if (message) w.key("message").value(message);
+        w.end_object();
     }
 
-    bpsJson << "]}";
-    sendResponse(seq, "setBreakpoints", true, bpsJson.str());
+    w.end_array().end_object();
+    sendResponse(seq, "setBreakpoints", true, body);
 }
 
-void Debugger::handleSetExceptionBreakpoints(int seq, const std::string& args) {
+void Debugger::handleSetExceptionBreakpoints(int seq, const json::Value& args) {
     sendResponse(seq, "setExceptionBreakpoints", true);
 }
 
-void Debugger::handleConfigurationDone(int seq, const std::string& args) {
+void Debugger::handleConfigurationDone(int seq, const json::Value& args) {
     sendResponse(seq, "configurationDone", true);
 
+    if (m_launchPending && !startProgram()) {
+        sendEvent("terminated");
+        m_terminated = true;
+        return;
+    }
+    if (m_process.alive() && !m_stopOnEntry) {
+        m_process.resume();
+        return;
+    }
+
     // Notify that we stopped at entry
     sendEvent("stopped", "{\"reason\":\"entry\",\"threadId\":1,\"allThreadsStopped\":true}");
 }
 
-void Debugger::handleThreads(int seq, const std::string& args) {
+void Debugger::handleThreads(int seq, const json::Value& args) {
+    if (m_process.alive()) {
+        std::string body;
+        json::Writer w(body);
+        w.begin_object().key("threads").begin_array();
+        for (int tid : m_process.threads()) {
+            w.begin_object()
+                .key("id").value(tid)
+                .key("name").value(tid == m_process.pid() ? "main thread" : "thread " + std::to_string(tid))
+            .end_object();
+        }
+        w.end_array().end_object();
+        sendResponse(seq, "threads", true, body);
+        return;
+    }
     sendResponse(seq, "threads", true,
         "{\"threads\":[{\"id\":1,\"name\":\"main thread\"}]}");
 }
 
-void Debugger::handleStackTrace(int seq, const std::string& args) {
-    std::ostringstream ss;
-    ss << "{\"stackFrames\":[";
-
-    if (!m_programPath.empty()) {
-        ss << "{\"id\":1,\"name\":\"main\","
-           << "\"source\":{\"name\":\"" << m_programPath << "\",\"path\":\"" << m_programPath << "\"},"
-           << "\"line\":1,\"column\":1}";
+void Debugger::handleStackTrace(int seq, const json::Value& args) {
+    std::string body;
+    json::Writer w(body);
+    w.begin_object().key("stackFrames").begin_array();
+
+    if (!m_currentSource.empty()) {
+        // Stopped at a compiled breakpoint, which knows its Mana line
+        w.begin_object()
+            .key("id").value(1)
+            .key("name").value(m_currentFunction.empty() ? "main" : m_currentFunction)
+            .key("source").begin_object()
+                .key("name").value(std::filesystem::path(m_currentSource).filename().string())
+                .key("path").value(m_currentSource)
+            .end_object()
+            .key("line").value(m_currentLine)
+            .key("column").value(1)
+        .end_object();
+    } else if (!m_programPath.empty()) {
+        w.begin_object()
+            .key("id").value(1)
+            .key("name").value("main")
+            .key("source").begin_object().key("name").value(m_programPath).key("path").value(m_programPath).end_object()
+            .key("line").value(1)
+            .key("column").value(1)
+        .end_object();
     }
 
-    ss << "],\"totalFrames\":1}";
-    sendResponse(seq, "stackTrace", true, ss.str());
+    w.end_array().key("totalFrames").value(1).end_object();
+    sendResponse(seq, "stackTrace", true, body);
 }
 
-void Debugger::handleScopes(int seq, const std::string& args) {
+void Debugger::handleScopes(int seq, const json::Value& args) {
     sendResponse(seq, "scopes", true,
         "{\"scopes\":["
         "{\"name\":\"Locals\",\"variablesReference\":1,\"expensive\":false},"
@@ -317,8 +489,8 @@ void Debugger::handleScopes(int seq, const std::string& args) {
         "]}");
 }
 
-void Debugger::handleVariables(int seq, const std::string& args) {
-    int ref = getJsonInt(args, "variablesReference");
+void Debugger::handleVariables(int seq, const json::Value& args) {
+    int ref = static_cast<int>(args["variablesReference"].as_int());
 
     std::vector<Variable> vars;
 
@@ -333,25 +505,28 @@ void Debugger::handleVariables(int seq, const std::string& args) {
         vars = getWatchVariables();
     }
 
-    std::ostringstream ss;
-    ss << "{\"variables\":[";
-
-    bool first = true;
+    std::string body;
+    json::Writer w(body);
+    w.begin_object().key("variables").begin_array();
     for (const auto& v : vars) {
-        if (!first) ss << ",";
-        ss << "{\"name\":\"" << v.name << "\""
-           << ",\"value\":\"" << v.value << "\""
-           << ",\"type\":\"" << v.type << "\""
-           << ",\"variablesReference\":" << v.variablesReference << "}";
-        first = false;
+        w.begin_object()
+            .key("name").value(v.name)
+            .key("value").value(v.value)
+            .key("type").value(v.type)
+            .key("variablesReference").value(v.variablesReference)
+        .end_object();
     }
-
-    ss << "]}";
-    sendResponse(seq, "variables", true, ss.str());
+    w.end_array().end_object();
+    sendResponse(seq, "variables", true, body);
 }
 
-void Debugger::handleContinue(int seq, const std::string& args) {
+void Debugger::handleContinue(int seq, const json::Value& args) {
     sendResponse(seq, "continue", true, "{\"allThreadsContinued\":true}");
+    m_currentSource.clear();
+    if (m_process.alive()) {
+        m_process.resume();
+        return;
+    }
 
     // Simulate running to completion
     sendEvent("continued", "{\"threadId\":1,\"allThreadsContinued\":true}");
@@ -359,82 +534,65 @@ void Debugger::handleContinue(int seq, const std::string& args) {
     m_terminated = true;
 }
 
-void Debugger::handleNext(int seq, const std::string& args) {
+void Debugger::handleNext(int seq, const json::Value& args) {
+    // A traced program only stops at its compiled breakpoints: stepping
+    // would need the line table from its debug info, which is not read
+    if (m_process.alive()) {
+        sendResponse(seq, "next", false, "{\"message\":\"Stepping is not supported; set a breakpoint and continue\"}");
+        return;
+    }
     sendResponse(seq, "next", true);
     sendEvent("stopped", "{\"reason\":\"step\",\"threadId\":1,\"allThreadsStopped\":true}");
 }
 
-void Debugger::handleStepIn(int seq, const std::string& args) {
+void Debugger::handleStepIn(int seq, const json::Value& args) {
+    if (m_process.alive()) {
+        sendResponse(seq, "stepIn", false, "{\"message\":\"Stepping is not supported; set a breakpoint and continue\"}");
+        return;
+    }
     sendResponse(seq, "stepIn", true);
     sendEvent("stopped", "{\"reason\":\"step\",\"threadId\":1,\"allThreadsStopped\":true}");
 }
 
-void Debugger::handleStepOut(int seq, const std::string& args) {
+void Debugger::handleStepOut(int seq, const json::Value& args) {
+    if (m_process.alive()) {
+        sendResponse(seq, "stepOut", false, "{\"message\":\"Stepping is not supported; set a breakpoint and continue\"}");
+        return;
+    }
     sendResponse(seq, "stepOut", true);
     sendEvent("stopped", "{\"reason\":\"step\",\"threadId\":1,\"allThreadsStopped\":true}");
 }
 
-void Debugger::handlePause(int seq, const std::string& args) {
+void Debugger::handlePause(int seq, const json::Value& args) {
     sendResponse(seq, "pause", true);
+    if (m_process.running()) {
+        m_process.interrupt();  // Reported as a stop once it lands
+        return;
+    }
     sendEvent("stopped", "{\"reason\":\"pause\",\"threadId\":1,\"allThreadsStopped\":true}");
 }
 
-void Debugger::handleTerminate(int seq, const std::string& args) {
+void Debugger::handleTerminate(int seq, const json::Value& args) {
     terminateProcess();
     sendResponse(seq, "terminate", true);
     sendEvent("terminated");
     m_terminated = true;
 }
 
-void Debugger::handleEvaluate(int seq, const std::string& args) {
-    std::string expr = getJsonString(args, "expression");
-    sendResponse(seq, "evaluate", true,
-        "{\"result\":\"" + expr + "\",\"variablesReference\":0}");
+void Debugger::handleEvaluate(int seq, const json::Value& args) {
+    std::string expr(args["expression"].as_string());
+    std::string body;
+    json::Writer(body).begin_object()
+        .key("result").value(expr)
+        .key("variablesReference").value(0)
+    .end_object();
+    sendResponse(seq, "evaluate", true, body);
 }
 
-void Debugger::handleSource(int seq, const std::string& args) {
+void Debugger::handleSource(int seq, const json::Value& args) {
     sendResponse(seq, "source", false, "{\"message\":\"Source not available\"}");
 }
 
-// JSON parsing helpers
-std::string Debugger::getJsonString(const std::string& json, const std::string& key) {
-    std::string search = "\"" + key + "\":\"";
-    size_t pos = json.find(search);
-    if (pos == std::string::npos) return "";
-
-    size_t start = pos + search.length();
-    size_t end = json.find('"', start);
-    if (end == std::string::npos) return "";
-
-    return json.substr(start, end - start);
-}
-
-int Debugger::getJsonInt(const std::string& json, const std::string& key) {
-    std::string search = "\"" + key + "\":";
-    size_t pos = json.find(search);
-    if (pos == std::string::npos) return 0;
-
-    size_t start = pos + search.length();
-    while (start < json.length() && (json[start] == ' ' || json[start] == '\t')) start++;
-
-    try {
-        return std::stoi(json.substr(start));
-    } catch (...) {
-        return 0;
-    }
-}
-
-bool Debugger::getJsonBool(const std::string& json, const std::string& key) {
-    std::string search = "\"" + key + "\":";
-    size_t pos = json.find(search);
-    if (pos == std::string::npos) return false;
-
-    size_t start = pos + search.length();
-    while (start < json.length() && (json[start] == ' ' || json[start] == '\t')) start++;
-
-    return json.substr(start, 4) == "true";
-}
-
 // Process management
 bool Debugger::launchProcess(const std::string& program, const std::vector<std::string>& args) {
 #ifdef _WIN32
@@ -465,6 +623,9 @@ bool Debugger::launchProcess(const std::string& program, const std::vector<std::
     m_processId = pi.dwProcessId;
     return true;
 #else
+    // Traced where ptrace is available, so that stops reach the adapter
+    if (TracedProcess::supported()) return m_process.launch(program, args, m_workingDir);
+
     m_processPid = fork();
     if (m_processPid == 0) {
         // Child process
@@ -487,6 +648,7 @@ bool Debugger::launchProcess(const std::string& program, const std::vector<std::
 }
 
 void Debugger::terminateProcess() {
+    m_process.kill();
 #ifdef _WIN32
     if (m_processHandle) {
         TerminateProcess(m_processHandle, 0);
@@ -505,6 +667,7 @@ void Debugger::terminateProcess() {
 }
 
 bool Debugger::isProcessRunning() {
+    if (m_process.alive()) return true;
 #ifdef _WIN32
     if (!m_processHandle) return false;
     DWORD exitCode;
@@ -524,172 +687,167 @@ bool Debugger::isProcessRunning() {
 // New DAP handlers
 // ============================================================================
 
-void Debugger::handleSetVariable(int seq, const std::string& args) {
-    int varRef = getJsonInt(args, "variablesReference");
-    std::string name = getJsonString(args, "name");
-    std::string value = getJsonString(args, "value");
+void Debugger::handleSetVariable(int seq, const json::Value& args) {
+    std::string_view value = args["value"].as_string();
 
     // For now, just acknowledge the set (actual implementation would modify debuggee)
-    sendResponse(seq, "setVariable", true,
-        "{\"value\":\"" + value + "\",\"variablesReference\":0}");
+    std::string body;
+    json::Writer(body).begin_object()
+        .key("value").value(value)
+        .key("variablesReference").value(0)
+    .end_object();
+    sendResponse(seq, "setVariable", true, body);
 }
 
-void Debugger::handleDataBreakpointInfo(int seq, const std::string& args) {
-    std::string name = getJsonString(args, "name");
-    sendResponse(seq, "dataBreakpointInfo", true,
-        "{\"dataId\":null,\"description\":\"Data breakpoints not supported\",\"accessTypes\":[]}");
+// Watched memory is named by address ("0x7ffd5c10" or "&0x7ffd5c10") and
+// its dataId is "<address>/<bytes>"
+static bool parseWatchedAddress(std::string_view text, uint64_t& address, int& size) {
+    std::string s(text);
+    size_t slash = s.find('/');
+    if (slash != std::string::npos) {
+        size = std::atoi(s.c_str() + slash + 1);
+        s.resize(slash);
+    }
+    s.erase(0, s.find_first_not_of(" \t&"));
+    s.erase(s.find_last_not_of(" \t") + 1);
+    if (s.empty()) return false;
+    char* end = nullptr;
+    address = std::strtoull(s.c_str(), &end, 0);
+    return *end == '\0';
 }
 
-void Debugger::handleSetDataBreakpoints(int seq, const std::string& args) {
-    sendResponse(seq, "setDataBreakpoints", true, "{\"breakpoints\":[]}");
+void Debugger::handleDataBreakpointInfo(int seq, const json::Value& args) {
+    uint64_t address = 0;
+    int size = static_cast<int>(args["bytes"].as_int(8));
+    std::string error;
+    if (!TracedProcess::supportsWatchpoints()) {
+        error = "Data breakpoints are only supported on Linux x86";
+    } else if (!parseWatchedAddress(args["name"].as_string(), address, size)) {
+        error = "Only memory addresses can be watched";
+    } else if ((size != 1 && size != 2 && size != 4 && size != 8) || address % static_cast<uint64_t>(size) != 0) {
+        error = "A data breakpoint covers 1, 2, 4 or 8 bytes aligned to its size";
+    }
+
+    std::string body;
+    json::Writer w(body);
+    w.begin_object();
+    if (!error.empty()) {
+        w.key("dataId").null()
+            .key("description").value(error)
+            .key("accessTypes").begin_array().end_array();
+    } else {
+        char hex[32];
+        std::snprintf(hex, sizeof(hex), "0x%llx", static_cast<unsigned long long>(address));
+        w.key("dataId").value(std::string(hex) + "/" + std::to_string(size))
+            .key("description").value(std::to_string(size) + " bytes at " + hex)
+            // x86 cannot watch reads alone
+            .key("accessTypes").begin_array().value("write").value("readWrite").end_array()
+            .key("canPersist").value(false);
+    }
+    w.end_object();
+    sendResponse(seq, "dataBreakpointInfo", true, body);
 }
 
-void Debugger::handleCompletions(int seq, const std::string& args) {
-    std::string text = getJsonString(args, "text");
+void Debugger::handleSetDataBreakpoints(int seq, const json::Value& args) {
+    std::vector<Watchpoint> watchpoints;
+    std::string error;
+    for (json::Value item : args["breakpoints"]) {
+        Watchpoint wp;
+        wp.id = m_nextBreakpointId++;
+        wp.size = 8;
+        wp.readWrite = item["accessType"].as_string("write") != "write";
+        if (!parseWatchedAddress(item["dataId"].as_string(), wp.address, wp.size)) {
+            error = "Unknown data breakpoint";
+        }
+        watchpoints.push_back(wp);
+    }
+    // All of them go into the debug registers together, or none do
+    if (!error.empty() || !m_process.setWatchpoints(watchpoints, error)) {
+        std::string ignored;
+        m_process.setWatchpoints({}, ignored);
+        m_dataBreakpoints.clear();
+    } else {
+        m_dataBreakpoints = watchpoints;
+    }
 
-    // Simple completion based on known symbols
-    std::ostringstream ss;
-    ss << "{\"targets\":[";
+    std::string body;
+    json::Writer w(body);
+    w.begin_object().key("breakpoints").begin_array();
+    for (const auto& wp : watchpoints) {
+        w.begin_object()
+            .key("id").value(wp.id)
+            .key("verified").value(error.empty());
+        if (!error.empty()) w.key("message").value(error);
+        w.end_object();
+    }
+    w.end_array().end_object();
+    sendResponse(seq, "setDataBreakpoints", true, body);
+}
+
+void Debugger::handleCompletions(int seq, const json::Value& args) {
+    std::string_view text = args["text"].as_string();
 
-    bool first = true;
+    // Simple completion based on known symbols
+    std::string body;
+    json::Writer w(body);
+    w.begin_object().key("targets").begin_array();
     for (const auto& sym : m_symbols) {
-        if (sym.name.find(text) == 0) {
-            if (!first) ss << ",";
-            ss << "{\"label\":\"" << sym.name << "\","
-               << "\"type\":\"" << (sym.isGlobal ? "variable" : "local") << "\"}";
-            first = false;
+        if (std::string_view(sym.name).substr(0, text.size()) == text) {
+            w.begin_object()
+                .key("label").value(sym.name)
+                .key("type").value(sym.isGlobal ? "variable" : "local")
+            .end_object();
         }
     }
-
-    ss << "]}";
-    sendResponse(seq, "completions", true, ss.str());
+    w.end_array().end_object();
+    sendResponse(seq, "completions", true, body);
 }
 
 // ============================================================================
 // Source mapping
 // ============================================================================
 
-bool Debugger::loadSourceMap(const std::string& mapFile) {
-    std::ifstream file(mapFile);
-    if (!file.is_open()) return false;
-
-    m_sourceMappings.clear();
-    std::string line;
-
-    // Format: manaLine,manaCol,cppLine,manaFile,cppFile,functionName
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') continue;
-
-        SourceMapping mapping;
-        std::istringstream ss(line);
-        std::string token;
-
-        if (!std::getline(ss, token, ',')) continue;
-        mapping.manaLine = std::stoi(token);
-
-        if (!std::getline(ss, token, ',')) continue;
-        mapping.manaColumn = std::stoi(token);
-
-        if (!std::getline(ss, token, ',')) continue;
-        mapping.cppLine = std::stoi(token);
-
-        if (!std::getline(ss, mapping.manaFile, ',')) continue;
-        if (!std::getline(ss, mapping.cppFile, ',')) continue;
-        std::getline(ss, mapping.functionName, ',');
-
-        m_sourceMappings.push_back(mapping);
-        m_manaToCpp[mapping.manaFile] = mapping.cppFile;
-    }
-
-    logDebug("Loaded " + std::to_string(m_sourceMappings.size()) + " source mappings");
-    return true;
+static SourceMapping toMapping(const backend::SourceMap& map, const backend::SourceMapEntry& entry) {
+    SourceMapping mapping;
+    mapping.manaLine = static_cast<int>(entry.line);
+    mapping.manaColumn = entry.column;
+    mapping.cppLine = static_cast<int>(entry.cpp_line);
+    mapping.manaFile = map.files()[entry.file];
+    mapping.cppFile = map.cpp_file;
+    mapping.functionName = map.functions()[entry.function];
+    return mapping;
 }
 
-bool Debugger::generateSourceMap(const std::string& manaFile, const std::string& cppFile) {
-    // Parse both files and generate simple line-by-line mapping
-    std::ifstream mana(manaFile);
-    std::ifstream cpp(cppFile);
-
-    if (!mana.is_open() || !cpp.is_open()) return false;
-
-    int manaLine = 0;
-    int cppLine = 0;
-    std::string line;
-    std::string currentFunc;
-
-    // Read C++ file and look for // Line X comments
-    while (std::getline(cpp, line)) {
-        cppLine++;
-
-        // Look for function declaration
-        size_t funcPos = line.find("int32_t ");
-        if (funcPos == std::string::npos) funcPos = line.find("void ");
-        if (funcPos != std::string::npos) {
-            size_t nameStart = line.find(' ', funcPos) + 1;
-            size_t nameEnd = line.find('(', nameStart);
-            if (nameEnd != std::string::npos) {
-                currentFunc = line.substr(nameStart, nameEnd - nameStart);
-            }
-        }
-
-        // Look for // Mana:line or // Line X markers
-        size_t markerPos = line.find("// Line ");
-        if (markerPos != std::string::npos) {
-            int srcLine = std::stoi(line.substr(markerPos + 8));
-            SourceMapping mapping;
-            mapping.manaLine = srcLine;
-            mapping.manaColumn = 1;
-            mapping.cppLine = cppLine;
-            mapping.manaFile = manaFile;
-            mapping.cppFile = cppFile;
-            mapping.functionName = currentFunc;
-            m_sourceMappings.push_back(mapping);
-        }
-    }
-
-    m_manaToCpp[manaFile] = cppFile;
+bool Debugger::loadSourceMap(const std::string& mapFile) {
+    if (!m_sourceMap.load(mapFile)) return false;
+    logDebug("Loaded " + std::to_string(m_sourceMap.entries().size()) + " source mappings");
     return true;
 }
 
 std::optional<SourceMapping> Debugger::manaLineToCppLine(const std::string& file, int line) {
-    for (const auto& mapping : m_sourceMappings) {
-        if (mapping.manaFile == file && mapping.manaLine == line) {
-            return mapping;
-        }
-    }
-    // Return approximate mapping (same line number)
-    auto it = m_manaToCpp.find(file);
-    if (it != m_manaToCpp.end()) {
-        SourceMapping approx;
-        approx.manaLine = line;
-        approx.manaColumn = 1;
-        approx.cppLine = line;
-        approx.manaFile = file;
-        approx.cppFile = it->second;
-        return approx;
+    // The map names files by canonical path; clients may not
+    int index = m_sourceMap.file_index(file);
+    if (index < 0) {
+        std::error_code ec;
+        index = m_sourceMap.file_index(std::filesystem::weakly_canonical(file, ec).string());
     }
-    return std::nullopt;
+    if (index < 0 || line <= 0) return std::nullopt;
+
+    auto found = m_sourceMap.find_original(static_cast<uint16_t>(index), static_cast<uint32_t>(line));
+    if (found.empty()) return std::nullopt;
+    return toMapping(m_sourceMap, *found.front());
 }
 
-std::optional<SourceMapping> Debugger::cppLineToManaLine(const std::string& file, int line) {
-    for (const auto& mapping : m_sourceMappings) {
-        if (mapping.cppFile == file && mapping.cppLine == line) {
-            return mapping;
-        }
+bool Debugger::bindBreakpoint(Breakpoint& bp) {
+    if (!m_hasSourceMap) {
+        // Nothing to check against until the program's map is loaded
+        bp.verified = true;
+        return true;
     }
-    // Find closest mapping
-    int closest = -1;
-    const SourceMapping* closestMapping = nullptr;
-    for (const auto& mapping : m_sourceMappings) {
-        if (mapping.cppFile == file && mapping.cppLine <= line) {
-            if (closest == -1 || mapping.cppLine > closest) {
-                closest = mapping.cppLine;
-                closestMapping = &mapping;
-            }
-        }
-    }
-    if (closestMapping) return *closestMapping;
-    return std::nullopt;
+    auto mapping = manaLineToCppLine(bp.source, bp.line);
+    bp.verified = mapping.has_value();
+    if (mapping) bp.line = mapping->manaLine;
+    return bp.verified;
 }
 
 // ============================================================================
@@ -877,36 +1035,99 @@ std::vector<Variable> Debugger::getWatchVariables() {
 // Breakpoint management
 // ============================================================================
 
-bool Debugger::checkBreakpointCondition(const Breakpoint& bp) {
-    if (bp.condition.empty()) return true;
+const Breakpoint* Debugger::findCompiledBreakpoint(const Breakpoint& bp) const {
+    for (const auto& compiled : m_compiledBreakpoints) {
+        if (compiled.source == bp.source && compiled.line == bp.line && compiled.condition == bp.condition &&
+            compiled.hitCondition == bp.hitCondition && compiled.logMessage.empty() && bp.logMessage.empty()) {
+            return &compiled;
+        }
+    }
+    return nullptr;
+}
 
-    // Evaluate condition
-    std::string result = evaluateExpression(bp.condition, m_currentFrameId);
-    return (result == "true" || result == "1");
+void Debugger::sendBreakpointChanged(const Breakpoint& bp) {
+    std::string body;
+    json::Writer(body).begin_object()
+        .key("reason").value("changed")
+        .key("breakpoint").begin_object()
+            .key("id").value(bp.id)
+            .key("verified").value(bp.verified)
+            .key("line").value(bp.line)
+        .end_object()
+    .end_object();
+    sendEvent("breakpoint", body);
 }
 
-void Debugger::updateBreakpointHitCount(int bpId) {
-    for (auto& bp : m_breakpoints) {
-        if (bp.id == bpId) {
-            bp.hitCount++;
+void Debugger::pollProcess() {
+    std::string output = m_process.readOutput();
+    if (!output.empty()) {
+        std::string body;
+        json::Writer(body).begin_object()
+            .key("category").value("stdout")
+            .key("output").value(output)
+        .end_object();
+        sendEvent("output", body);
+    }
+    while (m_process.running()) {
+        auto stop = m_process.poll();
+        if (!stop) break;
+        reportStop(*stop);
+    }
+}
 
-            // Check hit condition
-            if (!bp.hitCondition.empty()) {
-                int required = std::stoi(bp.hitCondition);
-                if (bp.hitCount < required) {
-                    // Don't break yet
-                }
+void Debugger::reportStop(const StopEvent& stop) {
+    m_currentSource.clear();  // Only a breakpoint stop knows where it is
+    std::string body;
+    json::Writer w(body);
+    switch (stop.kind) {
+        case StopEvent::Kind::Exited:
+            pollProcess();  // What it wrote last
+            w.begin_object().key("exitCode").value(stop.exitCode).end_object();
+            sendEvent("exited", body);
+            sendEvent("terminated");
+            m_terminated = true;
+            return;
+        case StopEvent::Kind::Breakpoint: {
+            auto it = std::find_if(m_breakpoints.begin(), m_breakpoints.end(),
+                [&stop](const Breakpoint& bp) { return bp.id == stop.id && bp.verified && bp.enabled; });
+            // Removed since the program was built; its check still traps
+            if (it == m_breakpoints.end() && !m_buildSource.empty()) {
+                m_process.resume();
+                return;
             }
-
-            // Handle log point
-            if (!bp.logMessage.empty()) {
-                std::string msg = bp.logMessage;
-                // Replace {} with evaluated expression
-                // sendEvent("output", "{\"category\":\"console\",\"output\":\"" + msg + "\\n\"}");
+            w.begin_object().key("reason").value("breakpoint");
+            if (it != m_breakpoints.end()) {
+                it->hitCount++;
+                m_currentSource = it->source;
+                m_currentLine = it->line;
+                auto mapping = m_hasSourceMap ? manaLineToCppLine(it->source, it->line) : std::nullopt;
+                m_currentFunction = mapping ? mapping->functionName : std::string();
+                w.key("hitBreakpointIds").begin_array().value(it->id).end_array();
             }
             break;
         }
+        case StopEvent::Kind::Watchpoint:
+            w.begin_object()
+                .key("reason").value("data breakpoint")
+                .key("hitBreakpointIds").begin_array().value(stop.id).end_array();
+            break;
+        case StopEvent::Kind::Signal:
+            w.begin_object()
+                .key("reason").value("exception")
+#ifdef _WIN32
+                .key("text").value("signal " + std::to_string(stop.signal));
+#else
+                .key("text").value(strsignal(stop.signal));
+#endif
+            break;
+        case StopEvent::Kind::Pause:
+            w.begin_object().key("reason").value("pause");
+            break;
     }
+    w.key("threadId").value(stop.threadId)
+        .key("allThreadsStopped").value(true)
+    .end_object();
+    sendEvent("stopped", body);
 }
 
 std::vector<int> Debugger::getBreakpointsAtLine(const std::string& file, int line) {
@@ -919,38 +1140,6 @@ std::vector<int> Debugger::getBreakpointsAtLine(const std::string& file, int lin
     return ids;
 }
 
-// ============================================================================
-// JSON parsing helper
-// ============================================================================
-
-std::vector<std::string> Debugger::getJsonArray(const std::string& json, const std::string& key) {
-    std::vector<std::string> result;
-
-    std::string search = "\"" + key + "\":[";
-    size_t pos = json.find(search);
-    if (pos == std::string::npos) return result;
-
-    size_t start = pos + search.length();
-    size_t end = json.find(']', start);
-    if (end == std::string::npos) return result;
-
-    std::string arrayContent = json.substr(start, end - start);
-
-    // Simple parsing of string array
-    size_t strStart = 0;
-    while ((strStart = arrayContent.find('"', strStart)) != std::string::npos) {
-        size_t strEnd = arrayContent.find('"', strStart + 1);
-        if (strEnd != std::string::npos) {
-            result.push_back(arrayContent.substr(strStart + 1, strEnd - strStart - 1));
-            strStart = strEnd + 1;
-        } else {
-            break;
-        }
-    }
-
-    return result;
-}
-
 // ============================================================================
 // Debug logging
 // ============================================================================
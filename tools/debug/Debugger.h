@@ -9,6 +9,9 @@
 #include <unordered_map>
 #include <set>
 #include <fstream>
+#include "../json/Json.h"
+#include "../../backend-cpp/SourceMap.h"
+#include "TracedProcess.h"
 
 namespace mana {
 namespace debug {
@@ -115,8 +118,8 @@ public:
     // Main run loop
     void run();
 
-    // Process a single DAP message
-    void processMessage(const std::string& json);
+    // Process a single DAP message (parsed in place)
+    void processMessage(std::string& message);
 
     // Send response
     void sendResponse(int requestSeq, const std::string& command,
@@ -126,43 +129,37 @@ public:
     void sendEvent(const std::string& event, const std::string& body = "{}");
 
     // DAP request handlers
-    void handleInitialize(int seq, const std::string& args);
-    void handleLaunch(int seq, const std::string& args);
-    void handleAttach(int seq, const std::string& args);
-    void handleDisconnect(int seq, const std::string& args);
-    void handleSetBreakpoints(int seq, const std::string& args);
-    void handleSetExceptionBreakpoints(int seq, const std::string& args);
-    void handleConfigurationDone(int seq, const std::string& args);
-    void handleThreads(int seq, const std::string& args);
-    void handleStackTrace(int seq, const std::string& args);
-    void handleScopes(int seq, const std::string& args);
-    void handleVariables(int seq, const std::string& args);
-    void handleContinue(int seq, const std::string& args);
-    void handleNext(int seq, const std::string& args);
-    void handleStepIn(int seq, const std::string& args);
-    void handleStepOut(int seq, const std::string& args);
-    void handlePause(int seq, const std::string& args);
-    void handleTerminate(int seq, const std::string& args);
-    void handleEvaluate(int seq, const std::string& args);
-    void handleSource(int seq, const std::string& args);
-    void handleSetVariable(int seq, const std::string& args);
-    void handleDataBreakpointInfo(int seq, const std::string& args);
-    void handleSetDataBreakpoints(int seq, const std::string& args);
-    void handleCompletions(int seq, const std::string& args);
+    void handleInitialize(int seq, const json::Value& args);
+    void handleLaunch(int seq, const json::Value& args);
+    void handleAttach(int seq, const json::Value& args);
+    void handleDisconnect(int seq, const json::Value& args);
+    void handleSetBreakpoints(int seq, const json::Value& args);
+    void handleSetExceptionBreakpoints(int seq, const json::Value& args);
+    void handleConfigurationDone(int seq, const json::Value& args);
+    void handleThreads(int seq, const json::Value& args);
+    void handleStackTrace(int seq, const json::Value& args);
+    void handleScopes(int seq, const json::Value& args);
+    void handleVariables(int seq, const json::Value& args);
+    void handleContinue(int seq, const json::Value& args);
+    void handleNext(int seq, const json::Value& args);
+    void handleStepIn(int seq, const json::Value& args);
+    void handleStepOut(int seq, const json::Value& args);
+    void handlePause(int seq, const json::Value& args);
+    void handleTerminate(int seq, const json::Value& args);
+    void handleEvaluate(int seq, const json::Value& args);
+    void handleSource(int seq, const json::Value& args);
+    void handleSetVariable(int seq, const json::Value& args);
+    void handleDataBreakpointInfo(int seq, const json::Value& args);
+    void handleSetDataBreakpoints(int seq, const json::Value& args);
+    void handleCompletions(int seq, const json::Value& args);
 
 private:
-    // Read a DAP message from stdin
-    std::optional<std::string> readMessage();
+    // Read a DAP message from stdin into out (reusing its storage)
+    static bool readMessage(std::string& out);
 
     // Write a DAP message to stdout
     void writeMessage(const std::string& json);
 
-    // Parse JSON (simple implementation)
-    std::string getJsonString(const std::string& json, const std::string& key);
-    int getJsonInt(const std::string& json, const std::string& key);
-    bool getJsonBool(const std::string& json, const std::string& key);
-    std::vector<std::string> getJsonArray(const std::string& json, const std::string& key);
-
     // Build JSON response
     std::string buildCapabilities();
 
@@ -170,12 +167,21 @@ private:
     bool launchProcess(const std::string& program, const std::vector<std::string>& args);
     void terminateProcess();
     bool isProcessRunning();
-
-    // Source mapping
+    // Starts the program, first building it when the launch named a Mana
+    // source; sends the process (or terminated) event
+    bool startProgram();
+    // `mana -g --breakpoints` with the current breakpoints compiled in
+    bool buildProgram();
+    // Reports the traced program's stops as DAP events
+    void pollProcess();
+    void reportStop(const StopEvent& stop);
+
+    // Source mapping, from the .manamap written by `mana -g`. Breakpoints
+    // bind to the first line at or after theirs that has code.
     bool loadSourceMap(const std::string& mapFile);
-    bool generateSourceMap(const std::string& manaFile, const std::string& cppFile);
     std::optional<SourceMapping> manaLineToCppLine(const std::string& file, int line);
-    std::optional<SourceMapping> cppLineToManaLine(const std::string& file, int line);
+    // Moves a breakpoint to the line its code starts on; false if it has none
+    bool bindBreakpoint(Breakpoint& bp);
 
     // Variable inspection
     void loadDebugSymbols(const std::string& symbolFile);
@@ -190,14 +196,21 @@ private:
     void updateWatches(int frameId);
     std::vector<Variable> getWatchVariables();
 
-    // Breakpoint management
-    bool checkBreakpointCondition(const Breakpoint& bp);
-    void updateBreakpointHitCount(int bpId);
+    // Breakpoint management. Conditions and hit counts are compiled into
+    // the program, which only stops when both pass.
     std::vector<int> getBreakpointsAtLine(const std::string& file, int line);
+    // Same check as one already compiled into the running program
+    const Breakpoint* findCompiledBreakpoint(const Breakpoint& bp) const;
+    void sendBreakpointChanged(const Breakpoint& bp);
 
     // Debug logging
     void logDebug(const std::string& message);
 
+    // Transport buffers, reused across messages
+    std::string m_buffer;
+    std::string m_output;
+    json::Document m_message;
+
     // Debugging state
     bool m_initialized;
     bool m_running;
@@ -207,9 +220,12 @@ private:
     int m_currentLine;
     int m_currentFrameId;
     std::string m_currentFunction;
+    std::string m_currentSource;  // Mana file of the breakpoint stopped at; empty elsewhere
 
     // Breakpoints
     std::vector<Breakpoint> m_breakpoints;
+    std::vector<Breakpoint> m_compiledBreakpoints;  // As built into the running program
+    std::vector<Watchpoint> m_dataBreakpoints;
     int m_nextBreakpointId;
 
     // Watches
@@ -222,14 +238,19 @@ private:
     int m_nextVariableRef;
 
     // Source mappings
-    std::vector<SourceMapping> m_sourceMappings;
-    std::unordered_map<std::string, std::string> m_manaToCpp;  // Mana file -> C++ file
+    backend::SourceMap m_sourceMap;
+    bool m_hasSourceMap;
 
     // Debug symbols
     std::vector<DebugSymbol> m_symbols;
     std::unordered_map<std::string, DebugSymbol> m_symbolsByName;
 
     // Process info
+    TracedProcess m_process;  // Linux; elsewhere the process below is untraced
+    std::string m_buildSource;  // Mana source that launch builds the program from
+    std::string m_compiler;
+    std::string m_sourceMapFile;
+    bool m_launchPending;
     std::string m_programPath;
     std::string m_manaSourcePath;  // Original .mana file
     std::vector<std::string> m_programArgs;
@@ -0,0 +1,417 @@
+#include "TracedProcess.h"
+#include <algorithm>
+
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace mana {
+namespace debug {
+
+#ifdef __linux__
+
+static int signalThread(int pid, int tid, int sig) {
+    return static_cast<int>(syscall(SYS_tgkill, pid, tid, sig));
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+static void* debugRegister(int index) {
+    return reinterpret_cast<void*>(offsetof(struct user, u_debugreg) + index * sizeof(long));
+}
+#endif
+
+TracedProcess::~TracedProcess() {
+    kill();
+    if (m_outputFd >= 0) close(m_outputFd);
+}
+
+bool TracedProcess::supported() {
+    return true;
+}
+
+bool TracedProcess::supportsWatchpoints() {
+#if defined(__x86_64__) || defined(__i386__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool TracedProcess::launch(const std::string& program, const std::vector<std::string>& args,
+                           const std::string& workingDir) {
+    kill();
+    if (m_outputFd >= 0) close(m_outputFd);
+    m_outputFd = -1;
+
+    int output[2];
+    if (pipe2(output, O_CLOEXEC) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(output[0]);
+        close(output[1]);
+        return false;
+    }
+    if (pid == 0) {
+        // Child process
+        int devNull = open("/dev/null", O_RDONLY);
+        if (devNull >= 0) dup2(devNull, STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        dup2(output[1], STDERR_FILENO);
+        ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+        setenv("MANA_DEBUGGER", "1", 1);
+        if (!workingDir.empty() && chdir(workingDir.c_str()) != 0) _exit(127);
+
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(program.c_str()));
+        for (const auto& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(program.c_str(), argv.data());
+        _exit(127);
+    }
+
+    close(output[1]);
+    fcntl(output[0], F_SETFL, fcntl(output[0], F_GETFL) | O_NONBLOCK);
+    m_outputFd = output[0];
+
+    // The exec stops the child with SIGTRAP before its first instruction
+    int status = 0;
+    if (waitpid(pid, &status, __WALL) != pid) {
+        ::kill(pid, SIGKILL);
+        waitpid(pid, nullptr, __WALL);
+        return false;
+    }
+    if (!WIFSTOPPED(status)) return false;  // The exec failed
+    ptrace(PTRACE_SETOPTIONS, pid, nullptr,
+           reinterpret_cast<void*>(static_cast<long>(PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL)));
+
+    m_pid = pid;
+    m_running = false;
+    m_interrupting = false;
+    m_threads.clear();
+    m_deferred.clear();
+    addThread(pid).stopped = true;
+    return true;
+}
+
+std::vector<int> TracedProcess::threads() const {
+    std::vector<int> tids;
+    for (const auto& t : m_threads) tids.push_back(t.tid);
+    return tids;
+}
+
+std::string TracedProcess::readOutput() {
+    std::string output;
+    if (m_outputFd < 0) return output;
+    char chunk[4096];
+    while (true) {
+        ssize_t n = read(m_outputFd, chunk, sizeof(chunk));
+        if (n > 0) {
+            output.append(chunk, static_cast<size_t>(n));
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n == 0) {
+                // Every writer has exited
+                close(m_outputFd);
+                m_outputFd = -1;
+            }
+            break;
+        }
+    }
+    return output;
+}
+
+TracedProcess::ThreadState* TracedProcess::findThread(int tid) {
+    for (auto& t : m_threads) {
+        if (t.tid == tid) return &t;
+    }
+    return nullptr;
+}
+
+TracedProcess::ThreadState& TracedProcess::addThread(int tid) {
+    m_threads.push_back(ThreadState{tid, false, false, 0, 0});
+    return m_threads.back();
+}
+
+std::optional<StopEvent> TracedProcess::poll() {
+    if (!m_running) return std::nullopt;
+    if (!m_deferred.empty()) {
+        StopEvent stop = m_deferred.front();
+        m_deferred.pop_front();
+        m_running = false;
+        return stop;
+    }
+
+    while (m_pid > 0) {
+        int status = 0;
+        int tid = waitpid(-1, &status, __WALL | WNOHANG);
+        if (tid <= 0) return std::nullopt;
+
+        auto stop = handleStatus(tid, status);
+        if (stop) {
+            m_running = false;
+            if (stop->kind != StopEvent::Kind::Exited) stopAll();
+            return stop;
+        }
+        // Thread bookkeeping only; the thread carries on
+        ThreadState* thread = findThread(tid);
+        if (thread && thread->stopped) {
+            applyWatchpoints(*thread);
+            ptrace(PTRACE_CONT, tid, nullptr, reinterpret_cast<void*>(static_cast<long>(thread->pendingSignal)));
+            thread->pendingSignal = 0;
+            thread->stopped = false;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<StopEvent> TracedProcess::handleStatus(int tid, int status) {
+    if (WIFEXITED(status) || WIFSIGNALED(status)) {
+        if (tid == m_pid) {
+            StopEvent stop;
+            stop.kind = StopEvent::Kind::Exited;
+            stop.threadId = tid;
+            stop.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+            m_pid = -1;
+            m_threads.clear();
+            return stop;
+        }
+        m_threads.erase(std::remove_if(m_threads.begin(), m_threads.end(),
+                                       [tid](const ThreadState& t) { return t.tid == tid; }),
+                        m_threads.end());
+        return std::nullopt;
+    }
+    if (!WIFSTOPPED(status)) return std::nullopt;
+
+    ThreadState* thread = findThread(tid);
+    if (!thread) {
+        // A new thread can report its first stop before its parent's clone event
+        thread = &addThread(tid);
+        thread->expectStop = true;
+    }
+    thread->stopped = true;
+    int sig = WSTOPSIG(status);
+
+    if ((status >> 16) == PTRACE_EVENT_CLONE) {
+        unsigned long child = 0;
+        ptrace(PTRACE_GETEVENTMSG, tid, nullptr, &child);
+        if (!findThread(static_cast<int>(child))) {
+            // Starts with a SIGSTOP of its own
+            addThread(static_cast<int>(child)).expectStop = true;
+        }
+        return std::nullopt;
+    }
+
+    if (sig == SIGSTOP && thread->expectStop) {
+        thread->expectStop = false;
+        return std::nullopt;
+    }
+
+    StopEvent stop;
+    stop.threadId = tid;
+    if (sig == SIGSTOP && m_interrupting) {
+        m_interrupting = false;
+        stop.kind = StopEvent::Kind::Pause;
+        return stop;
+    }
+    if (sig != SIGTRAP) {
+        thread->pendingSignal = sig;
+        stop.kind = StopEvent::Kind::Signal;
+        stop.signal = sig;
+        return stop;
+    }
+
+    // Traps are the debugger's own and never reach the program
+    siginfo_t info = {};
+    ptrace(PTRACE_GETSIGINFO, tid, nullptr, &info);
+    if (info.si_code == SI_QUEUE && info.si_pid == m_pid) {
+        stop.kind = StopEvent::Kind::Breakpoint;
+        stop.id = info.si_value.sival_int;
+        return stop;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    long dr6 = ptrace(PTRACE_PEEKUSER, tid, debugRegister(6), nullptr);
+    for (size_t i = 0; i < m_watchpoints.size(); ++i) {
+        if (dr6 != -1 && (dr6 & (1L << i))) {
+            ptrace(PTRACE_POKEUSER, tid, debugRegister(6), nullptr);
+            stop.kind = StopEvent::Kind::Watchpoint;
+            stop.id = m_watchpoints[i].id;
+            return stop;
+        }
+    }
+#endif
+    return std::nullopt;
+}
+
+void TracedProcess::stopAll() {
+    ThreadState* main = findThread(m_pid);
+    if (m_interrupting && main) {
+        // This stop stands in for the pause; its SIGSTOP is already on the way
+        m_interrupting = false;
+        if (!main->stopped) main->expectStop = true;
+    }
+    for (auto& t : m_threads) {
+        if (!t.stopped && !t.expectStop) {
+            signalThread(m_pid, t.tid, SIGSTOP);
+            t.expectStop = true;
+        }
+    }
+
+    while (m_pid > 0) {
+        auto it = std::find_if(m_threads.begin(), m_threads.end(),
+                               [](const ThreadState& t) { return !t.stopped; });
+        if (it == m_threads.end()) break;
+        int waited = it->tid;
+        int status = 0;
+        int tid = waitpid(waited, &status, __WALL);
+        if (tid < 0) {
+            if (errno == EINTR) continue;
+            // Already gone
+            m_threads.erase(it);
+            continue;
+        }
+        // Reported once the current stop has been handled
+        if (auto stop = handleStatus(tid, status)) m_deferred.push_back(*stop);
+    }
+}
+
+void TracedProcess::resume() {
+    // poll() reports a deferred stop without running
+    if (!m_deferred.empty()) {
+        m_running = true;
+        return;
+    }
+    if (m_pid <= 0) return;
+    m_running = true;
+    for (auto& t : m_threads) {
+        if (!t.stopped) continue;
+        applyWatchpoints(t);
+        ptrace(PTRACE_CONT, t.tid, nullptr, reinterpret_cast<void*>(static_cast<long>(t.pendingSignal)));
+        t.pendingSignal = 0;
+        t.stopped = false;
+    }
+}
+
+void TracedProcess::interrupt() {
+    if (!running() || m_interrupting) return;
+    m_interrupting = true;
+    signalThread(m_pid, m_pid, SIGSTOP);
+}
+
+void TracedProcess::kill() {
+    if (m_pid <= 0) return;
+    ::kill(m_pid, SIGKILL);
+    // Every traced thread reports its death before the process does
+    while (true) {
+        int status = 0;
+        int tid = waitpid(-1, &status, __WALL);
+        if (tid < 0 && errno == EINTR) continue;
+        if (tid < 0 || (tid == m_pid && (WIFEXITED(status) || WIFSIGNALED(status)))) break;
+    }
+    m_pid = -1;
+    m_running = false;
+    m_threads.clear();
+    m_deferred.clear();
+}
+
+bool TracedProcess::setWatchpoints(const std::vector<Watchpoint>& watchpoints, std::string& error) {
+    if (!supportsWatchpoints()) {
+        error = "Data breakpoints need x86 debug registers";
+        return false;
+    }
+    if (watchpoints.size() > kMaxWatchpoints) {
+        error = "At most " + std::to_string(kMaxWatchpoints) + " data breakpoints fit in the debug registers";
+        return false;
+    }
+    for (const auto& w : watchpoints) {
+        bool sized = w.size == 1 || w.size == 2 || w.size == 4 || w.size == 8;
+        if (!sized || w.address % static_cast<uint64_t>(w.size) != 0) {
+            error = "A data breakpoint covers 1, 2, 4 or 8 bytes aligned to its size";
+            return false;
+        }
+    }
+    m_watchpoints = watchpoints;
+    ++m_watchGeneration;
+
+    // Threads pick them up as they resume; a running program is stopped for it
+    if (m_running) {
+        m_running = false;
+        stopAll();
+        resume();
+    }
+    return true;
+}
+
+bool TracedProcess::applyWatchpoints(ThreadState& thread) {
+    if (thread.appliedWatchpoints == m_watchGeneration) return true;
+#if defined(__x86_64__) || defined(__i386__)
+    // DR7 disabled while the addresses change, then each slot enabled with
+    // its access type (01 write, 11 read/write) and length code
+    if (ptrace(PTRACE_POKEUSER, thread.tid, debugRegister(7), nullptr) != 0) return false;
+    unsigned long dr7 = 0;
+    for (size_t i = 0; i < m_watchpoints.size(); ++i) {
+        const Watchpoint& w = m_watchpoints[i];
+        if (ptrace(PTRACE_POKEUSER, thread.tid, debugRegister(static_cast<int>(i)),
+                   reinterpret_cast<void*>(static_cast<uintptr_t>(w.address))) != 0) {
+            return false;
+        }
+        unsigned long access = w.readWrite ? 3 : 1;
+        unsigned long length = w.size == 1 ? 0 : w.size == 2 ? 1 : w.size == 8 ? 2 : 3;
+        dr7 |= 1UL << (i * 2);
+        dr7 |= (access | (length << 2)) << (16 + i * 4);
+    }
+    if (dr7 != 0 && ptrace(PTRACE_POKEUSER, thread.tid, debugRegister(7), reinterpret_cast<void*>(dr7)) != 0) {
+        return false;
+    }
+#endif
+    thread.appliedWatchpoints = m_watchGeneration;
+    return true;
+}
+
+#else
+
+TracedProcess::~TracedProcess() = default;
+bool TracedProcess::supported() { return false; }
+bool TracedProcess::supportsWatchpoints() { return false; }
+
+bool TracedProcess::launch(const std::string&, const std::vector<std::string>&, const std::string&) {
+    return false;
+}
+
+std::vector<int> TracedProcess::threads() const { return {}; }
+std::string TracedProcess::readOutput() { return {}; }
+TracedProcess::ThreadState* TracedProcess::findThread(int) { return nullptr; }
+TracedProcess::ThreadState& TracedProcess::addThread(int tid) {
+    m_threads.push_back(ThreadState{tid, false, false, 0, 0});
+    return m_threads.back();
+}
+std::optional<StopEvent> TracedProcess::poll() { return std::nullopt; }
+std::optional<StopEvent> TracedProcess::handleStatus(int, int) { return std::nullopt; }
+void TracedProcess::stopAll() {}
+void TracedProcess::resume() {}
+void TracedProcess::interrupt() {}
+void TracedProcess::kill() {}
+
+bool TracedProcess::setWatchpoints(const std::vector<Watchpoint>&, std::string& error) {
+    error = "Data breakpoints are only supported on Linux";
+    return false;
+}
+
+bool TracedProcess::applyWatchpoints(ThreadState&) { return false; }
+
+#endif
+
+} // namespace debug
+} // namespace mana
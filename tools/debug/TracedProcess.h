@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mana {
+namespace debug {
+
+// Hardware data breakpoint. x86 debug registers hold up to four, each 1,
+// 2, 4 or 8 bytes long and aligned to its length.
+struct Watchpoint {
+    int id;
+    uint64_t address;
+    int size;
+    bool readWrite;  // Stop on reads too, not only on writes
+};
+
+// Why the traced program stopped
+struct StopEvent {
+    enum class Kind {
+        Breakpoint,  // A compiled breakpoint check passed
+        Watchpoint,
+        Signal,
+        Pause,       // interrupt()
+        Exited
+    };
+    Kind kind;
+    int threadId = 0;
+    int id = 0;        // Breakpoint or watchpoint id
+    int signal = 0;    // Kind::Signal
+    int exitCode = 0;  // Kind::Exited
+};
+
+// A program run under ptrace. Breakpoints are compiled into the program
+// (`mana -g --breakpoints`), which stops itself with a SIGTRAP naming the
+// breakpoint only when a check passes, so the adapter sees no traffic for
+// the hits that do not stop. Watchpoints live in the debug registers of
+// every thread. A stop in one thread stops all of them.
+//
+// Only Linux is supported; elsewhere launch() fails and the adapter keeps
+// its untraced process.
+class TracedProcess {
+public:
+    TracedProcess() = default;
+    ~TracedProcess();
+    TracedProcess(const TracedProcess&) = delete;
+    TracedProcess& operator=(const TracedProcess&) = delete;
+
+    static bool supported();
+    static bool supportsWatchpoints();
+    static constexpr size_t kMaxWatchpoints = 4;
+
+    // Starts the program stopped before its first instruction, with
+    // MANA_DEBUGGER set so that compiled breakpoints trap. Its stdin is
+    // /dev/null and its output goes to a pipe (see readOutput()), as the
+    // adapter's own streams carry the protocol.
+    bool launch(const std::string& program, const std::vector<std::string>& args,
+                const std::string& workingDir);
+    bool alive() const { return m_pid > 0; }
+    bool running() const { return m_running; }  // Resumed, and not yet seen to stop
+    int pid() const { return m_pid; }
+    std::vector<int> threads() const;
+    // Output written since the last call, without blocking
+    std::string readOutput();
+
+    // Next stop of a running program, without blocking. Every thread is
+    // stopped when one is returned.
+    std::optional<StopEvent> poll();
+    void resume();
+    void interrupt();  // Reported by poll() as Kind::Pause
+    void kill();
+
+    // Replaces all watchpoints; they take effect in every thread, including
+    // ones started later. Fails if the hardware cannot hold them.
+    bool setWatchpoints(const std::vector<Watchpoint>& watchpoints, std::string& error);
+
+private:
+    struct ThreadState {
+        int tid;
+        bool stopped;
+        bool expectStop;    // A SIGSTOP we sent is still to arrive
+        int pendingSignal;  // Delivered when the thread resumes
+        unsigned appliedWatchpoints;  // Generation in its debug registers
+    };
+
+    int m_pid = -1;
+    int m_outputFd = -1;
+    bool m_running = false;
+    bool m_interrupting = false;
+    std::vector<ThreadState> m_threads;
+    std::vector<Watchpoint> m_watchpoints;
+    unsigned m_watchGeneration = 1;
+    std::deque<StopEvent> m_deferred;  // Stops found while stopping other threads
+
+    ThreadState* findThread(int tid);
+    ThreadState& addThread(int tid);
+    // Updates thread state for a wait status; returns a stop to report
+    std::optional<StopEvent> handleStatus(int tid, int status);
+    void stopAll();
+    bool applyWatchpoints(ThreadState& thread);
+};
+
+} // namespace debug
+} // namespace mana
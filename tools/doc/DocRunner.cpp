@@ -0,0 +1,417 @@
+#include "DocRunner.h"
+#include "../common/FileUtil.h"
+#include "../common/Parallel.h"
+#include "../json/Json.h"
+#include "../../frontend/Lexer.h"
+#include "../../frontend/Parser.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+namespace mana::doc {
+
+using namespace frontend;
+using backend::DocGenerator;
+using backend::DocItem;
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* kStyle = R"(body { margin: 0; font: 15px/1.5 system-ui, sans-serif; color: #222; }
+nav { position: sticky; top: 0; display: flex; gap: 1em; align-items: center; padding: .5em 2em; background: #f4f4f4; border-bottom: 1px solid #ddd; }
+nav input { flex: 1; max-width: 30em; padding: .3em .5em; }
+#results { position: absolute; top: 2.5em; left: 8em; margin: 0; padding: 0; list-style: none; background: #fff; box-shadow: 0 2px 8px rgba(0,0,0,.2); max-width: 40em; }
+#results li a { display: block; padding: .3em .8em; text-decoration: none; color: inherit; }
+#results li a:hover, #results li.active a { background: #e8f0fe; }
+#results .kind { color: #888; margin-right: .5em; }
+#results .summary { color: #666; margin-left: .5em; font-size: 90%; }
+main { max-width: 60em; padding: 1em 2em; }
+pre { background: #f6f8fa; padding: .8em; overflow-x: auto; }
+code { font: 14px/1.4 ui-monospace, monospace; }
+h3 a { color: inherit; text-decoration: none; }
+.item { margin-bottom: 2em; }
+)";
+
+const char* kSearch = R"((function () {
+  var index = window.MANA_SEARCH_INDEX;
+  var input = document.getElementById('search');
+  var list = document.getElementById('results');
+  if (!index || !input || !list) return;
+  var items = index.items;
+
+  // Items are sorted by lower-cased name ("l"), so prefix matches are one
+  // contiguous run found by binary search; substring matches follow
+  function search(query) {
+    var lo = 0, hi = items.length;
+    while (lo < hi) {
+      var mid = (lo + hi) >> 1;
+      if (items[mid].l < query) lo = mid + 1; else hi = mid;
+    }
+    var found = [];
+    for (var i = lo; i < items.length && found.length < 50 && items[i].l.lastIndexOf(query, 0) === 0; i++) found.push(items[i]);
+    for (var j = 0; j < items.length && found.length < 50; j++) {
+      if (items[j].l.indexOf(query) > 0) found.push(items[j]);
+    }
+    return found;
+  }
+
+  input.addEventListener('input', function () {
+    var query = input.value.trim().toLowerCase();
+    list.innerHTML = '';
+    if (!query) return;
+    search(query).forEach(function (item) {
+      var li = document.createElement('li');
+      var a = document.createElement('a');
+      a.href = item.h;
+      var kind = document.createElement('span');
+      kind.className = 'kind';
+      kind.textContent = item.k;
+      a.appendChild(kind);
+      a.appendChild(document.createTextNode(index.modules[item.m] + '::' + item.n));
+      if (item.s) {
+        var summary = document.createElement('span');
+        summary.className = 'summary';
+        summary.textContent = item.s;
+        a.appendChild(summary);
+      }
+      li.appendChild(a);
+      list.appendChild(li);
+    });
+  });
+  input.addEventListener('keydown', function (e) {
+    if (e.key === 'Enter' && list.firstChild) window.location = list.firstChild.firstChild.href;
+  });
+})();
+)";
+
+bool read_file(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    out = buffer.str();
+    return true;
+}
+
+// Leaves the file alone if it already holds `content`, so unchanged pages
+// keep their timestamps
+bool write_if_changed(const fs::path& path, const std::string& content) {
+    std::string existing;
+    if (read_file(path.string(), existing) && existing == content) return true;
+    std::ofstream out(path, std::ios::binary);
+    return out && (out << content);
+}
+
+std::string escape_field(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\t') out += "\\t";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+std::vector<std::string> split_fields(const std::string& line) {
+    std::vector<std::string> fields(1);
+    for (size_t i = 0; i < line.size(); i++) {
+        if (line[i] == '\t') {
+            fields.emplace_back();
+        } else if (line[i] == '\\' && i + 1 < line.size()) {
+            char c = line[++i];
+            fields.back() += c == 't' ? '\t' : c == 'n' ? '\n' : c;
+        } else {
+            fields.back() += line[i];
+        }
+    }
+    return fields;
+}
+
+std::unique_ptr<AstModule> parse(const std::string& source, std::string& error) {
+    Lexer lex(source);
+    auto tokens = lex.tokenize();
+    DiagnosticEngine diag;
+    Parser parser(tokens, diag);
+    auto module = parser.parse_module();
+    if (diag.has_errors()) {
+        error = "parse error";
+        for (const auto& e : diag.errors()) error += "\n  " + e.message;
+        return nullptr;
+    }
+    return module;
+}
+
+std::string lower(std::string s) {
+    for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+} // namespace
+
+DocRunner::DocRunner(const DocConfig& config) : config_(config) {}
+
+std::string DocRunner::page_name(const std::string& file) {
+    fs::path path = fs::path(file).lexically_normal();
+    path.replace_extension();
+    std::string name;
+    for (const auto& part : path) {
+        std::string s = part.string();
+        if (s.empty() || s == "." || s == ".." || s == "/" || part == path.root_name()) continue;
+        if (!name.empty()) name += '.';
+        name += s;
+    }
+    return name;
+}
+
+int DocRunner::run(const std::vector<std::string>& paths) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> files = tools::collect_mana_files(paths);
+    if (files.empty()) {
+        std::cerr << "error: no .mana files found\n";
+        return 1;
+    }
+    if (config_.use_cache) load_cache();
+
+    fs::path out_dir(config_.out_dir);
+    std::error_code ec;
+    fs::create_directories(out_dir, ec);
+    if (ec) {
+        std::cerr << "error: cannot create " << out_dir.string() << ": " << ec.message() << "\n";
+        return 1;
+    }
+
+    size_t n = files.size();
+    unsigned jobs = tools::job_count(config_.jobs);
+
+    std::vector<std::string> pages(n);
+    std::vector<ModuleDoc> docs(n);
+    std::vector<std::string> sources(n);
+    std::vector<std::unique_ptr<AstModule>> modules(n);  // Modules parsed this run
+    std::vector<std::string> errors(n);
+    std::vector<char> rendered(n, 0);
+
+    // Parse changed modules and collect their items. Items of unchanged ones
+    // come from the cache.
+    tools::parallel_for(n, jobs, [&](size_t i) {
+        pages[i] = page_name(files[i]);
+        if (!read_file(files[i], sources[i])) {
+            errors[i] = "cannot open";
+            return;
+        }
+        uint64_t hash = tools::hash_bytes(sources[i]);
+        auto cached = cache_.find(files[i]);
+        if (cached != cache_.end() && cached->second.hash == hash &&
+            fs::exists(out_dir / (pages[i] + ".html"))) {
+            docs[i] = cached->second;
+            return;
+        }
+        modules[i] = parse(sources[i], errors[i]);
+        if (!modules[i]) return;
+        docs[i].hash = hash;
+        docs[i].module = modules[i]->name;
+        docs[i].items = DocGenerator::collect_items(*modules[i]);
+    });
+
+    // Project-wide symbol table. Types take precedence over functions of the
+    // same name; otherwise the first module in path order wins. Qualified
+    // names ("geo::Point") pick the item from the module of that name.
+    std::unordered_map<std::string, std::string> symbols;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < n; ++i) {
+            if (!errors[i].empty()) continue;
+            for (const auto& item : docs[i].items) {
+                if ((item.kind == "fn") == (pass == 1)) {
+                    std::string target = pages[i] + ".html#" + item.anchor;
+                    symbols.emplace(item.name, target);
+                    if (!docs[i].module.empty()) symbols.emplace(docs[i].module + "::" + item.name, target);
+                }
+            }
+        }
+    }
+    auto lookup = [&](const std::string& name) {
+        auto it = symbols.find(name);
+        return it == symbols.end() ? std::string() : it->second;
+    };
+
+    // Render HTML for changed modules, and for unchanged ones where a name
+    // they mention (in a signature or as a [Name] doc link) now links
+    // somewhere else
+    tools::parallel_for(n, jobs, [&](size_t i) {
+        if (!errors[i].empty()) return;
+        if (!modules[i]) {
+            bool stale = false;
+            for (const auto& [name, target] : docs[i].links) {
+                if (lookup(name) != target) {
+                    stale = true;
+                    break;
+                }
+            }
+            if (!stale) return;
+            modules[i] = parse(sources[i], errors[i]);
+            if (!modules[i]) return;
+        }
+        // The module's own items shadow the rest of the project
+        std::unordered_map<std::string, std::string> local;
+        for (const auto& item : docs[i].items) local.emplace(item.name, pages[i] + ".html#" + item.anchor);
+        std::unordered_map<std::string, std::string> links;
+        auto link = [&](const std::string& name) {
+            auto it = local.find(name);
+            if (it != local.end()) return it->second;
+            return links.emplace(name, lookup(name)).first->second;
+        };
+        DocGenerator generator;
+        if (!write_if_changed(out_dir / (pages[i] + ".html"), generator.generate_html(*modules[i], link))) {
+            errors[i] = "cannot write " + (out_dir / (pages[i] + ".html")).string();
+            return;
+        }
+        docs[i].links.assign(links.begin(), links.end());
+        std::sort(docs[i].links.begin(), docs[i].links.end());
+        modules[i].reset();
+        rendered[i] = 1;
+    });
+
+    int exit_code = 0;
+    size_t rendered_count = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!errors[i].empty()) {
+            std::cerr << files[i] << ": " << errors[i] << "\n";
+            exit_code = 1;
+            failed++;
+            continue;
+        }
+        rendered_count += rendered[i];
+        // Only doc comments can ask for a qualified name, so one that links
+        // nowhere is a typo or a missing module rather than bracketed prose
+        for (const auto& [name, target] : docs[i].links) {
+            if (target.empty() && name.find("::") != std::string::npos) {
+                std::cerr << files[i] << ": warning: unresolved link [" << name << "]\n";
+            }
+        }
+    }
+
+    // Pages of files that are no longer documented
+    std::unordered_map<std::string, bool> current;
+    for (const auto& f : files) current[f] = true;
+    for (const auto& [file, doc] : cache_) {
+        if (current.count(file)) continue;
+        fs::remove(out_dir / (page_name(file) + ".html"), ec);
+    }
+
+    if (!write_index(files, docs)) {
+        std::cerr << "error: cannot write " << (out_dir / "index.html").string() << "\n";
+        exit_code = 1;
+    }
+    if (config_.use_cache) save_cache(files, docs);
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Documented " << (n - failed) << " module(s) (" << rendered_count << " rendered, "
+              << (n - failed - rendered_count) << " unchanged) in " << ms << " ms: "
+              << (out_dir / "index.html").string() << "\n";
+    return exit_code;
+}
+
+bool DocRunner::write_index(const std::vector<std::string>& files, const std::vector<ModuleDoc>& docs) const {
+    fs::path out_dir(config_.out_dir);
+
+    // Search index: items sorted by lower-cased name so the page can binary
+    // search for prefixes; modules are referenced by position
+    struct Entry {
+        std::string key;
+        const DocItem* item;
+        size_t module;
+    };
+    std::vector<Entry> entries;
+    std::vector<size_t> listed;  // Modules with a page
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (docs[i].hash == 0) continue;  // Failed to parse
+        for (const auto& item : docs[i].items) entries.push_back({lower(item.name), &item, listed.size()});
+        listed.push_back(i);
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+
+    std::string index;
+    json::Writer w(index);
+    w.begin_object().key("modules").begin_array();
+    for (size_t i : listed) w.value(docs[i].module);
+    w.end_array().key("items").begin_array();
+    for (const auto& e : entries) {
+        w.begin_object()
+            .key("n").value(e.item->name)
+            .key("l").value(e.key)
+            .key("k").value(e.item->kind)
+            .key("m").value(static_cast<int64_t>(e.module))
+            .key("h").value(page_name(files[listed[e.module]]) + ".html#" + e.item->anchor);
+        if (!e.item->summary.empty()) w.key("s").value(e.item->summary);
+        w.end_object();
+    }
+    w.end_array().end_object();
+
+    std::ostringstream html;
+    html << "<!DOCTYPE html>\n<html lang=\"en\">\n<head>\n<meta charset=\"utf-8\">\n"
+         << "<title>Mana docs</title>\n<link rel=\"stylesheet\" href=\"style.css\">\n"
+         << "<script src=\"search-index.js\" defer></script>\n"
+         << "<script src=\"search.js\" defer></script>\n</head>\n<body>\n"
+         << "<nav><a href=\"index.html\">Index</a>"
+         << "<input id=\"search\" type=\"search\" placeholder=\"Search\" autocomplete=\"off\">"
+         << "<ul id=\"results\"></ul></nav>\n<main>\n<h1>Modules</h1>\n<table>\n";
+    for (size_t i : listed) {
+        html << "<tr><td><a href=\"" << DocGenerator::escape_html(page_name(files[i])) << ".html\"><code>"
+             << DocGenerator::escape_html(docs[i].module) << "</code></a></td><td>"
+             << DocGenerator::escape_html(files[i]) << "</td><td>" << docs[i].items.size() << " item(s)</td></tr>\n";
+    }
+    html << "</table>\n</main>\n</body>\n</html>\n";
+
+    return write_if_changed(out_dir / "search-index.json", index + "\n") &&
+           write_if_changed(out_dir / "search-index.js", "window.MANA_SEARCH_INDEX = " + index + ";\n") &&
+           write_if_changed(out_dir / "search.js", kSearch) &&
+           write_if_changed(out_dir / "style.css", kStyle) &&
+           write_if_changed(out_dir / "index.html", html.str());
+}
+
+void DocRunner::load_cache() {
+    std::ifstream in(config_.cache_file);
+    std::string line;
+    if (!in || !std::getline(in, line) || line != "mana-doc " + std::to_string(kVersion)) return;
+    ModuleDoc* current = nullptr;
+    while (std::getline(in, line)) {
+        auto fields = split_fields(line);
+        if (fields[0] == "file" && fields.size() == 4) {
+            current = &cache_[fields[1]];
+            current->hash = std::strtoull(fields[2].c_str(), nullptr, 16);
+            current->module = fields[3];
+        } else if (current && fields[0] == "item" && fields.size() == 6) {
+            current->items.push_back({fields[1], fields[2], fields[3], fields[4], fields[5]});
+        } else if (current && fields[0] == "link" && fields.size() == 3) {
+            current->links.emplace_back(fields[1], fields[2]);
+        }
+    }
+}
+
+void DocRunner::save_cache(const std::vector<std::string>& files, const std::vector<ModuleDoc>& docs) const {
+    std::ostringstream out;
+    out << "mana-doc " << kVersion << "\n";
+    for (size_t i = 0; i < files.size(); ++i) {
+        const ModuleDoc& doc = docs[i];
+        if (doc.hash == 0) continue;
+        out << "file\t" << escape_field(files[i]) << "\t" << std::hex << doc.hash << std::dec
+            << "\t" << escape_field(doc.module) << "\n";
+        for (const auto& item : doc.items) {
+            out << "item\t" << escape_field(item.kind) << "\t" << escape_field(item.name) << "\t"
+                << escape_field(item.anchor) << "\t" << escape_field(item.signature) << "\t"
+                << escape_field(item.summary) << "\n";
+        }
+        for (const auto& [name, target] : doc.links) {
+            out << "link\t" << escape_field(name) << "\t" << escape_field(target) << "\n";
+        }
+    }
+    tools::write_file_atomic(config_.cache_file, out.str());
+}
+
+} // namespace mana::doc
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../../backend-cpp/DocGenerator.h"
+
+namespace mana::doc {
+
+    struct DocConfig {
+        int jobs = 0;                                // 0 = one per hardware thread
+        bool use_cache = true;
+        std::string cache_file = ".mana_cache/doc";  // What each page was rendered from
+        std::string out_dir = "build/doc";
+    };
+
+    // Builds HTML documentation for every module of a project on a worker
+    // pool. Files are only parsed, not analyzed. Each module is one page
+    // named after its path; names in signatures and [Name] or [module::Name]
+    // references in doc comments link to the page that documents them, and
+    // all items go into a prebuilt search index. Qualified references that
+    // resolve to nothing are reported as warnings.
+    //
+    // A module whose content hash is unchanged since the cached run, and
+    // whose links would all resolve as they did then, is not parsed again.
+    class DocRunner {
+    public:
+        explicit DocRunner(const DocConfig& config);
+
+        int run(const std::vector<std::string>& paths);
+
+        // Page for a source file: its path relative to the working
+        // directory with separators replaced ("src/net/http.mana" -> "src.net.http")
+        static std::string page_name(const std::string& file);
+
+        static constexpr int kVersion = 3;
+
+    private:
+        struct ModuleDoc {
+            uint64_t hash = 0;
+            std::string module;                                      // Name from the `module` header
+            std::vector<backend::DocItem> items;
+            std::vector<std::pair<std::string, std::string>> links;  // Name looked up -> target it rendered as
+        };
+
+        DocConfig config_;
+        std::unordered_map<std::string, ModuleDoc> cache_;  // Keyed by source path
+
+        void load_cache();
+        void save_cache(const std::vector<std::string>& files, const std::vector<ModuleDoc>& docs) const;
+        bool write_index(const std::vector<std::string>& files, const std::vector<ModuleDoc>& docs) const;
+    };
+
+} // namespace mana::doc
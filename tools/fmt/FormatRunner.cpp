@@ -0,0 +1,246 @@
+#include "FormatRunner.h"
+#include "../../frontend/Lexer.h"
+#include "../../frontend/Parser.h"
+#include "../common/FileUtil.h"
+#include "../common/Parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+
+namespace mana::fmt {
+
+using namespace frontend;
+
+namespace {
+
+// Receives the formatter's output and compares it with the original source
+// as it arrives. At the first mismatch it refuses further output, which
+// puts the stream in a failed state and turns the remaining writes into no-ops.
+class CompareBuf : public std::streambuf {
+public:
+    explicit CompareBuf(const std::string& expected) : expected_(expected) {}
+
+    size_t mismatch() const {
+        if (mismatch_ != std::string::npos) return mismatch_;
+        return pos_ == expected_.size() ? std::string::npos : pos_;  // Output ended early
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+        char c = traits_type::to_char_type(ch);
+        return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (mismatch_ != std::string::npos) return 0;
+        size_t count = static_cast<size_t>(n);
+        size_t avail = expected_.size() - pos_;
+        size_t same = 0;
+        size_t limit = std::min(count, avail);
+        if (std::memcmp(s, expected_.data() + pos_, limit) == 0) {
+            same = limit;
+        } else {
+            while (same < limit && s[same] == expected_[pos_ + same]) same++;
+        }
+        pos_ += same;
+        if (same < count) mismatch_ = pos_;
+        return static_cast<std::streamsize>(same);
+    }
+
+private:
+    const std::string& expected_;
+    size_t pos_ = 0;
+    size_t mismatch_ = std::string::npos;
+};
+
+bool read_file(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    out = buffer.str();
+    return true;
+}
+
+} // namespace
+
+FormatRunner::FormatRunner(const FormatRunConfig& config) : config_(config) {}
+
+size_t FormatRunner::first_difference(const AstModule* module, const std::string& source, const FormatConfig& style) {
+    CompareBuf buf(source);
+    std::ostream out(&buf);
+    Formatter formatter(style);
+    formatter.format(module, out);
+    return buf.mismatch();
+}
+
+FormatResult FormatRunner::format_file(const std::string& file, std::vector<uint64_t>& formatted) {
+    FormatResult result;
+    result.file = file;
+
+    std::string source;
+    if (!read_file(file, source)) {
+        result.status = FormatResult::Status::Error;
+        result.message = "cannot open";
+        return result;
+    }
+
+    uint64_t hash = tools::hash_bytes(source);
+    if (cache_.count(hash)) {
+        formatted.push_back(hash);
+        result.status = FormatResult::Status::Cached;
+        if (config_.mode == FormatMode::Print) result.output = std::move(source);
+        return result;
+    }
+
+    Lexer lex(source);
+    auto tokens = lex.tokenize();
+    DiagnosticEngine diag;
+    Parser parser(tokens, diag);
+    auto module = parser.parse_module();
+    if (diag.has_errors()) {
+        result.status = FormatResult::Status::Error;
+        result.message = "parse error";
+        for (const auto& e : diag.errors()) result.message += "\n  " + e.message;
+        return result;
+    }
+
+    if (config_.mode == FormatMode::Check) {
+        size_t offset = first_difference(module.get(), source, config_.style);
+        if (offset == std::string::npos) {
+            formatted.push_back(hash);
+            return result;
+        }
+        result.status = FormatResult::Status::Reformatted;
+        result.diff_line = 1 + static_cast<int>(std::count(source.begin(), source.begin() + static_cast<std::ptrdiff_t>(offset), '\n'));
+        size_t line_start = source.rfind('\n', offset == 0 ? 0 : offset - 1);
+        result.diff_column = static_cast<int>(offset - (line_start == std::string::npos || offset == 0 ? 0 : line_start + 1)) + 1;
+        return result;
+    }
+
+    Formatter formatter(config_.style);
+    std::string output = formatter.format(module.get());
+    if (output == source) {
+        formatted.push_back(hash);
+        if (config_.mode == FormatMode::Print) result.output = std::move(output);
+        return result;
+    }
+
+    result.status = FormatResult::Status::Reformatted;
+    if (config_.mode == FormatMode::Write) {
+        std::ofstream out(file, std::ios::binary);
+        if (!out || !(out << output)) {
+            result.status = FormatResult::Status::Error;
+            result.message = "cannot write";
+            return result;
+        }
+        formatted.push_back(tools::hash_bytes(output));
+    } else {
+        result.output = std::move(output);
+    }
+    return result;
+}
+
+int FormatRunner::run(const std::vector<std::string>& paths) {
+    std::vector<std::string> files = tools::collect_mana_files(paths);
+    if (config_.use_cache) load_cache();
+
+    std::vector<FormatResult> results(files.size());
+    std::vector<std::vector<uint64_t>> formatted(files.size());  // Per file, merged afterwards
+    tools::parallel_for(files.size(), tools::job_count(config_.jobs), [&](size_t i) {
+        results[i] = format_file(files[i], formatted[i]);
+    });
+
+    int exit_code = 0;
+    int reformatted = 0;
+    int unchanged = 0;
+    for (const auto& r : results) {
+        switch (r.status) {
+            case FormatResult::Status::Error:
+                std::cerr << r.file << ": " << r.message << "\n";
+                exit_code = 1;
+                break;
+            case FormatResult::Status::Reformatted:
+                reformatted++;
+                if (config_.mode == FormatMode::Check) {
+                    std::cerr << r.file << ":" << r.diff_line << ":" << r.diff_column << ": would be reformatted\n";
+                    exit_code = 1;
+                } else if (config_.mode == FormatMode::Write) {
+                    std::cout << "Formatted: " << r.file << "\n";
+                }
+                break;
+            default:
+                unchanged++;
+                break;
+        }
+        if (config_.mode == FormatMode::Print && r.status != FormatResult::Status::Error) {
+            if (files.size() == 1) std::cout << r.output;
+            else std::cout << "=== " << r.file << " ===\n" << r.output << "\n";
+        }
+    }
+
+    if (config_.use_cache) {
+        bool changed = false;
+        for (const auto& list : formatted) {
+            for (uint64_t h : list) {
+                changed |= !cache_.count(h);
+                new_hashes_.push_back(h);
+            }
+        }
+        if (changed) save_cache();
+    }
+
+    if (config_.mode == FormatMode::Check) {
+        if (exit_code == 0) {
+            std::cout << "All " << files.size() << " files are formatted.\n";
+        } else if (reformatted > 0) {
+            std::cerr << reformatted << " file(s) would be reformatted.\n";
+        }
+    } else if (config_.mode == FormatMode::Write) {
+        std::cout << reformatted << " file(s) formatted, " << unchanged << " unchanged.\n";
+    }
+    return exit_code;
+}
+
+std::string FormatRunner::cache_header() const {
+    // Results only carry over between runs with the same formatter and settings
+    const FormatConfig& s = config_.style;
+    std::ostringstream out;
+    out << "mana-fmt " << Formatter::kVersion << " indent=" << s.indent_width << " tabs=" << s.use_tabs
+        << " width=" << s.max_line_length << " trailing_commas=" << s.trailing_commas
+        << " colon_space=" << s.space_after_colon << " operator_space=" << s.space_around_operators;
+    return out.str();
+}
+
+void FormatRunner::load_cache() {
+    std::ifstream in(config_.cache_file);
+    std::string line;
+    if (!in || !std::getline(in, line) || line != cache_header()) return;
+    while (std::getline(in, line)) {
+        if (!line.empty()) cache_.insert(std::strtoull(line.c_str(), nullptr, 16));
+    }
+}
+
+void FormatRunner::save_cache() const {
+    std::ostringstream out;
+    out << cache_header() << "\n" << std::hex;
+    // Sources that were edited since leave stale hashes behind; once there
+    // are too many, keep only what this run saw
+    std::unordered_set<uint64_t> written;
+    if (cache_.size() < kMaxCacheEntries) {
+        for (uint64_t h : cache_) {
+            out << h << "\n";
+            written.insert(h);
+        }
+    }
+    for (uint64_t h : new_hashes_) {
+        if (written.insert(h).second) out << h << "\n";
+    }
+    tools::write_file_atomic(config_.cache_file, out.str());
+}
+
+} // namespace mana::fmt
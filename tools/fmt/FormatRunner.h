@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "Formatter.h"
+
+namespace mana::fmt {
+
+    enum class FormatMode {
+        Print,  // Formatted source to stdout
+        Check,  // Report files that would change (exit 1 if any)
+        Write,  // Rewrite files in place
+    };
+
+    struct FormatRunConfig {
+        FormatConfig style;
+        FormatMode mode = FormatMode::Print;
+        int jobs = 0;                                // 0 = one per hardware thread
+        bool use_cache = true;
+        std::string cache_file = ".mana_cache/fmt";  // Hashes of sources known to be formatted
+    };
+
+    // What happened to one file
+    struct FormatResult {
+        std::string file;
+        enum class Status { Unchanged, Cached, Reformatted, Error } status = Status::Unchanged;
+        std::string message;
+        std::string output;       // Print mode: the formatted source
+        int diff_line = 0;        // Check mode: first line that would change
+        int diff_column = 0;
+    };
+
+    // Formats many files on a worker pool. A file whose content hash is in
+    // the cache was already formatted with the same settings and is not
+    // parsed again; --check stops comparing at the first differing byte.
+    class FormatRunner {
+    public:
+        explicit FormatRunner(const FormatRunConfig& config);
+
+        int run(const std::vector<std::string>& paths);
+
+        // Offset of the first byte where the formatted module differs from
+        // `source` (std::string::npos if identical). Output after the
+        // difference is not produced.
+        static size_t first_difference(const frontend::AstModule* module, const std::string& source,
+                                       const FormatConfig& style);
+
+    private:
+        FormatRunConfig config_;
+        std::unordered_set<uint64_t> cache_;
+        std::vector<uint64_t> new_hashes_;  // Formatted sources seen this run
+        static constexpr size_t kMaxCacheEntries = 1 << 16;
+
+        FormatResult format_file(const std::string& file, std::vector<uint64_t>& formatted);
+        std::string cache_header() const;
+        void load_cache();
+        void save_cache() const;
+    };
+
+} // namespace mana::fmt
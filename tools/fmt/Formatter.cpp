@@ -1,5 +1,11 @@
 #include "Formatter.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <sstream>
+#include <string_view>
+#include "../../frontend/Lexer.h"
+#include "../../frontend/Parser.h"
 
 namespace mana::fmt {
 
@@ -44,6 +50,21 @@ void Formatter::emit_type(const std::string& type, std::ostream& out) {
     out << type;
 }
 
+// `let` bindings are mutable; immutable ones were written `const`. An
+// "auto" type is what the parser records when none was written.
+void Formatter::emit_var_decl(const AstVarDeclStmt* vd, std::ostream& out) {
+    out << (vd->is_mutable ? "let " : "const ") << vd->name;
+    if (!vd->type_name.empty() && vd->type_name != "auto") {
+        if (config_.space_after_colon) out << ": ";
+        else out << ":";
+        emit_type(vd->type_name, out);
+    }
+    if (vd->init_expr) {
+        out << " = ";
+        emit_expr(static_cast<const AstExpr*>(vd->init_expr.get()), out);
+    }
+}
+
 void Formatter::emit_decl(const AstDecl* d, std::ostream& out) {
     if (auto fn = dynamic_cast<const AstFuncDecl*>(d)) {
         // Function declaration
@@ -242,16 +263,7 @@ void Formatter::emit_stmt(const AstStmt* s, std::ostream& out, int indent) {
         }
     } else if (auto vd = dynamic_cast<const AstVarDeclStmt*>(s)) {
         emit_indent(out, indent);
-        out << "let ";
-        if (vd->is_mutable) out << "mut ";
-        out << vd->name;
-        if (!vd->type_name.empty()) {
-            out << ": " << vd->type_name;
-        }
-        if (vd->init_expr) {
-            out << " = ";
-            emit_expr(static_cast<const AstExpr*>(vd->init_expr.get()), out);
-        }
+        emit_var_decl(vd, out);
         out << ";\n";
     } else if (auto ret = dynamic_cast<const AstReturnStmt*>(s)) {
         emit_indent(out, indent);
@@ -341,8 +353,15 @@ void Formatter::emit_stmt(const AstStmt* s, std::ostream& out, int indent) {
         emit_stmt(ds->body.get(), out, 0);
     } else if (auto sc = dynamic_cast<const AstScopeStmt*>(s)) {
         emit_indent(out, indent);
+        out << "scope ";
+        if (sc->init_expr) {
+            out << sc->name << " = ";
+            emit_expr(static_cast<const AstExpr*>(sc->init_expr.get()), out);
+            out << "\n";
+            return;
+        }
         if (!sc->name.empty()) {
-            out << sc->name << ": ";
+            out << sc->name << " ";
         }
         out << "{\n";
         if (auto blk = dynamic_cast<const AstBlockStmt*>(sc->body.get())) {
@@ -387,16 +406,7 @@ void Formatter::emit_stmt_inline(const AstStmt* s, std::ostream& out) {
     if (!s) return;
 
     if (auto vd = dynamic_cast<const AstVarDeclStmt*>(s)) {
-        out << "let ";
-        if (vd->is_mutable) out << "mut ";
-        out << vd->name;
-        if (!vd->type_name.empty()) {
-            out << ": " << vd->type_name;
-        }
-        if (vd->init_expr) {
-            out << " = ";
-            emit_expr(static_cast<const AstExpr*>(vd->init_expr.get()), out);
-        }
+        emit_var_decl(vd, out);
     } else if (auto as = dynamic_cast<const AstAssignStmt*>(s)) {
         if (as->target_expr) {
             emit_expr(static_cast<const AstExpr*>(as->target_expr.get()), out);
@@ -609,4 +619,208 @@ void Formatter::emit_expr(const AstExpr* e, std::ostream& out) {
     }
 }
 
+// ---------------- editor formatting ----------------
+
+namespace {
+
+// Byte offset of each line start in `source`
+std::vector<size_t> line_starts(const std::string& source) {
+    std::vector<size_t> starts{0};
+    for (size_t i = 0; i < source.size(); i++) {
+        if (source[i] == '\n') starts.push_back(i + 1);
+    }
+    return starts;
+}
+
+size_t offset_of(const std::vector<size_t>& starts, const std::string& source, int line, int column) {
+    if (line < 1 || static_cast<size_t>(line) > starts.size()) return source.size();
+    return std::min(starts[line - 1] + static_cast<size_t>(std::max(column, 1) - 1), source.size());
+}
+
+// The lexer drops comments, so a declaration containing one cannot be
+// reprinted without losing it. String and char literals are skipped.
+bool has_comment(const std::string& text) {
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        char next = i + 1 < text.size() ? text[i + 1] : '\0';
+        if (c == '"' || c == '\'') {
+            for (i++; i < text.size() && text[i] != c; i++) {
+                if (text[i] == '\\') i++;
+            }
+        } else if (c == '/' && (next == '/' || next == '*')) {
+            return true;
+        } else if (c == '\\' && (next == ' ' || next == '\t' || next == '\n' || std::isalpha(static_cast<unsigned char>(next)))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Forms the printer writes differently from how they were parsed
+bool printable(const AstDecl* d) {
+    if (auto fn = dynamic_cast<const AstFuncDecl*>(d)) {
+        return !fn->is_extern && !fn->is_method();
+    }
+    if (auto sd = dynamic_cast<const AstStructDecl*>(d)) {
+        return std::none_of(sd->fields.begin(), sd->fields.end(),
+                            [](const AstStructField& f) { return f.default_value != nullptr; });
+    }
+    if (auto ed = dynamic_cast<const AstEnumDecl*>(d)) {
+        return !ed->declared_as_variant;
+    }
+    if (auto td = dynamic_cast<const AstTraitDecl*>(d)) {
+        return td->associated_types.empty() &&
+               std::none_of(td->methods.begin(), td->methods.end(),
+                            [](const AstTraitMethod& m) { return m.has_default() || m.takes_self; });
+    }
+    if (auto impl = dynamic_cast<const AstImplDecl*>(d)) {
+        if (!impl->type_assignments.empty() || !impl->constants.empty()) return false;
+        return std::none_of(impl->methods.begin(), impl->methods.end(), [](const auto& m) {
+            return m->is_async || m->is_generic() || m->has_self == m->is_static;
+        });
+    }
+    if (auto use = dynamic_cast<const AstUseDecl*>(d)) {
+        return !use->is_pub && !use->is_glob && use->alias.empty();
+    }
+    return false;
+}
+
+// The printed declaration must parse back to a single declaration
+bool reparses(const std::string& text) {
+    Lexer lexer("module m;\n" + text);
+    auto tokens = lexer.tokenize();
+    DiagnosticEngine diag;
+    Parser parser(tokens, diag);
+    auto module = parser.parse_module();
+    return module && !diag.has_errors() && module->decls.size() == 1;
+}
+
+// Split into lines, each keeping its '\n'
+std::vector<std::string_view> split_lines(const std::string& text) {
+    std::vector<std::string_view> lines;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t nl = text.find('\n', start);
+        size_t end = nl == std::string::npos ? text.size() : nl + 1;
+        lines.emplace_back(text.data() + start, end - start);
+        start = end;
+    }
+    return lines;
+}
+
+// One edit turning before[offset, offset + length) into `after`, trimmed to
+// the bytes that actually differ
+void add_edit(std::vector<TextEdit>& edits, std::string_view before, std::string_view after, size_t offset) {
+    size_t prefix = 0;
+    while (prefix < before.size() && prefix < after.size() && before[prefix] == after[prefix]) prefix++;
+    size_t suffix = 0;
+    while (suffix < before.size() - prefix && suffix < after.size() - prefix &&
+           before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix]) {
+        suffix++;
+    }
+    if (prefix == before.size() && prefix == after.size()) return;
+    edits.push_back({offset + prefix, before.size() - prefix - suffix,
+                     std::string(after.substr(prefix, after.size() - prefix - suffix))});
+}
+
+// Line diff (longest common subsequence) of `before`, which starts at byte
+// `base` of the source, against `after`: one edit per run of changed lines
+std::vector<TextEdit> diff_edits(const std::string& before, const std::string& after, size_t base) {
+    std::vector<TextEdit> edits;
+    auto a = split_lines(before);
+    auto b = split_lines(after);
+    size_t n = a.size();
+    size_t m = b.size();
+
+    // Past this size a single trimmed edit is cheaper than the table
+    constexpr size_t kMaxTable = 1 << 22;
+    if ((n + 1) * (m + 1) > kMaxTable) {
+        add_edit(edits, before, after, base);
+        return edits;
+    }
+
+    // lcs[i][j]: common lines of a[i..] and b[j..]
+    std::vector<uint32_t> lcs((n + 1) * (m + 1), 0);
+    auto at = [&](size_t i, size_t j) -> uint32_t& { return lcs[i * (m + 1) + j]; };
+    for (size_t i = n; i-- > 0;) {
+        for (size_t j = m; j-- > 0;) {
+            at(i, j) = a[i] == b[j] ? at(i + 1, j + 1) + 1 : std::max(at(i + 1, j), at(i, j + 1));
+        }
+    }
+
+    size_t i = 0, j = 0, offset = 0;
+    while (i < n || j < m) {
+        if (i < n && j < m && a[i] == b[j]) {
+            offset += a[i].size();
+            i++;
+            j++;
+            continue;
+        }
+        // A run of changed lines ends at the next line both sides keep
+        size_t hunk_offset = offset;
+        std::string removed, added;
+        while ((i < n || j < m) && !(i < n && j < m && a[i] == b[j])) {
+            if (j >= m || (i < n && at(i + 1, j) >= at(i, j + 1))) {
+                removed += a[i];
+                offset += a[i].size();
+                i++;
+            } else {
+                added += b[j];
+                j++;
+            }
+        }
+        add_edit(edits, removed, added, base + hunk_offset);
+    }
+    return edits;
+}
+
+} // namespace
+
+std::vector<TextEdit> Formatter::format_decl(const AstDecl* decl, const std::string& source) {
+    return format_decl(decl, source, line_starts(source));
+}
+
+std::vector<TextEdit> Formatter::format_decl(const AstDecl* decl, const std::string& source,
+                                             const std::vector<size_t>& starts) {
+    if (!decl || decl->end_line == 0 || !printable(decl)) return {};
+    size_t begin = offset_of(starts, source, decl->start_line, decl->start_column);
+    size_t end = offset_of(starts, source, decl->end_line, decl->end_column);
+    if (begin >= end) return {};
+
+    std::string original = source.substr(begin, end - begin);
+    if (has_comment(original)) return {};
+
+    std::ostringstream oss;
+    current_indent_ = 0;
+    emit_decl(decl, oss);
+    std::string formatted = oss.str();
+    while (!formatted.empty() && formatted.back() == '\n') formatted.pop_back();
+    if (formatted == original || !reparses(formatted)) return {};
+
+    return diff_edits(original, formatted, begin);
+}
+
+std::vector<TextEdit> Formatter::format_range(const AstModule* module, const std::string& source,
+                                              size_t begin, size_t end) {
+    std::vector<TextEdit> edits;
+    if (!module) return edits;
+    auto starts = line_starts(source);
+    for (const auto& decl : module->decls) {
+        if (decl->end_line == 0) continue;
+        size_t decl_begin = offset_of(starts, source, decl->start_line, decl->start_column);
+        size_t decl_end = offset_of(starts, source, decl->end_line, decl->end_column);
+        // An empty range is a position, which may sit just past a closing brace
+        bool touches = begin == end ? decl_begin <= begin && begin <= decl_end
+                                    : decl_begin < end && begin < decl_end;
+        if (!touches) continue;
+        auto decl_edits = format_decl(decl.get(), source, starts);
+        edits.insert(edits.end(), decl_edits.begin(), decl_edits.end());
+    }
+    return edits;
+}
+
+std::vector<TextEdit> Formatter::format_at(const AstModule* module, const std::string& source, size_t offset) {
+    return format_range(module, source, offset, offset);
+}
+
 } // namespace mana::fmt
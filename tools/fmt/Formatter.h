@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <ostream>
+#include <vector>
 #include "../../frontend/AstModule.h"
 #include "../../frontend/AstExpressions.h"
 #include "../../frontend/AstStatements.h"
@@ -17,13 +18,37 @@ namespace mana::fmt {
         bool space_around_operators = true;
     };
 
+    // Replace bytes [offset, offset + length) of the source with `text`
+    struct TextEdit {
+        size_t offset = 0;
+        size_t length = 0;
+        std::string text;
+    };
+
     class Formatter {
     public:
         explicit Formatter(const FormatConfig& config = {});
 
+        // Bump whenever output changes for the same settings, so that cached
+        // "already formatted" results (mana fmt) are discarded
+        static constexpr int kVersion = 2;
+
         std::string format(const frontend::AstModule* module);
         void format(const frontend::AstModule* module, std::ostream& out);
 
+        // Editor formatting. `source` is the text `module` was parsed from;
+        // only the declarations involved are printed, and the result is the
+        // edits that turn their source text into the formatted text, covering
+        // just the lines that differ. Declarations the printer cannot
+        // reproduce faithfully (comments inside, forms it does not print)
+        // are left alone.
+        std::vector<TextEdit> format_range(const frontend::AstModule* module, const std::string& source,
+                                           size_t begin, size_t end);
+        // The top-level declaration containing `offset`, e.g. after a `}`
+        std::vector<TextEdit> format_at(const frontend::AstModule* module, const std::string& source,
+                                        size_t offset);
+        std::vector<TextEdit> format_decl(const frontend::AstDecl* decl, const std::string& source);
+
     private:
         void emit_decl(const frontend::AstDecl* d, std::ostream& out);
         void emit_stmt(const frontend::AstStmt* s, std::ostream& out, int indent);
@@ -31,6 +56,9 @@ namespace mana::fmt {
         void emit_expr(const frontend::AstExpr* e, std::ostream& out);
         void emit_indent(std::ostream& out, int level);
         void emit_type(const std::string& type, std::ostream& out);
+        void emit_var_decl(const frontend::AstVarDeclStmt* vd, std::ostream& out);
+        std::vector<TextEdit> format_decl(const frontend::AstDecl* decl, const std::string& source,
+                                          const std::vector<size_t>& line_starts);
 
         FormatConfig config_;
         int current_indent_ = 0;
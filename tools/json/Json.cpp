@@ -0,0 +1,538 @@
+#include "Json.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace mana::json {
+
+// Nesting limit; keeps hostile input from overflowing the stack
+static constexpr int max_depth = 512;
+
+// ============================================================================
+// Value
+// ============================================================================
+
+Type Value::type() const {
+    return doc_ ? doc_->nodes_[index_].type : Type::Null;
+}
+
+bool Value::as_bool(bool fallback) const {
+    if (!doc_ || doc_->nodes_[index_].type != Type::Bool) return fallback;
+    return doc_->nodes_[index_].boolean;
+}
+
+int64_t Value::as_int(int64_t fallback) const {
+    if (!doc_ || doc_->nodes_[index_].type != Type::Number) return fallback;
+    const auto& n = doc_->nodes_[index_];
+    if (n.is_integer) return n.integer;
+    // NaN and doubles outside [-2^63, 2^63) have no int64 value
+    if (!(n.number >= -9223372036854775808.0 && n.number < 9223372036854775808.0)) return fallback;
+    return static_cast<int64_t>(n.number);
+}
+
+double Value::as_double(double fallback) const {
+    if (!doc_ || doc_->nodes_[index_].type != Type::Number) return fallback;
+    return doc_->nodes_[index_].number;
+}
+
+std::string_view Value::as_string(std::string_view fallback) const {
+    if (!doc_ || doc_->nodes_[index_].type != Type::String) return fallback;
+    return doc_->nodes_[index_].str;
+}
+
+std::string_view Value::key() const {
+    return doc_ ? doc_->nodes_[index_].key : std::string_view();
+}
+
+Value Value::operator[](std::string_view key) const {
+    if (!doc_ || doc_->nodes_[index_].type != Type::Object) return {};
+    const auto& nodes = doc_->nodes_;
+    uint32_t child = index_ + 1;
+    for (uint32_t i = 0; i < nodes[index_].count; ++i) {
+        if (nodes[child].key == key) return Value(doc_, child);
+        child = nodes[child].end;
+    }
+    return {};
+}
+
+Value Value::at(size_t index) const {
+    if (!doc_) return {};
+    const auto& nodes = doc_->nodes_;
+    Type t = nodes[index_].type;
+    if ((t != Type::Array && t != Type::Object) || index >= nodes[index_].count) return {};
+    uint32_t child = index_ + 1;
+    for (size_t i = 0; i < index; ++i) child = nodes[child].end;
+    return Value(doc_, child);
+}
+
+size_t Value::size() const {
+    if (!doc_) return 0;
+    Type t = doc_->nodes_[index_].type;
+    return (t == Type::Array || t == Type::Object) ? doc_->nodes_[index_].count : 0;
+}
+
+Value::Iterator& Value::Iterator::operator++() {
+    index_ = doc_->nodes_[index_].end;
+    --remaining_;
+    return *this;
+}
+
+Value::Iterator Value::begin() const {
+    return Iterator(doc_, index_ + 1, static_cast<uint32_t>(size()));
+}
+
+Value::Iterator Value::end() const {
+    return Iterator(doc_, 0, 0);
+}
+
+// ============================================================================
+// Document
+// ============================================================================
+
+bool Document::parse(std::string& buffer) {
+    return parse(buffer.data(), buffer.size());
+}
+
+bool Document::parse(char* data, size_t size) {
+    nodes_.clear();
+    error_.clear();
+    begin_ = cur_ = data;
+    end_ = data + size;
+
+    skip_ws();
+    if (!parse_value({}, 0)) {
+        nodes_.clear();
+        return false;
+    }
+    skip_ws();
+    if (cur_ != end_) {
+        nodes_.clear();
+        return fail("trailing characters after JSON value");
+    }
+    return true;
+}
+
+bool Document::fail(const char* message) {
+    error_ = std::string(message) + " at offset " + std::to_string(cur_ - begin_);
+    return false;
+}
+
+void Document::skip_ws() {
+    while (cur_ < end_ && (*cur_ == ' ' || *cur_ == '\t' || *cur_ == '\n' || *cur_ == '\r')) ++cur_;
+}
+
+static bool match_literal(char*& cur, char* end, const char* lit, size_t len) {
+    if (static_cast<size_t>(end - cur) < len || std::memcmp(cur, lit, len) != 0) return false;
+    cur += len;
+    return true;
+}
+
+bool Document::parse_value(std::string_view key, int depth) {
+    if (depth > max_depth) return fail("JSON nested too deeply");
+    if (cur_ >= end_) return fail("unexpected end of input");
+
+    uint32_t index = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    nodes_[index].key = key;
+
+    char c = *cur_;
+    if (c == '{' || c == '[') {
+        bool is_object = c == '{';
+        char close = is_object ? '}' : ']';
+        nodes_[index].type = is_object ? Type::Object : Type::Array;
+        ++cur_;
+        skip_ws();
+        uint32_t count = 0;
+        if (cur_ < end_ && *cur_ == close) {
+            ++cur_;
+        } else {
+            for (;;) {
+                std::string_view member;
+                if (is_object) {
+                    if (cur_ >= end_ || *cur_ != '"') return fail("expected member name");
+                    if (!parse_string(member)) return false;
+                    skip_ws();
+                    if (cur_ >= end_ || *cur_ != ':') return fail("expected ':' after member name");
+                    ++cur_;
+                    skip_ws();
+                }
+                if (!parse_value(member, depth + 1)) return false;
+                ++count;
+                skip_ws();
+                if (cur_ < end_ && *cur_ == ',') {
+                    ++cur_;
+                    skip_ws();
+                    continue;
+                }
+                if (cur_ < end_ && *cur_ == close) {
+                    ++cur_;
+                    break;
+                }
+                return fail(is_object ? "expected ',' or '}'" : "expected ',' or ']'");
+            }
+        }
+        // nodes_ may have grown; index stays valid
+        nodes_[index].count = count;
+    } else if (c == '"') {
+        std::string_view str;
+        if (!parse_string(str)) return false;
+        nodes_[index].type = Type::String;
+        nodes_[index].str = str;
+    } else if (c == 't') {
+        if (!match_literal(cur_, end_, "true", 4)) return fail("invalid literal");
+        nodes_[index].type = Type::Bool;
+        nodes_[index].boolean = true;
+    } else if (c == 'f') {
+        if (!match_literal(cur_, end_, "false", 5)) return fail("invalid literal");
+        nodes_[index].type = Type::Bool;
+    } else if (c == 'n') {
+        if (!match_literal(cur_, end_, "null", 4)) return fail("invalid literal");
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        if (!parse_number(nodes_[index])) return false;
+    } else {
+        return fail("unexpected character");
+    }
+
+    nodes_[index].end = static_cast<uint32_t>(nodes_.size());
+    return true;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool read_hex4(const char* p, const char* end, uint32_t& out) {
+    if (end - p < 4) return false;
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+        int d = hex_digit(p[i]);
+        if (d < 0) return false;
+        out = (out << 4) | static_cast<uint32_t>(d);
+    }
+    return true;
+}
+
+// Unescapes the string starting at the opening quote into the same bytes. The
+// decoded form is never longer than the escaped one, so the write cursor stays
+// behind the read cursor.
+bool Document::parse_string(std::string_view& out) {
+    ++cur_;  // opening quote
+    char* start = cur_;
+
+    // Fast path: find the closing quote; nothing to rewrite if there are no escapes
+    char* p = cur_;
+    while (p < end_ && *p != '"' && *p != '\\') {
+        if (static_cast<unsigned char>(*p) < 0x20) {
+            cur_ = p;
+            return fail("control character in string");
+        }
+        ++p;
+    }
+    if (p < end_ && *p == '"') {
+        out = std::string_view(start, static_cast<size_t>(p - start));
+        cur_ = p + 1;
+        return true;
+    }
+
+    char* w = p;
+    while (p < end_) {
+        char c = *p;
+        if (c == '"') {
+            out = std::string_view(start, static_cast<size_t>(w - start));
+            cur_ = p + 1;
+            return true;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) {
+            cur_ = p;
+            return fail("control character in string");
+        }
+        if (c != '\\') {
+            *w++ = c;
+            ++p;
+            continue;
+        }
+        if (++p >= end_) break;
+        switch (*p++) {
+            case '"': *w++ = '"'; break;
+            case '\\': *w++ = '\\'; break;
+            case '/': *w++ = '/'; break;
+            case 'b': *w++ = '\b'; break;
+            case 'f': *w++ = '\f'; break;
+            case 'n': *w++ = '\n'; break;
+            case 'r': *w++ = '\r'; break;
+            case 't': *w++ = '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!read_hex4(p, end_, cp)) {
+                    cur_ = p;
+                    return fail("invalid \\u escape");
+                }
+                p += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    // High surrogate; combine with the following \uDC00-\uDFFF
+                    uint32_t low;
+                    if (end_ - p >= 6 && p[0] == '\\' && p[1] == 'u' && read_hex4(p + 2, end_, low) &&
+                        low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    } else {
+                        cp = 0xFFFD;
+                    }
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+                if (cp < 0x80) {
+                    *w++ = static_cast<char>(cp);
+                } else if (cp < 0x800) {
+                    *w++ = static_cast<char>(0xC0 | (cp >> 6));
+                    *w++ = static_cast<char>(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    *w++ = static_cast<char>(0xE0 | (cp >> 12));
+                    *w++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    *w++ = static_cast<char>(0x80 | (cp & 0x3F));
+                } else {
+                    *w++ = static_cast<char>(0xF0 | (cp >> 18));
+                    *w++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                    *w++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    *w++ = static_cast<char>(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default:
+                cur_ = p - 1;
+                return fail("invalid escape sequence");
+        }
+    }
+    cur_ = end_;
+    return fail("unterminated string");
+}
+
+bool Document::parse_number(Node& node) {
+    char* start = cur_;
+    char* p = cur_;
+    if (*p == '-') ++p;
+    if (p >= end_ || !(*p >= '0' && *p <= '9')) {
+        cur_ = p;
+        return fail("invalid number");
+    }
+    if (*p == '0') {
+        ++p;
+    } else {
+        while (p < end_ && *p >= '0' && *p <= '9') ++p;
+    }
+    bool integral = true;
+    if (p < end_ && *p == '.') {
+        integral = false;
+        ++p;
+        if (p >= end_ || !(*p >= '0' && *p <= '9')) {
+            cur_ = p;
+            return fail("invalid number");
+        }
+        while (p < end_ && *p >= '0' && *p <= '9') ++p;
+    }
+    if (p < end_ && (*p == 'e' || *p == 'E')) {
+        integral = false;
+        ++p;
+        if (p < end_ && (*p == '+' || *p == '-')) ++p;
+        if (p >= end_ || !(*p >= '0' && *p <= '9')) {
+            cur_ = p;
+            return fail("invalid number");
+        }
+        while (p < end_ && *p >= '0' && *p <= '9') ++p;
+    }
+    cur_ = p;
+    node.type = Type::Number;
+
+    size_t len = static_cast<size_t>(p - start);
+    if (integral && len <= 18) {
+        // Up to 18 digits always fit in int64_t
+        bool negative = *start == '-';
+        int64_t v = 0;
+        for (const char* d = start + (negative ? 1 : 0); d < p; ++d) v = v * 10 + (*d - '0');
+        node.integer = negative ? -v : v;
+        node.number = static_cast<double>(node.integer);
+        node.is_integer = true;
+        return true;
+    }
+    // strtod needs a terminated copy; numbers in JSON-RPC traffic are short
+    char local[64];
+    std::string heap;
+    const char* text;
+    if (len < sizeof(local)) {
+        std::memcpy(local, start, len);
+        local[len] = '\0';
+        text = local;
+    } else {
+        heap.assign(start, len);
+        text = heap.c_str();
+    }
+    node.number = std::strtod(text, nullptr);
+    if (integral) {
+        errno = 0;
+        long long v = std::strtoll(text, nullptr, 10);
+        if (errno != ERANGE) {
+            node.integer = v;
+            node.is_integer = true;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+void write_escaped(std::string& out, std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    out.reserve(out.size() + s.size() + 2);
+    out += '"';
+    size_t run = 0;  // Start of the pending run of bytes that need no escaping
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+                break;
+        }
+    }
+    out.append(s.data() + run, s.size() - run);
+    out += '"';
+}
+
+void Writer::separate() {
+    if (need_comma_) out_ += ',';
+}
+
+Writer& Writer::begin_object() {
+    separate();
+    out_ += '{';
+    need_comma_ = false;
+    return *this;
+}
+
+Writer& Writer::end_object() {
+    out_ += '}';
+    need_comma_ = true;
+    return *this;
+}
+
+Writer& Writer::begin_array() {
+    separate();
+    out_ += '[';
+    need_comma_ = false;
+    return *this;
+}
+
+Writer& Writer::end_array() {
+    out_ += ']';
+    need_comma_ = true;
+    return *this;
+}
+
+Writer& Writer::key(std::string_view k) {
+    separate();
+    write_escaped(out_, k);
+    out_ += ':';
+    need_comma_ = false;
+    return *this;
+}
+
+Writer& Writer::value(std::string_view s) {
+    separate();
+    write_escaped(out_, s);
+    need_comma_ = true;
+    return *this;
+}
+
+Writer& Writer::value(bool b) {
+    separate();
+    out_ += b ? "true" : "false";
+    need_comma_ = true;
+    return *this;
+}
+
+Writer& Writer::value(int64_t v) {
+    separate();
+    char buf[24];
+    int n = std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(v));
+    out_.append(buf, static_cast<size_t>(n));
+    need_comma_ = true;
+    return *this;
+}
+
+Writer& Writer::value(uint64_t v) {
+    separate();
+    char buf[24];
+    int n = std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(v));
+    out_.append(buf, static_cast<size_t>(n));
+    need_comma_ = true;
+    return *this;
+}
+
+Writer& Writer::value(double v) {
+    separate();
+    if (!std::isfinite(v)) {
+        out_ += "null";  // JSON has no NaN/Infinity
+    } else {
+        char buf[32];
+        int n = std::snprintf(buf, sizeof(buf), "%.17g", v);
+        out_.append(buf, static_cast<size_t>(n));
+    }
+    need_comma_ = true;
+    return *this;
+}
+
+Writer& Writer::null() {
+    separate();
+    out_ += "null";
+    need_comma_ = true;
+    return *this;
+}
+
+Writer& Writer::value(const Value& v) {
+    switch (v.type()) {
+        case Type::Null: return null();
+        case Type::Bool: return value(v.as_bool());
+        case Type::Number: {
+            double d = v.as_double();
+            if (d == std::floor(d) && std::fabs(d) < 9.2e18) return value(v.as_int());
+            return value(d);
+        }
+        case Type::String: return value(v.as_string());
+        case Type::Array:
+            begin_array();
+            for (Value item : v) value(item);
+            return end_array();
+        case Type::Object:
+            begin_object();
+            for (Value member : v) key(member.key()).value(member);
+            return end_object();
+    }
+    return *this;
+}
+
+Writer& Writer::raw(std::string_view json) {
+    separate();
+    out_.append(json.data(), json.size());
+    need_comma_ = true;
+    return *this;
+}
+
+} // namespace mana::json
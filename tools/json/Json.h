@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// JSON reader/writer for the JSON-RPC transports (mana-lsp, mana-debug) and
+// tool files such as `mana bench` baselines.
+//
+// Document::parse works on the caller's buffer: strings are unescaped in place
+// and every string value is a std::string_view into that buffer, so a message
+// is parsed with no per-value allocations. Keep the buffer alive (and
+// unmodified) while its Values are in use; reusing one Document across
+// messages also reuses its node storage.
+
+namespace mana::json {
+
+    enum class Type : uint8_t { Null, Bool, Number, String, Array, Object };
+
+    class Document;
+
+    // Handle to a node in a Document. Lookups that miss return an invalid
+    // Value, which reads as null, so chains like v["a"]["b"].as_int() are safe.
+    class Value {
+    public:
+        Value() = default;
+
+        Type type() const;
+        bool valid() const { return doc_ != nullptr; }
+        bool is_null() const { return type() == Type::Null; }
+        bool is_bool() const { return type() == Type::Bool; }
+        bool is_number() const { return type() == Type::Number; }
+        bool is_string() const { return type() == Type::String; }
+        bool is_array() const { return type() == Type::Array; }
+        bool is_object() const { return type() == Type::Object; }
+
+        bool as_bool(bool fallback = false) const;
+        int64_t as_int(int64_t fallback = 0) const;
+        double as_double(double fallback = 0.0) const;
+        std::string_view as_string(std::string_view fallback = {}) const;
+
+        // Member name when this value sits in an object
+        std::string_view key() const;
+
+        // Object member (linear scan; LSP/DAP objects are small)
+        Value operator[](std::string_view key) const;
+        Value operator[](const char* key) const { return (*this)[std::string_view(key)]; }
+        // Array element or object member by position
+        Value at(size_t index) const;
+        size_t size() const;
+
+        class Iterator {
+        public:
+            Iterator(const Document* doc, uint32_t index, uint32_t remaining)
+                : doc_(doc), index_(index), remaining_(remaining) {}
+            Value operator*() const { return Value(doc_, index_); }
+            Iterator& operator++();
+            bool operator!=(const Iterator& other) const { return remaining_ != other.remaining_; }
+
+        private:
+            const Document* doc_;
+            uint32_t index_;
+            uint32_t remaining_;
+        };
+
+        // Iterates array elements or object members (use key() for the name)
+        Iterator begin() const;
+        Iterator end() const;
+
+    private:
+        friend class Document;
+        Value(const Document* doc, uint32_t index) : doc_(doc), index_(index) {}
+
+        const Document* doc_ = nullptr;
+        uint32_t index_ = 0;
+    };
+
+    class Document {
+    public:
+        // Parses `buffer` in place. On failure returns false and error() says why.
+        bool parse(std::string& buffer);
+        bool parse(char* data, size_t size);
+
+        Value root() const { return nodes_.empty() ? Value() : Value(this, 0); }
+        const std::string& error() const { return error_; }
+
+    private:
+        friend class Value;
+
+        // Nodes are stored in pre-order; `end` is one past the node's subtree,
+        // so the next sibling of node i is nodes_[nodes_[i].end].
+        struct Node {
+            Type type = Type::Null;
+            bool boolean = false;
+            uint32_t end = 0;
+            uint32_t count = 0;     // Elements or members
+            std::string_view key;   // Member name inside an object
+            std::string_view str;   // String value
+            double number = 0.0;
+            int64_t integer = 0;    // Exact value when the number has no fraction/exponent
+            bool is_integer = false;
+        };
+
+        bool parse_value(std::string_view key, int depth);
+        bool parse_string(std::string_view& out);
+        bool parse_number(Node& node);
+        void skip_ws();
+        bool fail(const char* message);
+
+        std::vector<Node> nodes_;
+        char* cur_ = nullptr;
+        char* end_ = nullptr;
+        char* begin_ = nullptr;
+        std::string error_;
+    };
+
+    // Streaming serializer that appends compact JSON to a string. Commas are
+    // inserted automatically:
+    //   Writer w(out);
+    //   w.begin_object().key("id").value(1).key("result").null().end_object();
+    class Writer {
+    public:
+        explicit Writer(std::string& out) : out_(out) {}
+
+        Writer& begin_object();
+        Writer& end_object();
+        Writer& begin_array();
+        Writer& end_array();
+        Writer& key(std::string_view k);
+
+        Writer& value(std::string_view s);
+        Writer& value(const char* s) { return value(std::string_view(s)); }
+        Writer& value(const std::string& s) { return value(std::string_view(s)); }
+        Writer& value(bool b);
+        Writer& value(int v) { return value(static_cast<int64_t>(v)); }
+        Writer& value(int64_t v);
+        Writer& value(uint64_t v);
+        Writer& value(double v);
+        Writer& null();
+        // Copies a parsed value (e.g. echoing a request id back)
+        Writer& value(const Value& v);
+        // Splices in an already-serialized JSON value
+        Writer& raw(std::string_view json);
+
+    private:
+        void separate();
+
+        std::string& out_;
+        bool need_comma_ = false;
+    };
+
+    // Appends `s` as a quoted JSON string
+    void write_escaped(std::string& out, std::string_view s);
+
+} // namespace mana::json
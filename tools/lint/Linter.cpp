@@ -1,16 +1,28 @@
 #include "Linter.h"
-#include "../frontend/Lexer.h"
-#include "../frontend/Parser.h"
+#include "../../frontend/Lexer.h"
+#include "../../frontend/Parser.h"
+#include "../../frontend/Semantic.h"
+#include "../../frontend/Imports.h"
+#include "../json/Json.h"
+#include "../common/FileUtil.h"
+#include "../common/Parallel.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
+#include <filesystem>
 #include <iomanip>
+#include <map>
 
 namespace mana::lint {
 
-// Static rule definitions
+using namespace frontend;
+namespace fs = std::filesystem;
+
+// Static rule definitions. Break/continue outside a loop and missing returns
+// are compile errors reported by the semantic analyzer, so they are not lints.
 static std::vector<LintRule> s_all_rules = {
     {"unused_variable", "Unused Variable", "Warns when a variable is declared but never used",
      LintCategory::Unused, LintSeverity::Warn, true},
@@ -34,14 +46,8 @@ static std::vector<LintRule> s_all_rules = {
      LintCategory::Correctness, LintSeverity::Warn, true},
     {"shadowed_variable", "Shadowed Variable", "Variable shadows a variable from an outer scope",
      LintCategory::Correctness, LintSeverity::Warn, true},
-    {"assignment_in_condition", "Assignment in Condition", "Assignment used where comparison expected",
-     LintCategory::Correctness, LintSeverity::Warn, true},
     {"empty_block", "Empty Block", "Empty block statements may indicate missing code",
      LintCategory::Correctness, LintSeverity::Warn, true},
-    {"break_outside_loop", "Break Outside Loop", "Break statement outside of loop",
-     LintCategory::Correctness, LintSeverity::Deny, true},
-    {"continue_outside_loop", "Continue Outside Loop", "Continue statement outside of loop",
-     LintCategory::Correctness, LintSeverity::Deny, true},
 
     {"high_complexity", "High Complexity", "Function has high cyclomatic complexity",
      LintCategory::Complexity, LintSeverity::Warn, true},
@@ -50,12 +56,28 @@ static std::vector<LintRule> s_all_rules = {
     {"deep_nesting", "Deep Nesting", "Code has deep nesting levels",
      LintCategory::Complexity, LintSeverity::Warn, true},
 
-    {"missing_return", "Missing Return", "Non-void function may not return a value",
-     LintCategory::Correctness, LintSeverity::Warn, true},
     {"redundant_return", "Redundant Return", "Void function has unnecessary return statement",
      LintCategory::Style, LintSeverity::Warn, false},  // Disabled by default
+
+    {"string_concat_in_loop", "String Concatenation In Loop", "String rebuilt with '+' on every loop iteration",
+     LintCategory::Performance, LintSeverity::Warn, true, true},
+    {"vec_push_without_reserve", "Push Without Reserve", "Vec grown by push in a loop whose iteration count is known",
+     LintCategory::Performance, LintSeverity::Warn, true, true},
+    {"large_struct_by_value", "Large Struct By Value", "Large or heap-owning struct parameter copied on every call",
+     LintCategory::Performance, LintSeverity::Warn, true},
+    {"regex_in_loop", "Regex In Loop", "Regular expression compiled on every loop iteration",
+     LintCategory::Performance, LintSeverity::Warn, true, true},
+    {"map_double_lookup", "Map Double Lookup", "HashMap searched by get/contains and again by insert for the same key",
+     LintCategory::Performance, LintSeverity::Warn, true},
+    {"loop_variable_copy", "Loop Variable Copy", "for-in loop copies each non-trivial element of a Vec",
+     LintCategory::Performance, LintSeverity::Warn, true, true},
 };
 
+static constexpr int kMaxComplexity = 10;
+static constexpr int kMaxParameters = 5;
+static constexpr int kMaxNesting = 4;
+static constexpr int kMaxByValueBytes = 64;  // Larger parameters should be borrowed
+
 // Terminal colors
 static bool s_colors_enabled = true;
 
@@ -68,722 +90,1292 @@ static const char* color_cyan() { return s_colors_enabled ? "\033[36m" : ""; }
 static const char* color_green() { return s_colors_enabled ? "\033[32m" : ""; }
 static const char* color_dim() { return s_colors_enabled ? "\033[2m" : ""; }
 
-// Linter implementation
-Linter::Linter(const LintConfig& config) : config_(config) {}
+// State of one module's walk
+struct Linter::Walk {
+    Walk(std::string file, std::vector<LintMessage>& messages) : file(std::move(file)), messages(messages) {}
+
+    std::string file;
+    std::vector<LintMessage>& messages;
+    const LintInput* input = nullptr;
+    int complexity = 1;      // Cyclomatic complexity of the current function
+    int depth = 0;           // Nested control-flow bodies in the current function
+    bool reported_nesting = false;
+
+    // Performance rules
+    std::vector<size_t> line_starts;                                 // Offsets into input->source
+    std::unordered_map<std::string, const AstStructDecl*> structs;   // Including imported ones
+    std::vector<const AstStmt*> loops;                               // Enclosing loops, outermost first
+    std::unordered_map<std::string, std::string> local_types;        // Parameters and lets, as analyzed
+    std::unordered_map<std::string, const AstVarDeclStmt*> local_decls;
+    std::unordered_set<std::string> reserved;                        // Vecs reserved or already reported
+    std::vector<std::pair<std::string, const AstMethodCallExpr*>> lookups;  // "map\tkey" of get/contains
+};
 
-std::vector<LintRule> Linter::get_all_rules() {
-    return s_all_rules;
+namespace {
+
+bool read_file(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    out = buffer.str();
+    return true;
 }
 
-const LintRule* Linter::get_rule(const std::string& id) {
-    for (const auto& rule : s_all_rules) {
-        if (rule.id == id) {
-            return &rule;
+std::string decl_name(const AstDecl* d) {
+    if (auto fn = dynamic_cast<const AstFuncDecl*>(d)) return fn->name;
+    if (auto s = dynamic_cast<const AstStructDecl*>(d)) return s->name;
+    if (auto e = dynamic_cast<const AstEnumDecl*>(d)) return e->name;
+    if (auto t = dynamic_cast<const AstTraitDecl*>(d)) return t->name;
+    if (auto a = dynamic_cast<const AstTypeAliasDecl*>(d)) return a->alias_name;
+    if (auto g = dynamic_cast<const AstGlobalVarDecl*>(d)) return g->var ? g->var->name : "";
+    return "";
+}
+
+// Cache fields are tab-separated; tabs, newlines and backslashes are escaped
+std::string escape_field(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\t') out += "\\t";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+std::vector<std::string> split_fields(const std::string& line) {
+    std::vector<std::string> fields(1);
+    for (size_t i = 0; i < line.size(); i++) {
+        if (line[i] == '\t') {
+            fields.emplace_back();
+        } else if (line[i] == '\\' && i + 1 < line.size()) {
+            char c = line[++i];
+            fields.back() += c == 't' ? '\t' : c == 'n' ? '\n' : c;
+        } else {
+            fields.back() += line[i];
         }
     }
-    return nullptr;
+    return fields;
+}
+
+std::vector<size_t> compute_line_starts(std::string_view source) {
+    std::vector<size_t> starts{0};
+    for (size_t i = 0; i < source.size(); i++) {
+        if (source[i] == '\n') starts.push_back(i + 1);
+    }
+    return starts;
+}
+
+size_t offset_at(const std::vector<size_t>& line_starts, size_t size, int line, int column) {
+    if (line < 1 || line > static_cast<int>(line_starts.size()) || column < 1) return std::string::npos;
+    size_t offset = line_starts[line - 1] + column - 1;
+    return offset <= size ? offset : std::string::npos;
+}
+
+std::string line_indent(std::string_view source, const std::vector<size_t>& line_starts, int line) {
+    size_t begin = line_starts[line - 1];
+    size_t end = begin;
+    while (end < source.size() && (source[end] == ' ' || source[end] == '\t')) end++;
+    return std::string(source.substr(begin, end - begin));
+}
+
+LintFix make_fix(const std::vector<size_t>& line_starts, size_t begin, size_t end, std::string replacement) {
+    auto position = [&](size_t offset, int& line, int& column) {
+        auto it = std::upper_bound(line_starts.begin(), line_starts.end(), offset) - 1;
+        line = static_cast<int>(it - line_starts.begin()) + 1;
+        column = static_cast<int>(offset - *it) + 1;
+    };
+    LintFix fix;
+    position(begin, fix.line, fix.column);
+    position(end, fix.end_line, fix.end_column);
+    fix.replacement = std::move(replacement);
+    return fix;
 }
 
-void Linter::push_scope() {
-    scopes_.push_back({});
+// Index of the first token at or after (line, column)
+size_t find_token(const std::vector<Token>& tokens, int line, int column) {
+    auto it = std::lower_bound(tokens.begin(), tokens.end(), std::make_pair(line, column),
+        [](const Token& t, const std::pair<int, int>& pos) {
+            return t.line < pos.first || (t.line == pos.first && t.column < pos.second);
+        });
+    return static_cast<size_t>(it - tokens.begin());
 }
 
-void Linter::pop_scope() {
-    if (!scopes_.empty()) {
-        scopes_.pop_back();
+// Offset just past a token. Literal lexemes are unescaped, so their extent
+// is read from the source.
+size_t token_end(std::string_view source, const std::vector<size_t>& line_starts, const Token& token) {
+    size_t offset = offset_at(line_starts, source.size(), token.line, token.column);
+    if (offset == std::string::npos) return source.size();
+    bool literal = token.kind == TokenKind::StringLiteral || token.kind == TokenKind::RawStringLiteral ||
+                   token.kind == TokenKind::MultiLineStringLiteral || token.kind == TokenKind::CharLiteral;
+    if (!literal) return std::min(source.size(), offset + token.lexeme.size());
+
+    size_t i = offset;
+    while (i < source.size() && std::isalpha(static_cast<unsigned char>(source[i]))) i++;  // r"", f""
+    if (source.compare(i, 3, "\"\"\"") == 0) {
+        size_t close = source.find("\"\"\"", i + 3);
+        return close == std::string::npos ? source.size() : close + 3;
+    }
+    if (i >= source.size()) return source.size();
+    char quote = source[i++];
+    bool raw = token.kind == TokenKind::RawStringLiteral;
+    while (i < source.size() && source[i] != quote) {
+        if (source[i] == '\\' && !raw) i++;
+        i++;
+    }
+    return std::min(source.size(), i + 1);
+}
+
+bool is_opening(TokenKind kind) {
+    return kind == TokenKind::LParen || kind == TokenKind::LBracket || kind == TokenKind::LBrace;
+}
+
+bool is_closing(TokenKind kind) {
+    return kind == TokenKind::RParen || kind == TokenKind::RBracket || kind == TokenKind::RBrace;
+}
+
+// Index of the bracket closing the one at `open`, or tokens.size()
+size_t matching_token(const std::vector<Token>& tokens, size_t open) {
+    int depth = 0;
+    for (size_t i = open; i < tokens.size(); i++) {
+        if (is_opening(tokens[i].kind)) depth++;
+        else if (is_closing(tokens[i].kind) && --depth == 0) return i;
+    }
+    return tokens.size();
+}
+
+// Last token of the statement starting at `first` (semicolons are optional,
+// so a new line ends it unless the previous token needs an operand)
+size_t statement_end(const std::vector<Token>& tokens, size_t first, bool& semicolon) {
+    semicolon = false;
+    int depth = 0;
+    size_t last = first;
+    for (size_t i = first; i < tokens.size() && tokens[i].kind != TokenKind::EndOfFile; i++) {
+        const Token& t = tokens[i];
+        if (depth == 0) {
+            if (t.kind == TokenKind::Semicolon) {
+                semicolon = true;
+                break;
+            }
+            if (is_closing(t.kind)) break;
+            TokenKind prev = tokens[last].kind;
+            bool continues = prev == TokenKind::Plus || prev == TokenKind::Minus || prev == TokenKind::Star ||
+                             prev == TokenKind::Slash || prev == TokenKind::Assign || prev == TokenKind::Comma ||
+                             prev == TokenKind::Dot || prev == TokenKind::AndAnd || prev == TokenKind::OrOr;
+            if (i > first && t.line > tokens[last].line && !continues) break;
+        }
+        if (is_opening(t.kind)) depth++;
+        else if (is_closing(t.kind)) depth--;
+        last = i;
     }
+    return last;
 }
 
-void Linter::declare_var(const std::string& name, const std::string& type,
-                         int line, int col, bool is_param, bool is_loop_var) {
-    if (scopes_.empty()) {
-        push_scope();
+// An identifier not yet used anywhere in the file
+std::string fresh_name(const std::vector<Token>& tokens, const std::string& base) {
+    for (int n = 1;; n++) {
+        std::string name = n == 1 ? base : base + std::to_string(n);
+        bool taken = std::any_of(tokens.begin(), tokens.end(), [&](const Token& t) {
+            return t.kind == TokenKind::Identifier && t.lexeme == name;
+        });
+        if (!taken) return name;
     }
+}
+
+bool is_string_type(const std::string& type) {
+    return type == "string" || type == "String" || type == "str";
+}
+
+// "T" for "Vec<T>", else empty
+std::string vec_element(const std::string& type) {
+    if (type.rfind("Vec<", 0) != 0 || type.back() != '>') return "";
+    return type.substr(4, type.size() - 5);
+}
 
-    VarUsage usage;
-    usage.name = name;
-    usage.type = type;
-    usage.decl_line = line;
-    usage.decl_column = col;
-    usage.is_parameter = is_param;
-    usage.is_loop_var = is_loop_var;
-    usage.is_read = false;
-    usage.is_written = is_loop_var;  // Loop vars are implicitly written
+// Rough size of a value and whether copying it allocates
+struct TypeCost {
+    int bytes = 8;
+    bool owns_heap = false;
+};
 
-    scopes_.back()[name] = usage;
+TypeCost type_cost(const std::string& type, const std::unordered_map<std::string, const AstStructDecl*>& structs,
+                   int depth = 0) {
+    if (type == "bool" || type == "i8" || type == "u8" || type == "char") return {1, false};
+    if (type == "i16" || type == "u16") return {2, false};
+    if (type == "i32" || type == "u32" || type == "f32") return {4, false};
+    if (type == "Vec2") return {8, false};
+    if (type == "Vec3") return {12, false};
+    if (type == "Vec4" || type == "Quat") return {16, false};
+    if (type == "Mat4") return {64, false};
+    if (is_string_type(type)) return {32, true};
+    if (type.rfind("HashMap<", 0) == 0 || type.rfind("HashSet<", 0) == 0) return {56, true};
+    if (type.rfind("Vec<", 0) == 0) return {24, true};
+    if (type.rfind("Option<", 0) == 0 && type.back() == '>') {
+        TypeCost inner = type_cost(type.substr(7, type.size() - 8), structs, depth + 1);
+        return {inner.bytes + 8, inner.owns_heap};
+    }
+    auto it = structs.find(type);
+    if (it == structs.end() || depth > 8) return {8, false};  // Scalars, references, unknown types
+    TypeCost cost{0, false};
+    for (const auto& field : it->second->fields) {
+        TypeCost f = type_cost(field.type_name, structs, depth + 1);
+        cost.bytes += f.bytes;
+        cost.owns_heap |= f.owns_heap;
+    }
+    return cost;
 }
 
-void Linter::mark_var_read(const std::string& name) {
-    if (VarUsage* var = find_var(name)) {
-        var->is_read = true;
+// Source-independent spelling of a simple map key, empty if not simple
+std::string key_text(const AstNode* node) {
+    if (auto id = dynamic_cast<const AstIdentifierExpr*>(node)) return id->name;
+    if (auto lit = dynamic_cast<const AstLiteralExpr*>(node)) return lit->is_string ? "\"" + lit->value + "\"" : lit->value;
+    if (auto member = dynamic_cast<const AstMemberAccessExpr*>(node)) {
+        std::string object = key_text(member->object.get());
+        return object.empty() ? "" : object + "." + member->member_name;
     }
+    return "";
 }
 
-void Linter::mark_var_written(const std::string& name) {
-    if (VarUsage* var = find_var(name)) {
-        var->is_written = true;
+} // namespace
+
+// Linter implementation
+Linter::Linter(const LintConfig& config) : config_(config) {}
+
+std::vector<std::string> Linter::rules_in_category(const std::string& name) {
+    static const std::unordered_map<std::string, LintCategory> categories = {
+        {"style", LintCategory::Style},
+        {"unused", LintCategory::Unused},
+        {"correctness", LintCategory::Correctness},
+        {"perf", LintCategory::Performance},
+        {"complexity", LintCategory::Complexity},
+    };
+    std::vector<std::string> ids;
+    auto it = categories.find(name);
+    if (it == categories.end()) return ids;
+    for (const auto& rule : s_all_rules) {
+        if (rule.category == it->second) ids.push_back(rule.id);
     }
+    return ids;
+}
+
+std::vector<LintRule> Linter::get_all_rules() {
+    return s_all_rules;
 }
 
-VarUsage* Linter::find_var(const std::string& name) {
-    for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
-        auto found = it->find(name);
-        if (found != it->end()) {
-            return &found->second;
+const LintRule* Linter::get_rule(const std::string& id) {
+    for (const auto& rule : s_all_rules) {
+        if (rule.id == id) {
+            return &rule;
         }
     }
     return nullptr;
 }
 
 std::vector<LintMessage> Linter::lint_file(const std::string& file) {
-    std::vector<LintMessage> messages;
-
-    std::ifstream in(file);
-    if (!in) {
+    std::string source;
+    if (!read_file(file, source)) {
         LintMessage msg;
         msg.rule_id = "file_error";
         msg.message = "Cannot open file: " + file;
         msg.file = file;
         msg.severity = LintSeverity::Deny;
-        messages.push_back(msg);
-        return messages;
+        return {msg};
     }
+    return lint_source(file, source).messages;
+}
 
-    std::stringstream buffer;
-    buffer << in.rdbuf();
-    std::string source = buffer.str();
-
-    // Lex and parse
-    frontend::Lexer lexer(source);
-    auto tokens = lexer.tokenize();
-
-    frontend::DiagnosticEngine diag;
-    diag.set_source(file, source);
+Linter::CachedFile Linter::lint_source(const std::string& file, const std::string& source) const {
+    CachedFile result;
+    result.hash = tools::hash_bytes(source);
 
-    frontend::Parser parser(tokens, diag);
-    auto module = parser.parse();
+    LintInput input;
+    Lexer lexer(source);
+    input.tokens = lexer.tokenize();
+    DiagnosticEngine diag;
+    Parser parser(input.tokens, diag);
+    auto module = parser.parse_module();
 
-    if (!module) {
+    if (!module || diag.has_errors()) {
         LintMessage msg;
         msg.rule_id = "parse_error";
-        msg.message = "Failed to parse file: " + file;
+        msg.message = "Failed to parse file";
+        if (diag.has_errors()) {
+            const auto first = diag.errors().front();
+            msg.message += ": " + first.message;
+            msg.line = first.line;
+            msg.column = first.column;
+        }
         msg.file = file;
         msg.severity = LintSeverity::Deny;
-        messages.push_back(msg);
-        return messages;
-    }
-
-    return lint_module(module.get(), file);
+        result.messages.push_back(msg);
+        return result;
+    }
+
+    // Spliced as the compiler does, so the analyzer can resolve everything
+    // the file uses. Every file read is recorded with its content hash; a
+    // cached result is reused only while they are unchanged.
+    FileImportOptions imports;
+    imports.skip_broken = true;
+    imports.on_read = [&](const std::string& path, const std::string& text) {
+        result.imports.emplace_back(path, tools::hash_bytes(text));
+    };
+    imports.on_import = [&](const AstImportDecl& imp, const std::vector<const AstDecl*>& decls) {
+        ImportedFile entry;
+        entry.path = imp.path;
+        entry.line = imp.line;
+        entry.column = imp.column;
+        for (const AstDecl* d : decls) {
+            std::string name = decl_name(d);
+            if (!name.empty()) entry.names.push_back(std::move(name));
+        }
+        input.imports.push_back(std::move(entry));
+    };
+    std::unordered_set<std::string> seen;
+    DiagnosticEngine import_diag;
+    splice_file_imports(module.get(), fs::path(file).parent_path(), import_diag, seen, imports);
+
+    // Type errors are the compiler's to report; the analysis still records
+    // every name it resolved
+    DiagnosticEngine sema_diag;
+    SemanticAnalyzer analyzer(sema_diag);
+    analyzer.set_semantic_info(&input.semantic);
+    analyzer.analyze(module.get());
+
+    input.module = module.get();
+    input.source = source;
+    result.messages = lint_module(input, file);
+    return result;
 }
 
-std::vector<LintMessage> Linter::lint_module(const frontend::AstModule* module,
-                                              const std::string& file) {
+std::vector<LintMessage> Linter::lint_module(const LintInput& input, const std::string& file) const {
     std::vector<LintMessage> messages;
-    current_file_ = file;
-
-    // Reset state
-    scopes_.clear();
-    functions_.clear();
-    imports_.clear();
-    used_imports_.clear();
-    warning_count_ = 0;
-    error_count_ = 0;
-
-    visit_module(module, messages);
+    Walk walk{file, messages};
+    walk.input = &input;
+    walk.line_starts = compute_line_starts(input.source);
+    for (const auto& decl : input.module->decls) {
+        if (auto s = dynamic_cast<const AstStructDecl*>(decl.get())) walk.structs[s->name] = s;
+    }
 
-    // Check for unused functions
-    check_unused_functions(messages);
+    check_symbols(input, walk);
+    check_unused_imports(input, walk);
 
-    // Check for unused imports
-    check_unused_imports(messages);
+    for (const auto& decl : input.module->decls) {
+        if (!decl->source_module.empty()) continue;  // Spliced in from an import
 
-    // Count warnings and errors
-    for (const auto& msg : messages) {
-        if (msg.severity == LintSeverity::Warn) {
-            warning_count_++;
-        } else if (msg.severity == LintSeverity::Deny || msg.severity == LintSeverity::Forbid) {
-            error_count_++;
+        if (auto fn = dynamic_cast<const AstFuncDecl*>(decl.get())) {
+            visit_function(fn, walk);
+        } else if (auto impl = dynamic_cast<const AstImplDecl*>(decl.get())) {
+            for (const auto& method : impl->methods) {
+                visit_function(method.get(), walk);
+            }
+        } else if (auto s = dynamic_cast<const AstStructDecl*>(decl.get())) {
+            check_naming_conventions(s->name, "type", s->line, s->column, walk);
+        } else if (auto e = dynamic_cast<const AstEnumDecl*>(decl.get())) {
+            check_naming_conventions(e->name, "type", e->line, e->column, walk);
+        } else if (auto t = dynamic_cast<const AstTraitDecl*>(decl.get())) {
+            check_naming_conventions(t->name, "type", t->line, t->column, walk);
+        } else if (auto a = dynamic_cast<const AstTypeAliasDecl*>(decl.get())) {
+            check_naming_conventions(a->alias_name, "type", a->line, a->column, walk);
         }
     }
 
+    std::stable_sort(messages.begin(), messages.end(), [](const LintMessage& a, const LintMessage& b) {
+        return a.line < b.line || (a.line == b.line && a.column < b.column);
+    });
     return messages;
 }
 
-std::vector<LintMessage> Linter::lint_files(const std::vector<std::string>& files) {
-    std::vector<LintMessage> all_messages;
+std::vector<LintMessage> Linter::lint_files(const std::vector<std::string>& paths) {
+    std::vector<std::string> files = tools::collect_mana_files(paths);
+    if (config_.use_cache) load_cache();
+
+    // Results by canonical path, in input order
+    std::vector<std::pair<std::string, CachedFile>> results(files.size());
+    std::vector<char> from_cache(files.size(), 0);
+    tools::parallel_for(files.size(), tools::job_count(config_.jobs), [&](size_t i) {
+        const std::string& file = files[i];
+        std::string key = fs::weakly_canonical(file).string();
+        results[i].first = key;
+
+        std::string source;
+        if (!read_file(file, source)) {
+            LintMessage msg;
+            msg.rule_id = "file_error";
+            msg.message = "Cannot open file: " + file;
+            msg.file = file;
+            msg.severity = LintSeverity::Deny;
+            results[i].second.messages.push_back(msg);
+            return;
+        }
 
-    for (const auto& file : files) {
-        auto messages = lint_file(file);
-        all_messages.insert(all_messages.end(), messages.begin(), messages.end());
+        auto cached = cache_.find(key);
+        if (cached != cache_.end() && cached->second.hash == tools::hash_bytes(source)) {
+            bool fresh = std::all_of(cached->second.imports.begin(), cached->second.imports.end(),
+                [](const std::pair<std::string, uint64_t>& dep) {
+                    std::string content;
+                    return read_file(dep.first, content) && tools::hash_bytes(content) == dep.second;
+                });
+            if (fresh) {
+                results[i].second = cached->second;
+                for (auto& msg : results[i].second.messages) msg.file = file;
+                from_cache[i] = 1;
+                return;
+            }
+        }
+        results[i].second = lint_source(file, source);
+    });
+
+    std::vector<LintMessage> all_messages;
+    warning_count_ = 0;
+    error_count_ = 0;
+    cached_count_ = static_cast<int>(std::count(from_cache.begin(), from_cache.end(), 1));
+    for (const auto& [key, result] : results) {
+        for (const auto& msg : result.messages) {
+            if (msg.severity == LintSeverity::Warn) {
+                warning_count_++;
+            } else if (msg.severity == LintSeverity::Deny || msg.severity == LintSeverity::Forbid) {
+                error_count_++;
+            }
+            all_messages.push_back(msg);
+        }
     }
 
+    bool changed = std::any_of(from_cache.begin(), from_cache.end(), [](char c) { return c == 0; });
+    if (config_.use_cache && changed) save_cache(results);
     return all_messages;
 }
 
-void Linter::visit_module(const frontend::AstModule* module, std::vector<LintMessage>& messages) {
-    push_scope();  // Global scope
-
-    // Process imports
-    for (const auto& import : module->imports) {
-        if (import && import->kind == frontend::NodeKind::Import) {
-            auto* imp = static_cast<const frontend::Import*>(import.get());
-            imports_.insert(imp->module_path);
-        }
+uint64_t Linter::config_hash() const {
+    // Rule overrides, in a stable order
+    std::vector<std::string> parts;
+    for (const auto& [rule, severity] : config_.rule_severities) {
+        parts.push_back(rule + "=" + std::to_string(static_cast<int>(severity)));
     }
-
-    // Process functions
-    for (const auto& decl : module->declarations) {
-        if (decl && decl->kind == frontend::NodeKind::FuncDecl) {
-            auto* func = static_cast<const frontend::FuncDecl*>(decl.get());
-
-            FuncInfo info;
-            info.name = func->name;
-            info.decl_line = func->line;
-            info.is_public = !func->is_private;
-            info.is_called = (func->name == "main");  // main is always "called"
-            functions_[func->name] = info;
-
-            // Check function naming
-            check_naming_conventions(func->name, "function", func->line, 1, messages);
-        }
+    for (const auto& rule : config_.disabled_rules) {
+        parts.push_back("-" + rule);
     }
+    std::sort(parts.begin(), parts.end());
+    std::string key = std::to_string(kVersion);
+    for (const auto& part : parts) key += "\n" + part;
+    return tools::hash_bytes(key);
+}
 
-    // Visit function bodies
-    for (const auto& decl : module->declarations) {
-        if (decl && decl->kind == frontend::NodeKind::FuncDecl) {
-            auto* func = static_cast<const frontend::FuncDecl*>(decl.get());
-            visit_function(func, messages);
+// Cache layout, after a "mana-lint <config hash>" header line:
+//   file <path> <content hash>
+//   import <content hash> <path>
+//   msg <rule> <severity> <line> <column> <span> <message> <suggestion> <help>
+//   fix <line> <column> <end line> <end column> <replacement>   (of the msg above)
+// with fields separated by tabs.
+void Linter::load_cache() {
+    std::ifstream in(config_.cache_file);
+    std::string line;
+    std::ostringstream header;
+    header << "mana-lint " << std::hex << config_hash();
+    if (!in || !std::getline(in, line) || line != header.str()) return;
+
+    CachedFile* current = nullptr;
+    while (std::getline(in, line)) {
+        auto fields = split_fields(line);
+        if (fields[0] == "file" && fields.size() == 3) {
+            current = &cache_[fields[1]];
+            current->hash = std::strtoull(fields[2].c_str(), nullptr, 16);
+        } else if (current && fields[0] == "import" && fields.size() == 3) {
+            current->imports.emplace_back(fields[2], std::strtoull(fields[1].c_str(), nullptr, 16));
+        } else if (current && fields[0] == "msg" && fields.size() == 9) {
+            LintMessage msg;
+            msg.rule_id = fields[1];
+            msg.severity = static_cast<LintSeverity>(std::atoi(fields[2].c_str()));
+            msg.line = std::atoi(fields[3].c_str());
+            msg.column = std::atoi(fields[4].c_str());
+            msg.span_length = std::atoi(fields[5].c_str());
+            msg.message = fields[6];
+            msg.suggestion = fields[7];
+            msg.help = fields[8];
+            current->messages.push_back(std::move(msg));
+        } else if (current && !current->messages.empty() && fields[0] == "fix" && fields.size() == 6) {
+            LintFix fix;
+            fix.line = std::atoi(fields[1].c_str());
+            fix.column = std::atoi(fields[2].c_str());
+            fix.end_line = std::atoi(fields[3].c_str());
+            fix.end_column = std::atoi(fields[4].c_str());
+            fix.replacement = fields[5];
+            current->messages.back().fixes.push_back(std::move(fix));
         }
     }
-
-    // Check unused variables in global scope
-    check_unused_variables(messages);
-    pop_scope();
 }
 
-void Linter::visit_function(const frontend::FuncDecl* func, std::vector<LintMessage>& messages) {
-    push_scope();
-
-    in_loop_ = false;
-    after_return_ = false;
-    current_complexity_ = 1;
-
-    // Declare parameters
-    for (const auto& param : func->params) {
-        if (param.name.empty()) continue;
-
-        // Check parameter naming
-        check_naming_conventions(param.name, "parameter", func->line, 1, messages);
-
-        // Check for shadowing
-        check_shadowing(param.name, func->line, 1, messages);
-
-        declare_var(param.name, param.type, func->line, 1, true, false);
+void Linter::save_cache(const std::vector<std::pair<std::string, CachedFile>>& results) const {
+    // Files linted earlier but not in this run stay cached while they exist
+    std::unordered_map<std::string, const CachedFile*> entries;
+    for (const auto& [key, entry] : cache_) {
+        std::error_code ec;
+        if (fs::exists(key, ec)) entries[key] = &entry;
     }
-
-    // Check for too many parameters
-    if (func->params.size() > 5 && is_rule_enabled("too_many_parameters")) {
-        emit("too_many_parameters",
-             "Function '" + func->name + "' has " + std::to_string(func->params.size()) +
-             " parameters (consider using a struct)",
-             func->line, 1, static_cast<int>(func->name.length()),
-             "", "Functions with many parameters are harder to use correctly",
-             messages);
+    for (const auto& [key, entry] : results) {
+        if (!key.empty()) entries[key] = &entry;
     }
 
-    // Visit body
-    if (func->body) {
-        auto* block = static_cast<const frontend::BlockStmt*>(func->body.get());
-        for (const auto& stmt : block->statements) {
-            visit_statement(stmt.get(), messages);
+    std::ostringstream out;
+    out << "mana-lint " << std::hex << config_hash() << "\n";
+    for (const auto& [key, entry] : entries) {
+        out << "file\t" << escape_field(key) << "\t" << entry->hash << "\n";
+        for (const auto& [dep, hash] : entry->imports) {
+            out << "import\t" << hash << "\t" << escape_field(dep) << "\n";
         }
-
-        // Check for empty function body
-        if (block->statements.empty()) {
-            check_empty_block(block, "function body", func->line, messages);
+        for (const auto& msg : entry->messages) {
+            out << std::dec << "msg\t" << escape_field(msg.rule_id) << "\t" << static_cast<int>(msg.severity)
+                << "\t" << msg.line << "\t" << msg.column << "\t" << msg.span_length
+                << "\t" << escape_field(msg.message) << "\t" << escape_field(msg.suggestion)
+                << "\t" << escape_field(msg.help) << "\n";
+            for (const auto& fix : msg.fixes) {
+                out << "fix\t" << fix.line << "\t" << fix.column << "\t" << fix.end_line << "\t" << fix.end_column
+                    << "\t" << escape_field(fix.replacement) << "\n";
+            }
+            out << std::hex;
         }
     }
-
-    // Check cyclomatic complexity
-    check_complexity(func, messages);
-
-    // Check unused variables
-    check_unused_variables(messages);
-
-    pop_scope();
+    tools::write_file_atomic(config_.cache_file, out.str());
 }
 
-void Linter::visit_statement(const frontend::AstNode* stmt, std::vector<LintMessage>& messages) {
-    if (!stmt) return;
-
-    // Check for unreachable code
-    if (after_return_ && is_rule_enabled("unreachable_code")) {
-        emit("unreachable_code", "Unreachable code after return/break/continue",
-             stmt->line, 1, 1, "Remove this code or the preceding control flow statement", "",
-             messages);
-    }
-
-    switch (stmt->kind) {
-    case frontend::NodeKind::VarDeclStmt: {
-        auto* var = static_cast<const frontend::VarDeclStmt*>(stmt);
-
-        // Check naming
-        check_naming_conventions(var->name, var->is_const ? "constant" : "variable",
-                                stmt->line, 1, messages);
-
-        // Check shadowing
-        check_shadowing(var->name, stmt->line, 1, messages);
-
-        declare_var(var->name, var->type_name, stmt->line, 1, false, false);
-
-        if (var->initializer) {
-            visit_expression(var->initializer.get(), messages);
+int Linter::apply_fixes(std::vector<LintMessage>& messages) {
+    std::map<std::string, std::vector<size_t>> by_file;
+    for (size_t i = 0; i < messages.size(); i++) {
+        if (!messages[i].fixes.empty()) by_file[messages[i].file].push_back(i);
+    }
+
+    std::vector<char> fixed(messages.size(), 0);
+    int count = 0;
+    for (const auto& [file, indices] : by_file) {
+        std::string source;
+        if (!read_file(file, source)) continue;
+        auto line_starts = compute_line_starts(source);
+
+        struct Edit {
+            size_t begin;
+            size_t end;
+            const std::string* text;
+        };
+        auto overlaps = [](const Edit& a, const Edit& b) {
+            return a.begin == b.begin || (a.begin < b.end && b.begin < a.end);
+        };
+        std::vector<Edit> accepted;
+        for (size_t i : indices) {
+            std::vector<Edit> edits;
+            bool ok = true;
+            for (const auto& fix : messages[i].fixes) {
+                size_t begin = offset_at(line_starts, source.size(), fix.line, fix.column);
+                size_t end = offset_at(line_starts, source.size(), fix.end_line, fix.end_column);
+                if (begin == std::string::npos || end == std::string::npos || end < begin) ok = false;
+                for (const auto& other : accepted) {
+                    if (ok && overlaps(Edit{begin, end, nullptr}, other)) ok = false;
+                }
+                edits.push_back({begin, end, &fix.replacement});
+            }
+            if (!ok) continue;  // Reported again on the next run
+            accepted.insert(accepted.end(), edits.begin(), edits.end());
+            fixed[i] = 1;
+            count++;
         }
-        break;
-    }
-
-    case frontend::NodeKind::AssignStmt: {
-        auto* assign = static_cast<const frontend::AssignStmt*>(stmt);
-        mark_var_written(assign->target);
+        if (accepted.empty()) continue;
 
-        // Check for assignment as condition (unlikely here but check anyway)
-        if (assign->value) {
-            visit_expression(assign->value.get(), messages);
+        std::sort(accepted.begin(), accepted.end(), [](const Edit& a, const Edit& b) { return a.begin > b.begin; });
+        for (const auto& edit : accepted) {
+            source.replace(edit.begin, edit.end - edit.begin, *edit.text);
         }
-        break;
-    }
-
-    case frontend::NodeKind::ExprStmt: {
-        auto* expr = static_cast<const frontend::ExprStmt*>(stmt);
-        if (expr->expr) {
-            visit_expression(expr->expr.get(), messages);
+        std::ofstream out(file, std::ios::binary);
+        if (!out || !(out << source)) {
+            std::cerr << "error: cannot write " << file << "\n";
+            for (size_t i : indices) fixed[i] = 0;
         }
-        break;
     }
 
-    case frontend::NodeKind::BlockStmt: {
-        auto* block = static_cast<const frontend::BlockStmt*>(stmt);
-        push_scope();
-        for (const auto& s : block->statements) {
-            visit_statement(s.get(), messages);
+    std::vector<LintMessage> remaining;
+    warning_count_ = 0;
+    error_count_ = 0;
+    for (size_t i = 0; i < messages.size(); i++) {
+        if (fixed[i]) continue;
+        if (messages[i].severity == LintSeverity::Warn) {
+            warning_count_++;
+        } else if (messages[i].severity == LintSeverity::Deny || messages[i].severity == LintSeverity::Forbid) {
+            error_count_++;
         }
-        check_unused_variables(messages);
-        pop_scope();
-        break;
+        remaining.push_back(std::move(messages[i]));
     }
+    messages = std::move(remaining);
+    return static_cast<int>(std::count(fixed.begin(), fixed.end(), 1));
+}
 
-    case frontend::NodeKind::IfStmt: {
-        auto* if_stmt = static_cast<const frontend::IfStmt*>(stmt);
-        current_complexity_++;  // Branching increases complexity
+// ---------------- semantic checks ----------------
 
-        // Check condition for assignment
-        if (if_stmt->condition) {
-            check_assignment_in_condition(if_stmt->condition.get(), messages);
-            visit_expression(if_stmt->condition.get(), messages);
+void Linter::check_symbols(const LintInput& input, Walk& walk) const {
+    // Functions the test and bench harnesses call
+    std::unordered_set<std::string> harness_entries;
+    for (const auto& decl : input.module->decls) {
+        if (auto fn = dynamic_cast<const AstFuncDecl*>(decl.get())) {
+            if (fn->is_test || fn->is_bench) harness_entries.insert(fn->name);
         }
+    }
 
-        bool then_returns = false;
-        bool else_returns = false;
+    const auto& symbols = input.semantic.symbols;
+    for (const auto& sym : symbols) {
+        int span = static_cast<int>(sym.name.size());
+        bool silenced = !sym.name.empty() && sym.name[0] == '_';
 
-        if (if_stmt->then_branch) {
-            bool saved_after_return = after_return_;
-            after_return_ = false;
-            visit_statement(if_stmt->then_branch.get(), messages);
-            then_returns = after_return_;
-            after_return_ = saved_after_return;
+        switch (sym.kind) {
+        case SemanticKind::Function:
+            check_naming_conventions(sym.name, "function", sym.line, sym.column, walk);
+            if (sym.reads == 0 && !sym.is_public && sym.name != "main" && !harness_entries.count(sym.name) &&
+                is_rule_enabled("unused_function")) {
+                emit(walk, "unused_function", "Private function '" + sym.name + "' is never called",
+                     sym.line, sym.column, span, "Remove this function or call it");
+            }
+            break;
 
-            // Check for empty then block
-            if (if_stmt->then_branch->kind == frontend::NodeKind::BlockStmt) {
-                auto* block = static_cast<const frontend::BlockStmt*>(if_stmt->then_branch.get());
-                check_empty_block(block, "if body", stmt->line, messages);
+        case SemanticKind::Parameter:
+            check_naming_conventions(sym.name, "parameter", sym.line, sym.column, walk);
+            if (sym.reads == 0 && !silenced && is_rule_enabled("unused_parameter")) {
+                emit(walk, "unused_parameter", "Parameter '" + sym.name + "' is never used",
+                     sym.line, sym.column, span, "Prefix with underscore to silence: _" + sym.name);
             }
-        }
+            break;
 
-        if (if_stmt->else_branch) {
-            bool saved_after_return = after_return_;
-            after_return_ = false;
-            visit_statement(if_stmt->else_branch.get(), messages);
-            else_returns = after_return_;
-            after_return_ = saved_after_return;
+        default:
+            check_naming_conventions(sym.name, sym.is_mutable ? "variable" : "constant", sym.line, sym.column, walk);
+            if (sym.reads == 0 && !sym.is_global && !silenced && is_rule_enabled("unused_variable")) {
+                emit(walk, "unused_variable",
+                     sym.writes > 0 ? "Variable '" + sym.name + "' is assigned but never read"
+                                    : "Variable '" + sym.name + "' is declared but never used",
+                     sym.line, sym.column, span, "Remove this variable or use it");
+            }
+            break;
         }
 
-        // Both branches return means code after this is unreachable
-        after_return_ = then_returns && else_returns;
-        break;
-    }
-
-    case frontend::NodeKind::WhileStmt: {
-        auto* while_stmt = static_cast<const frontend::WhileStmt*>(stmt);
-        current_complexity_++;  // Loop increases complexity
-
-        // Check condition
-        if (while_stmt->condition) {
-            check_assignment_in_condition(while_stmt->condition.get(), messages);
-            visit_expression(while_stmt->condition.get(), messages);
+        if (sym.shadows >= 0 && is_rule_enabled("shadowed_variable")) {
+            const auto& outer = symbols[sym.shadows];
+            emit(walk, "shadowed_variable",
+                 "Variable '" + sym.name + "' shadows a variable in outer scope (line " +
+                 std::to_string(outer.line) + ")",
+                 sym.line, sym.column, span, "Use a different name to avoid confusion");
         }
+    }
+}
 
-        bool saved_in_loop = in_loop_;
-        in_loop_ = true;
-
-        if (while_stmt->body) {
-            visit_statement(while_stmt->body.get(), messages);
+void Linter::check_unused_imports(const LintInput& input, Walk& walk) const {
+    if (!is_rule_enabled("unused_import")) return;
 
-            // Check for empty loop body
-            if (while_stmt->body->kind == frontend::NodeKind::BlockStmt) {
-                auto* block = static_cast<const frontend::BlockStmt*>(while_stmt->body.get());
-                check_empty_block(block, "while body", stmt->line, messages);
-            }
+    std::unordered_set<std::string> identifiers;
+    for (const auto& token : input.tokens) {
+        if (token.kind == TokenKind::Identifier) identifiers.insert(token.lexeme);
+    }
+    for (const auto& import : input.imports) {
+        if (import.names.empty()) continue;
+        bool used = std::any_of(import.names.begin(), import.names.end(),
+                                [&](const std::string& name) { return identifiers.count(name) > 0; });
+        if (!used) {
+            emit(walk, "unused_import", "Import '" + import.path + "' is never used",
+                 import.line, import.column, static_cast<int>(import.path.size()) + 2, "Remove this import");
         }
-
-        in_loop_ = saved_in_loop;
-        break;
     }
+}
 
-    case frontend::NodeKind::ForStmt: {
-        auto* for_stmt = static_cast<const frontend::ForStmt*>(stmt);
-        current_complexity_++;
+// ---------------- structural checks ----------------
 
-        push_scope();
+void Linter::visit_function(const AstFuncDecl* func, Walk& walk) const {
+    walk.complexity = 1;
+    walk.depth = 0;
+    walk.reported_nesting = false;
+    walk.local_types.clear();
+    walk.local_decls.clear();
+    walk.reserved.clear();
+    walk.lookups.clear();
+    for (const auto& param : func->params) {
+        walk.local_types[param.name] = param.type_name;
+    }
+    check_large_params(func, walk);
 
-        if (for_stmt->init) {
-            visit_statement(for_stmt->init.get(), messages);
-        }
-        if (for_stmt->condition) {
-            visit_expression(for_stmt->condition.get(), messages);
-        }
-        if (for_stmt->update) {
-            visit_statement(for_stmt->update.get(), messages);
-        }
+    if (func->params.size() > kMaxParameters && is_rule_enabled("too_many_parameters")) {
+        emit(walk, "too_many_parameters",
+             "Function '" + func->name + "' has " + std::to_string(func->params.size()) +
+             " parameters (consider using a struct)",
+             func->line, func->column, static_cast<int>(func->name.length()),
+             "", "Functions with many parameters are harder to use correctly");
+    }
 
-        bool saved_in_loop = in_loop_;
-        in_loop_ = true;
+    if (!func->body) return;  // extern fn
+    visit_statement(func->body.get(), walk);
+    check_empty_block(func->body.get(), "function body", func->line, func->column, walk);
 
-        if (for_stmt->body) {
-            visit_statement(for_stmt->body.get(), messages);
+    const auto& statements = func->body->statements;
+    if ((func->return_type.empty() || func->return_type == "void") && !statements.empty() &&
+        is_rule_enabled("redundant_return")) {
+        auto ret = dynamic_cast<const AstReturnStmt*>(statements.back().get());
+        if (ret && !ret->value) {
+            emit(walk, "redundant_return", "Unnecessary return at the end of a void function",
+                 ret->line, ret->column, 6, "Remove this return");
         }
-
-        in_loop_ = saved_in_loop;
-        check_unused_variables(messages);
-        pop_scope();
-        break;
     }
 
-    case frontend::NodeKind::ReturnStmt: {
-        auto* ret = static_cast<const frontend::ReturnStmt*>(stmt);
-        if (ret->value) {
-            visit_expression(ret->value.get(), messages);
-        }
-        after_return_ = true;
-        break;
+    if (walk.complexity > kMaxComplexity && is_rule_enabled("high_complexity")) {
+        emit(walk, "high_complexity",
+             "Function '" + func->name + "' has cyclomatic complexity of " +
+             std::to_string(walk.complexity) + " (max: " + std::to_string(kMaxComplexity) + ")",
+             func->line, func->column, static_cast<int>(func->name.length()),
+             "Consider breaking this function into smaller pieces");
     }
+}
 
-    case frontend::NodeKind::BreakStmt:
-        if (!in_loop_ && is_rule_enabled("break_outside_loop")) {
-            emit("break_outside_loop", "Break statement outside of loop",
-                 stmt->line, 1, 5, "Remove this break or move it inside a loop", "",
-                 messages);
+void Linter::visit_statement(const AstStmt* stmt, Walk& walk) const {
+    if (!stmt) return;
+
+    // Body of a branch or loop: one level deeper
+    auto nested = [&](const AstStmt* body) {
+        if (!body) return;
+        walk.depth++;
+        if (walk.depth > kMaxNesting && !walk.reported_nesting && is_rule_enabled("deep_nesting")) {
+            walk.reported_nesting = true;
+            emit(walk, "deep_nesting",
+                 "Code is nested " + std::to_string(walk.depth) + " levels deep (max: " +
+                 std::to_string(kMaxNesting) + ")",
+                 body->line, body->column, 1, "Extract the inner code into a function or return early");
         }
-        after_return_ = true;  // Unreachable after break (within loop)
-        break;
-
-    case frontend::NodeKind::ContinueStmt:
-        if (!in_loop_ && is_rule_enabled("continue_outside_loop")) {
-            emit("continue_outside_loop", "Continue statement outside of loop",
-                 stmt->line, 1, 8, "Remove this continue or move it inside a loop", "",
-                 messages);
+        visit_statement(body, walk);
+        walk.depth--;
+    };
+
+    // Body of a loop, which the performance rules look inside
+    auto loop_body = [&](const AstStmt* body) {
+        walk.loops.push_back(stmt);
+        nested(body);
+        walk.loops.pop_back();
+    };
+
+    if (auto block = dynamic_cast<const AstBlockStmt*>(stmt)) {
+        bool terminated = false;
+        bool reported = false;
+        for (const auto& s : block->statements) {
+            if (terminated && !reported && is_rule_enabled("unreachable_code")) {
+                reported = true;
+                emit(walk, "unreachable_code", "Unreachable code after return/break/continue",
+                     s->line, s->column, 1, "Remove this code or the preceding control flow statement");
+            }
+            visit_statement(s.get(), walk);
+            terminated |= dynamic_cast<const AstReturnStmt*>(s.get()) != nullptr ||
+                          dynamic_cast<const AstBreakStmt*>(s.get()) != nullptr ||
+                          dynamic_cast<const AstContinueStmt*>(s.get()) != nullptr;
         }
-        after_return_ = true;  // Unreachable after continue (within loop)
-        break;
-
-    case frontend::NodeKind::DeferStmt: {
-        auto* defer = static_cast<const frontend::DeferStmt*>(stmt);
-        if (defer->body) {
-            visit_statement(defer->body.get(), messages);
+    } else if (auto var = dynamic_cast<const AstVarDeclStmt*>(stmt)) {
+        visit_expression(var->init_expr.get(), walk);
+        walk.local_types[var->name] = var->type_name;  // Inferred by the analyzer
+        walk.local_decls[var->name] = var;
+    } else if (auto assign = dynamic_cast<const AstAssignStmt*>(stmt)) {
+        if (!walk.loops.empty()) check_string_concat(assign, walk);
+        visit_expression(assign->target_expr.get(), walk);
+        visit_expression(assign->value.get(), walk);
+    } else if (auto expr = dynamic_cast<const AstExprStmt*>(stmt)) {
+        visit_expression(expr->expr.get(), walk);
+    } else if (auto if_stmt = dynamic_cast<const AstIfStmt*>(stmt)) {
+        walk.complexity++;
+        visit_expression(if_stmt->condition.get(), walk);
+        nested(if_stmt->then_block.get());
+        check_empty_block(if_stmt->then_block.get(), "if body", stmt->line, stmt->column, walk);
+        // `else if` chains stay at the same depth
+        if (dynamic_cast<const AstIfStmt*>(if_stmt->else_block.get())) {
+            visit_statement(if_stmt->else_block.get(), walk);
+        } else {
+            nested(if_stmt->else_block.get());
         }
-        break;
+    } else if (auto while_stmt = dynamic_cast<const AstWhileStmt*>(stmt)) {
+        walk.complexity++;
+        visit_expression(while_stmt->condition.get(), walk);
+        loop_body(while_stmt->body.get());
+        check_empty_block(while_stmt->body.get(), "while body", stmt->line, stmt->column, walk);
+    } else if (auto for_stmt = dynamic_cast<const AstForStmt*>(stmt)) {
+        walk.complexity++;
+        visit_statement(for_stmt->init.get(), walk);
+        visit_expression(for_stmt->condition.get(), walk);
+        visit_statement(for_stmt->increment.get(), walk);
+        loop_body(for_stmt->body.get());
+        check_empty_block(for_stmt->body.get(), "for body", stmt->line, stmt->column, walk);
+    } else if (auto for_in = dynamic_cast<const AstForInStmt*>(stmt)) {
+        walk.complexity++;
+        visit_expression(for_in->iterable.get(), walk);
+        check_push_reserve(for_in, walk);
+        check_loop_copy(for_in, walk);
+        loop_body(for_in->body.get());
+        check_empty_block(for_in->body.get(), "for body", stmt->line, stmt->column, walk);
+    } else if (auto loop = dynamic_cast<const AstLoopStmt*>(stmt)) {
+        walk.complexity++;
+        loop_body(loop->body.get());
+        check_empty_block(loop->body.get(), "loop body", stmt->line, stmt->column, walk);
+    } else if (auto ret = dynamic_cast<const AstReturnStmt*>(stmt)) {
+        visit_expression(ret->value.get(), walk);
+    } else if (auto brk = dynamic_cast<const AstBreakStmt*>(stmt)) {
+        visit_expression(brk->value.get(), walk);
+    } else if (auto defer = dynamic_cast<const AstDeferStmt*>(stmt)) {
+        visit_statement(defer->body.get(), walk);
+    } else if (auto scope = dynamic_cast<const AstScopeStmt*>(stmt)) {
+        visit_expression(scope->init_expr.get(), walk);
+        visit_statement(scope->body.get(), walk);
+    } else if (auto destructure = dynamic_cast<const AstDestructureStmt*>(stmt)) {
+        visit_expression(destructure->init_expr.get(), walk);
     }
+}
 
-    case frontend::NodeKind::MatchStmt: {
-        auto* match = static_cast<const frontend::MatchStmt*>(stmt);
-        if (match->value) {
-            visit_expression(match->value.get(), messages);
-        }
+void Linter::visit_expression(const AstNode* node, Walk& walk) const {
+    if (!node) return;
+
+    if (auto bin = dynamic_cast<const AstBinaryExpr*>(node)) {
+        if (bin->op == "&&" || bin->op == "||") walk.complexity++;
+        visit_expression(bin->left.get(), walk);
+        visit_expression(bin->right.get(), walk);
+    } else if (auto un = dynamic_cast<const AstUnaryExpr*>(node)) {
+        visit_expression(un->right.get(), walk);
+    } else if (auto call = dynamic_cast<const AstCallExpr*>(node)) {
+        if (!walk.loops.empty()) check_regex_in_loop(call, walk);
+        for (const auto& arg : call->args) visit_expression(arg.get(), walk);
+    } else if (auto mc = dynamic_cast<const AstMethodCallExpr*>(node)) {
+        check_map_lookup(mc, walk);
+        auto object = dynamic_cast<const AstIdentifierExpr*>(mc->object.get());
+        if (object && mc->method_name == "reserve") walk.reserved.insert(object->name);
+        visit_expression(mc->object.get(), walk);
+        for (const auto& arg : mc->args) visit_expression(arg.get(), walk);
+    } else if (auto ma = dynamic_cast<const AstMemberAccessExpr*>(node)) {
+        visit_expression(ma->object.get(), walk);
+    } else if (auto idx = dynamic_cast<const AstIndexExpr*>(node)) {
+        visit_expression(idx->base.get(), walk);
+        visit_expression(idx->index.get(), walk);
+    } else if (auto arr = dynamic_cast<const AstArrayLiteralExpr*>(node)) {
+        for (const auto& element : arr->elements) visit_expression(element.get(), walk);
+    } else if (auto lit = dynamic_cast<const AstStructLiteralExpr*>(node)) {
+        for (const auto& field : lit->fields) visit_expression(field.value.get(), walk);
+    } else if (auto match = dynamic_cast<const AstMatchExpr*>(node)) {
+        visit_expression(match->value.get(), walk);
+        // Each arm past the first is another path
+        if (!match->arms.empty()) walk.complexity += static_cast<int>(match->arms.size()) - 1;
         for (const auto& arm : match->arms) {
-            current_complexity_++;  // Each match arm increases complexity
-            if (arm.body) {
-                visit_statement(arm.body.get(), messages);
+            visit_expression(arm.guard.get(), walk);
+            visit_expression(arm.result.get(), walk);
+            if (arm.result_block) {
+                walk.depth++;
+                visit_statement(arm.result_block.get(), walk);
+                walk.depth--;
             }
         }
-        break;
-    }
-
-    default:
-        break;
+    } else if (auto closure = dynamic_cast<const AstClosureExpr*>(node)) {
+        visit_expression(closure->body_expr.get(), walk);
+        visit_statement(closure->body_block.get(), walk);
+    } else if (auto if_expr = dynamic_cast<const AstIfExpr*>(node)) {
+        walk.complexity++;
+        visit_expression(if_expr->condition.get(), walk);
+        visit_expression(if_expr->then_expr.get(), walk);
+        visit_expression(if_expr->else_expr.get(), walk);
+    } else if (auto cast = dynamic_cast<const AstCastExpr*>(node)) {
+        visit_expression(cast->operand.get(), walk);
+    } else if (auto tuple = dynamic_cast<const AstTupleExpr*>(node)) {
+        for (const auto& element : tuple->elements) visit_expression(element.get(), walk);
+    } else if (auto try_expr = dynamic_cast<const AstTryExpr*>(node)) {
+        visit_expression(try_expr->operand.get(), walk);
+    } else if (auto await = dynamic_cast<const AstAwaitExpr*>(node)) {
+        visit_expression(await->operand.get(), walk);
+    } else if (auto range = dynamic_cast<const AstRangeExpr*>(node)) {
+        visit_expression(range->start.get(), walk);
+        visit_expression(range->end.get(), walk);
+    } else if (auto coalesce = dynamic_cast<const AstNullCoalesceExpr*>(node)) {
+        walk.complexity++;
+        visit_expression(coalesce->option_expr.get(), walk);
+        visit_expression(coalesce->default_expr.get(), walk);
+    } else if (auto or_expr = dynamic_cast<const AstOrExpr*>(node)) {
+        walk.complexity++;
+        visit_expression(or_expr->lhs.get(), walk);
+        visit_expression(or_expr->default_expr.get(), walk);
+        visit_statement(or_expr->fallback_stmt.get(), walk);
+        visit_statement(or_expr->fallback_block.get(), walk);
     }
 }
 
-void Linter::visit_expression(const frontend::AstNode* expr, std::vector<LintMessage>& messages) {
-    if (!expr) return;
-
-    switch (expr->kind) {
-    case frontend::NodeKind::Identifier: {
-        auto* id = static_cast<const frontend::AstIdentifierExpr*>(expr);
-        mark_var_read(id->name);
+void Linter::check_empty_block(const AstStmt* body, const std::string& context,
+                               int line, int col, Walk& walk) const {
+    if (!is_rule_enabled("empty_block")) return;
 
-        // Check if this is using an imported module
-        auto dot_pos = id->name.find('.');
-        if (dot_pos != std::string::npos) {
-            std::string module = id->name.substr(0, dot_pos);
-            used_imports_.insert(module);
-        }
-        break;
+    auto block = dynamic_cast<const AstBlockStmt*>(body);
+    if (block && block->statements.empty()) {
+        emit(walk, "empty_block", "Empty " + context, line, col, 1,
+             "Add code or a comment explaining why this is empty");
     }
+}
 
-    case frontend::NodeKind::CallExpr: {
-        auto* call = static_cast<const frontend::AstCallExpr*>(expr);
+// ---------------- performance checks ----------------
 
-        // Mark function as called
-        auto it = functions_.find(call->func_name);
-        if (it != functions_.end()) {
-            it->second.is_called = true;
-        }
+void Linter::check_string_concat(const AstAssignStmt* assign, Walk& walk) const {
+    if (!is_rule_enabled("string_concat_in_loop") || assign->is_complex_target()) return;
+    const std::string& name = assign->target_name;
+    auto type = walk.local_types.find(name);
+    if (type == walk.local_types.end() || !is_string_type(type->second)) return;
 
-        // Check for imported function usage
-        auto dot_pos = call->func_name.find('.');
-        if (dot_pos != std::string::npos) {
-            std::string module = call->func_name.substr(0, dot_pos);
-            used_imports_.insert(module);
-        }
+    // A string declared inside the loop starts over on every iteration
+    const AstStmt* outer_loop = walk.loops.front();
+    auto decl = walk.local_decls.find(name);
+    if (decl != walk.local_decls.end() &&
+        (decl->second->line > outer_loop->line ||
+         (decl->second->line == outer_loop->line && decl->second->column > outer_loop->column))) {
+        return;
+    }
 
-        // Visit arguments
-        for (const auto& arg : call->args) {
-            visit_expression(arg.get(), messages);
+    // a + b + c parses as ((a + b) + c)
+    std::vector<const AstNode*> parts;
+    const AstNode* node = assign->value.get();
+    while (auto bin = dynamic_cast<const AstBinaryExpr*>(node)) {
+        if (bin->op != "+") break;
+        parts.push_back(bin->right.get());
+        node = bin->left.get();
+    }
+    if (parts.empty()) return;
+    parts.push_back(node);
+    std::reverse(parts.begin(), parts.end());
+
+    auto is_target = [&](const AstNode* n) {
+        auto id = dynamic_cast<const AstIdentifierExpr*>(n);
+        return id && id->name == name;
+    };
+    int span = static_cast<int>(name.size());
+
+    if (!is_target(parts[0])) {
+        if (std::any_of(parts.begin() + 1, parts.end(), is_target)) {
+            emit(walk, "string_concat_in_loop",
+                 "Prepending to string '" + name + "' copies all of it on every iteration",
+                 assign->line, assign->column, span, "",
+                 "Append in place and reverse once after the loop, or collect the parts in a Vec<string>");
         }
-        break;
+        return;
     }
+    // `s += x` and `s = s + x` append in place
+    if (parts.size() == 2) return;
 
-    case frontend::NodeKind::BinaryExpr: {
-        auto* bin = static_cast<const frontend::AstBinaryExpr*>(expr);
-        current_complexity_++;  // && and || increase complexity
+    LintMessage& msg = emit(walk, "string_concat_in_loop",
+        "Each '+' builds a new copy of string '" + name + "' on every iteration",
+        assign->line, assign->column, span, "Append the parts one at a time: " + name + " += ...");
 
-        if (bin->left) {
-            visit_expression(bin->left.get(), messages);
-        }
-        if (bin->right) {
-            visit_expression(bin->right.get(), messages);
-        }
-        break;
+    // Fix: s = s + a + b  ->  s += a; s += b
+    const auto& tokens = walk.input->tokens;
+    std::string_view source = walk.input->source;
+    size_t first = find_token(tokens, assign->line, assign->column);
+    if (first + 3 >= tokens.size() || tokens[first].lexeme != name || tokens[first + 1].kind != TokenKind::Assign ||
+        tokens[first + 2].lexeme != name || tokens[first + 3].kind != TokenKind::Plus) {
+        return;
     }
-
-    case frontend::NodeKind::UnaryExpr: {
-        auto* unary = static_cast<const frontend::AstUnaryExpr*>(expr);
-        if (unary->operand) {
-            visit_expression(unary->operand.get(), messages);
+    bool semicolon = false;
+    size_t last = statement_end(tokens, first, semicolon);
+    std::vector<size_t> pluses;
+    int depth = 0;
+    for (size_t i = first + 2; i <= last; i++) {
+        const Token& t = tokens[i];
+        if (is_opening(t.kind)) depth++;
+        else if (is_closing(t.kind)) depth--;
+        else if (depth == 0 && t.kind == TokenKind::Plus) pluses.push_back(i);
+        // A later part reading the string would see the partial result
+        if (i > first + 3 && t.kind == TokenKind::Identifier && t.lexeme == name && tokens[i - 1].kind != TokenKind::Dot) {
+            return;
         }
-        break;
     }
+    if (pluses.size() != parts.size() - 1) return;
+
+    std::string separator = (semicolon ? ";\n" : "\n") + line_indent(source, walk.line_starts, tokens[first].line);
+    std::string replacement;
+    for (size_t k = 0; k < pluses.size(); k++) {
+        const Token& begin = tokens[pluses[k] + 1];
+        const Token& end = k + 1 < pluses.size() ? tokens[pluses[k + 1] - 1] : tokens[last];
+        size_t from = offset_at(walk.line_starts, source.size(), begin.line, begin.column);
+        size_t to = token_end(source, walk.line_starts, end);
+        if (from == std::string::npos || to < from) return;
+        if (k > 0) replacement += separator;
+        replacement += name + " += " + std::string(source.substr(from, to - from));
+    }
+    size_t begin = offset_at(walk.line_starts, source.size(), tokens[first].line, tokens[first].column);
+    size_t end = token_end(source, walk.line_starts, tokens[last]);
+    msg.fixes.push_back(make_fix(walk.line_starts, begin, end, replacement));
+}
 
-    case frontend::NodeKind::MemberExpr: {
-        auto* member = static_cast<const frontend::AstMemberExpr*>(expr);
-        if (member->object) {
-            visit_expression(member->object.get(), messages);
-        }
-        break;
+void Linter::check_push_reserve(const AstForInStmt* loop, Walk& walk) const {
+    // Only outermost loops: a reserve inside an outer loop would run on every pass
+    if (!is_rule_enabled("vec_push_without_reserve") || !walk.loops.empty() || loop->is_destructure) return;
+    auto body = dynamic_cast<const AstBlockStmt*>(loop->body.get());
+    if (!body) return;
+
+    const auto& tokens = walk.input->tokens;
+    std::string_view source = walk.input->source;
+    size_t loop_token = find_token(tokens, loop->line, loop->column);
+    size_t body_token = find_token(tokens, body->line, body->column);
+    if (loop_token >= body_token || body_token >= tokens.size()) return;
+
+    // Iteration count, as source text
+    std::string count;
+    std::string iterable;
+    if (auto range = dynamic_cast<const AstRangeExpr*>(loop->iterable.get())) {
+        auto start = dynamic_cast<const AstLiteralExpr*>(range->start.get());
+        if (!start || start->value != "0" || !range->end) return;
+        size_t dots = loop_token;
+        while (dots < body_token && tokens[dots].kind != TokenKind::DotDot && tokens[dots].kind != TokenKind::DotDotEqual) dots++;
+        if (dots + 1 >= body_token) return;
+        size_t from = offset_at(walk.line_starts, source.size(), tokens[dots + 1].line, tokens[dots + 1].column);
+        size_t to = token_end(source, walk.line_starts, tokens[body_token - 1]);
+        if (from == std::string::npos || to <= from) return;
+        count = std::string(source.substr(from, to - from));
+        if (range->inclusive) count += " + 1";
+    } else if (auto id = dynamic_cast<const AstIdentifierExpr*>(loop->iterable.get())) {
+        auto type = walk.local_types.find(id->name);
+        if (type == walk.local_types.end() || vec_element(type->second).empty()) return;
+        iterable = id->name;
+        count = id->name + ".len()";
+    } else {
+        return;
     }
 
-    case frontend::NodeKind::IndexExpr: {
-        auto* index = static_cast<const frontend::AstIndexExpr*>(expr);
-        if (index->array) {
-            visit_expression(index->array.get(), messages);
-        }
-        if (index->index) {
-            visit_expression(index->index.get(), messages);
+    std::unordered_set<std::string> declared_inside;
+    for (const auto& stmt : body->statements) {
+        if (auto var = dynamic_cast<const AstVarDeclStmt*>(stmt.get())) declared_inside.insert(var->name);
+        auto expr = dynamic_cast<const AstExprStmt*>(stmt.get());
+        auto call = expr ? dynamic_cast<const AstMethodCallExpr*>(expr->expr.get()) : nullptr;
+        auto target = call ? dynamic_cast<const AstIdentifierExpr*>(call->object.get()) : nullptr;
+        if (!target || call->method_name != "push") continue;
+
+        const std::string& name = target->name;
+        if (declared_inside.count(name) || walk.reserved.count(name) || name == iterable || name == loop->var_name) continue;
+        auto type = walk.local_types.find(name);
+        if (type == walk.local_types.end() || vec_element(type->second).empty()) continue;
+        walk.reserved.insert(name);  // Report each vector once
+
+        // A vector that may already hold elements grows by the count
+        std::string amount = name + ".len() + " + count;
+        auto decl = walk.local_decls.find(name);
+        if (decl != walk.local_decls.end()) {
+            auto init = dynamic_cast<const AstArrayLiteralExpr*>(decl->second->init_expr.get());
+            auto ctor = dynamic_cast<const AstCallExpr*>(decl->second->init_expr.get());
+            bool empty = (init && init->elements.empty() && !init->is_fill()) || (ctor && ctor->func_name == "Vec::new");
+            size_t binding = find_token(tokens, decl->second->line, decl->second->column);
+            while (binding < loop_token && tokens[binding].lexeme != name) binding++;
+            bool untouched = true;
+            for (size_t i = binding + 1; i < loop_token; i++) {
+                if (tokens[i].kind == TokenKind::Identifier && tokens[i].lexeme == name) untouched = false;
+            }
+            if (empty && untouched) amount = count;
         }
-        break;
-    }
 
-    case frontend::NodeKind::ArrayExpr: {
-        auto* arr = static_cast<const frontend::AstArrayExpr*>(expr);
-        for (const auto& elem : arr->elements) {
-            visit_expression(elem.get(), messages);
-        }
-        break;
-    }
+        std::string reserve = name + ".reserve(" + amount + ")";
+        LintMessage& msg = emit(walk, "vec_push_without_reserve",
+            "'" + name + "' grows one push at a time in a loop that runs a known number of times",
+            call->line, call->column, static_cast<int>(name.size()), "Reserve before the loop: " + reserve);
 
-    case frontend::NodeKind::CastExpr: {
-        auto* cast = static_cast<const frontend::AstCastExpr*>(expr);
-        if (cast->expr) {
-            visit_expression(cast->expr.get(), messages);
-        }
-        break;
+        bool semicolon = false;
+        statement_end(tokens, find_token(tokens, stmt->line, stmt->column), semicolon);
+        size_t at = offset_at(walk.line_starts, source.size(), tokens[loop_token].line, tokens[loop_token].column);
+        if (at == std::string::npos) continue;
+        msg.fixes.push_back(make_fix(walk.line_starts, at, at,
+            reserve + (semicolon ? ";\n" : "\n") + line_indent(source, walk.line_starts, tokens[loop_token].line)));
     }
+}
 
-    case frontend::NodeKind::TernaryExpr: {
-        auto* tern = static_cast<const frontend::AstTernaryExpr*>(expr);
-        current_complexity_++;
+void Linter::check_loop_copy(const AstForInStmt* loop, Walk& walk) const {
+    if (!is_rule_enabled("loop_variable_copy") || loop->is_destructure) return;
+    auto vec = dynamic_cast<const AstIdentifierExpr*>(loop->iterable.get());
+    if (!vec) return;
+    auto type = walk.local_types.find(vec->name);
+    if (type == walk.local_types.end()) return;
+    std::string element = vec_element(type->second);
+    if (element.empty()) return;
+    TypeCost cost = type_cost(element, walk.structs);
+    if (!cost.owns_heap && cost.bytes <= 16) return;
+
+    // Where the body uses the variable. Assigning to it or taking its address
+    // relies on the copy, so such loops are left alone; method calls and
+    // indexing might mutate it, so those are reported without a fix.
+    const auto& tokens = walk.input->tokens;
+    const std::string& var = loop->var_name;
+    size_t for_token = find_token(tokens, loop->line, loop->column);
+    size_t open = find_token(tokens, loop->body->line, loop->body->column);
+    if (open >= tokens.size() || tokens[open].kind != TokenKind::LBrace) return;
+    size_t close = matching_token(tokens, open);
+    bool fixable = true;
+    std::vector<size_t> uses;
+    for (size_t i = open + 1; i < close; i++) {
+        const Token& t = tokens[i];
+        if (t.kind == TokenKind::Or || (t.kind == TokenKind::Identifier && t.lexeme == vec->name)) {
+            fixable = false;  // Closure or the vector itself used in the body
+        }
+        if (t.kind != TokenKind::Identifier || t.lexeme != var || tokens[i - 1].kind == TokenKind::Dot) continue;
 
-        if (tern->condition) {
-            visit_expression(tern->condition.get(), messages);
+        TokenKind before = tokens[i - 1].kind;
+        if (before == TokenKind::KwLet || before == TokenKind::KwMut || before == TokenKind::KwFor ||
+            before == TokenKind::And) {
+            return;
         }
-        if (tern->then_expr) {
-            visit_expression(tern->then_expr.get(), messages);
+        size_t after = i + 1;
+        while (after + 1 < close && tokens[after].kind == TokenKind::Dot && tokens[after + 1].kind == TokenKind::Identifier) {
+            after += 2;
         }
-        if (tern->else_expr) {
-            visit_expression(tern->else_expr.get(), messages);
+        TokenKind next = after < close ? tokens[after].kind : TokenKind::RBrace;
+        switch (next) {
+        case TokenKind::Assign: case TokenKind::PlusEqual: case TokenKind::MinusEqual: case TokenKind::StarEqual:
+        case TokenKind::SlashEqual: case TokenKind::PercentEqual: case TokenKind::StarStarEqual:
+        case TokenKind::AndEqual: case TokenKind::OrEqual: case TokenKind::CaretEqual:
+        case TokenKind::LessLessEqual: case TokenKind::GreaterGreaterEqual:
+        case TokenKind::PlusPlus: case TokenKind::MinusMinus:
+            return;
+        case TokenKind::LParen: case TokenKind::LBracket:
+            fixable = false;
+            break;
+        default:
+            break;
         }
-        break;
+        uses.push_back(i);
+    }
+
+    std::string index = fresh_name(tokens, "idx");
+    LintMessage& msg = emit(walk, "loop_variable_copy",
+        "Loop variable '" + var + "' copies each " + element + " out of '" + vec->name + "'",
+        loop->line, loop->column, 3,
+        "Index the vector instead: for " + index + " in 0.." + vec->name + ".len() { ... " + vec->name + "[" + index + "] ... }");
+    if (!fixable || for_token + 3 >= open || tokens[for_token + 1].lexeme != var ||
+        tokens[for_token + 2].kind != TokenKind::KwIn || tokens[for_token + 3].lexeme != vec->name) {
+        return;
     }
 
-    default:
-        break;
+    std::string_view source = walk.input->source;
+    auto replace_token_range = [&](const Token& from, const Token& to, const std::string& text) {
+        size_t begin = offset_at(walk.line_starts, source.size(), from.line, from.column);
+        size_t end = token_end(source, walk.line_starts, to);
+        msg.fixes.push_back(make_fix(walk.line_starts, begin, end, text));
+    };
+    replace_token_range(tokens[for_token + 1], tokens[for_token + 3], index + " in 0.." + vec->name + ".len()");
+    for (size_t i : uses) {
+        replace_token_range(tokens[i], tokens[i], vec->name + "[" + index + "]");
     }
 }
 
-void Linter::check_unused_variables(std::vector<LintMessage>& messages) {
-    if (scopes_.empty()) return;
-
-    const auto& scope = scopes_.back();
-    for (const auto& [name, var] : scope) {
-        if (!var.is_read) {
-            if (var.is_parameter) {
-                if (is_rule_enabled("unused_parameter")) {
-                    emit("unused_parameter",
-                         "Parameter '" + name + "' is never used",
-                         var.decl_line, var.decl_column, static_cast<int>(name.length()),
-                         "Prefix with underscore to silence: _" + name, "",
-                         messages);
-                }
-            } else if (!var.is_loop_var) {
-                if (is_rule_enabled("unused_variable")) {
-                    emit("unused_variable",
-                         "Variable '" + name + "' is declared but never used",
-                         var.decl_line, var.decl_column, static_cast<int>(name.length()),
-                         "Remove this variable or use it", "",
-                         messages);
-                }
-            }
+void Linter::check_regex_in_loop(const AstCallExpr* call, Walk& walk) const {
+    if (!is_rule_enabled("regex_in_loop")) return;
+    const std::string& name = call->func_name;
+    bool constructs = name == "Regex::new" || name == "regex::Regex::new" || name == "regex::new" || name == "regex";
+    if (!constructs && name.rfind("regex::", 0) != 0) return;
+
+    auto is_literal = [](const std::unique_ptr<AstNode>& arg) {
+        auto lit = dynamic_cast<const AstLiteralExpr*>(arg.get());
+        return lit && lit->is_string;
+    };
+    bool literal_pattern = !call->args.empty() && is_literal(call->args[0]);
+    int span = static_cast<int>(name.size());
+
+    if (!constructs) {
+        // regex::is_match(pattern, text) and friends compile the pattern per call
+        if (literal_pattern) {
+            emit(walk, "regex_in_loop", "'" + name + "' compiles its pattern again on every iteration",
+                 call->line, call->column, span, "",
+                 "Build the regex once before the loop with Regex::new and call its methods");
         }
+        return;
     }
-}
 
-void Linter::check_unused_functions(std::vector<LintMessage>& messages) {
-    if (!is_rule_enabled("unused_function")) return;
+    LintMessage& msg = emit(walk, "regex_in_loop", "Regex compiled on every loop iteration",
+                            call->line, call->column, span, "Build it once before the loop");
+    if (!std::all_of(call->args.begin(), call->args.end(), is_literal)) return;
+
+    // Fix: hoist the constructor in front of the outermost loop
+    const auto& tokens = walk.input->tokens;
+    std::string_view source = walk.input->source;
+    size_t start = find_token(tokens, call->line, call->column);
+    size_t open = start;
+    while (open < tokens.size() && tokens[open].kind != TokenKind::LParen) open++;
+    size_t close = matching_token(tokens, open);
+    const AstStmt* outer = walk.loops.front();
+    size_t loop_token = find_token(tokens, outer->line, outer->column);
+    if (close >= tokens.size() || loop_token >= start) return;
+
+    size_t begin = offset_at(walk.line_starts, source.size(), tokens[start].line, tokens[start].column);
+    size_t end = token_end(source, walk.line_starts, tokens[close]);
+    size_t at = offset_at(walk.line_starts, source.size(), tokens[loop_token].line, tokens[loop_token].column);
+    if (begin == std::string::npos || at == std::string::npos) return;
+    std::string var = fresh_name(tokens, "re");
+    msg.fixes.push_back(make_fix(walk.line_starts, at, at,
+        "let " + var + " = " + std::string(source.substr(begin, end - begin)) + ";\n" +
+        line_indent(source, walk.line_starts, tokens[loop_token].line)));
+    msg.fixes.push_back(make_fix(walk.line_starts, begin, end, var));
+}
 
-    for (const auto& [name, func] : functions_) {
-        if (!func.is_called && !func.is_public) {
-            emit("unused_function",
-                 "Private function '" + name + "' is never called",
-                 func.decl_line, 1, static_cast<int>(name.length()),
-                 "Remove this function or call it", "",
-                 messages);
-        }
+void Linter::check_map_lookup(const AstMethodCallExpr* call, Walk& walk) const {
+    if (!is_rule_enabled("map_double_lookup") || call->args.empty()) return;
+    auto map = dynamic_cast<const AstIdentifierExpr*>(call->object.get());
+    if (!map) return;
+    std::string type = call->object_type;
+    if (type.empty()) {
+        auto local = walk.local_types.find(map->name);
+        if (local != walk.local_types.end()) type = local->second;
+    }
+    if (type.rfind("HashMap", 0) != 0) return;
+    std::string key = key_text(call->args[0].get());
+    if (key.empty()) return;
+
+    std::string entry = map->name + "\t" + key;
+    if (call->method_name == "get" || call->method_name == "contains") {
+        walk.lookups.emplace_back(entry, call);
+    } else if (call->method_name == "insert") {
+        auto it = std::find_if(walk.lookups.begin(), walk.lookups.end(),
+                               [&](const auto& lookup) { return lookup.first == entry; });
+        if (it == walk.lookups.end()) return;
+        emit(walk, "map_double_lookup",
+             "'" + map->name + "' is searched for " + key + " by " + it->second->method_name +
+             " (line " + std::to_string(it->second->line) + ") and again by insert",
+             call->line, call->column, static_cast<int>(map->name.size()), "",
+             "Index the map once: " + map->name + "[" + key + "] reads an entry in place and " +
+             map->name + "[" + key + "] = value updates it");
+        walk.lookups.erase(it);
     }
 }
 
-void Linter::check_unused_imports(std::vector<LintMessage>& messages) {
-    if (!is_rule_enabled("unused_import")) return;
+void Linter::check_large_params(const AstFuncDecl* func, Walk& walk) const {
+    if (!is_rule_enabled("large_struct_by_value")) return;
+    for (const auto& param : func->params) {
+        if (!walk.structs.count(param.type_name)) continue;  // Only user structs are passed by value
+        TypeCost cost = type_cost(param.type_name, walk.structs);
+        if (!cost.owns_heap && cost.bytes <= kMaxByValueBytes) continue;
 
-    for (const auto& import : imports_) {
-        if (used_imports_.find(import) == used_imports_.end()) {
-            emit("unused_import",
-                 "Import '" + import + "' is never used",
-                 1, 1, static_cast<int>(import.length()),
-                 "Remove this import", "",
-                 messages);
-        }
+        std::string what = cost.owns_heap ? param.type_name + " (with heap-allocated fields)"
+                                          : std::to_string(cost.bytes) + "-byte " + param.type_name;
+        emit(walk, "large_struct_by_value",
+             "Parameter '" + param.name + "' copies a " + what + " on every call",
+             param.line, param.column, static_cast<int>(param.name.size()),
+             "Take it by reference: " + param.name + ": &" + param.type_name);
     }
 }
 
 void Linter::check_naming_conventions(const std::string& name, const std::string& kind,
-                                       int line, int col, std::vector<LintMessage>& messages) {
+                                      int line, int col, Walk& walk) const {
     // Skip names starting with underscore (intentionally ignored)
-    if (!name.empty() && name[0] == '_') return;
+    if (name.empty() || name[0] == '_') return;
+    int span = static_cast<int>(name.length());
 
     if (kind == "variable" || kind == "parameter") {
         if (!is_snake_case(name) && is_rule_enabled("snake_case_variable")) {
-            emit("snake_case_variable",
-                 "Variable '" + name + "' should use snake_case",
-                 line, col, static_cast<int>(name.length()),
-                 "Rename to: " + to_snake_case(name), "",
-                 messages);
+            emit(walk, "snake_case_variable", "Variable '" + name + "' should use snake_case",
+                 line, col, span, "Rename to: " + to_snake_case(name));
         }
     } else if (kind == "function") {
         if (!is_snake_case(name) && is_rule_enabled("snake_case_function")) {
-            emit("snake_case_function",
-                 "Function '" + name + "' should use snake_case",
-                 line, col, static_cast<int>(name.length()),
-                 "Rename to: " + to_snake_case(name), "",
-                 messages);
+            emit(walk, "snake_case_function", "Function '" + name + "' should use snake_case",
+                 line, col, span, "Rename to: " + to_snake_case(name));
         }
     } else if (kind == "constant") {
         if (!is_upper_snake_case(name) && is_rule_enabled("upper_snake_case_constant")) {
-            emit("upper_snake_case_constant",
-                 "Constant '" + name + "' should use UPPER_SNAKE_CASE",
-                 line, col, static_cast<int>(name.length()),
-                 "", "",
-                 messages);
+            emit(walk, "upper_snake_case_constant", "Constant '" + name + "' should use UPPER_SNAKE_CASE",
+                 line, col, span);
         }
-    }
-}
-
-void Linter::check_complexity(const frontend::FuncDecl* func, std::vector<LintMessage>& messages) {
-    if (!is_rule_enabled("high_complexity")) return;
-
-    const int MAX_COMPLEXITY = 10;
-    if (current_complexity_ > MAX_COMPLEXITY) {
-        emit("high_complexity",
-             "Function '" + func->name + "' has cyclomatic complexity of " +
-             std::to_string(current_complexity_) + " (max: " + std::to_string(MAX_COMPLEXITY) + ")",
-             func->line, 1, static_cast<int>(func->name.length()),
-             "Consider breaking this function into smaller pieces", "",
-             messages);
-    }
-}
-
-void Linter::check_unreachable_code(const frontend::AstNode* stmt, std::vector<LintMessage>& messages) {
-    // Already handled in visit_statement
-}
-
-void Linter::check_shadowing(const std::string& name, int line, int col,
-                              std::vector<LintMessage>& messages) {
-    if (!is_rule_enabled("shadowed_variable")) return;
-
-    // Check if variable exists in outer scopes (skip the current scope)
-    for (size_t i = 0; i + 1 < scopes_.size(); ++i) {
-        auto it = scopes_[i].find(name);
-        if (it != scopes_[i].end()) {
-            emit("shadowed_variable",
-                 "Variable '" + name + "' shadows a variable in outer scope (line " +
-                 std::to_string(it->second.decl_line) + ")",
-                 line, col, static_cast<int>(name.length()),
-                 "Use a different name to avoid confusion", "",
-                 messages);
-            break;
+    } else if (kind == "type") {
+        if (!is_pascal_case(name) && is_rule_enabled("pascal_case_type")) {
+            emit(walk, "pascal_case_type", "Type '" + name + "' should use PascalCase",
+                 line, col, span);
         }
     }
 }
 
-void Linter::check_assignment_in_condition(const frontend::AstNode* cond,
-                                           std::vector<LintMessage>& messages) {
-    if (!cond || !is_rule_enabled("assignment_in_condition")) return;
-
-    // This is a simplified check - would need more sophisticated analysis
-    // to detect assignment expressions in conditions
-}
-
-void Linter::check_empty_block(const frontend::BlockStmt* block, const std::string& context,
-                               int line, std::vector<LintMessage>& messages) {
-    if (!is_rule_enabled("empty_block")) return;
-
-    if (block && block->statements.empty()) {
-        emit("empty_block",
-             "Empty " + context,
-             line, 1, 1,
-             "Add code or a comment explaining why this is empty", "",
-             messages);
-    }
-}
-
 LintSeverity Linter::get_severity(const std::string& rule_id) const {
     auto it = config_.rule_severities.find(rule_id);
     if (it != config_.rule_severities.end()) {
@@ -801,6 +1393,10 @@ bool Linter::is_rule_enabled(const std::string& rule_id) const {
     if (config_.disabled_rules.count(rule_id)) {
         return false;
     }
+    // Naming a rule on the command line turns it on
+    if (config_.rule_severities.count(rule_id)) {
+        return true;
+    }
 
     const LintRule* rule = get_rule(rule_id);
     if (rule) {
@@ -809,24 +1405,26 @@ bool Linter::is_rule_enabled(const std::string& rule_id) const {
     return true;
 }
 
-void Linter::emit(const std::string& rule_id, const std::string& message,
-                  int line, int col, int span,
-                  const std::string& suggestion, const std::string& help,
-                  std::vector<LintMessage>& messages) {
+LintMessage& Linter::emit(Walk& walk, const std::string& rule_id, const std::string& message,
+                          int line, int col, int span,
+                          const std::string& suggestion, const std::string& help) const {
     LintMessage msg;
     msg.rule_id = rule_id;
     msg.message = message;
-    msg.file = current_file_;
+    msg.file = walk.file;
     msg.line = line;
     msg.column = col;
     msg.span_length = span;
     msg.severity = get_severity(rule_id);
     msg.suggestion = suggestion;
     msg.help = help;
-    messages.push_back(msg);
+    walk.messages.push_back(msg);
+    return walk.messages.back();
 }
 
-bool Linter::is_snake_case(const std::string& name) const {
+// ---------------- naming ----------------
+
+bool Linter::is_snake_case(const std::string& name) {
     if (name.empty()) return true;
 
     for (size_t i = 0; i < name.length(); ++i) {
@@ -837,7 +1435,7 @@ bool Linter::is_snake_case(const std::string& name) const {
     return true;
 }
 
-bool Linter::is_upper_snake_case(const std::string& name) const {
+bool Linter::is_upper_snake_case(const std::string& name) {
     if (name.empty()) return true;
 
     for (char c : name) {
@@ -846,7 +1444,7 @@ bool Linter::is_upper_snake_case(const std::string& name) const {
     return true;
 }
 
-bool Linter::is_pascal_case(const std::string& name) const {
+bool Linter::is_pascal_case(const std::string& name) {
     if (name.empty()) return true;
     if (!std::isupper(name[0])) return false;
 
@@ -856,7 +1454,7 @@ bool Linter::is_pascal_case(const std::string& name) const {
     return true;
 }
 
-std::string Linter::to_snake_case(const std::string& name) const {
+std::string Linter::to_snake_case(const std::string& name) {
     if (name.empty()) return name;
 
     std::string result;
@@ -931,6 +1529,10 @@ void Linter::print_results(const std::vector<LintMessage>& messages, std::ostrea
                 << msg.help << "\n";
         }
 
+        if (!msg.fixes.empty()) {
+            out << color_green() << "   = fix: " << color_reset() << "available with --fix\n";
+        }
+
         out << "\n";
     }
 
@@ -951,41 +1553,51 @@ void Linter::print_results(const std::vector<LintMessage>& messages, std::ostrea
             out << color_yellow() << warns << " warning" << (warns > 1 ? "s" : "") << color_reset();
         }
         out << " generated\n";
+        long fixable = std::count_if(messages.begin(), messages.end(),
+                                     [](const LintMessage& msg) { return !msg.fixes.empty(); });
+        if (fixable > 0) {
+            out << color_dim() << fixable << " fixable with `mana lint --fix`" << color_reset() << "\n";
+        }
     } else {
         out << color_green() << color_bold() << "No lint issues found" << color_reset() << "\n";
     }
 }
 
 void Linter::print_json(const std::vector<LintMessage>& messages, std::ostream& out) {
-    out << "[\n";
-    bool first = true;
+    std::string text;
+    json::Writer w(text);
+    w.begin_array();
     for (const auto& msg : messages) {
-        if (!first) out << ",\n";
-        first = false;
-
-        out << "  {\n";
-        out << "    \"rule\": \"" << msg.rule_id << "\",\n";
-        out << "    \"severity\": \"";
-        switch (msg.severity) {
-            case LintSeverity::Allow: out << "allow"; break;
-            case LintSeverity::Warn: out << "warning"; break;
-            case LintSeverity::Deny: out << "error"; break;
-            case LintSeverity::Forbid: out << "error"; break;
-        }
-        out << "\",\n";
-        out << "    \"message\": \"" << msg.message << "\",\n";
-        out << "    \"file\": \"" << msg.file << "\",\n";
-        out << "    \"line\": " << msg.line << ",\n";
-        out << "    \"column\": " << msg.column;
-        if (!msg.suggestion.empty()) {
-            out << ",\n    \"suggestion\": \"" << msg.suggestion << "\"";
-        }
-        if (!msg.help.empty()) {
-            out << ",\n    \"help\": \"" << msg.help << "\"";
+        const char* severity = "error";
+        if (msg.severity == LintSeverity::Allow) severity = "allow";
+        else if (msg.severity == LintSeverity::Warn) severity = "warning";
+
+        w.begin_object()
+            .key("rule").value(msg.rule_id)
+            .key("severity").value(severity)
+            .key("message").value(msg.message)
+            .key("file").value(msg.file)
+            .key("line").value(msg.line)
+            .key("column").value(msg.column);
+        if (!msg.suggestion.empty()) w.key("suggestion").value(msg.suggestion);
+        if (!msg.help.empty()) w.key("help").value(msg.help);
+        if (!msg.fixes.empty()) {
+            w.key("fixes").begin_array();
+            for (const auto& fix : msg.fixes) {
+                w.begin_object()
+                    .key("line").value(fix.line)
+                    .key("column").value(fix.column)
+                    .key("end_line").value(fix.end_line)
+                    .key("end_column").value(fix.end_column)
+                    .key("replacement").value(fix.replacement)
+                    .end_object();
+            }
+            w.end_array();
         }
-        out << "\n  }";
+        w.end_object();
     }
-    out << "\n]\n";
+    w.end_array();
+    out << text << "\n";
 }
 
 void Linter::print_compact(const std::vector<LintMessage>& messages, std::ostream& out) {
@@ -1001,7 +1613,7 @@ void Linter::print_compact(const std::vector<LintMessage>& messages, std::ostrea
     }
 }
 
-// CLI entry point
+
 int run_lint(int argc, char* argv[]) {
     LintConfig config;
     std::vector<std::string> files;
@@ -1026,15 +1638,23 @@ int run_lint(int argc, char* argv[]) {
             config.output_format = "json";
         } else if (arg == "--compact") {
             config.output_format = "compact";
-        } else if (arg.substr(0, 2) == "-W") {
-            std::string rule = arg.substr(2);
-            config.rule_severities[rule] = LintSeverity::Warn;
-        } else if (arg.substr(0, 2) == "-D") {
-            std::string rule = arg.substr(2);
-            config.rule_severities[rule] = LintSeverity::Deny;
-        } else if (arg.substr(0, 2) == "-A") {
-            std::string rule = arg.substr(2);
-            config.disabled_rules.insert(rule);
+        } else if (arg == "-j" && i + 1 < argc) {
+            config.jobs = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--no-cache") {
+            config.use_cache = false;
+        } else if (arg == "--no-color") {
+            s_colors_enabled = false;
+        } else if (arg.size() > 2 && (arg[1] == 'W' || arg[1] == 'D' || arg[1] == 'A') && arg[0] == '-') {
+            // -Wperf, -Dunused_variable, -Astyle: a rule or a whole category
+            std::vector<std::string> rules = Linter::rules_in_category(arg.substr(2));
+            if (rules.empty()) rules.push_back(arg.substr(2));
+            for (const auto& rule : rules) {
+                if (arg[1] == 'A') {
+                    config.disabled_rules.insert(rule);
+                } else {
+                    config.rule_severities[rule] = arg[1] == 'W' ? LintSeverity::Warn : LintSeverity::Deny;
+                }
+            }
         } else if (arg[0] != '-') {
             files.push_back(arg);
         }
@@ -1043,21 +1663,27 @@ int run_lint(int argc, char* argv[]) {
     if (show_help) {
         std::cout << "mana lint - Mana code linter\n\n";
         std::cout << "USAGE:\n";
-        std::cout << "    mana lint [OPTIONS] <FILES>...\n\n";
+        std::cout << "    mana lint [OPTIONS] <FILES|DIRS>...\n\n";
         std::cout << "OPTIONS:\n";
         std::cout << "    -h, --help     Show this help message\n";
         std::cout << "    --rules        List all available lint rules\n";
         std::cout << "    -q, --quiet    Only show errors, not warnings\n";
         std::cout << "    -v, --verbose  Show more details\n";
-        std::cout << "    --fix          Auto-fix issues when possible\n";
+        std::cout << "    --fix          Apply the available fixes, rewriting files in place\n";
         std::cout << "    --json         Output in JSON format\n";
         std::cout << "    --compact      Output in compact format\n";
+        std::cout << "    -j <n>         Lint on n workers (0 = one per core)\n";
+        std::cout << "    --no-cache     Re-analyze every file (ignore .mana_cache/lint)\n";
+        std::cout << "    --no-color     Disable colored output\n";
         std::cout << "    -W<rule>       Set rule severity to warning\n";
         std::cout << "    -D<rule>       Set rule severity to error\n";
-        std::cout << "    -A<rule>       Allow (disable) a rule\n\n";
+        std::cout << "    -A<rule>       Allow (disable) a rule\n";
+        std::cout << "                   <rule> may also be a category: style, unused,\n";
+        std::cout << "                   correctness, perf, complexity\n\n";
         std::cout << "EXAMPLES:\n";
         std::cout << "    mana lint src/*.mana\n";
         std::cout << "    mana lint -Dunused_variable -Aempty_block main.mana\n";
+        std::cout << "    mana lint -Dperf --fix src/\n";
         std::cout << "    mana lint --json src/ > lint_report.json\n";
         return 0;
     }
@@ -1084,6 +1710,9 @@ int run_lint(int argc, char* argv[]) {
             }
 
             std::cout << rule.description;
+            if (rule.fixable) {
+                std::cout << color_green() << " (fixable)" << color_reset();
+            }
             if (!rule.enabled) {
                 std::cout << color_dim() << " (disabled by default)" << color_reset();
             }
@@ -1101,7 +1730,15 @@ int run_lint(int argc, char* argv[]) {
 
     Linter linter(config);
     auto messages = linter.lint_files(files);
+    int fixed = config.fix ? linter.apply_fixes(messages) : 0;
     linter.print_results(messages, std::cout);
+    if (fixed > 0) {
+        std::cerr << "Fixed " << fixed << " issue" << (fixed > 1 ? "s" : "") << "\n";
+    }
+    if (config.verbose && linter.cached_count() > 0) {
+        std::cerr << linter.cached_count() << " file" << (linter.cached_count() > 1 ? "s" : "")
+                  << " unchanged since the last run (cached)\n";
+    }
 
     // Return error code if there were any errors
     return linter.error_count() > 0 ? 1 : 0;
@@ -1,12 +1,19 @@
 #pragma once
 
+#include <cstdint>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
-#include <memory>
-#include "../frontend/AstModule.h"
-#include "../frontend/Diagnostic.h"
+#include "../../frontend/AstModule.h"
+#include "../../frontend/AstDeclarations.h"
+#include "../../frontend/AstStatements.h"
+#include "../../frontend/AstExpressions.h"
+#include "../../frontend/Diagnostic.h"
+#include "../../frontend/SemanticInfo.h"
+#include "../../frontend/Token.h"
 
 namespace mana::lint {
 
@@ -37,6 +44,16 @@ struct LintRule {
     LintCategory category;
     LintSeverity default_severity;
     bool enabled = true;
+    bool fixable = false;        // Messages may carry an auto-fix
+};
+
+// Text edit of an auto-fix; 1-based positions, the end is exclusive
+struct LintFix {
+    int line = 0;
+    int column = 0;
+    int end_line = 0;
+    int end_column = 0;
+    std::string replacement;
 };
 
 // Lint warning/error
@@ -47,59 +64,71 @@ struct LintMessage {
     int line = 0;
     int column = 0;
     int span_length = 1;
-    LintSeverity severity;
+    LintSeverity severity = LintSeverity::Warn;
     std::string suggestion;      // Optional fix suggestion
     std::string help;            // Optional help text
+    std::vector<LintFix> fixes;  // Applied together by --fix
 };
 
 // Linter configuration
 struct LintConfig {
     std::unordered_map<std::string, LintSeverity> rule_severities;
     std::unordered_set<std::string> disabled_rules;
-    std::unordered_set<LintCategory> enabled_categories;
     bool fix = false;            // Auto-fix issues when possible
     bool quiet = false;          // Only show errors
     bool verbose = false;        // Show more details
     std::string output_format = "pretty";  // pretty, json, compact
+    int jobs = 0;                // Files linted in parallel; 0 = one per hardware thread
+    bool use_cache = true;
+    std::string cache_file = ".mana_cache/lint";  // Results of unchanged files
 };
 
-// Variable usage tracking
-struct VarUsage {
-    std::string name;
-    std::string type;
-    int decl_line = 0;
-    int decl_column = 0;
-    bool is_read = false;
-    bool is_written = false;
-    bool is_parameter = false;
-    bool is_loop_var = false;
+// One `import "file"` of the linted file
+struct ImportedFile {
+    std::string path;
+    int line = 0;
+    int column = 0;
+    std::vector<std::string> names;  // Top-level declarations it brought in
 };
 
-// Function tracking
-struct FuncInfo {
-    std::string name;
-    int decl_line = 0;
-    bool is_called = false;
-    bool is_public = true;
-    bool has_return = false;
-    int complexity = 1;          // Cyclomatic complexity
+// What lint_module reads about one analyzed file
+struct LintInput {
+    const frontend::AstModule* module = nullptr;  // Imported declarations spliced in
+    frontend::SemanticInfo semantic;              // Recorded by SemanticAnalyzer
+    std::vector<frontend::Token> tokens;          // The file's own tokens
+    std::string_view source;                      // The file's text; fixes are located in it
+    std::vector<ImportedFile> imports;
 };
 
-// Main linter class
+// Main linter class. Name resolution and use counts come from the semantic
+// analyzer (SemanticInfo::symbols); the linter itself only walks the tree
+// for structural rules such as complexity and nesting.
 class Linter {
 public:
     Linter(const LintConfig& config = LintConfig());
 
-    // Lint a single file
+    // Bump when a rule starts reporting differently, so cached results are dropped
+    static constexpr int kVersion = 2;
+
+    // Lint a single file (its file imports are loaded so names resolve)
     std::vector<LintMessage> lint_file(const std::string& file);
-    std::vector<LintMessage> lint_module(const frontend::AstModule* module, const std::string& file);
+    std::vector<LintMessage> lint_module(const LintInput& input, const std::string& file) const;
 
-    // Lint multiple files
-    std::vector<LintMessage> lint_files(const std::vector<std::string>& files);
+    // Lint files and directories on a worker pool. A file whose content and
+    // imported files are unchanged since the cached run is not re-analyzed.
+    std::vector<LintMessage> lint_files(const std::vector<std::string>& paths);
 
     // Get available rules
     static std::vector<LintRule> get_all_rules();
     static const LintRule* get_rule(const std::string& id);
+    // Rule ids in a category named on the command line (style, unused,
+    // correctness, perf, complexity); empty if `name` is not a category
+    static std::vector<std::string> rules_in_category(const std::string& name);
+
+    // Rewrites the files of messages that carry fixes. A message whose edits
+    // overlap an earlier one is left for the next run. Fixed messages are
+    // removed from `messages`; returns how many were fixed.
+    int apply_fixes(std::vector<LintMessage>& messages);
 
     // Output results
     void print_results(const std::vector<LintMessage>& messages, std::ostream& out);
@@ -109,65 +138,61 @@ public:
     // Statistics
     int warning_count() const { return warning_count_; }
     int error_count() const { return error_count_; }
+    int cached_count() const { return cached_count_; }
 
 private:
     LintConfig config_;
     int warning_count_ = 0;
     int error_count_ = 0;
-
-    // Variable and function tracking
-    std::vector<std::unordered_map<std::string, VarUsage>> scopes_;
-    std::unordered_map<std::string, FuncInfo> functions_;
-    std::unordered_set<std::string> imports_;
-    std::unordered_set<std::string> used_imports_;
-
-    // Current context
-    std::string current_file_;
-    bool in_loop_ = false;
-    bool after_return_ = false;
-    int current_complexity_ = 1;
-
-    // Scope management
-    void push_scope();
-    void pop_scope();
-    void declare_var(const std::string& name, const std::string& type, int line, int col,
-                    bool is_param = false, bool is_loop_var = false);
-    void mark_var_read(const std::string& name);
-    void mark_var_written(const std::string& name);
-    VarUsage* find_var(const std::string& name);
-
-    // AST visitors
-    void visit_module(const frontend::AstModule* module, std::vector<LintMessage>& messages);
-    void visit_function(const frontend::FuncDecl* func, std::vector<LintMessage>& messages);
-    void visit_statement(const frontend::AstNode* stmt, std::vector<LintMessage>& messages);
-    void visit_expression(const frontend::AstNode* expr, std::vector<LintMessage>& messages);
-
-    // Individual lint checks
-    void check_unused_variables(std::vector<LintMessage>& messages);
-    void check_unused_functions(std::vector<LintMessage>& messages);
-    void check_unused_imports(std::vector<LintMessage>& messages);
+    int cached_count_ = 0;
+
+    // Per-file results from earlier runs, keyed by path
+    struct CachedFile {
+        uint64_t hash = 0;
+        std::vector<std::pair<std::string, uint64_t>> imports;  // Imported file -> content hash
+        std::vector<LintMessage> messages;
+    };
+    std::unordered_map<std::string, CachedFile> cache_;
+
+    CachedFile lint_source(const std::string& file, const std::string& source) const;
+    uint64_t config_hash() const;
+    void load_cache();
+    void save_cache(const std::vector<std::pair<std::string, CachedFile>>& results) const;
+
+    // Structural and performance checks over one module; state lives in the
+    // walk, so a Linter can lint several files at once
+    struct Walk;
+    void visit_function(const frontend::AstFuncDecl* func, Walk& walk) const;
+    void visit_statement(const frontend::AstStmt* stmt, Walk& walk) const;
+    void visit_expression(const frontend::AstNode* expr, Walk& walk) const;
+    void check_empty_block(const frontend::AstStmt* body, const std::string& context,
+                           int line, int col, Walk& walk) const;
+
+    // Performance rules
+    void check_string_concat(const frontend::AstAssignStmt* assign, Walk& walk) const;
+    void check_push_reserve(const frontend::AstForInStmt* loop, Walk& walk) const;
+    void check_loop_copy(const frontend::AstForInStmt* loop, Walk& walk) const;
+    void check_regex_in_loop(const frontend::AstCallExpr* call, Walk& walk) const;
+    void check_map_lookup(const frontend::AstMethodCallExpr* call, Walk& walk) const;
+    void check_large_params(const frontend::AstFuncDecl* func, Walk& walk) const;
+
+    void check_symbols(const LintInput& input, Walk& walk) const;
+    void check_unused_imports(const LintInput& input, Walk& walk) const;
     void check_naming_conventions(const std::string& name, const std::string& kind,
-                                  int line, int col, std::vector<LintMessage>& messages);
-    void check_complexity(const frontend::FuncDecl* func, std::vector<LintMessage>& messages);
-    void check_unreachable_code(const frontend::AstNode* stmt, std::vector<LintMessage>& messages);
-    void check_shadowing(const std::string& name, int line, int col, std::vector<LintMessage>& messages);
-    void check_assignment_in_condition(const frontend::AstNode* cond, std::vector<LintMessage>& messages);
-    void check_empty_block(const frontend::BlockStmt* block, const std::string& context,
-                          int line, std::vector<LintMessage>& messages);
+                                  int line, int col, Walk& walk) const;
 
     // Helpers
     LintSeverity get_severity(const std::string& rule_id) const;
     bool is_rule_enabled(const std::string& rule_id) const;
-    void emit(const std::string& rule_id, const std::string& message,
-             int line, int col, int span = 1,
-             const std::string& suggestion = "", const std::string& help = "",
-             std::vector<LintMessage>& messages);
+    LintMessage& emit(Walk& walk, const std::string& rule_id, const std::string& message,
+                      int line, int col, int span = 1,
+                      const std::string& suggestion = "", const std::string& help = "") const;
 
     // Name validation
-    bool is_snake_case(const std::string& name) const;
-    bool is_upper_snake_case(const std::string& name) const;
-    bool is_pascal_case(const std::string& name) const;
-    std::string to_snake_case(const std::string& name) const;
+    static bool is_snake_case(const std::string& name);
+    static bool is_upper_snake_case(const std::string& name);
+    static bool is_pascal_case(const std::string& name);
+    static std::string to_snake_case(const std::string& name);
 };
 
 // CLI interface
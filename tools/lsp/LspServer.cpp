@@ -1,25 +1,32 @@
 #include "LspServer.h"
+#include "../fmt/Formatter.h"
 #include <regex>
+#include <cstdlib>
+#include <cstdint>
 #include <algorithm>
 
 namespace mana::lsp {
 
 LspServer::LspServer() {}
 
+LspServer::~LspServer() {
+    stop_analysis();
+}
+
 void LspServer::run() {
+    analysis_thread_ = std::thread(&LspServer::analysis_loop, this);
     while (running_) {
-        std::string msg = read_message();
-        if (!msg.empty()) {
-            handle_message(msg);
+        if (read_message(buffer_)) {
+            handle_message(buffer_);
         }
     }
+    stop_analysis();
 }
 
-std::string LspServer::read_message() {
+bool LspServer::read_message(std::string& out) {
     // Read headers until empty line
-    std::string headers;
     std::string line;
-    int content_length = 0;
+    size_t content_length = 0;
 
     while (std::getline(std::cin, line)) {
         // Remove \r if present
@@ -28,45 +35,43 @@ std::string LspServer::read_message() {
         }
         if (line.empty()) break;
 
-        if (line.find("Content-Length:") == 0) {
-            content_length = std::stoi(line.substr(15));
+        if (line.rfind("Content-Length:", 0) == 0) {
+            content_length = static_cast<size_t>(std::strtoull(line.c_str() + 15, nullptr, 10));
         }
     }
+    if (!std::cin) {
+        running_ = false;
+        return false;
+    }
+    if (content_length == 0) return false;
 
-    if (content_length == 0) return "";
-
-    // Read content
-    std::string content(content_length, '\0');
-    std::cin.read(&content[0], content_length);
-    return content;
+    // Read content into the reused buffer
+    out.resize(content_length);
+    std::cin.read(&out[0], static_cast<std::streamsize>(content_length));
+    return static_cast<size_t>(std::cin.gcount()) == content_length;
 }
 
 void LspServer::write_message(const std::string& content) {
+    std::lock_guard<std::mutex> lock(output_mutex_);
     std::cout << "Content-Length: " << content.size() << "\r\n\r\n" << content;
     std::cout.flush();
 }
 
-void LspServer::handle_message(const std::string& json) {
-    // Extract method and id
-    std::string method = extract_string(json, "method");
-    int id = extract_int(json, "id");
-
-    // Find params section
-    size_t params_pos = json.find("\"params\"");
-    std::string params = "{}";
-    if (params_pos != std::string::npos) {
-        size_t start = json.find('{', params_pos);
-        if (start != std::string::npos) {
-            int depth = 1;
-            size_t end = start + 1;
-            while (end < json.size() && depth > 0) {
-                if (json[end] == '{') depth++;
-                else if (json[end] == '}') depth--;
-                end++;
-            }
-            params = json.substr(start, end - start);
-        }
-    }
+json::Writer LspServer::begin_response(const json::Value& id) {
+    response_.clear();
+    json::Writer w(response_);
+    w.begin_object().key("jsonrpc").value("2.0").key("id").value(id).key("result");
+    return w;
+}
+
+void LspServer::handle_message(std::string& message) {
+    // Strings in the message are unescaped in place; params stay valid until the next read
+    if (!message_.parse(message)) return;
+    json::Value root = message_.root();
+
+    std::string_view method = root["method"].as_string();
+    json::Value id = root["id"];
+    json::Value params = root["params"];
 
     if (method == "initialize") {
         handle_initialize(id, params);
@@ -88,187 +93,505 @@ void LspServer::handle_message(const std::string& json) {
         handle_text_document_completion(id, params);
     } else if (method == "textDocument/definition") {
         handle_text_document_definition(id, params);
+    } else if (method == "textDocument/references") {
+        handle_text_document_references(id, params);
+    } else if (method == "workspace/symbol") {
+        handle_workspace_symbol(id, params);
+    } else if (method == "textDocument/semanticTokens/full") {
+        handle_semantic_tokens_full(id, params);
+    } else if (method == "textDocument/semanticTokens/full/delta") {
+        handle_semantic_tokens_delta(id, params);
+    } else if (method == "textDocument/inlayHint") {
+        handle_inlay_hint(id, params);
+    } else if (method == "textDocument/rangeFormatting") {
+        handle_range_formatting(id, params);
+    } else if (method == "textDocument/onTypeFormatting") {
+        handle_on_type_formatting(id, params);
     }
 }
 
-void LspServer::handle_initialize(int id, const std::string& params) {
-    std::string response = R"({
-        "jsonrpc": "2.0",
-        "id": )" + std::to_string(id) + R"(,
-        "result": {
-            "capabilities": {
-                "textDocumentSync": 1,
-                "hoverProvider": true,
-                "completionProvider": {
-                    "triggerCharacters": [".", ":", "<"]
-                },
-                "definitionProvider": true
-            },
-            "serverInfo": {
-                "name": "mana-lsp",
-                "version": "0.1.0"
-            }
-        }
-    })";
-    write_message(response);
+void LspServer::handle_initialize(const json::Value& id, const json::Value& params) {
+    json::Value delay = params["initializationOptions"]["analysisDelayMs"];
+    if (delay.is_number()) {
+        analysis_delay_ = std::chrono::milliseconds(std::max<int64_t>(0, delay.as_int()));
+    }
+
+    json::Value workspace = params["capabilities"]["workspace"];
+    semantic_refresh_ = workspace["semanticTokens"]["refreshSupport"].as_bool();
+    inlay_refresh_ = workspace["inlayHint"]["refreshSupport"].as_bool();
+
+    std::string root(params["rootUri"].as_string());
+    if (root.empty()) root.assign(params["workspaceFolders"].at(0)["uri"].as_string());
+    root = root.empty() ? std::string(params["rootPath"].as_string()) : uri_to_path(root);
+    if (!root.empty() && !index_thread_.joinable()) {
+        index_thread_ = std::thread([this, root]() {
+            index_.build(root, std::max(1u, std::thread::hardware_concurrency()));
+        });
+    }
+
+    json::Writer w = begin_response(id);
+    w.begin_object()
+        .key("capabilities").begin_object()
+            .key("textDocumentSync").begin_object()
+                .key("openClose").value(true)
+                .key("change").value(2)  // Incremental
+            .end_object()
+            .key("hoverProvider").value(true)
+            .key("completionProvider").begin_object()
+                .key("triggerCharacters").begin_array().value(".").value(":").value("<").end_array()
+            .end_object()
+            .key("definitionProvider").value(true)
+            .key("referencesProvider").value(true)
+            .key("workspaceSymbolProvider").value(true)
+            .key("semanticTokensProvider").begin_object()
+                .key("legend").begin_object()
+                    // Order matches frontend::SemanticKind and SemanticModifier
+                    .key("tokenTypes").begin_array()
+                        .value("variable").value("parameter").value("function").value("method").value("struct")
+                        .value("enum").value("enumMember").value("type").value("property").value("namespace")
+                    .end_array()
+                    .key("tokenModifiers").begin_array()
+                        .value("declaration").value("readonly").value("defaultLibrary")
+                    .end_array()
+                .end_object()
+                .key("full").begin_object().key("delta").value(true).end_object()
+            .end_object()
+            .key("inlayHintProvider").value(true)
+            .key("documentRangeFormattingProvider").value(true)
+            .key("documentOnTypeFormattingProvider").begin_object()
+                .key("firstTriggerCharacter").value("}")
+                .key("moreTriggerCharacter").begin_array().value(";").end_array()
+            .end_object()
+        .end_object()
+        .key("serverInfo").begin_object()
+            .key("name").value("mana-lsp")
+            .key("version").value("0.1.0")
+        .end_object()
+    .end_object();
+    w.end_object();
+    write_message(response_);
 }
 
 void LspServer::handle_initialized() {
     initialized_ = true;
 }
 
-void LspServer::handle_shutdown(int id) {
-    std::string response = R"({"jsonrpc": "2.0", "id": )" + std::to_string(id) + R"(, "result": null})";
-    write_message(response);
+void LspServer::handle_shutdown(const json::Value& id) {
+    if (index_thread_.joinable()) index_thread_.join();
+    index_.save();
+    begin_response(id).null().end_object();
+    write_message(response_);
 }
 
 void LspServer::handle_exit() {
     running_ = false;
 }
 
-void LspServer::handle_text_document_did_open(const std::string& params) {
-    // Extract URI and text from textDocument
-    size_t uri_pos = params.find("\"uri\"");
-    std::string uri = extract_string(params, "uri");
-
-    size_t text_pos = params.find("\"text\"");
-    if (text_pos != std::string::npos) {
-        size_t start = params.find('"', text_pos + 6) + 1;
-        size_t end = start;
-        while (end < params.size()) {
-            if (params[end] == '"' && params[end-1] != '\\') break;
-            end++;
-        }
-        std::string text = params.substr(start, end - start);
-        // Unescape
-        std::string unescaped;
-        for (size_t i = 0; i < text.size(); i++) {
-            if (text[i] == '\\' && i + 1 < text.size()) {
-                switch (text[i+1]) {
-                    case 'n': unescaped += '\n'; i++; break;
-                    case 't': unescaped += '\t'; i++; break;
-                    case 'r': unescaped += '\r'; i++; break;
-                    case '"': unescaped += '"'; i++; break;
-                    case '\\': unescaped += '\\'; i++; break;
-                    default: unescaped += text[i]; break;
-                }
-            } else {
-                unescaped += text[i];
-            }
-        }
-        documents_[uri] = unescaped;
-        analyze_document(uri);
+void LspServer::handle_text_document_did_open(const json::Value& params) {
+    json::Value doc = params["textDocument"];
+    std::string uri(doc["uri"].as_string());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // The text was unescaped in the message buffer; this is its only copy
+        OpenDocument& open = documents_[uri];
+        open.text.set_text(doc["text"].as_string());
+        open.text.version = static_cast<int>(doc["version"].as_int());
+        open.generation = ++last_generation_;
     }
+    schedule_analysis(uri, std::chrono::milliseconds(0));
 }
 
-void LspServer::handle_text_document_did_change(const std::string& params) {
-    std::string uri = extract_string(params, "uri");
+void LspServer::handle_text_document_did_change(const json::Value& params) {
+    json::Value doc = params["textDocument"];
+    std::string uri(doc["uri"].as_string());
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = documents_.find(uri);
+    if (it == documents_.end()) return;
 
-    // Find contentChanges array and extract text
-    size_t changes_pos = params.find("\"contentChanges\"");
-    if (changes_pos != std::string::npos) {
-        size_t text_pos = params.find("\"text\"", changes_pos);
-        if (text_pos != std::string::npos) {
-            size_t start = params.find('"', text_pos + 6) + 1;
-            size_t end = start;
-            while (end < params.size()) {
-                if (params[end] == '"' && params[end-1] != '\\') break;
-                end++;
-            }
-            std::string text = params.substr(start, end - start);
-            // Unescape
-            std::string unescaped;
-            for (size_t i = 0; i < text.size(); i++) {
-                if (text[i] == '\\' && i + 1 < text.size()) {
-                    switch (text[i+1]) {
-                        case 'n': unescaped += '\n'; i++; break;
-                        case 't': unescaped += '\t'; i++; break;
-                        case 'r': unescaped += '\r'; i++; break;
-                        case '"': unescaped += '"'; i++; break;
-                        case '\\': unescaped += '\\'; i++; break;
-                        default: unescaped += text[i]; break;
-                    }
-                } else {
-                    unescaped += text[i];
-                }
-            }
-            documents_[uri] = unescaped;
-            analyze_document(uri);
+    // Changes apply in order, each against the text left by the previous one.
+    // A change without a range replaces the whole document.
+    TextDocument& text = it->second.text;
+    for (json::Value change : params["contentChanges"]) {
+        json::Value range = change["range"];
+        if (!range.valid()) {
+            text.set_text(change["text"].as_string());
+            continue;
         }
+        json::Value start = range["start"];
+        json::Value end = range["end"];
+        size_t begin = text.offset_at(static_cast<int>(start["line"].as_int()), static_cast<int>(start["character"].as_int()));
+        size_t finish = text.offset_at(static_cast<int>(end["line"].as_int()), static_cast<int>(end["character"].as_int()));
+        text.replace(begin, finish, change["text"].as_string());
     }
+    text.version = static_cast<int>(doc["version"].as_int(text.version));
+    it->second.generation = ++last_generation_;
+    lock.unlock();
+    schedule_analysis(uri, analysis_delay_);
 }
 
-void LspServer::handle_text_document_did_close(const std::string& params) {
-    std::string uri = extract_string(params, "uri");
-    documents_.erase(uri);
-    parsed_modules_.erase(uri);
+void LspServer::handle_text_document_did_close(const json::Value& params) {
+    std::string uri(params["textDocument"]["uri"].as_string());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        documents_.erase(uri);
+        pending_.erase(uri);
+    }
+    sent_tokens_.erase(uri);
     // Clear diagnostics
+    std::lock_guard<std::mutex> publish(publish_mutex_);
     publish_diagnostics(uri, {});
 }
 
-void LspServer::handle_text_document_hover(int id, const std::string& params) {
-    std::string uri = extract_string(params, "uri");
-    int line = extract_int(params, "line");
-    int character = extract_int(params, "character");
+static Position position_of(const json::Value& params) {
+    json::Value pos = params["position"];
+    return { static_cast<int>(pos["line"].as_int(-1)), static_cast<int>(pos["character"].as_int(-1)) };
+}
+
+static void write_range(json::Writer& w, const Range& r) {
+    w.begin_object()
+        .key("start").begin_object().key("line").value(r.start.line).key("character").value(r.start.character).end_object()
+        .key("end").begin_object().key("line").value(r.end.line).key("character").value(r.end.character).end_object()
+    .end_object();
+}
 
-    std::string info = get_hover_info(uri, {line, character});
+void LspServer::handle_text_document_hover(const json::Value& id, const json::Value& params) {
+    std::string uri(params["textDocument"]["uri"].as_string());
+    std::string info = get_hover_info(uri, position_of(params));
 
-    std::string response;
+    json::Writer w = begin_response(id);
     if (info.empty()) {
-        response = R"({"jsonrpc": "2.0", "id": )" + std::to_string(id) + R"(, "result": null})";
+        w.null();
     } else {
-        response = R"({"jsonrpc": "2.0", "id": )" + std::to_string(id) + R"(, "result": {"contents": {"kind": "markdown", "value": ")" + info + R"("}}})";
+        w.begin_object()
+            .key("contents").begin_object().key("kind").value("markdown").key("value").value(info).end_object()
+        .end_object();
+    }
+    w.end_object();
+    write_message(response_);
+}
+
+void LspServer::handle_text_document_completion(const json::Value& id, const json::Value& params) {
+    std::string uri(params["textDocument"]["uri"].as_string());
+    auto items = get_completions(uri, position_of(params));
+
+    json::Writer w = begin_response(id);
+    w.begin_array();
+    for (const auto& item : items) {
+        w.begin_object().key("label").value(item.label).key("kind").value(item.kind);
+        if (!item.detail.empty()) w.key("detail").value(item.detail);
+        w.end_object();
     }
-    write_message(response);
+    w.end_array().end_object();
+    write_message(response_);
 }
 
-void LspServer::handle_text_document_completion(int id, const std::string& params) {
-    std::string uri = extract_string(params, "uri");
-    int line = extract_int(params, "line");
-    int character = extract_int(params, "character");
+void LspServer::handle_text_document_definition(const json::Value& id, const json::Value& params) {
+    std::string uri(params["textDocument"]["uri"].as_string());
+    Location loc = get_definition(uri, position_of(params));
 
-    auto items = get_completions(uri, {line, character});
+    json::Writer w = begin_response(id);
+    if (loc.uri.empty()) {
+        w.null();
+    } else {
+        w.begin_object().key("uri").value(loc.uri).key("range");
+        write_range(w, loc.range);
+        w.end_object();
+    }
+    w.end_object();
+    write_message(response_);
+}
+
+void LspServer::schedule_analysis(const std::string& uri, std::chrono::milliseconds delay) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Re-arming the timer on every edit debounces bursts of typing
+        pending_[uri] = std::chrono::steady_clock::now() + delay;
+    }
+    analysis_cv_.notify_one();
+}
 
-    std::string items_json = "[";
-    for (size_t i = 0; i < items.size(); i++) {
-        if (i > 0) items_json += ",";
-        items_json += R"({"label": ")" + items[i].label + R"(", "kind": )" + std::to_string(items[i].kind);
-        if (!items[i].detail.empty()) {
-            items_json += R"(, "detail": ")" + items[i].detail + R"(")";
+void LspServer::analysis_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (pending_.empty()) {
+            analysis_cv_.wait(lock);
+            continue;
         }
-        items_json += "}";
+        auto next = std::min_element(pending_.begin(), pending_.end(),
+            [](const auto& a, const auto& b) { return a.second < b.second; });
+        if (next->second > std::chrono::steady_clock::now()) {
+            analysis_cv_.wait_until(lock, next->second);
+            continue;
+        }
+
+        std::string uri = next->first;
+        pending_.erase(next);
+        auto doc = documents_.find(uri);
+        if (doc == documents_.end()) continue;
+
+        uint64_t generation = doc->second.generation;
+        int version = doc->second.text.version;
+        // The lexer needs contiguous text
+        std::string content = doc->second.text.text();
+
+        lock.unlock();
+        analyze_document(uri, content, generation, version);
+        lock.lock();
     }
-    items_json += "]";
+}
 
-    std::string response = R"({"jsonrpc": "2.0", "id": )" + std::to_string(id) + R"(, "result": )" + items_json + "}";
-    write_message(response);
+void LspServer::stop_analysis() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    analysis_cv_.notify_one();
+    if (analysis_thread_.joinable()) analysis_thread_.join();
+    if (index_thread_.joinable()) index_thread_.join();
 }
 
-void LspServer::handle_text_document_definition(int id, const std::string& params) {
-    std::string uri = extract_string(params, "uri");
-    int line = extract_int(params, "line");
-    int character = extract_int(params, "character");
+bool LspServer::is_current(const std::string& uri, uint64_t generation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = documents_.find(uri);
+    return it != documents_.end() && it->second.generation == generation;
+}
 
-    Location loc = get_definition(uri, {line, character});
+std::shared_ptr<const AnalysisSnapshot> LspServer::snapshot_of(const std::string& uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = documents_.find(uri);
+    return it != documents_.end() ? it->second.snapshot : nullptr;
+}
 
-    std::string response;
-    if (loc.uri.empty()) {
-        response = R"({"jsonrpc": "2.0", "id": )" + std::to_string(id) + R"(, "result": null})";
+void LspServer::handle_text_document_references(const json::Value& id, const json::Value& params) {
+    std::string uri(params["textDocument"]["uri"].as_string());
+    std::string word = word_at(uri, position_of(params));
+    bool include_declaration = params["context"]["includeDeclaration"].as_bool(true);
+
+    std::vector<SymbolLocation> refs;
+    if (!word.empty()) refs = index_.references(word);
+    if (!include_declaration) {
+        auto decls = index_.definitions(word, uri);
+        refs.erase(std::remove_if(refs.begin(), refs.end(), [&decls](const SymbolLocation& r) {
+            return std::any_of(decls.begin(), decls.end(), [&r](const SymbolLocation& d) {
+                return d.uri == r.uri && d.line == r.line && d.column == r.column;
+            });
+        }), refs.end());
+    }
+
+    json::Writer w = begin_response(id);
+    w.begin_array();
+    for (const auto& ref : refs) {
+        w.begin_object().key("uri").value(ref.uri).key("range");
+        write_range(w, {{ref.line, ref.column}, {ref.line, ref.column + ref.length}});
+        w.end_object();
+    }
+    w.end_array().end_object();
+    write_message(response_);
+}
+
+void LspServer::handle_workspace_symbol(const json::Value& id, const json::Value& params) {
+    auto symbols = index_.search(params["query"].as_string(), 256);
+
+    json::Writer w = begin_response(id);
+    w.begin_array();
+    for (const auto& ws : symbols) {
+        const IndexedSymbol& sym = ws.symbol;
+        w.begin_object()
+            .key("name").value(sym.name)
+            .key("kind").value(static_cast<int>(sym.kind))
+            .key("location").begin_object().key("uri").value(ws.uri).key("range");
+        write_range(w, {{sym.line, sym.column}, {sym.line, sym.column + static_cast<int>(sym.name.size())}});
+        w.end_object();
+        if (!sym.container.empty()) w.key("containerName").value(sym.container);
+        w.end_object();
+    }
+    w.end_array().end_object();
+    write_message(response_);
+}
+
+void LspServer::request_refresh() {
+    // Server-to-client requests; the client's empty responses are ignored
+    auto send = [this](const char* method) {
+        std::string request;
+        json::Writer(request).begin_object()
+            .key("jsonrpc").value("2.0")
+            .key("id").value(next_request_id_++)
+            .key("method").value(method)
+        .end_object();
+        write_message(request);
+    };
+    if (semantic_refresh_) send("workspace/semanticTokens/refresh");
+    if (inlay_refresh_) send("workspace/inlayHint/refresh");
+}
+
+static void write_token_data(json::Writer& w, const uint32_t* data, size_t count) {
+    w.begin_array();
+    for (size_t i = 0; i < count; ++i) w.value(static_cast<int64_t>(data[i]));
+    w.end_array();
+}
+
+void LspServer::handle_semantic_tokens_full(const json::Value& id, const json::Value& params) {
+    std::string uri(params["textDocument"]["uri"].as_string());
+    auto snapshot = snapshot_of(uri);
+
+    json::Writer w = begin_response(id);
+    if (!snapshot) {
+        w.begin_object().key("data").begin_array().end_array().end_object();
     } else {
-        response = R"({"jsonrpc": "2.0", "id": )" + std::to_string(id) + R"(, "result": {"uri": ")" + loc.uri +
-            R"(", "range": {"start": {"line": )" + std::to_string(loc.range.start.line) +
-            R"(, "character": )" + std::to_string(loc.range.start.character) +
-            R"(}, "end": {"line": )" + std::to_string(loc.range.end.line) +
-            R"(, "character": )" + std::to_string(loc.range.end.character) + "}}}})";
+        w.begin_object().key("resultId").value(snapshot->result_id).key("data");
+        write_token_data(w, snapshot->semantic_tokens.data(), snapshot->semantic_tokens.size());
+        w.end_object();
+        sent_tokens_[uri] = snapshot;
     }
-    write_message(response);
+    w.end_object();
+    write_message(response_);
 }
 
-void LspServer::analyze_document(const std::string& uri) {
-    auto it = documents_.find(uri);
-    if (it == documents_.end()) return;
+void LspServer::handle_semantic_tokens_delta(const json::Value& id, const json::Value& params) {
+    std::string uri(params["textDocument"]["uri"].as_string());
+    auto sent = sent_tokens_.find(uri);
+    if (sent == sent_tokens_.end() || sent->second->result_id != params["previousResultId"].as_string()) {
+        handle_semantic_tokens_full(id, params);
+        return;
+    }
+    auto snapshot = snapshot_of(uri);
+    if (!snapshot) {
+        handle_semantic_tokens_full(id, params);
+        return;
+    }
 
-    const std::string& content = it->second;
+    // One edit covering everything between the common prefix and suffix
+    const auto& before = sent->second->semantic_tokens;
+    const auto& after = snapshot->semantic_tokens;
+    size_t prefix = 0;
+    while (prefix < before.size() && prefix < after.size() && before[prefix] == after[prefix]) prefix++;
+    size_t suffix = 0;
+    while (suffix < before.size() - prefix && suffix < after.size() - prefix &&
+           before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix]) suffix++;
+
+    json::Writer w = begin_response(id);
+    w.begin_object().key("resultId").value(snapshot->result_id).key("edits").begin_array();
+    if (prefix + suffix != before.size() || prefix + suffix != after.size()) {
+        w.begin_object()
+            .key("start").value(static_cast<int64_t>(prefix))
+            .key("deleteCount").value(static_cast<int64_t>(before.size() - prefix - suffix))
+            .key("data");
+        write_token_data(w, after.data() + prefix, after.size() - prefix - suffix);
+        w.end_object();
+    }
+    w.end_array().end_object().end_object();
+    write_message(response_);
+    sent->second = snapshot;
+}
+
+void LspServer::handle_inlay_hint(const json::Value& id, const json::Value& params) {
+    std::string uri(params["textDocument"]["uri"].as_string());
+    json::Value range = params["range"];
+    // Hints are 1-based and sorted, so the visible range is one contiguous run
+    int first = static_cast<int>(range["start"]["line"].as_int()) + 1;
+    int last = static_cast<int>(range["end"]["line"].as_int(INT32_MAX - 1)) + 1;
+    auto snapshot = snapshot_of(uri);
+
+    json::Writer w = begin_response(id);
+    w.begin_array();
+    if (snapshot) {
+        const auto& hints = snapshot->semantic.hints;
+        auto it = std::lower_bound(hints.begin(), hints.end(), first,
+            [](const frontend::SemanticHint& h, int line) { return h.line < line; });
+        for (; it != hints.end() && it->line <= last; ++it) {
+            bool is_type = it->kind == frontend::SemanticHintKind::Type;
+            w.begin_object()
+                .key("position").begin_object().key("line").value(it->line - 1).key("character").value(it->column - 1).end_object()
+                .key("label").value(it->label)
+                .key("kind").value(static_cast<int>(it->kind))
+                .key(is_type ? "paddingLeft" : "paddingRight").value(!is_type)
+            .end_object();
+        }
+    }
+    w.end_array().end_object();
+    write_message(response_);
+}
+
+void LspServer::handle_range_formatting(const json::Value& id, const json::Value& params) {
+    std::string uri(params["textDocument"]["uri"].as_string());
+    json::Value start = params["range"]["start"];
+    json::Value end = params["range"]["end"];
+    std::string text;
+    size_t begin = 0, finish = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = documents_.find(uri);
+        if (it != documents_.end()) {
+            const TextDocument& doc = it->second.text;
+            text = doc.text();
+            begin = doc.offset_at(static_cast<int>(start["line"].as_int()), static_cast<int>(start["character"].as_int()));
+            finish = doc.offset_at(static_cast<int>(end["line"].as_int()), static_cast<int>(end["character"].as_int()));
+        }
+    }
+    respond_with_format_edits(id, params, text, begin, std::max(begin, finish));
+}
+
+void LspServer::handle_on_type_formatting(const json::Value& id, const json::Value& params) {
+    std::string uri(params["textDocument"]["uri"].as_string());
+    Position pos = position_of(params);
+    std::string text;
+    size_t offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = documents_.find(uri);
+        if (it != documents_.end()) {
+            text = it->second.text.text();
+            offset = it->second.text.offset_at(pos.line, pos.character);
+        }
+    }
+    respond_with_format_edits(id, params, text, offset, offset);
+}
+
+void LspServer::respond_with_format_edits(const json::Value& id, const json::Value& params,
+                                          const std::string& text, size_t begin, size_t end) {
+    // The snapshot's tree may be older than the text and has been through
+    // semantic analysis, which fills in inferred types; parse afresh
+    std::vector<fmt::TextEdit> edits;
+    if (!text.empty()) {
+        frontend::Lexer lexer(text);
+        auto tokens = lexer.tokenize();
+        frontend::DiagnosticEngine diag;
+        frontend::Parser parser(tokens, diag);
+        auto module = parser.parse_module();
+        // Extents are only trusted when the whole file parsed
+        if (module && !diag.has_errors()) {
+            json::Value options = params["options"];
+            fmt::FormatConfig config;
+            config.indent_width = static_cast<int>(options["tabSize"].as_int(config.indent_width));
+            config.use_tabs = !options["insertSpaces"].as_bool(true);
+            edits = fmt::Formatter(config).format_range(module.get(), text, begin, end);
+        }
+    }
+
+    // Offsets to LSP positions
+    std::vector<size_t> line_starts{0};
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\n') line_starts.push_back(i + 1);
+    }
+    auto position_at = [&](size_t offset) {
+        size_t line = std::upper_bound(line_starts.begin(), line_starts.end(), offset) - line_starts.begin() - 1;
+        std::string_view prefix(text.data() + line_starts[line], offset - line_starts[line]);
+        return Position{static_cast<int>(line), byte_to_utf16_column(prefix, prefix.size())};
+    };
+
+    json::Writer w = begin_response(id);
+    w.begin_array();
+    for (const auto& edit : edits) {
+        Range range{position_at(edit.offset), position_at(edit.offset + edit.length)};
+        w.begin_object().key("range");
+        write_range(w, range);
+        w.key("newText").value(edit.text).end_object();
+    }
+    w.end_array().end_object();
+    write_message(response_);
+}
+
+void LspServer::analyze_document(const std::string& uri, const std::string& content, uint64_t generation, int version) {
     std::vector<Diagnostic> diagnostics;
 
     // Create a diagnostic collector
@@ -277,10 +600,13 @@ void LspServer::analyze_document(const std::string& uri) {
     // Parse the document
     frontend::Lexer lexer(content);
     auto tokens = lexer.tokenize();
+    if (!is_current(uri, generation)) return;
 
     frontend::DiagnosticEngine diag;
     frontend::Parser parser(tokens, diag);
     auto module = parser.parse_module();
+    if (!is_current(uri, generation)) return;
+    index_.update(uri, tokens, module.get());
 
     // Collect parse errors
     for (const auto& err : diag.errors()) {
@@ -296,8 +622,10 @@ void LspServer::analyze_document(const std::string& uri) {
 
     // Run semantic analysis if parsing succeeded
     if (module && diag.errors().empty()) {
+        auto snapshot = std::make_shared<AnalysisSnapshot>();
         frontend::DiagnosticEngine sem_diag;
         frontend::SemanticAnalyzer analyzer(sem_diag);
+        analyzer.set_semantic_info(&snapshot->semantic);
         analyzer.analyze(module.get());
 
         for (const auto& err : sem_diag.errors()) {
@@ -322,34 +650,79 @@ void LspServer::analyze_document(const std::string& uri) {
             diagnostics.push_back(d);
         }
 
-        parsed_modules_[uri] = std::move(module);
+        snapshot->module = std::move(module);
+        snapshot->version = version;
+        snapshot->result_id = std::to_string(generation);
+
+        // LSP encoding: 5 integers per token, positions relative to the previous token
+        int prev_line = 0;
+        int prev_column = 0;
+        snapshot->semantic_tokens.reserve(snapshot->semantic.tokens.size() * 5);
+        for (const auto& tok : snapshot->semantic.tokens) {
+            int line = tok.line - 1;
+            int column = tok.column - 1;
+            snapshot->semantic_tokens.push_back(static_cast<uint32_t>(line - prev_line));
+            snapshot->semantic_tokens.push_back(static_cast<uint32_t>(line == prev_line ? column - prev_column : column));
+            snapshot->semantic_tokens.push_back(tok.length);
+            snapshot->semantic_tokens.push_back(static_cast<uint32_t>(tok.kind));
+            snapshot->semantic_tokens.push_back(tok.modifiers);
+            prev_line = line;
+            prev_column = column;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = documents_.find(uri);
+            if (it == documents_.end() || it->second.generation != generation) return;
+            it->second.snapshot = std::move(snapshot);
+        }
+        request_refresh();
     }
 
+    std::lock_guard<std::mutex> publish(publish_mutex_);
+    if (!is_current(uri, generation)) return;
     publish_diagnostics(uri, diagnostics);
 }
 
 void LspServer::publish_diagnostics(const std::string& uri, const std::vector<Diagnostic>& diagnostics) {
-    std::string diags_json = "[";
-    for (size_t i = 0; i < diagnostics.size(); i++) {
-        if (i > 0) diags_json += ",";
-        const auto& d = diagnostics[i];
-        diags_json += R"({"range": {"start": {"line": )" + std::to_string(d.range.start.line) +
-            R"(, "character": )" + std::to_string(d.range.start.character) +
-            R"(}, "end": {"line": )" + std::to_string(d.range.end.line) +
-            R"(, "character": )" + std::to_string(d.range.end.character) +
-            R"(}}, "severity": )" + std::to_string(d.severity) +
-            R"(, "source": "mana", "message": )" + json_string(d.message) + "}";
-    }
-    diags_json += "]";
-
-    std::string notification = R"({"jsonrpc": "2.0", "method": "textDocument/publishDiagnostics", "params": {"uri": ")" +
-        uri + R"(", "diagnostics": )" + diags_json + "}}";
+    std::string notification;
+    json::Writer w(notification);
+    w.begin_object()
+        .key("jsonrpc").value("2.0")
+        .key("method").value("textDocument/publishDiagnostics")
+        .key("params").begin_object()
+            .key("uri").value(uri)
+            .key("diagnostics").begin_array();
+    for (const auto& d : diagnostics) {
+        w.begin_object().key("range");
+        write_range(w, d.range);
+        w.key("severity").value(d.severity)
+         .key("source").value(d.source)
+         .key("message").value(d.message)
+         .end_object();
+    }
+    w.end_array().end_object().end_object();
     write_message(notification);
 }
 
 std::vector<CompletionItem> LspServer::get_completions(const std::string& uri, Position pos) {
     std::vector<CompletionItem> items;
 
+    // Only names that continue the identifier typed before the cursor
+    std::string prefix;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto doc_it = documents_.find(uri);
+        if (doc_it != documents_.end() && pos.character > 0) {
+            std::string current_line = doc_it->second.text.line(pos.line);
+            size_t end = std::min(utf16_to_byte_column(current_line, pos.character), current_line.size());
+            size_t start = end;
+            while (start > 0 && (std::isalnum(static_cast<unsigned char>(current_line[start - 1])) || current_line[start - 1] == '_')) start--;
+            prefix = current_line.substr(start, end - start);
+        }
+    }
+    auto matches = [&](const std::string& name) { return name.compare(0, prefix.size(), prefix) == 0; };
+
     // Keywords
     static const std::vector<std::pair<std::string, std::string>> keywords = {
         {"fn", "Function declaration"}, {"let", "Variable declaration"}, {"mut", "Mutable variable"},
@@ -363,7 +736,7 @@ std::vector<CompletionItem> LspServer::get_completions(const std::string& uri, P
     };
 
     for (const auto& [kw, desc] : keywords) {
-        items.push_back({kw, 14, desc, ""});  // 14 = Keyword
+        if (matches(kw)) items.push_back({kw, 14, desc, ""});  // 14 = Keyword
     }
 
     // Types
@@ -371,7 +744,7 @@ std::vector<CompletionItem> LspServer::get_completions(const std::string& uri, P
         "i32", "i64", "f32", "f64", "bool", "string", "void", "Vec", "Option", "Result"
     };
     for (const auto& t : types) {
-        items.push_back({t, 7, "Type", ""});  // 7 = Class
+        if (matches(t)) items.push_back({t, 7, "Type", ""});  // 7 = Class
     }
 
     // Built-in functions
@@ -380,61 +753,79 @@ std::vector<CompletionItem> LspServer::get_completions(const std::string& uri, P
         {"len", "Get length"}, {"push", "Push to collection"}, {"pop", "Pop from collection"}
     };
     for (const auto& [fn, desc] : builtins) {
-        items.push_back({fn, 3, desc, ""});  // 3 = Function
+        if (matches(fn)) items.push_back({fn, 3, desc, ""});  // 3 = Function
+    }
+
+    // Declarations in this file and public ones from imported modules
+    std::unordered_map<std::string, bool> seen;
+    for (auto& sym : index_.visible_symbols(uri)) {
+        if (sym.kind == SymbolKind::Field || sym.kind == SymbolKind::EnumMember) continue;
+        if (!matches(sym.name) || !seen.emplace(sym.name, true).second) continue;
+        int kind = 3;  // Function
+        switch (sym.kind) {
+            case SymbolKind::Method: kind = 2; break;
+            case SymbolKind::Struct: kind = 22; break;
+            case SymbolKind::Enum: kind = 13; break;
+            case SymbolKind::Interface: kind = 8; break;
+            case SymbolKind::Variable: kind = 6; break;
+            case SymbolKind::TypeParameter: kind = 7; break;
+            default: break;
+        }
+        items.push_back({std::move(sym.name), kind, std::move(sym.detail), ""});
     }
 
     return items;
 }
 
-std::string LspServer::get_hover_info(const std::string& uri, Position pos) {
-    auto doc_it = documents_.find(uri);
-    if (doc_it == documents_.end()) return "";
-
-    // Get the word at the cursor position
-    const std::string& content = doc_it->second;
-    std::vector<std::string> lines;
-    std::istringstream iss(content);
-    std::string line;
-    while (std::getline(iss, line)) {
-        lines.push_back(line);
+std::string LspServer::word_at(const std::string& uri, Position pos) {
+    std::string current_line;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto doc_it = documents_.find(uri);
+        if (doc_it == documents_.end()) return "";
+        // Only the cursor's line is extracted from the document
+        current_line = doc_it->second.text.line(pos.line);
     }
-
-    if (pos.line < 0 || pos.line >= static_cast<int>(lines.size())) return "";
-    const std::string& current_line = lines[pos.line];
-    if (pos.character < 0 || pos.character >= static_cast<int>(current_line.size())) return "";
+    if (pos.character < 0) return "";
+    int column = static_cast<int>(utf16_to_byte_column(current_line, pos.character));
+    if (column >= static_cast<int>(current_line.size())) return "";
 
     // Find word boundaries
-    int start = pos.character;
-    int end = pos.character;
-    while (start > 0 && (std::isalnum(current_line[start - 1]) || current_line[start - 1] == '_')) start--;
-    while (end < static_cast<int>(current_line.size()) && (std::isalnum(current_line[end]) || current_line[end] == '_')) end++;
+    int start = column;
+    int end = column;
+    while (start > 0 && (std::isalnum(static_cast<unsigned char>(current_line[start - 1])) || current_line[start - 1] == '_')) start--;
+    while (end < static_cast<int>(current_line.size()) && (std::isalnum(static_cast<unsigned char>(current_line[end])) || current_line[end] == '_')) end++;
+
+    return current_line.substr(start, end - start);
+}
 
-    if (start == end) return "";
-    std::string word = current_line.substr(start, end - start);
+std::string LspServer::get_hover_info(const std::string& uri, Position pos) {
+    std::string word = word_at(uri, pos);
+    if (word.empty()) return "";
 
-    // Check if we have a parsed module
-    auto mod_it = parsed_modules_.find(uri);
-    if (mod_it != parsed_modules_.end() && mod_it->second) {
-        auto* module = mod_it->second.get();
+    // Answer from the last good analysis; never wait for a running one
+    auto snapshot = snapshot_of(uri);
+    if (snapshot && snapshot->module) {
+        auto* module = snapshot->module.get();
 
         // Search for functions
         for (const auto& decl : module->decls) {
             if (auto* fn = dynamic_cast<frontend::AstFuncDecl*>(decl.get())) {
                 if (fn->name == word) {
-                    std::string info = "```mana\\nfn " + fn->name + "(";
+                    std::string info = "```mana\nfn " + fn->name + "(";
                     for (size_t i = 0; i < fn->params.size(); ++i) {
                         if (i > 0) info += ", ";
                         info += fn->params[i].name + ": " + fn->params[i].type_name;
                     }
                     info += ") -> " + (fn->return_type.empty() ? "void" : fn->return_type);
-                    info += "\\n```";
+                    info += "\n```";
                     return info;
                 }
             }
             // Search for structs
             if (auto* st = dynamic_cast<frontend::AstStructDecl*>(decl.get())) {
                 if (st->name == word) {
-                    std::string info = "```mana\\nstruct " + st->name;
+                    std::string info = "```mana\nstruct " + st->name;
                     if (!st->type_params.empty()) {
                         info += "<";
                         for (size_t i = 0; i < st->type_params.size(); ++i) {
@@ -443,22 +834,22 @@ std::string LspServer::get_hover_info(const std::string& uri, Position pos) {
                         }
                         info += ">";
                     }
-                    info += " {\\n";
+                    info += " {\n";
                     for (const auto& field : st->fields) {
-                        info += "    " + field.name + ": " + field.type_name + ",\\n";
+                        info += "    " + field.name + ": " + field.type_name + ",\n";
                     }
-                    info += "}\\n```";
+                    info += "}\n```";
                     return info;
                 }
             }
             // Search for enums
             if (auto* en = dynamic_cast<frontend::AstEnumDecl*>(decl.get())) {
                 if (en->name == word) {
-                    std::string info = "```mana\\nenum " + en->name + " {\\n";
+                    std::string info = "```mana\nenum " + en->name + " {\n";
                     for (const auto& variant : en->variants) {
-                        info += "    " + variant.name + ",\\n";
+                        info += "    " + variant.name + ",\n";
                     }
-                    info += "}\\n```";
+                    info += "}\n```";
                     return info;
                 }
             }
@@ -478,29 +869,54 @@ std::string LspServer::get_hover_info(const std::string& uri, Position pos) {
         {"Option", "Optional value: Some(T) or None"},
         {"Result", "Result type: Ok(T) or Err(E)"},
         {"HashMap", "Key-value hash map"},
+        {"Rng", "Seedable xoshiro256++ random generator"},
+        {"Vec2", "2D float vector"},
+        {"Vec3", "3D float vector"},
+        {"Vec4", "4D float vector (SIMD)"},
+        {"Mat4", "Column-major 4x4 float matrix (SIMD)"},
+        {"Quat", "Rotation quaternion"},
+        {"Arena", "Bump allocator; frees all allocations at once"},
+        {"ArenaVec", "Vec<T> whose storage lives in an Arena"},
+        {"ArenaString", "String whose storage lives in an Arena"},
+        {"AllocStats", "Snapshot of global allocation counters"},
     };
 
     auto type_it = builtin_types.find(word);
     if (type_it != builtin_types.end()) {
-        return "**" + word + "**\\n\\n" + type_it->second;
+        return "**" + word + "**\n\n" + type_it->second;
     }
 
     // Check built-in functions
     static const std::unordered_map<std::string, std::string> builtin_fns = {
-        {"println", "```mana\\nfn println(value: any) -> void\\n```\\n\\nPrints value with newline"},
-        {"print", "```mana\\nfn print(value: any) -> void\\n```\\n\\nPrints value without newline"},
-        {"len", "```mana\\nfn len(s: string) -> i32\\n```\\n\\nReturns length of string or collection"},
-        {"push", "```mana\\nfn push(vec: Vec<T>, value: T) -> void\\n```\\n\\nAppends value to vector"},
-        {"pop", "```mana\\nfn pop(vec: Vec<T>) -> Option<T>\\n```\\n\\nRemoves and returns last element"},
-        {"Some", "```mana\\nfn Some<T>(value: T) -> Option<T>\\n```\\n\\nWraps value in Some variant"},
-        {"None", "```mana\\nNone: Option<T>\\n```\\n\\nRepresents absence of value"},
-        {"Ok", "```mana\\nfn Ok<T>(value: T) -> Result<T, E>\\n```\\n\\nSuccess result variant"},
-        {"Err", "```mana\\nfn Err<E>(error: E) -> Result<T, E>\\n```\\n\\nError result variant"},
-        {"sqrt", "```mana\\nfn sqrt(x: f32) -> f32\\n```\\n\\nSquare root"},
-        {"sin", "```mana\\nfn sin(x: f32) -> f32\\n```\\n\\nSine (radians)"},
-        {"cos", "```mana\\nfn cos(x: f32) -> f32\\n```\\n\\nCosine (radians)"},
-        {"random_int", "```mana\\nfn random_int(min: i32, max: i32) -> i32\\n```\\n\\nRandom integer in range"},
-        {"random_float", "```mana\\nfn random_float() -> f32\\n```\\n\\nRandom float 0.0 to 1.0"},
+        {"println", "```mana\nfn println(value: any) -> void\n```\n\nPrints value with newline"},
+        {"print", "```mana\nfn print(value: any) -> void\n```\n\nPrints value without newline"},
+        {"len", "```mana\nfn len(s: string) -> i32\n```\n\nReturns length of string or collection"},
+        {"push", "```mana\nfn push(vec: Vec<T>, value: T) -> void\n```\n\nAppends value to vector"},
+        {"pop", "```mana\nfn pop(vec: Vec<T>) -> Option<T>\n```\n\nRemoves and returns last element"},
+        {"Some", "```mana\nfn Some<T>(value: T) -> Option<T>\n```\n\nWraps value in Some variant"},
+        {"None", "```mana\nNone: Option<T>\n```\n\nRepresents absence of value"},
+        {"Ok", "```mana\nfn Ok<T>(value: T) -> Result<T, E>\n```\n\nSuccess result variant"},
+        {"Err", "```mana\nfn Err<E>(error: E) -> Result<T, E>\n```\n\nError result variant"},
+        {"sqrt", "```mana\nfn sqrt(x: f32) -> f32\n```\n\nSquare root"},
+        {"sin", "```mana\nfn sin(x: f32) -> f32\n```\n\nSine (radians)"},
+        {"cos", "```mana\nfn cos(x: f32) -> f32\n```\n\nCosine (radians)"},
+        {"random_int", "```mana\nfn random_int(min: i32, max: i32) -> i32\n```\n\nRandom integer in range"},
+        {"random_float", "```mana\nfn random_float() -> f32\n```\n\nRandom float in [0.0, 1.0)"},
+        {"random_range", "```mana\nfn random_range(min: f32, max: f32) -> f32\n```\n\nRandom float in [min, max)"},
+        {"seed_random", "```mana\nfn seed_random(seed: i32) -> void\n```\n\nReseeds the current thread's generator"},
+        {"fill_random", "```mana\nfn fill_random(out: Vec<f32>) -> void\n```\n\nFills a vector with random floats in [0.0, 1.0)"},
+        {"dot", "```mana\nfn dot(a: Vec3, b: Vec3) -> f32\n```\n\nDot product (Vec2, Vec3, Vec4, Quat)"},
+        {"cross", "```mana\nfn cross(a: Vec3, b: Vec3) -> Vec3\n```\n\nCross product"},
+        {"lerp", "```mana\nfn lerp(a: T, b: T, t: f32) -> T\n```\n\nLinear interpolation"},
+        {"slerp", "```mana\nfn slerp(a: Quat, b: Quat, t: f32) -> Quat\n```\n\nSpherical interpolation"},
+        {"look_at", "```mana\nfn look_at(eye: Vec3, target: Vec3, up: Vec3) -> Mat4\n```\n\nRight-handed view matrix"},
+        {"perspective", "```mana\nfn perspective(fov_y: f32, aspect: f32, near: f32, far: f32) -> Mat4\n```\n\nPerspective projection matrix"},
+        {"transform_points", "```mana\nfn transform_points(m: Mat4, points: Vec<Vec3>) -> Vec<Vec3>\n```\n\nBatch point transform"},
+        {"sin_all", "```mana\nfn sin_all(xs: Vec<f32>) -> Vec<f32>\n```\n\nSIMD sine of each element (< 2.5 ulp)"},
+        {"exp_all", "```mana\nfn exp_all(xs: Vec<f32>) -> Vec<f32>\n```\n\nSIMD exponential of each element (< 1 ulp)"},
+        {"axpy", "```mana\nfn axpy(a: f32, x: Vec<f32>, y: Vec<f32>) -> void\n```\n\nIn-place y = a * x + y"},
+        {"sum", "```mana\nfn sum(xs: Vec<f32>) -> f32\n```\n\nSIMD sum of elements"},
+        {"alloc_stats", "```mana\nfn alloc_stats() -> AllocStats\n```\n\nAllocation counters; all zero unless built with --alloc-stats"},
     };
 
     auto fn_it = builtin_fns.find(word);
@@ -510,23 +926,23 @@ std::string LspServer::get_hover_info(const std::string& uri, Position pos) {
 
     // Check keywords
     static const std::unordered_map<std::string, std::string> keywords = {
-        {"fn", "**fn**\\n\\nFunction declaration keyword"},
-        {"let", "**let**\\n\\nVariable declaration (immutable by default)"},
-        {"mut", "**mut**\\n\\nMutable variable modifier"},
-        {"if", "**if**\\n\\nConditional statement"},
-        {"else", "**else**\\n\\nAlternative branch"},
-        {"match", "**match**\\n\\nPattern matching expression"},
-        {"for", "**for**\\n\\nFor loop (for x in collection)"},
-        {"while", "**while**\\n\\nWhile loop"},
-        {"return", "**return**\\n\\nReturn from function"},
-        {"struct", "**struct**\\n\\nDefine a structure type"},
-        {"enum", "**enum**\\n\\nDefine an enumeration type"},
-        {"impl", "**impl**\\n\\nImplementation block for methods"},
-        {"trait", "**trait**\\n\\nDefine a trait (interface)"},
-        {"pub", "**pub**\\n\\nPublic visibility modifier"},
-        {"use", "**use**\\n\\nImport declaration"},
-        {"async", "**async**\\n\\nAsynchronous function modifier"},
-        {"await", "**await**\\n\\nAwait async operation"},
+        {"fn", "**fn**\n\nFunction declaration keyword"},
+        {"let", "**let**\n\nVariable declaration (immutable by default)"},
+        {"mut", "**mut**\n\nMutable variable modifier"},
+        {"if", "**if**\n\nConditional statement"},
+        {"else", "**else**\n\nAlternative branch"},
+        {"match", "**match**\n\nPattern matching expression"},
+        {"for", "**for**\n\nFor loop (for x in collection)"},
+        {"while", "**while**\n\nWhile loop"},
+        {"return", "**return**\n\nReturn from function"},
+        {"struct", "**struct**\n\nDefine a structure type"},
+        {"enum", "**enum**\n\nDefine an enumeration type"},
+        {"impl", "**impl**\n\nImplementation block for methods"},
+        {"trait", "**trait**\n\nDefine a trait (interface)"},
+        {"pub", "**pub**\n\nPublic visibility modifier"},
+        {"use", "**use**\n\nImport declaration"},
+        {"async", "**async**\n\nAsynchronous function modifier"},
+        {"await", "**await**\n\nAwait async operation"},
     };
 
     auto kw_it = keywords.find(word);
@@ -538,36 +954,14 @@ std::string LspServer::get_hover_info(const std::string& uri, Position pos) {
 }
 
 Location LspServer::get_definition(const std::string& uri, Position pos) {
-    auto doc_it = documents_.find(uri);
-    if (doc_it == documents_.end()) return {};
-
-    // Get the word at the cursor position
-    const std::string& content = doc_it->second;
-    std::vector<std::string> lines;
-    std::istringstream iss(content);
-    std::string line;
-    while (std::getline(iss, line)) {
-        lines.push_back(line);
-    }
+    std::string word = word_at(uri, pos);
+    if (word.empty()) return {};
 
-    if (pos.line < 0 || pos.line >= static_cast<int>(lines.size())) return {};
-    const std::string& current_line = lines[pos.line];
-    if (pos.character < 0 || pos.character >= static_cast<int>(current_line.size())) return {};
+    // Answer from the last good analysis; never wait for a running one
+    auto snapshot = snapshot_of(uri);
+    if (!snapshot || !snapshot->module) return definition_from_index(uri, word);
 
-    // Find word boundaries
-    int start = pos.character;
-    int end = pos.character;
-    while (start > 0 && (std::isalnum(current_line[start - 1]) || current_line[start - 1] == '_')) start--;
-    while (end < static_cast<int>(current_line.size()) && (std::isalnum(current_line[end]) || current_line[end] == '_')) end++;
-
-    if (start == end) return {};
-    std::string word = current_line.substr(start, end - start);
-
-    // Check if we have a parsed module
-    auto mod_it = parsed_modules_.find(uri);
-    if (mod_it == parsed_modules_.end() || !mod_it->second) return {};
-
-    auto* module = mod_it->second.get();
+    auto* module = snapshot->module.get();
 
     // Search for functions
     for (const auto& decl : module->decls) {
@@ -608,55 +1002,14 @@ Location LspServer::get_definition(const std::string& uri, Position pos) {
         }
     }
 
-    return {};
-}
-
-std::string LspServer::json_string(const std::string& s) {
-    std::string result = "\"";
-    for (char c : s) {
-        switch (c) {
-            case '"': result += "\\\""; break;
-            case '\\': result += "\\\\"; break;
-            case '\n': result += "\\n"; break;
-            case '\r': result += "\\r"; break;
-            case '\t': result += "\\t"; break;
-            default: result += c; break;
-        }
-    }
-    result += "\"";
-    return result;
-}
-
-std::string LspServer::extract_string(const std::string& json, const std::string& key) {
-    std::string search = "\"" + key + "\"";
-    size_t pos = json.find(search);
-    if (pos == std::string::npos) return "";
-
-    size_t colon = json.find(':', pos);
-    if (colon == std::string::npos) return "";
-
-    size_t start = json.find('"', colon) + 1;
-    size_t end = start;
-    while (end < json.size() && !(json[end] == '"' && json[end-1] != '\\')) end++;
-    return json.substr(start, end - start);
+    return definition_from_index(uri, word);
 }
 
-int LspServer::extract_int(const std::string& json, const std::string& key) {
-    std::string search = "\"" + key + "\"";
-    size_t pos = json.find(search);
-    if (pos == std::string::npos) return -1;
-
-    size_t colon = json.find(':', pos);
-    if (colon == std::string::npos) return -1;
-
-    size_t start = colon + 1;
-    while (start < json.size() && (json[start] == ' ' || json[start] == '\t')) start++;
-
-    std::string num;
-    while (start < json.size() && (isdigit(json[start]) || json[start] == '-')) {
-        num += json[start++];
-    }
-    return num.empty() ? -1 : std::stoi(num);
+Location LspServer::definition_from_index(const std::string& uri, const std::string& word) {
+    auto defs = index_.definitions(word, uri);
+    if (defs.empty()) return {};
+    const SymbolLocation& def = defs.front();
+    return {def.uri, {{def.line, def.column}, {def.line, def.column + def.length}}};
 }
 
 } // namespace mana::lsp
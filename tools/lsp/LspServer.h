@@ -5,9 +5,18 @@
 #include <functional>
 #include <iostream>
 #include <sstream>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
 #include "../../frontend/Parser.h"
 #include "../../frontend/Semantic.h"
 #include "../../frontend/Diagnostic.h"
+#include "../json/Json.h"
+#include "TextDocument.h"
+#include "WorkspaceIndex.h"
 
 namespace mana::lsp {
 
@@ -40,46 +49,115 @@ namespace mana::lsp {
         std::string documentation;
     };
 
+    // Result of the last successful parse of a document. The analysis thread
+    // publishes a new one; request handlers keep a reference while reading it.
+    struct AnalysisSnapshot {
+        std::unique_ptr<frontend::AstModule> module;
+        int version = 0;
+        // Resolved names and inferred types from the semantic pass, plus the
+        // names pre-encoded as LSP semantic token data
+        frontend::SemanticInfo semantic;
+        std::vector<uint32_t> semantic_tokens;
+        std::string result_id;
+    };
+
+    struct OpenDocument {
+        TextDocument text;
+        uint64_t generation = 0;  // New on every open and edit; stale analyses are dropped
+        std::shared_ptr<const AnalysisSnapshot> snapshot;
+    };
+
     class LspServer {
     public:
         LspServer();
+        ~LspServer();
         void run();
 
     private:
         // JSON-RPC handling
-        std::string read_message();
+        bool read_message(std::string& out);
         void write_message(const std::string& content);
-        void handle_message(const std::string& json);
+        void handle_message(std::string& message);
+        // Starts {"jsonrpc":"2.0","id":...,"result": in response_; caller writes the result and closes
+        json::Writer begin_response(const json::Value& id);
 
         // LSP methods
-        void handle_initialize(int id, const std::string& params);
+        void handle_initialize(const json::Value& id, const json::Value& params);
         void handle_initialized();
-        void handle_shutdown(int id);
+        void handle_shutdown(const json::Value& id);
         void handle_exit();
-        void handle_text_document_did_open(const std::string& params);
-        void handle_text_document_did_change(const std::string& params);
-        void handle_text_document_did_close(const std::string& params);
-        void handle_text_document_hover(int id, const std::string& params);
-        void handle_text_document_completion(int id, const std::string& params);
-        void handle_text_document_definition(int id, const std::string& params);
-
-        // Document management
-        std::unordered_map<std::string, std::string> documents_;  // uri -> content
-        std::unordered_map<std::string, std::unique_ptr<frontend::AstModule>> parsed_modules_;
-
-        // Analyze and publish diagnostics
-        void analyze_document(const std::string& uri);
+        void handle_text_document_did_open(const json::Value& params);
+        void handle_text_document_did_change(const json::Value& params);
+        void handle_text_document_did_close(const json::Value& params);
+        void handle_text_document_hover(const json::Value& id, const json::Value& params);
+        void handle_text_document_completion(const json::Value& id, const json::Value& params);
+        void handle_text_document_definition(const json::Value& id, const json::Value& params);
+        void handle_text_document_references(const json::Value& id, const json::Value& params);
+        void handle_workspace_symbol(const json::Value& id, const json::Value& params);
+        void handle_semantic_tokens_full(const json::Value& id, const json::Value& params);
+        void handle_semantic_tokens_delta(const json::Value& id, const json::Value& params);
+        void handle_inlay_hint(const json::Value& id, const json::Value& params);
+        void handle_range_formatting(const json::Value& id, const json::Value& params);
+        void handle_on_type_formatting(const json::Value& id, const json::Value& params);
+        // Reparse the current text and answer with the edits that format the
+        // declarations touching [begin, end) (a position when begin == end)
+        void respond_with_format_edits(const json::Value& id, const json::Value& params,
+                                       const std::string& text, size_t begin, size_t end);
+
+        // Document management. documents_ and pending_ are shared with the
+        // analysis thread and guarded by mutex_.
+        std::unordered_map<std::string, OpenDocument> documents_;  // uri -> content
+        std::unordered_map<std::string, std::chrono::steady_clock::time_point> pending_;  // uri -> due
+        std::mutex mutex_;
+        // Source of OpenDocument::generation, shared by all documents so that
+        // a reopened one never repeats a generation from before its close
+        uint64_t last_generation_ = 0;
+        std::condition_variable analysis_cv_;
+        std::thread analysis_thread_;
+        bool stopping_ = false;
+        // Quiet period after an edit before the document is re-analyzed
+        std::chrono::milliseconds analysis_delay_{150};
+
+        // Background analysis: debounced per document, cancelled between
+        // phases when a newer edit arrives
+        void schedule_analysis(const std::string& uri, std::chrono::milliseconds delay);
+        void analysis_loop();
+        void stop_analysis();
+        void analyze_document(const std::string& uri, const std::string& content, uint64_t generation, int version);
+        bool is_current(const std::string& uri, uint64_t generation);
+        std::shared_ptr<const AnalysisSnapshot> snapshot_of(const std::string& uri);
+
+        // Declarations and references across the workspace; built on
+        // index_thread_ at startup and updated by each document analysis
+        WorkspaceIndex index_;
+        std::thread index_thread_;
+
+        // Snapshot whose semantic tokens were last sent per document, the
+        // base for semanticTokens/delta (request thread only)
+        std::unordered_map<std::string, std::shared_ptr<const AnalysisSnapshot>> sent_tokens_;
+        // Ask the client to re-request tokens/hints when a new analysis lands.
+        // Set by initialize, read from the analysis thread.
+        std::atomic<bool> semantic_refresh_{false};
+        std::atomic<bool> inlay_refresh_{false};
+        std::atomic<int> next_request_id_{1};
+        void request_refresh();
         void publish_diagnostics(const std::string& uri, const std::vector<Diagnostic>& diagnostics);
 
         // Helpers
+        std::string word_at(const std::string& uri, Position pos);
         std::vector<CompletionItem> get_completions(const std::string& uri, Position pos);
         std::string get_hover_info(const std::string& uri, Position pos);
         Location get_definition(const std::string& uri, Position pos);
+        Location definition_from_index(const std::string& uri, const std::string& word);
 
-        // Simple JSON helpers (basic implementation)
-        static std::string json_string(const std::string& s);
-        static std::string extract_string(const std::string& json, const std::string& key);
-        static int extract_int(const std::string& json, const std::string& key);
+        // Transport buffers, reused across messages
+        std::string buffer_;
+        std::string response_;
+        json::Document message_;
+        std::mutex output_mutex_;  // Diagnostics are written from the analysis thread
+        // Held from an analysis's last is_current() check through its publish,
+        // and by didClose's clear, so a stale publish cannot follow the clear
+        std::mutex publish_mutex_;
 
         bool running_ = true;
         bool initialized_ = false;
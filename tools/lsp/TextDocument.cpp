@@ -0,0 +1,251 @@
+#include "TextDocument.h"
+#include <algorithm>
+#include <utility>
+
+namespace mana::lsp {
+
+namespace {
+
+// Chunks built from inserted text are at most this long; in-place edits may
+// grow a chunk to twice this before it is split.
+constexpr size_t kMaxChunk = 2048;
+
+uint32_t next_priority() {
+    static uint32_t state = 0x9E3779B9u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+size_t count_newlines(std::string_view s) {
+    return static_cast<size_t>(std::count(s.begin(), s.end(), '\n'));
+}
+
+} // namespace
+
+struct TextDocument::Node {
+    std::string text;
+    size_t newlines = 0;    // In `text`
+    size_t bytes = 0;       // In this subtree
+    size_t lines = 0;       // Newlines in this subtree
+    uint32_t priority = 0;  // Max-heap order keeps the tree balanced
+    std::unique_ptr<Node> left;
+    std::unique_ptr<Node> right;
+};
+
+using NodePtr = std::unique_ptr<TextDocument::Node>;
+
+static size_t bytes_of(const NodePtr& n) { return n ? n->bytes : 0; }
+static size_t lines_of(const NodePtr& n) { return n ? n->lines : 0; }
+
+static void update(TextDocument::Node* n) {
+    n->bytes = bytes_of(n->left) + n->text.size() + bytes_of(n->right);
+    n->lines = lines_of(n->left) + n->newlines + lines_of(n->right);
+}
+
+static NodePtr make_node(std::string_view text, uint32_t priority) {
+    auto n = std::make_unique<TextDocument::Node>();
+    n->text.assign(text);
+    n->newlines = count_newlines(text);
+    n->priority = priority;
+    update(n.get());
+    return n;
+}
+
+static NodePtr merge(NodePtr a, NodePtr b) {
+    if (!a) return b;
+    if (!b) return a;
+    if (a->priority > b->priority) {
+        a->right = merge(std::move(a->right), std::move(b));
+        update(a.get());
+        return a;
+    }
+    b->left = merge(std::move(a), std::move(b->left));
+    update(b.get());
+    return b;
+}
+
+// Splits `t` so that `l` holds its first `offset` bytes, cutting a chunk if needed
+static void split(NodePtr t, size_t offset, NodePtr& l, NodePtr& r) {
+    if (!t) {
+        l.reset();
+        r.reset();
+        return;
+    }
+    size_t lb = bytes_of(t->left);
+    size_t here = t->text.size();
+    if (offset <= lb) {
+        split(std::move(t->left), offset, l, t->left);
+        update(t.get());
+        r = std::move(t);
+    } else if (offset >= lb + here) {
+        split(std::move(t->right), offset - lb - here, t->right, r);
+        update(t.get());
+        l = std::move(t);
+    } else {
+        // The tail keeps t's priority, so it may adopt t's right subtree
+        size_t cut = offset - lb;
+        NodePtr tail = make_node(std::string_view(t->text).substr(cut), t->priority);
+        tail->right = std::move(t->right);
+        update(tail.get());
+        t->text.resize(cut);
+        t->newlines = count_newlines(t->text);
+        update(t.get());
+        l = std::move(t);
+        r = std::move(tail);
+    }
+}
+
+static NodePtr build(std::string_view text) {
+    NodePtr result;
+    for (size_t pos = 0; pos < text.size(); pos += kMaxChunk) {
+        result = merge(std::move(result), make_node(text.substr(pos, kMaxChunk), next_priority()));
+    }
+    return result;
+}
+
+// Applies the edit inside a single chunk when the range does not cross one
+static bool edit_in_place(TextDocument::Node* n, size_t offset, size_t len, std::string_view text) {
+    size_t lb = bytes_of(n->left);
+    size_t here = n->text.size();
+    bool done = false;
+    if (n->left && offset + len <= lb) {
+        done = edit_in_place(n->left.get(), offset, len, text);
+    } else if (offset >= lb && offset + len <= lb + here) {
+        if (here - len + text.size() > 2 * kMaxChunk) return false;
+        size_t cut = offset - lb;
+        n->newlines -= count_newlines(std::string_view(n->text).substr(cut, len));
+        n->newlines += count_newlines(text);
+        n->text.replace(cut, len, text.data(), text.size());
+        done = true;
+    } else if (n->right && offset >= lb + here) {
+        done = edit_in_place(n->right.get(), offset - lb - here, len, text);
+    }
+    if (done) update(n);
+    return done;
+}
+
+static void collect(const TextDocument::Node* n, size_t base, size_t begin, size_t end, std::string& out) {
+    if (!n || begin >= base + n->bytes || end <= base) return;
+    collect(n->left.get(), base, begin, end, out);
+    size_t start = base + bytes_of(n->left);
+    size_t from = std::max(begin, start);
+    size_t to = std::min(end, start + n->text.size());
+    if (from < to) out.append(n->text, from - start, to - from);
+    collect(n->right.get(), start + n->text.size(), begin, end, out);
+}
+
+TextDocument::TextDocument() = default;
+TextDocument::TextDocument(std::string_view text) : root_(build(text)) {}
+TextDocument::TextDocument(TextDocument&&) noexcept = default;
+TextDocument& TextDocument::operator=(TextDocument&&) noexcept = default;
+TextDocument::~TextDocument() = default;
+
+void TextDocument::set_text(std::string_view text) {
+    root_ = build(text);
+}
+
+void TextDocument::replace(size_t begin, size_t end, std::string_view text) {
+    size_t total = size();
+    begin = std::min(begin, total);
+    end = std::min(std::max(end, begin), total);
+    if (begin == end && text.empty()) return;
+
+    if (root_ && edit_in_place(root_.get(), begin, end - begin, text)) return;
+
+    NodePtr before, rest, removed, after;
+    split(std::move(root_), begin, before, rest);
+    split(std::move(rest), end - begin, removed, after);
+    root_ = merge(merge(std::move(before), build(text)), std::move(after));
+}
+
+size_t TextDocument::size() const {
+    return bytes_of(root_);
+}
+
+int TextDocument::line_count() const {
+    return static_cast<int>(lines_of(root_)) + 1;
+}
+
+size_t TextDocument::line_start(int line) const {
+    if (line <= 0) return 0;
+    size_t k = static_cast<size_t>(line);
+    if (k > lines_of(root_)) return size();
+
+    // Find the k-th newline; the line starts just after it
+    const Node* n = root_.get();
+    size_t base = 0;
+    while (n) {
+        if (k <= lines_of(n->left)) {
+            n = n->left.get();
+            continue;
+        }
+        k -= lines_of(n->left);
+        size_t start = base + bytes_of(n->left);
+        if (k <= n->newlines) {
+            size_t pos = 0;
+            for (;; ++pos) {
+                if (n->text[pos] == '\n' && --k == 0) break;
+            }
+            return start + pos + 1;
+        }
+        k -= n->newlines;
+        base = start + n->text.size();
+        n = n->right.get();
+    }
+    return size();
+}
+
+std::string TextDocument::line(int line) const {
+    std::string out;
+    if (line < 0 || line >= line_count()) return out;
+    append_to(out, line_start(line), line_start(line + 1));
+    if (!out.empty() && out.back() == '\n') out.pop_back();
+    if (!out.empty() && out.back() == '\r') out.pop_back();
+    return out;
+}
+
+size_t TextDocument::offset_at(int line, int character) const {
+    if (line < 0) return 0;
+    if (line >= line_count()) return size();
+    return line_start(line) + utf16_to_byte_column(this->line(line), character);
+}
+
+std::string TextDocument::text() const {
+    std::string out;
+    out.reserve(size());
+    append_to(out, 0, size());
+    return out;
+}
+
+void TextDocument::append_to(std::string& out, size_t begin, size_t end) const {
+    collect(root_.get(), 0, begin, end, out);
+}
+
+size_t utf16_to_byte_column(std::string_view line, int character) {
+    size_t i = 0;
+    int units = 0;
+    while (i < line.size() && units < character) {
+        unsigned char c = static_cast<unsigned char>(line[i]);
+        size_t len = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        units += len == 4 ? 2 : 1;  // Astral characters are surrogate pairs
+        i += len;
+    }
+    return std::min(i, line.size());
+}
+
+int byte_to_utf16_column(std::string_view line, size_t byte) {
+    size_t i = 0;
+    int units = 0;
+    byte = std::min(byte, line.size());
+    while (i < byte) {
+        unsigned char c = static_cast<unsigned char>(line[i]);
+        size_t len = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        units += len == 4 ? 2 : 1;
+        i += len;
+    }
+    return units;
+}
+
+} // namespace mana::lsp
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Open-document text for mana-lsp.
+//
+// The text is a rope: a balanced tree (treap keyed by position) of chunks of
+// at most a few KiB. Every node caches the byte length and newline count of
+// its subtree, so an edit at a (line, character) position is located in
+// O(log n) and the line index never has to be rebuilt. Typing inside a chunk
+// edits that chunk in place; larger edits split and re-join the tree.
+
+namespace mana::lsp {
+
+    class TextDocument {
+    public:
+        TextDocument();
+        explicit TextDocument(std::string_view text);
+        TextDocument(TextDocument&&) noexcept;
+        TextDocument& operator=(TextDocument&&) noexcept;
+        ~TextDocument();
+
+        void set_text(std::string_view text);
+
+        // Replaces bytes [begin, end) with `text`; offsets are clamped to size()
+        void replace(size_t begin, size_t end, std::string_view text);
+
+        // Byte offset of an LSP position. `character` counts UTF-16 code units,
+        // as LSP requires; positions past the end of a line clamp to its end.
+        size_t offset_at(int line, int character) const;
+
+        size_t size() const;
+        int line_count() const;
+
+        // Byte offset of the first character of `line` (size() past the end)
+        size_t line_start(int line) const;
+        // Text of `line` without its line terminator
+        std::string line(int line) const;
+        // The whole document, for the lexer
+        std::string text() const;
+        void append_to(std::string& out, size_t begin, size_t end) const;
+
+        int version = 0;
+
+        struct Node;  // Rope node, defined in TextDocument.cpp
+
+    private:
+        std::unique_ptr<Node> root_;
+    };
+
+    // Byte index in `line` of the UTF-16 column `character` (clamped)
+    size_t utf16_to_byte_column(std::string_view line, int character);
+    // UTF-16 column of byte index `byte` in `line`, the inverse of the above
+    int byte_to_utf16_column(std::string_view line, size_t byte);
+
+} // namespace mana::lsp
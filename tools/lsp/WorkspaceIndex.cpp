@@ -0,0 +1,538 @@
+#include "WorkspaceIndex.h"
+#include "../../frontend/Lexer.h"
+#include "../../frontend/Parser.h"
+#include "../common/FileUtil.h"
+#include "../common/Parallel.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace mana::lsp {
+
+namespace {
+
+constexpr char kIndexMagic[8] = {'M', 'A', 'N', 'A', 'I', 'D', 'X', '1'};
+
+uint64_t pack_position(int line, int column) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(line)) << 32) | static_cast<uint32_t>(column);
+}
+
+int packed_line(uint64_t p) { return static_cast<int>(p >> 32); }
+int packed_column(uint64_t p) { return static_cast<int>(p & 0xFFFFFFFFu); }
+
+char ascii_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+bool ends_with(std::string_view s, std::string_view suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string signature(const frontend::AstFuncDecl& fn) {
+    std::string s = "fn ";
+    if (fn.is_method()) s += fn.receiver_type + ".";
+    s += fn.name + "(";
+    for (size_t i = 0; i < fn.params.size(); ++i) {
+        if (i > 0) s += ", ";
+        s += fn.params[i].name + ": " + fn.params[i].type_name;
+    }
+    s += ") -> " + (fn.return_type.empty() ? std::string("void") : fn.return_type);
+    return s;
+}
+
+// Builds the per-file index from a token stream and a (possibly partial) parse
+class FileIndexer {
+public:
+    FileIndexer(const std::vector<frontend::Token>& tokens, FileIndex& out) : tokens_(tokens), out_(out) {}
+
+    void run(const frontend::AstModule* module) {
+        for (const auto& tok : tokens_) {
+            if (tok.kind == frontend::TokenKind::Identifier) {
+                out_.occurrences[tok.lexeme].push_back(pack_position(tok.line - 1, tok.column - 1));
+            }
+        }
+        if (!module) return;
+        out_.module = module->name;
+
+        for (const auto& decl : module->decls) {
+            if (auto* use = dynamic_cast<frontend::AstUseDecl*>(decl.get())) {
+                out_.imports.push_back(use->module_path);
+            } else if (auto* imp = dynamic_cast<frontend::AstImportDecl*>(decl.get())) {
+                out_.imports.push_back(imp->name);
+            } else if (auto* fn = dynamic_cast<frontend::AstFuncDecl*>(decl.get())) {
+                add_function(*fn, fn->receiver_type);
+            } else if (auto* st = dynamic_cast<frontend::AstStructDecl*>(decl.get())) {
+                add(st->name, "", "struct " + st->name, SymbolKind::Struct, st->line, st->column, st->is_pub);
+                for (const auto& field : st->fields) {
+                    add(field.name, st->name, field.name + ": " + field.type_name, SymbolKind::Field,
+                        field.line, field.column, st->is_pub);
+                }
+            } else if (auto* en = dynamic_cast<frontend::AstEnumDecl*>(decl.get())) {
+                add(en->name, "", "enum " + en->name, SymbolKind::Enum, en->line, en->column, en->is_pub);
+                for (const auto& variant : en->variants) {
+                    add(variant.name, en->name, en->name + "::" + variant.name, SymbolKind::EnumMember,
+                        variant.line ? variant.line : en->line, variant.line ? variant.column : en->column, en->is_pub);
+                }
+            } else if (auto* tr = dynamic_cast<frontend::AstTraitDecl*>(decl.get())) {
+                add(tr->name, "", "trait " + tr->name, SymbolKind::Interface, tr->line, tr->column, tr->is_pub);
+                for (const auto& method : tr->methods) {
+                    add(method.name, tr->name, "fn " + tr->name + "." + method.name, SymbolKind::Method,
+                        method.line, method.column, tr->is_pub);
+                }
+            } else if (auto* impl = dynamic_cast<frontend::AstImplDecl*>(decl.get())) {
+                for (const auto& method : impl->methods) {
+                    add_function(*method, impl->type_name);
+                }
+            } else if (auto* alias = dynamic_cast<frontend::AstTypeAliasDecl*>(decl.get())) {
+                add(alias->alias_name, "", "type " + alias->alias_name + " = " + alias->target_type,
+                    SymbolKind::TypeParameter, alias->line, alias->column, alias->is_pub);
+            } else if (auto* global = dynamic_cast<frontend::AstGlobalVarDecl*>(decl.get())) {
+                if (global->var) {
+                    std::string detail = "let " + global->var->name;
+                    if (!global->var->type_name.empty()) detail += ": " + global->var->type_name;
+                    add(global->var->name, "", detail, SymbolKind::Variable, global->line, global->column, false);
+                }
+            }
+        }
+    }
+
+private:
+    void add_function(const frontend::AstFuncDecl& fn, const std::string& container) {
+        add(fn.name, container, signature(fn), container.empty() ? SymbolKind::Function : SymbolKind::Method,
+            fn.line, fn.column, fn.is_pub);
+    }
+
+    void add(const std::string& name, const std::string& container, std::string detail,
+             SymbolKind kind, int line, int column, bool is_public) {
+        if (name.empty()) return;
+        IndexedSymbol sym;
+        sym.name = name;
+        sym.container = container;
+        sym.detail = std::move(detail);
+        sym.kind = kind;
+        sym.is_public = is_public;
+        locate(name, line, column, sym);
+        out_.symbols.push_back(std::move(sym));
+    }
+
+    // AST positions point at the start of a declaration; use the name token
+    void locate(const std::string& name, int line, int column, IndexedSymbol& sym) const {
+        auto it = std::lower_bound(tokens_.begin(), tokens_.end(), std::make_pair(line, column),
+            [](const frontend::Token& t, const std::pair<int, int>& pos) {
+                return t.line < pos.first || (t.line == pos.first && t.column < pos.second);
+            });
+        for (int i = 0; i < 16 && it != tokens_.end(); ++i, ++it) {
+            if (it->kind == frontend::TokenKind::Identifier && it->lexeme == name) {
+                sym.line = it->line - 1;
+                sym.column = it->column - 1;
+                return;
+            }
+        }
+        sym.line = std::max(0, line - 1);
+        sym.column = std::max(0, column - 1);
+    }
+
+    const std::vector<frontend::Token>& tokens_;
+    FileIndex& out_;
+};
+
+std::shared_ptr<FileIndex> index_tokens(const std::string& uri, const std::vector<frontend::Token>& tokens,
+                                        const frontend::AstModule* module) {
+    auto index = std::make_shared<FileIndex>();
+    index->uri = uri;
+    FileIndexer(tokens, *index).run(module);
+    return index;
+}
+
+std::shared_ptr<FileIndex> index_file(const fs::path& path, uint64_t size, int64_t mtime) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return nullptr;
+    std::ostringstream ss;
+    ss << in.rdbuf();
+
+    frontend::Lexer lexer(ss.str());
+    auto tokens = lexer.tokenize();
+    frontend::DiagnosticEngine diag;
+    frontend::Parser parser(tokens, diag);
+    auto module = parser.parse_module();
+
+    auto index = index_tokens(path_to_uri(path.string()), tokens, module.get());
+    index->file_size = size;
+    index->mtime = mtime;
+    return index;
+}
+
+// Binary encoding for the persisted index
+class Encoder {
+public:
+    explicit Encoder(std::string& out) : out_(out) {}
+    void u8(uint8_t v) { out_.push_back(static_cast<char>(v)); }
+    void u32(uint32_t v) { out_.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    void u64(uint64_t v) { out_.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    void str(std::string_view s) { u32(static_cast<uint32_t>(s.size())); out_.append(s.data(), s.size()); }
+
+private:
+    std::string& out_;
+};
+
+class Decoder {
+public:
+    Decoder(const char* data, size_t size) : p_(data), end_(data + size) {}
+    bool ok() const { return ok_; }
+    uint8_t u8() { uint8_t v = 0; take(&v, sizeof(v)); return v; }
+    uint32_t u32() { uint32_t v = 0; take(&v, sizeof(v)); return v; }
+    uint64_t u64() { uint64_t v = 0; take(&v, sizeof(v)); return v; }
+    std::string str() {
+        uint32_t n = u32();
+        if (!ok_ || static_cast<size_t>(end_ - p_) < n) { ok_ = false; return {}; }
+        std::string s(p_, n);
+        p_ += n;
+        return s;
+    }
+
+private:
+    void take(void* dst, size_t n) {
+        if (!ok_ || static_cast<size_t>(end_ - p_) < n) { ok_ = false; return; }
+        std::memcpy(dst, p_, n);
+        p_ += n;
+    }
+
+    const char* p_;
+    const char* end_;
+    bool ok_ = true;
+};
+
+// Editors percent-encode differently (e.g. "c%3A"); key files by one spelling
+std::string normalize_uri(const std::string& uri) {
+    return uri.rfind("file://", 0) == 0 ? path_to_uri(uri_to_path(uri)) : uri;
+}
+
+std::string index_path(const std::string& root) {
+    return (fs::path(root) / ".mana_cache" / "lsp-index.bin").string();
+}
+
+} // namespace
+
+void WorkspaceIndex::build(const std::string& root, unsigned threads) {
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        root_ = root;
+    }
+    load(index_path(root));
+
+    struct Candidate {
+        fs::path path;
+        std::string uri;
+        uint64_t size;
+        int64_t mtime;
+    };
+    std::vector<Candidate> stale;
+    std::unordered_map<std::string, bool> present;
+
+    std::error_code ec;
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+    for (; !ec && it != end; it.increment(ec)) {
+        const fs::path& path = it->path();
+        if (tools::is_hidden_dir(*it)) {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (!it->is_regular_file(ec) || path.extension() != ".mana") continue;
+
+        uint64_t size = static_cast<uint64_t>(it->file_size(ec));
+        int64_t mtime = static_cast<int64_t>(it->last_write_time(ec).time_since_epoch().count());
+        std::string uri = path_to_uri(path.string());
+        present[uri] = true;
+
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto existing = files_.find(uri);
+        if (existing != files_.end() && existing->second->file_size == size && existing->second->mtime == mtime) {
+            continue;
+        }
+        stale.push_back({path, std::move(uri), size, mtime});
+    }
+
+    std::vector<std::shared_ptr<FileIndex>> results(stale.size());
+    tools::parallel_for(stale.size(), threads, [&](size_t i) {
+        results[i] = index_file(stale[i].path, stale[i].size, stale[i].mtime);
+    });
+
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (auto f = files_.begin(); f != files_.end();) {
+            if (!f->second->from_buffer && !present.count(f->first)) f = files_.erase(f);
+            else ++f;
+        }
+        for (auto& result : results) {
+            if (!result) continue;
+            auto& slot = files_[result->uri];
+            // An open document's buffer is newer than the file on disk
+            if (slot && slot->from_buffer) continue;
+            slot = std::move(result);
+        }
+    }
+    save();
+}
+
+void WorkspaceIndex::update(const std::string& uri, const std::vector<frontend::Token>& tokens,
+                            const frontend::AstModule* module) {
+    auto index = index_tokens(normalize_uri(uri), tokens, module);
+    index->from_buffer = true;
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    files_[index->uri] = std::move(index);
+}
+
+bool WorkspaceIndex::save() const {
+    std::string data(kIndexMagic, sizeof(kIndexMagic));
+    Encoder enc(data);
+    std::string path;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (root_.empty()) return false;
+        path = index_path(root_);
+
+        uint32_t count = 0;
+        for (const auto& [uri, f] : files_) count += f->from_buffer ? 0 : 1;
+        enc.u32(count);
+        for (const auto& [uri, f] : files_) {
+            // Buffer contents may differ from disk; those files re-index on load
+            if (f->from_buffer) continue;
+            enc.str(f->uri);
+            enc.str(f->module);
+            enc.u64(f->file_size);
+            enc.u64(static_cast<uint64_t>(f->mtime));
+            enc.u32(static_cast<uint32_t>(f->imports.size()));
+            for (const auto& imp : f->imports) enc.str(imp);
+            enc.u32(static_cast<uint32_t>(f->symbols.size()));
+            for (const auto& s : f->symbols) {
+                enc.str(s.name);
+                enc.str(s.container);
+                enc.str(s.detail);
+                enc.u8(static_cast<uint8_t>(s.kind));
+                enc.u32(static_cast<uint32_t>(s.line));
+                enc.u32(static_cast<uint32_t>(s.column));
+                enc.u8(s.is_public ? 1 : 0);
+            }
+            enc.u32(static_cast<uint32_t>(f->occurrences.size()));
+            for (const auto& [name, positions] : f->occurrences) {
+                enc.str(name);
+                enc.u32(static_cast<uint32_t>(positions.size()));
+                for (uint64_t p : positions) enc.u64(p);
+            }
+        }
+    }
+
+    return tools::write_file_atomic(path, data);
+}
+
+bool WorkspaceIndex::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    std::string data = ss.str();
+    if (data.size() < sizeof(kIndexMagic) || std::memcmp(data.data(), kIndexMagic, sizeof(kIndexMagic)) != 0) {
+        return false;
+    }
+
+    Decoder dec(data.data() + sizeof(kIndexMagic), data.size() - sizeof(kIndexMagic));
+    std::vector<std::shared_ptr<FileIndex>> loaded;
+    uint32_t count = dec.u32();
+    for (uint32_t i = 0; i < count && dec.ok(); ++i) {
+        auto f = std::make_shared<FileIndex>();
+        f->uri = dec.str();
+        f->module = dec.str();
+        f->file_size = dec.u64();
+        f->mtime = static_cast<int64_t>(dec.u64());
+        uint32_t imports = dec.u32();
+        for (uint32_t j = 0; j < imports && dec.ok(); ++j) f->imports.push_back(dec.str());
+        uint32_t symbols = dec.u32();
+        for (uint32_t j = 0; j < symbols && dec.ok(); ++j) {
+            IndexedSymbol s;
+            s.name = dec.str();
+            s.container = dec.str();
+            s.detail = dec.str();
+            s.kind = static_cast<SymbolKind>(dec.u8());
+            s.line = static_cast<int>(dec.u32());
+            s.column = static_cast<int>(dec.u32());
+            s.is_public = dec.u8() != 0;
+            f->symbols.push_back(std::move(s));
+        }
+        uint32_t names = dec.u32();
+        for (uint32_t j = 0; j < names && dec.ok(); ++j) {
+            std::string name = dec.str();
+            uint32_t n = dec.u32();
+            auto& positions = f->occurrences[std::move(name)];
+            for (uint32_t k = 0; k < n && dec.ok(); ++k) positions.push_back(dec.u64());
+        }
+        loaded.push_back(std::move(f));
+    }
+    // A truncated or corrupt file is ignored as a whole
+    if (!dec.ok()) return false;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (auto& f : loaded) {
+        auto& slot = files_[f->uri];
+        if (!slot || !slot->from_buffer) slot = std::move(f);
+    }
+    return true;
+}
+
+bool WorkspaceIndex::imports_module(const FileIndex& file, const std::string& module) const {
+    if (module.empty()) return false;
+    for (const auto& imp : file.imports) {
+        if (imp == module || ends_with(imp, "::" + module)) return true;
+    }
+    return false;
+}
+
+std::vector<SymbolLocation> WorkspaceIndex::definitions(std::string_view name, const std::string& from) const {
+    std::vector<std::pair<int, SymbolLocation>> ranked;
+    std::string key(name);
+    std::string from_uri = normalize_uri(from);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto importer = files_.find(from_uri);
+    for (const auto& [uri, f] : files_) {
+        // A declared name is always among the file's identifiers
+        if (!f->occurrences.count(key)) continue;
+        int rank = uri == from_uri ? 0 : (importer != files_.end() && imports_module(*importer->second, f->module)) ? 1 : 2;
+        for (const auto& s : f->symbols) {
+            if (s.name != name) continue;
+            ranked.push_back({rank, {uri, s.line, s.column, static_cast<int>(s.name.size())}});
+        }
+    }
+    lock.unlock();
+
+    std::stable_sort(ranked.begin(), ranked.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<SymbolLocation> out;
+    out.reserve(ranked.size());
+    for (auto& r : ranked) out.push_back(std::move(r.second));
+    return out;
+}
+
+std::vector<SymbolLocation> WorkspaceIndex::references(std::string_view name) const {
+    std::vector<SymbolLocation> out;
+    std::string key(name);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& [uri, f] : files_) {
+        auto it = f->occurrences.find(key);
+        if (it == f->occurrences.end()) continue;
+        for (uint64_t p : it->second) {
+            out.push_back({uri, packed_line(p), packed_column(p), static_cast<int>(name.size())});
+        }
+    }
+    return out;
+}
+
+std::vector<WorkspaceSymbol> WorkspaceIndex::search(std::string_view query, size_t limit) const {
+    std::string q(query);
+    for (char& c : q) c = ascii_lower(c);
+
+    // 0 = prefix, 1 = substring, 2 = subsequence, -1 = no match
+    auto score = [&q](const std::string& name) -> int {
+        // Every match is a subsequence, and that single pass rejects most names
+        size_t qi = 0;
+        for (size_t i = 0; i < name.size() && qi < q.size(); ++i) {
+            if (ascii_lower(name[i]) == q[qi]) qi++;
+        }
+        if (qi < q.size()) return -1;
+        for (size_t start = 0; start + q.size() <= name.size(); ++start) {
+            size_t k = 0;
+            while (k < q.size() && ascii_lower(name[start + k]) == q[k]) k++;
+            if (k == q.size()) return start == 0 ? 0 : 1;
+        }
+        return 2;
+    };
+
+    struct Match {
+        int score;
+        const IndexedSymbol* symbol;
+        const std::string* uri;
+    };
+    std::vector<Match> matches;
+    std::vector<WorkspaceSymbol> out;
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& [uri, f] : files_) {
+        for (const auto& s : f->symbols) {
+            int sc = score(s.name);
+            if (sc >= 0) matches.push_back({sc, &s, &uri});
+        }
+    }
+
+    size_t n = std::min(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + static_cast<std::ptrdiff_t>(n), matches.end(),
+        [](const Match& a, const Match& b) {
+            if (a.score != b.score) return a.score < b.score;
+            return a.symbol->name.size() < b.symbol->name.size();
+        });
+    out.reserve(n);
+    for (size_t i = 0; i < n; ++i) out.push_back({*matches[i].symbol, *matches[i].uri});
+    return out;
+}
+
+std::vector<IndexedSymbol> WorkspaceIndex::visible_symbols(const std::string& document) const {
+    std::vector<IndexedSymbol> out;
+    std::string uri = normalize_uri(document);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto self = files_.find(uri);
+    if (self == files_.end()) return out;
+
+    out = self->second->symbols;
+    for (const auto& [other_uri, f] : files_) {
+        if (other_uri == uri || !imports_module(*self->second, f->module)) continue;
+        for (const auto& s : f->symbols) {
+            if (s.is_public) out.push_back(s);
+        }
+    }
+    return out;
+}
+
+size_t WorkspaceIndex::file_count() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return files_.size();
+}
+
+std::string path_to_uri(const std::string& path) {
+    std::string generic = fs::path(path).generic_string();
+    std::string uri = "file://";
+    if (generic.size() > 1 && generic[1] == ':') uri += '/';  // file:///C:/...
+    static const char* hex = "0123456789ABCDEF";
+    for (unsigned char c : generic) {
+        if (std::isalnum(c) || std::strchr("/-._~:", c)) {
+            uri += static_cast<char>(c);
+        } else {
+            uri += '%';
+            uri += hex[c >> 4];
+            uri += hex[c & 15];
+        }
+    }
+    return uri;
+}
+
+std::string uri_to_path(std::string_view uri) {
+    if (uri.rfind("file://", 0) == 0) uri.remove_prefix(7);
+    std::string path;
+    for (size_t i = 0; i < uri.size(); ++i) {
+        if (uri[i] == '%' && i + 2 < uri.size() &&
+            std::isxdigit(static_cast<unsigned char>(uri[i + 1])) && std::isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+            path += static_cast<char>(std::stoi(std::string(uri.substr(i + 1, 2)), nullptr, 16));
+            i += 2;
+        } else {
+            path += uri[i];
+        }
+    }
+    if (path.size() > 2 && path[0] == '/' && path[2] == ':') path.erase(0, 1);  // /C:/... on Windows
+    return path;
+}
+
+} // namespace mana::lsp
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mana::frontend {
+    struct AstModule;
+    struct Token;
+}
+
+// Workspace-wide symbol index for mana-lsp.
+//
+// Every .mana file under the workspace root gets a FileIndex: the module it
+// declares, the modules it imports, its declarations, and the positions of
+// every identifier (the reference list). Startup indexing runs across all
+// cores and is persisted to .mana_cache/lsp-index.bin, so a restart only
+// re-indexes files whose size or mtime changed. Open documents are
+// re-indexed from the editor buffer after each analysis.
+
+namespace mana::lsp {
+
+    // Values are LSP SymbolKind numbers
+    enum class SymbolKind : uint8_t {
+        Class = 5, Method = 6, Field = 8, Enum = 10, Interface = 11,
+        Function = 12, Variable = 13, EnumMember = 22, Struct = 23, TypeParameter = 26
+    };
+
+    struct IndexedSymbol {
+        std::string name;
+        std::string container;  // Owning type for methods, fields and variants
+        std::string detail;     // One-line signature
+        SymbolKind kind = SymbolKind::Function;
+        int line = 0;           // 0-based
+        int column = 0;
+        bool is_public = false;
+    };
+
+    struct FileIndex {
+        std::string uri;
+        std::string module;
+        std::vector<std::string> imports;  // Module paths from use/import
+        std::vector<IndexedSymbol> symbols;
+        // Identifier -> packed (line << 32 | column) occurrences, 0-based
+        std::unordered_map<std::string, std::vector<uint64_t>> occurrences;
+        // On-disk stamp when indexed from disk; 0 when indexed from an editor buffer
+        uint64_t file_size = 0;
+        int64_t mtime = 0;
+        bool from_buffer = false;
+    };
+
+    struct SymbolLocation {
+        std::string uri;
+        int line = 0;
+        int column = 0;
+        int length = 0;
+    };
+
+    struct WorkspaceSymbol {
+        IndexedSymbol symbol;
+        std::string uri;
+    };
+
+    class WorkspaceIndex {
+    public:
+        // Loads the persisted index for `root`, re-indexes stale files on
+        // `threads` workers, and saves the result
+        void build(const std::string& root, unsigned threads);
+        bool save() const;
+
+        // Re-index an open document from its current tokens and parse
+        void update(const std::string& uri, const std::vector<frontend::Token>& tokens,
+                    const frontend::AstModule* module);
+
+        // Declarations named `name`: the current file first, then files it
+        // imports, then the rest of the workspace
+        std::vector<SymbolLocation> definitions(std::string_view name, const std::string& from_uri) const;
+        std::vector<SymbolLocation> references(std::string_view name) const;
+        // Case-insensitive subsequence match; prefix matches sort first
+        std::vector<WorkspaceSymbol> search(std::string_view query, size_t limit) const;
+        // Declarations visible from `uri`: its own plus public ones from imported modules
+        std::vector<IndexedSymbol> visible_symbols(const std::string& uri) const;
+
+        size_t file_count() const;
+
+    private:
+        bool load(const std::string& path);
+        bool imports_module(const FileIndex& file, const std::string& module) const;
+
+        mutable std::shared_mutex mutex_;
+        std::unordered_map<std::string, std::shared_ptr<const FileIndex>> files_;  // uri -> index
+        std::string root_;
+    };
+
+    std::string path_to_uri(const std::string& path);
+    std::string uri_to_path(std::string_view uri);
+
+} // namespace mana::lsp
@@ -4,11 +4,20 @@
 #include <sstream>
 #include <cstdlib>
 #include <cstdio>
+#include <cctype>
 #include <sys/stat.h>
 #include <algorithm>
 #include <regex>
 #include <iomanip>
 #include <functional>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include "../common/FileUtil.h"
+#include "../common/Parallel.h"
+#include "../json/Json.h"
+#include "Resolver.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -22,11 +31,101 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <cstring>
 #endif
 
 namespace mana::pkg {
 
-PackageManager::PackageManager() {}
+namespace fs = std::filesystem;
+
+namespace {
+
+// SHA-256 (FIPS 180-4) of archive contents, as lowercase hex
+std::string sha256_hex(const std::string& data) {
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+    uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                     0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    auto rotr = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+
+    std::string msg = data;
+    uint64_t bit_len = static_cast<uint64_t>(data.size()) * 8;
+    msg += static_cast<char>(0x80);
+    while (msg.size() % 64 != 56) msg += '\0';
+    for (int i = 7; i >= 0; --i) msg += static_cast<char>((bit_len >> (i * 8)) & 0xff);
+
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            const auto* b = reinterpret_cast<const unsigned char*>(msg.data() + chunk + i * 4);
+            w[i] = (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) | b[3];
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = hh + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            hh = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+    }
+
+    std::ostringstream out;
+    out << std::hex << std::setfill('0');
+    for (uint32_t v : h) out << std::setw(8) << v;
+    return out.str();
+}
+
+// Package names become directories under deps/, so only plain identifiers
+// (no separators, no leading dot, nothing absolute) are accepted
+bool is_package_name(const std::string& name) {
+    if (name.empty() || name[0] == '.' || name[0] == '-') return false;
+    for (char c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.') return false;
+    }
+    return name.find("..") == std::string::npos;
+}
+
+// Checksums name store directories: "sha256:" and 64 lowercase hex digits
+bool is_store_checksum(const std::string& checksum) {
+    const std::string prefix = "sha256:";
+    if (checksum.size() != prefix.size() + 64 || checksum.compare(0, prefix.size(), prefix) != 0) return false;
+    for (size_t i = prefix.size(); i < checksum.size(); ++i) {
+        char c = checksum[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+    }
+    return true;
+}
+
+// Splits a lockfile dependency entry "name constraint"
+Dependency parse_locked_requirement(const std::string& entry) {
+    Dependency dep;
+    size_t space = entry.find(' ');
+    dep.name = entry.substr(0, space);
+    dep.version = space == std::string::npos ? "*" : entry.substr(space + 1);
+    dep.source = "registry";
+    return dep;
+}
+
+} // namespace
+
+PackageManager::PackageManager() {
+    // Points installs at a mirror or a local stand-in registry
+    if (const char* registry = getenv("MANA_REGISTRY")) {
+        registry_url_ = registry;
+    }
+}
 
 bool PackageManager::create_directory(const std::string& path) {
     #ifdef _WIN32
@@ -701,19 +800,12 @@ int PackageManager::remove(const std::string& name) {
     return 1;
 }
 
-int PackageManager::update() {
-    if (!load_package()) {
-        return 1;
-    }
-
-    std::cout << "Updating dependencies for " << package_.name << "\n";
-
-    // TODO: Actually fetch and update dependencies
-    for (const auto& dep : package_.dependencies) {
-        std::cout << "  " << dep.name << ": " << dep.version << " (up to date)\n";
-    }
-
-    return 0;
+int PackageManager::update(const InstallOptions& options) {
+    // Same as install, but the lockfile is re-resolved from package.toml
+    InstallOptions update_options = options;
+    update_options.update = true;
+    update_options.frozen = false;
+    return install(update_options);
 }
 
 int PackageManager::publish() {
@@ -843,7 +935,7 @@ int PackageManager::info(const std::string& package_name) {
     return 0;
 }
 
-int PackageManager::install() {
+int PackageManager::install(const InstallOptions& options) {
     if (!load_package()) {
         return 1;
     }
@@ -855,34 +947,97 @@ int PackageManager::install() {
         return 0;
     }
 
-    // Create cache directory
-    std::string cache_dir = get_cache_dir();
-    create_directory(cache_dir);
+    auto start = std::chrono::steady_clock::now();
+    int jobs = options.jobs > 0 ? options.jobs : 8;
 
-    // Resolve all dependencies
-    auto resolved = resolve_dependencies();
+    std::error_code ec;
+    fs::create_directories(get_cache_dir() + "/store", ec);
 
-    if (resolved.empty() && !package_.dependencies.empty()) {
-        std::cerr << "Failed to resolve dependencies.\n";
-        return 1;
+    // A current lockfile pins every version and checksum, so the registry
+    // is only asked for archives missing from the store
+    std::vector<ResolvedDep> resolved;
+    bool locked = !options.update && read_lockfile(resolved) && lockfile_satisfies(resolved);
+    if (!locked) {
+        if (options.frozen) {
+            std::cerr << "Error: mana.lock is missing or out of date with package.toml\n";
+            return 1;
+        }
+        resolved.clear();
+        if (!resolve_dependencies(resolved, jobs)) {
+            return 1;
+        }
     }
 
-    int installed = 0;
+    // Names and checksums from mana.lock or the registry become paths under
+    // deps/ and the store, so a corrupt or malicious entry stops the install
     for (const auto& dep : resolved) {
-        if (is_package_cached(dep.name, dep.version)) {
-            std::cout << "  " << dep.name << "@" << dep.version << " (cached)\n";
+        if (!is_package_name(dep.name)) {
+            std::cerr << "Error: invalid package name '" << dep.name << "'"
+                      << (locked ? " in mana.lock" : "") << "\n";
+            return 1;
+        }
+        if (!dep.checksum.empty() && !is_store_checksum(dep.checksum)) {
+            std::cerr << "Error: invalid checksum '" << dep.checksum << "' for " << dep.name
+                      << (locked ? " in mana.lock" : "") << "\n";
+            return 1;
+        }
+    }
+
+    // Download missing archives in parallel
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < resolved.size(); ++i) {
+        if (resolved[i].checksum.empty() || !is_in_store(resolved[i].checksum)) {
+            missing.push_back(i);
+        }
+    }
+    std::vector<std::string> errors(missing.size());
+    tools::parallel_for(missing.size(), tools::job_count(jobs), [&](size_t k) {
+        download_package(resolved[missing[k]], errors[k]);
+    });
+
+    bool failed = false;
+    for (size_t k = 0; k < missing.size(); ++k) {
+        const auto& dep = resolved[missing[k]];
+        if (!errors[k].empty()) {
+            std::cerr << "  Failed to download " << dep.name << "@" << dep.version << ": " << errors[k] << "\n";
+            failed = true;
         } else {
-            std::cout << "  Downloading " << dep.name << "@" << dep.version << "...\n";
-            if (download_package(dep.name, dep.version)) {
-                installed++;
-            } else {
-                std::cerr << "  Failed to download " << dep.name << "\n";
-            }
+            std::cout << "  Downloaded " << dep.name << "@" << dep.version << "\n";
+        }
+    }
+    if (failed) {
+        return 1;
+    }
+
+    // Link every package from the store into deps/
+    const std::string deps_dir = "deps";
+    fs::create_directories(deps_dir, ec);
+    for (const auto& dep : resolved) {
+        if (!link_from_store(dep, deps_dir)) {
+            std::cerr << "  Failed to link " << dep.name << "@" << dep.version << " into " << deps_dir << "\n";
+            return 1;
+        }
+    }
+
+    // Drop packages installed earlier that are no longer dependencies
+    std::set<std::string> names;
+    for (const auto& dep : resolved) names.insert(dep.name);
+    for (const auto& entry : fs::directory_iterator(deps_dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (!names.count(name) && file_exists((entry.path() / ".mana-checksum").string())) {
+            fs::remove_all(entry.path(), ec);
         }
     }
 
-    std::cout << "\nInstalled " << installed << " new packages, "
-              << (resolved.size() - installed) << " from cache.\n";
+    if (!locked && !write_lockfile(resolved)) {
+        std::cerr << "Warning: could not write mana.lock\n";
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "\nInstalled " << resolved.size() << " packages ("
+              << missing.size() << " downloaded, " << (resolved.size() - missing.size())
+              << " from store) in " << elapsed << " ms.\n";
     return 0;
 }
 
@@ -927,84 +1082,86 @@ std::string PackageManager::get_cache_dir() const {
 
 std::optional<RegistryPackage> PackageManager::fetch_package_info(const std::string& name) {
     std::string url = registry_url_ + "/api/v1/packages/" + url_encode(name);
-    std::string response = http_get(url);
+    std::string response = fetch(url);
 
     if (response.empty()) {
         return std::nullopt;
     }
 
-    // Simple JSON parsing (production would use a proper JSON library)
-    RegistryPackage pkg;
-    pkg.name = name;
-
-    // Parse "version": "x.y.z"
-    std::regex version_re("\"version\"\\s*:\\s*\"([^\"]+)\"");
-    std::smatch match;
-    if (std::regex_search(response, match, version_re)) {
-        pkg.latest_version = match[1];
-    }
-
-    // Parse "description": "..."
-    std::regex desc_re("\"description\"\\s*:\\s*\"([^\"]+)\"");
-    if (std::regex_search(response, match, desc_re)) {
-        pkg.description = match[1];
-    }
-
-    // Parse "downloads": N
-    std::regex dl_re("\"downloads\"\\s*:\\s*(\\d+)");
-    if (std::regex_search(response, match, dl_re)) {
-        pkg.downloads = std::stoi(match[1]);
-    }
-
-    // Parse "license": "..."
-    std::regex lic_re("\"license\"\\s*:\\s*\"([^\"]+)\"");
-    if (std::regex_search(response, match, lic_re)) {
-        pkg.license = match[1];
+    json::Document doc;
+    if (!doc.parse(response)) {
+        return std::nullopt;
     }
+    json::Value root = doc.root();
 
-    // Parse versions array
-    std::regex ver_re("\"versions\"\\s*:\\s*\\[([^\\]]+)\\]");
-    if (std::regex_search(response, match, ver_re)) {
-        std::string versions_str = match[1];
-        std::regex ver_item_re("\"([^\"]+)\"");
-        std::sregex_iterator it(versions_str.begin(), versions_str.end(), ver_item_re);
-        std::sregex_iterator end;
-        while (it != end) {
-            pkg.versions.push_back((*it)[1]);
-            ++it;
+    RegistryPackage pkg;
+    pkg.name = name;
+    pkg.latest_version = std::string(root["version"].as_string());
+    pkg.description = std::string(root["description"].as_string());
+    pkg.downloads = static_cast<int>(root["downloads"].as_int());
+    pkg.license = std::string(root["license"].as_string());
+    pkg.repository = std::string(root["repository"].as_string());
+    for (json::Value author : root["authors"]) {
+        pkg.authors.emplace_back(author.as_string());
+    }
+    for (json::Value keyword : root["keywords"]) {
+        pkg.keywords.emplace_back(keyword.as_string());
+    }
+    for (json::Value version : root["versions"]) {
+        pkg.versions.emplace_back(version.as_string());
+    }
+
+    // "dependencies": { "<version>": { "<name>": "<constraint>" } }
+    for (json::Value version : root["dependencies"]) {
+        auto& deps = pkg.dependencies[std::string(version.key())];
+        for (json::Value requirement : version) {
+            Dependency dep;
+            dep.name = std::string(requirement.key());
+            dep.version = std::string(requirement.as_string("*"));
+            dep.source = "registry";
+            deps.push_back(dep);
         }
     }
+    // "checksums": { "<version>": "sha256:<hex>" }
+    for (json::Value checksum : root["checksums"]) {
+        pkg.checksums[std::string(checksum.key())] = std::string(checksum.as_string());
+    }
 
     return pkg;
 }
 
-bool PackageManager::download_package(const std::string& name, const std::string& version) {
-    std::string url = registry_url_ + "/api/v1/packages/" + url_encode(name) +
-                      "/versions/" + url_encode(version) + "/download";
+bool PackageManager::download_package(ResolvedDep& dep, std::string& error) {
+    std::string url = dep.url;
+    if (url.empty()) {
+        url = registry_url_ + "/api/v1/packages/" + url_encode(dep.name) +
+              "/versions/" + url_encode(dep.version) + "/download";
+    }
 
-    std::string response = http_get(url);
-    if (response.empty()) {
+    std::string archive = fetch(url);
+    if (archive.empty()) {
+        error = "no response from " + url;
         return false;
     }
 
-    // Save to cache
-    std::string cache_path = get_cached_package_path(name, version);
-
-    // Create directory structure
-    size_t last_slash = cache_path.rfind('/');
-    if (last_slash != std::string::npos) {
-        std::string dir = cache_path.substr(0, last_slash);
-        create_directory(dir);
+    std::string checksum = "sha256:" + sha256_hex(archive);
+    if (!dep.checksum.empty() && dep.checksum != checksum) {
+        error = "checksum mismatch (expected " + dep.checksum + ", got " + checksum + ")";
+        return false;
     }
+    dep.checksum = checksum;
 
-    return write_file(cache_path + ".tar.gz", response);
+    if (!add_to_store(archive, checksum)) {
+        error = "could not unpack the archive into " + get_store_path(checksum);
+        return false;
+    }
+    return true;
 }
 
 std::vector<RegistryPackage> PackageManager::search_registry(const std::string& query) {
     std::vector<RegistryPackage> results;
 
     std::string url = registry_url_ + "/api/v1/search?q=" + url_encode(query);
-    std::string response = http_get(url);
+    std::string response = fetch(url);
 
     if (response.empty()) {
         // Return some mock results for offline/demo mode
@@ -1065,104 +1222,217 @@ bool PackageManager::upload_package(const Package& pkg) {
 // Dependency Resolution
 // ============================================================================
 
-std::vector<ResolvedDep> PackageManager::resolve_dependencies() {
-    std::vector<ResolvedDep> resolved;
-    std::set<std::string> visited;
-
-    std::function<void(const std::vector<Dependency>&)> resolve_recursive;
-    resolve_recursive = [&](const std::vector<Dependency>& deps) {
-        for (const auto& dep : deps) {
-            std::string key = dep.name + "@" + dep.version;
-            if (visited.count(key)) continue;
-            visited.insert(key);
-
-            ResolvedDep rdep;
-            rdep.name = dep.name;
-
-            // Fetch info to get exact version
-            auto pkg_info = fetch_package_info(dep.name);
-            if (pkg_info.has_value()) {
-                rdep.version = find_best_version(pkg_info->versions, dep.version);
-                if (rdep.version.empty()) {
-                    rdep.version = pkg_info->latest_version;
-                }
-                rdep.url = registry_url_ + "/api/v1/packages/" + dep.name +
-                          "/versions/" + rdep.version + "/download";
-            } else {
-                rdep.version = dep.version;
-            }
-
-            resolved.push_back(rdep);
-
-            // Resolve transitive dependencies
-            // (In production, fetch package manifest and recurse)
-        }
-    };
+bool PackageManager::resolve_dependencies(std::vector<ResolvedDep>& resolved, int jobs) {
+    // The resolver asks for metadata in batches (a package's dependencies,
+    // prefetched breadth first); each batch is fetched in parallel
+    Resolver resolver([&](const std::vector<std::string>& names,
+                          std::vector<std::optional<RegistryPackage>>& out) {
+        tools::parallel_for(names.size(), tools::job_count(jobs), [&](size_t i) {
+            out[i] = fetch_package_info(names[i]);
+        });
+    });
+
+    if (!resolver.resolve(package_.name, package_.dependencies)) {
+        std::cerr << "Error: no versions satisfy the dependencies of " << package_.name << ":\n";
+        std::istringstream lines(resolver.error());
+        std::string line;
+        while (std::getline(lines, line)) std::cerr << "  " << line << "\n";
+        return false;
+    }
 
-    resolve_recursive(package_.dependencies);
-    return resolved;
+    for (ResolvedDep dep : resolver.solution()) {
+        dep.url = registry_url_ + "/api/v1/packages/" + url_encode(dep.name) +
+                  "/versions/" + url_encode(dep.version) + "/download";
+        resolved.push_back(std::move(dep));
+    }
+    return true;
 }
 
 bool PackageManager::check_version_compatible(const std::string& required, const std::string& available) {
-    if (required == "*" || required.empty()) return true;
-    if (required == available) return true;
+    return version_matches(required, available);
+}
+
+// ============================================================================
+// Cache Management
+// ============================================================================
 
-    // Handle ^x.y.z (compatible with)
-    if (required[0] == '^') {
-        std::string req = required.substr(1);
-        // Parse major version
-        size_t dot = req.find('.');
-        std::string req_major = (dot != std::string::npos) ? req.substr(0, dot) : req;
-        dot = available.find('.');
-        std::string avail_major = (dot != std::string::npos) ? available.substr(0, dot) : available;
-        return req_major == avail_major;
+bool PackageManager::read_lockfile(std::vector<ResolvedDep>& locked, const std::string& path) {
+    std::string content = read_file(path);
+    if (content.empty()) {
+        return false;
     }
 
-    // Handle ~x.y.z (approximately)
-    if (required[0] == '~') {
-        std::string req = required.substr(1);
-        // Match major.minor
-        size_t dot1 = req.find('.');
-        size_t dot2 = (dot1 != std::string::npos) ? req.find('.', dot1 + 1) : std::string::npos;
-        std::string req_prefix = (dot2 != std::string::npos) ? req.substr(0, dot2) : req;
+    std::istringstream stream(content);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        if (line == "[[package]]") {
+            locked.emplace_back();
+            continue;
+        }
 
-        dot1 = available.find('.');
-        dot2 = (dot1 != std::string::npos) ? available.find('.', dot1 + 1) : std::string::npos;
-        std::string avail_prefix = (dot2 != std::string::npos) ? available.substr(0, dot2) : available;
+        size_t eq = line.find(" = ");
+        if (eq == std::string::npos || locked.empty()) continue;
+        std::string key = line.substr(0, eq);
+        std::string value = line.substr(eq + 3);
+        auto& dep = locked.back();
+
+        if (key == "dependencies") {
+            // ["name constraint", ...]
+            size_t pos = 0;
+            while ((pos = value.find('"', pos)) != std::string::npos) {
+                size_t end = value.find('"', pos + 1);
+                if (end == std::string::npos) break;
+                dep.transitive_deps.push_back(parse_locked_requirement(value.substr(pos + 1, end - pos - 1)));
+                pos = end + 1;
+            }
+            continue;
+        }
 
-        return req_prefix == avail_prefix;
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+        if (key == "name") dep.name = value;
+        else if (key == "version") dep.version = value;
+        else if (key == "source") dep.url = value;
+        else if (key == "checksum") dep.checksum = value;
     }
+    return !locked.empty();
+}
+
+bool PackageManager::write_lockfile(const std::vector<ResolvedDep>& resolved, const std::string& path) {
+    std::ostringstream oss;
+    oss << "# Generated by `mana install`. Exact versions and archive checksums of\n";
+    oss << "# every dependency; commit it so installs are reproducible.\n";
+    oss << "version = 1\n";
 
-    // Handle >=x.y.z
-    if (required.substr(0, 2) == ">=") {
-        // Simple numeric comparison (production would use semver library)
-        return available >= required.substr(2);
+    for (const auto& dep : resolved) {
+        oss << "\n[[package]]\n";
+        oss << "name = \"" << dep.name << "\"\n";
+        oss << "version = \"" << dep.version << "\"\n";
+        oss << "source = \"" << dep.url << "\"\n";
+        oss << "checksum = \"" << dep.checksum << "\"\n";
+        if (!dep.transitive_deps.empty()) {
+            oss << "dependencies = [";
+            for (size_t i = 0; i < dep.transitive_deps.size(); ++i) {
+                if (i > 0) oss << ", ";
+                oss << "\"" << dep.transitive_deps[i].name << " " << dep.transitive_deps[i].version << "\"";
+            }
+            oss << "]\n";
+        }
     }
 
-    return required == available;
+    // Replace atomically so a concurrent install never reads half a lockfile
+    return tools::write_file_atomic(path, oss.str());
 }
 
-std::string PackageManager::find_best_version(const std::vector<std::string>& versions,
-                                              const std::string& constraint) {
-    for (auto it = versions.rbegin(); it != versions.rend(); ++it) {
-        if (check_version_compatible(constraint, *it)) {
-            return *it;
+bool PackageManager::lockfile_satisfies(const std::vector<ResolvedDep>& locked) {
+    std::unordered_map<std::string, const ResolvedDep*> by_name;
+    for (const auto& dep : locked) {
+        if (dep.name.empty() || dep.version.empty() || dep.checksum.empty()) return false;
+        by_name[dep.name] = &dep;
+    }
+
+    // Every requirement reachable from package.toml must be locked to a
+    // compatible version, and nothing else may be locked
+    std::set<std::string> reached;
+    std::vector<const Dependency*> pending;
+    for (const auto& dep : package_.dependencies) pending.push_back(&dep);
+    while (!pending.empty()) {
+        const Dependency* dep = pending.back();
+        pending.pop_back();
+        auto it = by_name.find(dep->name);
+        if (it == by_name.end() || !check_version_compatible(dep->version, it->second->version)) {
+            return false;
+        }
+        if (reached.insert(dep->name).second) {
+            for (const auto& next : it->second->transitive_deps) pending.push_back(&next);
         }
     }
-    return "";
+    return reached.size() == by_name.size();
 }
 
-// ============================================================================
-// Cache Management
-// ============================================================================
+std::string PackageManager::get_store_path(const std::string& checksum) const {
+    size_t colon = checksum.find(':');
+    return get_cache_dir() + "/store/" + (colon == std::string::npos ? checksum : checksum.substr(colon + 1));
+}
 
-std::string PackageManager::get_cached_package_path(const std::string& name, const std::string& version) {
-    return get_cache_dir() + "/" + name + "/" + version;
+bool PackageManager::is_in_store(const std::string& checksum) const {
+    if (!is_store_checksum(checksum)) return false;
+    std::error_code ec;
+    return fs::is_directory(get_store_path(checksum), ec);
 }
 
-bool PackageManager::is_package_cached(const std::string& name, const std::string& version) {
-    std::string path = get_cached_package_path(name, version);
-    return file_exists(path) || file_exists(path + ".tar.gz");
+bool PackageManager::add_to_store(const std::string& archive, const std::string& checksum) {
+    if (!is_store_checksum(checksum)) {
+        return false;
+    }
+    if (is_in_store(checksum)) {
+        return true;
+    }
+
+    // Unpack next to the final path, then rename it into place, so a
+    // store entry is either complete or absent
+    static std::atomic<unsigned> counter{0};
+    std::string dest = get_store_path(checksum);
+    std::string tmp = dest + ".tmp" + std::to_string(counter++);
+    std::string archive_path = tmp + ".tar.gz";
+
+    std::error_code ec;
+    fs::create_directories(tmp, ec);
+    {
+        std::ofstream out(archive_path, std::ios::binary);
+        if (!out) return false;
+        out.write(archive.data(), static_cast<std::streamsize>(archive.size()));
+    }
+
+    bool unpacked = run_command("tar -xzf \"" + archive_path + "\" -C \"" + tmp + "\"") == 0;
+    fs::remove(archive_path, ec);
+    if (!unpacked) {
+        fs::remove_all(tmp, ec);
+        return false;
+    }
+
+    fs::rename(tmp, dest, ec);
+    if (ec) {
+        // Another install stored the same archive first
+        fs::remove_all(tmp, ec);
+    }
+    return is_in_store(checksum);
+}
+
+bool PackageManager::link_from_store(const ResolvedDep& dep, const std::string& deps_dir) {
+    // The target is removed before linking; never let it leave deps/
+    if (!is_package_name(dep.name) || !is_in_store(dep.checksum)) {
+        return false;
+    }
+    fs::path target = fs::path(deps_dir) / dep.name;
+    fs::path marker = target / ".mana-checksum";
+    if (read_file(marker.string()) == dep.checksum) {
+        return true;  // Already linked from this store entry
+    }
+
+    std::error_code ec;
+    fs::remove_all(target, ec);
+    fs::create_directories(target, ec);
+
+    // Hard links share the store's copy; fall back to copying across devices
+    fs::path store = get_store_path(dep.checksum);
+    for (auto it = fs::recursive_directory_iterator(store, ec); it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) return false;
+        fs::path out = target / fs::relative(it->path(), store);
+        if (it->is_directory()) {
+            fs::create_directories(out, ec);
+            continue;
+        }
+        fs::create_hard_link(it->path(), out, ec);
+        if (ec) {
+            ec.clear();
+            fs::copy_file(it->path(), out, fs::copy_options::overwrite_existing, ec);
+            if (ec) return false;
+        }
+    }
+    return !ec && write_file(marker.string(), dep.checksum);
 }
 
 void PackageManager::clean_cache() {
@@ -1246,6 +1516,26 @@ std::string PackageManager::url_encode(const std::string& str) {
     return escaped.str();
 }
 
+std::string PackageManager::fetch(const std::string& url) {
+    // file:// registries are a directory tree with the same paths as the
+    // HTTP API; a package's metadata lives in its directory's index.json
+    // since the directory also holds its versions
+    const std::string scheme = "file://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        return http_get(url);
+    }
+    fs::path path = url.substr(scheme.size());
+    std::error_code ec;
+    if (fs::is_directory(path, ec)) {
+        path /= "index.json";
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return "";
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
 #ifdef _WIN32
 std::string PackageManager::http_get(const std::string& url) {
     // Parse URL
@@ -1305,7 +1595,13 @@ std::string PackageManager::http_get(const std::string& url) {
         return "";
     }
 
-    if (!WinHttpReceiveResponse(hRequest, NULL)) {
+    DWORD status = 0;
+    DWORD status_size = sizeof(status);
+    if (!WinHttpReceiveResponse(hRequest, NULL) ||
+        !WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                             WINHTTP_HEADER_NAME_BY_INDEX, &status, &status_size,
+                             WINHTTP_NO_HEADER_INDEX) ||
+        status != 200) {
         WinHttpCloseHandle(hRequest);
         WinHttpCloseHandle(hConnect);
         WinHttpCloseHandle(hSession);
@@ -1434,29 +1730,31 @@ std::string PackageManager::http_get(const std::string& url) {
         ? url.substr(path_start)
         : "/";
 
-    int port = 80;
+    std::string port = "80";
     size_t port_pos = host.find(':');
     if (port_pos != std::string::npos) {
-        port = std::stoi(host.substr(port_pos + 1));
+        port = host.substr(port_pos + 1);
         host = host.substr(0, port_pos);
     }
 
-    // Connect
-    struct hostent* server = gethostbyname(host.c_str());
-    if (!server) return "";
-
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) return "";
+    // Connect (getaddrinfo, unlike gethostbyname, is safe from the
+    // parallel fetch workers)
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addrs = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addrs) != 0) return "";
 
-    struct sockaddr_in server_addr = {};
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    memcpy(&server_addr.sin_addr.s_addr, server->h_addr, server->h_length);
-
-    if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    int sock = -1;
+    for (struct addrinfo* a = addrs; a; a = a->ai_next) {
+        sock = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (sock < 0) continue;
+        if (connect(sock, a->ai_addr, a->ai_addrlen) == 0) break;
         close(sock);
-        return "";
+        sock = -1;
     }
+    freeaddrinfo(addrs);
+    if (sock < 0) return "";
 
     // Send request
     std::string request = "GET " + path + " HTTP/1.1\r\n";
@@ -1468,24 +1766,41 @@ std::string PackageManager::http_get(const std::string& url) {
 
     send(sock, request.c_str(), request.size(), 0);
 
-    // Read response
+    // Read response (archives are binary, so append by length)
     std::string response;
-    char buffer[4096];
+    char buffer[16384];
     ssize_t n;
-    while ((n = recv(sock, buffer, sizeof(buffer) - 1, 0)) > 0) {
-        buffer[n] = '\0';
-        response += buffer;
+    while ((n = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, static_cast<size_t>(n));
     }
 
     close(sock);
 
-    // Extract body
+    // Only a 200 carries a usable body
     size_t body_start = response.find("\r\n\r\n");
-    if (body_start != std::string::npos) {
-        return response.substr(body_start + 4);
+    if (body_start == std::string::npos || response.compare(9, 3, "200") != 0) {
+        return "";
     }
+    std::string headers = response.substr(0, body_start);
+    std::string body = response.substr(body_start + 4);
 
-    return response;
+    std::transform(headers.begin(), headers.end(), headers.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (headers.find("transfer-encoding: chunked") == std::string::npos) {
+        return body;
+    }
+
+    std::string decoded;
+    size_t pos = 0;
+    while (pos < body.size()) {
+        size_t line_end = body.find("\r\n", pos);
+        if (line_end == std::string::npos) break;
+        size_t size = std::strtoul(body.substr(pos, line_end - pos).c_str(), nullptr, 16);
+        if (size == 0) break;
+        decoded.append(body, line_end + 2, size);
+        pos = line_end + 2 + size + 2;
+    }
+    return decoded;
 }
 
 std::string PackageManager::http_post(const std::string& url, const std::string& body) {
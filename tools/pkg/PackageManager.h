@@ -36,7 +36,10 @@ namespace mana::pkg {
         std::string license;
         std::string repository;
         std::vector<std::string> keywords;
-        int downloads;
+        int downloads = 0;
+        // Per version, when the registry publishes them
+        std::unordered_map<std::string, std::vector<Dependency>> dependencies;
+        std::unordered_map<std::string, std::string> checksums;  // "sha256:<hex>" of the archive
     };
 
     // Resolved dependency with full metadata
@@ -44,9 +47,17 @@ namespace mana::pkg {
         std::string name;
         std::string version;
         std::string url;
+        std::string checksum;  // "sha256:<hex>"; empty until the archive is known
         std::vector<Dependency> transitive_deps;
     };
 
+    // Options of `mana install` / `mana update`
+    struct InstallOptions {
+        int jobs = 0;          // Parallel registry requests; 0 = default (8)
+        bool frozen = false;   // Fail instead of re-resolving when mana.lock is missing or stale
+        bool update = false;   // Ignore mana.lock and resolve again
+    };
+
     class PackageManager {
     public:
         PackageManager();
@@ -58,13 +69,18 @@ namespace mana::pkg {
         int test();
         int add(const std::string& dep_spec);
         int remove(const std::string& name);
-        int update();
+        int update(const InstallOptions& options = InstallOptions());
         int publish();
 
         // Registry commands
         int search(const std::string& query);
         int info(const std::string& package_name);
-        int install();  // Install all dependencies
+        // Installs all dependencies into deps/<name>. Exact versions and
+        // archive checksums are pinned in mana.lock; archives are unpacked
+        // once into a content-addressed store (<cache>/store/<sha256>) and
+        // hard-linked into projects, so an install whose lockfile is current
+        // and whose archives are in the store makes no registry requests.
+        int install(const InstallOptions& options = InstallOptions());
         int login(const std::string& token);
         int logout();
 
@@ -98,18 +114,26 @@ namespace mana::pkg {
 
         // Registry operations
         std::optional<RegistryPackage> fetch_package_info(const std::string& name);
-        bool download_package(const std::string& name, const std::string& version);
+        bool download_package(ResolvedDep& dep, std::string& error);
         std::vector<RegistryPackage> search_registry(const std::string& query);
         bool upload_package(const Package& pkg);
 
-        // Dependency resolution
-        std::vector<ResolvedDep> resolve_dependencies();
+        // Dependency resolution (PubGrub, see Resolver.h); metadata is
+        // fetched in parallel batches. Returns false with an explanation
+        // when no set of versions satisfies every constraint.
+        bool resolve_dependencies(std::vector<ResolvedDep>& resolved, int jobs);
         bool check_version_compatible(const std::string& required, const std::string& available);
-        std::string find_best_version(const std::vector<std::string>& versions, const std::string& constraint);
 
-        // Cache management
-        std::string get_cached_package_path(const std::string& name, const std::string& version);
-        bool is_package_cached(const std::string& name, const std::string& version);
+        // Lockfile (mana.lock, sorted by name)
+        bool read_lockfile(std::vector<ResolvedDep>& locked, const std::string& path = "mana.lock");
+        bool write_lockfile(const std::vector<ResolvedDep>& resolved, const std::string& path = "mana.lock");
+        bool lockfile_satisfies(const std::vector<ResolvedDep>& locked);
+
+        // Content-addressed store
+        std::string get_store_path(const std::string& checksum) const;
+        bool is_in_store(const std::string& checksum) const;
+        bool add_to_store(const std::string& archive, const std::string& checksum);
+        bool link_from_store(const ResolvedDep& dep, const std::string& deps_dir);
         void clean_cache();
 
         // Auth
@@ -117,6 +141,7 @@ namespace mana::pkg {
         bool save_auth();
 
         // HTTP helpers (platform-independent)
+        std::string fetch(const std::string& url);  // http_get, or reads a file:// URL
         std::string http_get(const std::string& url);
         std::string http_post(const std::string& url, const std::string& body);
         std::string url_encode(const std::string& str);
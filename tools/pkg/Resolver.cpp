@@ -0,0 +1,825 @@
+#include "Resolver.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <unordered_set>
+
+namespace mana::pkg {
+
+namespace {
+
+size_t word_count(size_t versions) {
+    return (versions + 63) / 64;
+}
+
+void set_bit(std::vector<uint64_t>& bits, size_t i) {
+    bits[i / 64] |= 1ull << (i % 64);
+}
+
+bool test_bit(const std::vector<uint64_t>& bits, size_t i) {
+    return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+size_t count_bits(const std::vector<uint64_t>& bits) {
+    size_t n = 0;
+    for (uint64_t w : bits) {
+        for (; w; w &= w - 1) ++n;
+    }
+    return n;
+}
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+
+// Registry versions oldest first; unparseable ones before the rest
+bool version_less(const std::string& a, const std::string& b) {
+    auto va = SemVer::parse(a);
+    auto vb = SemVer::parse(b);
+    if (va && vb) return *va < *vb || (*va == *vb && a < b);
+    if (va || vb) return !va;
+    return a < b;
+}
+
+} // namespace
+
+// ============================================================================
+// Versions
+// ============================================================================
+
+std::optional<SemVer> SemVer::parse(const std::string& text) {
+    SemVer v;
+    std::string core = trim(text);
+    size_t plus = core.find('+');  // Build metadata does not affect ordering
+    if (plus != std::string::npos) core = core.substr(0, plus);
+    size_t dash = core.find('-');
+    if (dash != std::string::npos) {
+        v.pre = core.substr(dash + 1);
+        core = core.substr(0, dash);
+    }
+
+    int* fields[3] = {&v.major, &v.minor, &v.patch};
+    v.parts = 0;
+    size_t pos = 0;
+    while (v.parts < 3) {
+        size_t end = pos;
+        while (end < core.size() && std::isdigit(static_cast<unsigned char>(core[end]))) ++end;
+        if (end == pos || end - pos > 9) return std::nullopt;
+        *fields[v.parts++] = std::stoi(core.substr(pos, end - pos));
+        if (end == core.size()) return v;
+        if (core[end] != '.') return std::nullopt;
+        pos = end + 1;
+    }
+    return std::nullopt;
+}
+
+bool SemVer::operator<(const SemVer& other) const {
+    if (major != other.major) return major < other.major;
+    if (minor != other.minor) return minor < other.minor;
+    if (patch != other.patch) return patch < other.patch;
+    if (pre.empty() != other.pre.empty()) return !pre.empty();
+    return pre < other.pre;
+}
+
+bool SemVer::operator==(const SemVer& other) const {
+    return major == other.major && minor == other.minor && patch == other.patch && pre == other.pre;
+}
+
+bool version_matches(const std::string& constraint, const std::string& version) {
+    std::string all = trim(constraint);
+    if (all.empty() || all == "*") return true;
+    auto v = SemVer::parse(version);
+
+    size_t start = 0;
+    while (start <= all.size()) {
+        size_t comma = all.find(',', start);
+        std::string part = trim(all.substr(start, comma == std::string::npos ? std::string::npos : comma - start));
+        start = comma == std::string::npos ? all.size() + 1 : comma + 1;
+        if (part.empty() || part == "*") continue;
+
+        size_t n = 0;
+        while (n < part.size() && std::strchr("<>=^~", part[n])) ++n;
+        std::string op = part.substr(0, n);
+        std::string text = trim(part.substr(n));
+        auto bound = SemVer::parse(text);
+        if (!v || !bound) {
+            // Versions that are not semver only match themselves
+            if ((op.empty() || op == "=") && text == version) continue;
+            return false;
+        }
+
+        const SemVer& b = *bound;
+        bool ok = false;
+        if (op == ">=") {
+            ok = !(*v < b);
+        } else if (op == ">") {
+            ok = b < *v;
+        } else if (op == "<=") {
+            ok = !(b < *v);
+        } else if (op == "<") {
+            ok = *v < b;
+        } else if (op == "^" || op == "~") {
+            // ^ allows changes that keep the leftmost non-zero component;
+            // ~ allows patch changes (minor changes for "~1")
+            SemVer upper;
+            if (op == "^" ? (b.major > 0 || b.parts == 1) : b.parts == 1) {
+                upper.major = b.major + 1;
+            } else if (op == "~" || b.minor > 0 || b.parts == 2) {
+                upper.major = b.major;
+                upper.minor = b.minor + 1;
+            } else {
+                upper.patch = b.patch + 1;
+            }
+            ok = !(*v < b) && *v < upper;
+        } else if (op.empty() || op == "=") {
+            ok = *v == b;
+        }
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Metadata
+// ============================================================================
+
+Resolver::Resolver(MetadataFetcher fetch) : fetch_(std::move(fetch)) {}
+
+int Resolver::intern(const std::string& name) {
+    auto it = index_.find(name);
+    if (it != index_.end()) return it->second;
+    int id = static_cast<int>(packages_.size());
+    packages_.emplace_back();
+    packages_.back().name = name;
+    index_.emplace(name, id);
+    return id;
+}
+
+void Resolver::ensure_fetched(const std::vector<int>& pkgs) {
+    std::unordered_set<int> queued;
+    std::vector<int> batch;
+    for (int p : pkgs) {
+        if (!packages_[p].fetched && queued.insert(p).second) batch.push_back(p);
+    }
+
+    while (!batch.empty()) {
+        std::vector<std::string> names;
+        for (int p : batch) names.push_back(packages_[p].name);
+        std::vector<std::optional<RegistryPackage>> out(names.size());
+        fetch_(names, out);
+        ++stats_.fetch_batches;
+
+        std::vector<int> next;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            int p = batch[i];
+            packages_[p].fetched = true;
+            ++stats_.packages;
+
+            if (out[i].has_value()) {
+                RegistryPackage& info = *out[i];
+                std::vector<std::string> versions = info.versions;
+                std::sort(versions.begin(), versions.end(), version_less);
+                versions.erase(std::unique(versions.begin(), versions.end()), versions.end());
+
+                std::vector<std::vector<Dependency>> dependencies(versions.size());
+                std::vector<std::string> checksums(versions.size());
+                for (size_t v = 0; v < versions.size(); ++v) {
+                    auto deps = info.dependencies.find(versions[v]);
+                    if (deps != info.dependencies.end()) dependencies[v] = std::move(deps->second);
+                    auto checksum = info.checksums.find(versions[v]);
+                    if (checksum != info.checksums.end()) checksums[v] = checksum->second;
+                }
+
+                // Prefetch what the newest version needs; it is usually chosen
+                if (!versions.empty()) {
+                    for (const auto& dep : dependencies.back()) {
+                        int d = intern(dep.name);
+                        if (!packages_[d].fetched && queued.insert(d).second) next.push_back(d);
+                    }
+                }
+
+                packages_[p].versions = std::move(versions);
+                packages_[p].dependencies = std::move(dependencies);
+                packages_[p].checksums = std::move(checksums);
+            }
+            packages_[p].accumulated = any(p);
+        }
+        batch = std::move(next);
+    }
+}
+
+// ============================================================================
+// Terms
+// ============================================================================
+
+Resolver::Term Resolver::any(int pkg) const {
+    size_t n = packages_[pkg].versions.size();
+    Term t;
+    t.pkg = pkg;
+    t.versions.assign(word_count(n), ~0ull);
+    if (n % 64) t.versions.back() = (1ull << (n % 64)) - 1;
+    t.none = true;
+    return t;
+}
+
+Resolver::Term Resolver::exactly(int pkg, size_t version) const {
+    Term t;
+    t.pkg = pkg;
+    t.versions.assign(word_count(packages_[pkg].versions.size()), 0);
+    set_bit(t.versions, version);
+    return t;
+}
+
+Resolver::Term Resolver::matching(int pkg, const std::string& constraint) const {
+    const auto& versions = packages_[pkg].versions;
+    Term t;
+    t.pkg = pkg;
+    t.versions.assign(word_count(versions.size()), 0);
+    for (size_t i = 0; i < versions.size(); ++i) {
+        if (version_matches(constraint, versions[i])) set_bit(t.versions, i);
+    }
+    return t;
+}
+
+Resolver::Term Resolver::negate(const Term& t) const {
+    Term r = any(t.pkg);
+    for (size_t i = 0; i < r.versions.size(); ++i) r.versions[i] &= ~t.versions[i];
+    r.none = !t.none;
+    return r;
+}
+
+Resolver::Term Resolver::intersect(const Term& a, const Term& b) {
+    Term r = a;
+    for (size_t i = 0; i < r.versions.size(); ++i) r.versions[i] &= b.versions[i];
+    r.none = a.none && b.none;
+    return r;
+}
+
+bool Resolver::is_empty(const Term& t) {
+    if (t.none) return false;
+    for (uint64_t w : t.versions) {
+        if (w) return false;
+    }
+    return true;
+}
+
+bool Resolver::subset(const Term& a, const Term& b) {
+    for (size_t i = 0; i < a.versions.size(); ++i) {
+        if (a.versions[i] & ~b.versions[i]) return false;
+    }
+    return !a.none || b.none;
+}
+
+bool Resolver::disjoint(const Term& a, const Term& b) {
+    for (size_t i = 0; i < a.versions.size(); ++i) {
+        if (a.versions[i] & b.versions[i]) return false;
+    }
+    return !(a.none && b.none);
+}
+
+// ============================================================================
+// Partial solution
+// ============================================================================
+
+void Resolver::assign(Term term, int cause) {
+    int pkg = term.pkg;
+    Package& p = packages_[pkg];
+    p.accumulated = intersect(p.accumulated, term);
+    p.assignments.push_back(static_cast<int>(assignments_.size()));
+    assignments_.push_back({std::move(term), level_, cause});
+    update_pending(pkg);
+}
+
+void Resolver::backtrack(int level) {
+    std::vector<int> touched;
+    while (!assignments_.empty() && assignments_.back().level > level) {
+        int pkg = assignments_.back().term.pkg;
+        if (assignments_.back().cause < 0) packages_[pkg].decided = -1;
+        packages_[pkg].assignments.pop_back();
+        touched.push_back(pkg);
+        assignments_.pop_back();
+    }
+    level_ = level;
+
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (int pkg : touched) recompute(pkg);
+}
+
+void Resolver::recompute(int pkg) {
+    Package& p = packages_[pkg];
+    p.accumulated = any(pkg);
+    for (int idx : p.assignments) {
+        p.accumulated = intersect(p.accumulated, assignments_[idx].term);
+    }
+    update_pending(pkg);
+}
+
+void Resolver::update_pending(int pkg) {
+    Package& p = packages_[pkg];
+    bool want = p.decided < 0 && !p.assignments.empty() && !p.accumulated.none;
+    if (want && p.pending < 0) {
+        p.pending = static_cast<int>(pending_.size());
+        pending_.push_back(pkg);
+    } else if (!want && p.pending >= 0) {
+        int last = pending_.back();
+        pending_[p.pending] = last;
+        packages_[last].pending = p.pending;
+        pending_.pop_back();
+        p.pending = -1;
+    }
+}
+
+int Resolver::satisfier(const Term& term) const {
+    // The earliest assignment after which the package's assignments imply `term`
+    Term acc = any(term.pkg);
+    for (int idx : packages_[term.pkg].assignments) {
+        acc = intersect(acc, assignments_[idx].term);
+        if (subset(acc, term)) return idx;
+    }
+    return -1;
+}
+
+// ============================================================================
+// Incompatibilities
+// ============================================================================
+
+int Resolver::store(Incompatibility incompat) {
+    // One term per package; terms that always hold say nothing
+    std::vector<Term> terms;
+    for (auto& t : incompat.terms) {
+        auto same = std::find_if(terms.begin(), terms.end(), [&](const Term& u) { return u.pkg == t.pkg; });
+        if (same != terms.end()) *same = intersect(*same, t);
+        else terms.push_back(std::move(t));
+    }
+    terms.erase(std::remove_if(terms.begin(), terms.end(),
+                               [&](const Term& t) { return subset(any(t.pkg), t); }),
+                terms.end());
+    // The root is always selected, so requiring it adds nothing to a learned fact
+    if (incompat.kind == Incompatibility::Kind::Derived && terms.size() > 1) {
+        terms.erase(std::remove_if(terms.begin(), terms.end(),
+                                   [](const Term& t) { return t.pkg == 0 && !t.none; }),
+                    terms.end());
+    }
+    incompat.terms = std::move(terms);
+
+    if (incompat.kind == Incompatibility::Kind::Derived) ++stats_.learned;
+    incompatibilities_.push_back(std::move(incompat));
+    return static_cast<int>(incompatibilities_.size()) - 1;
+}
+
+void Resolver::watch(int id) {
+    for (const auto& t : incompatibilities_[id].terms) {
+        packages_[t.pkg].incompatibilities.push_back(id);
+    }
+}
+
+void Resolver::add_dependencies(int pkg, size_t version, std::vector<int>& added) {
+    // Versions are often tried again after backjumping
+    if (packages_[pkg].added.empty()) packages_[pkg].added.resize(packages_[pkg].versions.size());
+    if (!packages_[pkg].added[version].empty() || packages_[pkg].dependencies[version].empty()) {
+        added = packages_[pkg].added[version];
+        return;
+    }
+
+    const std::vector<Dependency> deps = packages_[pkg].dependencies[version];
+    std::vector<int> targets;
+    for (const auto& dep : deps) targets.push_back(intern(dep.name));
+    ensure_fetched(targets);
+
+    for (size_t i = 0; i < deps.size(); ++i) {
+        int target = targets[i];
+        if (target == pkg) continue;
+        const std::string& constraint = deps[i].version;
+
+        std::string key = std::to_string(pkg) + "\t" + deps[i].name + "\t" + constraint;
+        auto known = dependency_keys_.find(key);
+        if (known != dependency_keys_.end()) {
+            added.push_back(known->second);
+            continue;
+        }
+
+        // Every version of `pkg` with the same requirement shares one incompatibility
+        const Package& p = packages_[pkg];
+        Term depender;
+        depender.pkg = pkg;
+        depender.versions.assign(word_count(p.versions.size()), 0);
+        for (size_t v = 0; v < p.versions.size(); ++v) {
+            for (const auto& dep : p.dependencies[v]) {
+                if (dep.name == deps[i].name && dep.version == constraint) {
+                    set_bit(depender.versions, v);
+                    break;
+                }
+            }
+        }
+
+        Incompatibility incompat;
+        incompat.kind = Incompatibility::Kind::Dependency;
+        incompat.dependency = target;
+        incompat.constraint = constraint;
+        incompat.terms.push_back(std::move(depender));
+        incompat.terms.push_back(negate(matching(target, constraint)));
+        int id = add_incompatibility(std::move(incompat));
+        dependency_keys_.emplace(key, id);
+        added.push_back(id);
+    }
+    packages_[pkg].added[version] = added;
+}
+
+Resolver::Relation Resolver::check(int id, int& unsatisfied) const {
+    unsatisfied = -1;
+    const auto& terms = incompatibilities_[id].terms;
+    for (size_t k = 0; k < terms.size(); ++k) {
+        const Term& acc = packages_[terms[k].pkg].accumulated;
+        if (subset(acc, terms[k])) continue;
+        if (disjoint(acc, terms[k]) || unsatisfied >= 0) return Relation::None;
+        unsatisfied = static_cast<int>(k);
+    }
+    return unsatisfied < 0 ? Relation::Satisfied : Relation::AlmostSatisfied;
+}
+
+bool Resolver::propagate(int start) {
+    std::vector<int> changed{start};
+    while (!changed.empty()) {
+        int pkg = changed.back();
+        changed.pop_back();
+
+        // Newest first: learned incompatibilities are the most specific
+        for (size_t i = packages_[pkg].incompatibilities.size(); i-- > 0;) {
+            int id = packages_[pkg].incompatibilities[i];
+            int unsatisfied = -1;
+            Relation relation = check(id, unsatisfied);
+
+            if (relation == Relation::Satisfied) {
+                ++stats_.conflicts;
+                int cause = resolve_conflict(id);
+                if (cause < 0) return false;
+                if (check(cause, unsatisfied) != Relation::AlmostSatisfied) {
+                    error_ = "internal error: conflict resolution did not backjump\n";
+                    return false;
+                }
+                const Term& t = incompatibilities_[cause].terms[unsatisfied];
+                assign(negate(t), cause);
+                changed.assign(1, t.pkg);
+                break;
+            }
+
+            if (relation == Relation::AlmostSatisfied) {
+                const Term& t = incompatibilities_[id].terms[unsatisfied];
+                assign(negate(t), id);
+                if (std::find(changed.begin(), changed.end(), t.pkg) == changed.end()) {
+                    changed.push_back(t.pkg);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int Resolver::resolve_conflict(int id) {
+    bool created = false;
+    for (;;) {
+        std::vector<Term> terms = incompatibilities_[id].terms;
+        if (terms.empty() || (terms.size() == 1 && terms[0].pkg == 0 && !terms[0].none)) {
+            std::vector<std::string> lines;
+            if (incompatibilities_[id].kind == Incompatibility::Kind::Derived) {
+                std::unordered_map<int, int> uses;
+                std::vector<int> stack{id};
+                std::unordered_set<int> seen;
+                while (!stack.empty()) {
+                    int c = stack.back();
+                    stack.pop_back();
+                    if (!seen.insert(c).second) continue;
+                    const auto& inc = incompatibilities_[c];
+                    if (inc.kind != Incompatibility::Kind::Derived) continue;
+                    for (int cause : {inc.cause1, inc.cause2}) {
+                        ++uses[cause];
+                        stack.push_back(cause);
+                    }
+                }
+                std::unordered_map<int, int> numbered;
+                explain(id, lines, numbered, uses);
+            } else {
+                lines.push_back(incompatibility_text(id) + ".");
+            }
+            error_.clear();
+            for (const auto& line : lines) error_ += line + "\n";
+            return -1;
+        }
+
+        // The term satisfied last, and the decision level the conflict
+        // already existed at without it
+        int recent = -1;
+        size_t recent_term = 0;
+        int previous_level = 1;
+        for (size_t k = 0; k < terms.size(); ++k) {
+            int s = satisfier(terms[k]);
+            if (recent < 0 || s > recent) {
+                if (recent >= 0) previous_level = std::max(previous_level, assignments_[recent].level);
+                recent = s;
+                recent_term = k;
+            } else {
+                previous_level = std::max(previous_level, assignments_[s].level);
+            }
+        }
+
+        Assignment sat = assignments_[recent];
+        Term difference = intersect(sat.term, negate(terms[recent_term]));
+        bool has_difference = !is_empty(difference);
+        if (has_difference) {
+            int prior = satisfier(negate(difference));
+            if (prior >= 0) previous_level = std::max(previous_level, assignments_[prior].level);
+        }
+
+        if (sat.cause < 0 || previous_level < sat.level) {
+            backtrack(previous_level);
+            if (created) watch(id);
+            return id;
+        }
+
+        // Resolve with the incompatibility the satisfier was derived from
+        Incompatibility prior;
+        prior.cause1 = id;
+        prior.cause2 = sat.cause;
+        for (size_t k = 0; k < terms.size(); ++k) {
+            if (k != recent_term) prior.terms.push_back(terms[k]);
+        }
+        for (const auto& t : incompatibilities_[sat.cause].terms) {
+            if (t.pkg != sat.term.pkg) prior.terms.push_back(t);
+        }
+        if (has_difference) prior.terms.push_back(negate(difference));
+        id = store(std::move(prior));
+        created = true;
+    }
+}
+
+int Resolver::choose_version() {
+    // Most constrained package first: fewest versions left to try
+    int best = -1;
+    size_t best_count = 0;
+    for (int p : pending_) {
+        size_t count = count_bits(packages_[p].accumulated.versions);
+        if (best < 0 || count < best_count || (count == best_count && p < best)) {
+            best = p;
+            best_count = count;
+        }
+    }
+    if (best < 0) return -1;
+
+    if (best_count == 0) {
+        Incompatibility incompat;
+        incompat.kind = packages_[best].versions.empty() ? Incompatibility::Kind::NotFound
+                                                        : Incompatibility::Kind::NoVersions;
+        incompat.terms.push_back(packages_[best].accumulated);
+        add_incompatibility(std::move(incompat));
+        return best;
+    }
+
+    // Newest allowed version
+    const auto& bits = packages_[best].accumulated.versions;
+    size_t version = 0;
+    for (size_t w = bits.size(); w-- > 0;) {
+        if (bits[w]) {
+            uint64_t word = bits[w];
+            int high = 63;
+            while (!((word >> high) & 1)) --high;
+            version = w * 64 + static_cast<size_t>(high);
+            break;
+        }
+    }
+
+    std::vector<int> added;
+    add_dependencies(best, version, added);
+
+    // Don't pick a version whose dependencies already conflict; propagation
+    // rules it out instead
+    for (int id : added) {
+        bool conflict = true;
+        for (const auto& t : incompatibilities_[id].terms) {
+            if (t.pkg != best && !subset(packages_[t.pkg].accumulated, t)) {
+                conflict = false;
+                break;
+            }
+        }
+        if (conflict) return best;
+    }
+
+    ++level_;
+    ++stats_.decisions;
+    packages_[best].decided = static_cast<int>(version);
+    assign(exactly(best, version), -1);
+    return best;
+}
+
+bool Resolver::resolve(const std::string& root, const std::vector<Dependency>& dependencies) {
+    packages_.clear();
+    index_.clear();
+    incompatibilities_.clear();
+    dependency_keys_.clear();
+    assignments_.clear();
+    pending_.clear();
+    level_ = 0;
+    solution_.clear();
+    error_.clear();
+    stats_ = ResolverStats();
+
+    // The root is not in index_, so a dependency can't be mistaken for it
+    packages_.emplace_back();
+    packages_[0].name = root;
+    packages_[0].fetched = true;
+    packages_[0].versions = {"0.0.0"};
+    packages_[0].dependencies = {dependencies};
+    packages_[0].checksums = {""};
+    packages_[0].accumulated = any(0);
+
+    Incompatibility incompat;
+    incompat.kind = Incompatibility::Kind::Root;
+    incompat.terms.push_back(negate(exactly(0, 0)));
+    add_incompatibility(std::move(incompat));
+
+    for (int next = 0; next >= 0; next = choose_version()) {
+        if (!propagate(next)) return false;
+    }
+
+    for (size_t p = 1; p < packages_.size(); ++p) {
+        const Package& pkg = packages_[p];
+        if (pkg.decided < 0) continue;
+        ResolvedDep dep;
+        dep.name = pkg.name;
+        dep.version = pkg.versions[pkg.decided];
+        dep.checksum = pkg.checksums[pkg.decided];
+        dep.transitive_deps = pkg.dependencies[pkg.decided];
+        solution_.push_back(std::move(dep));
+    }
+    std::sort(solution_.begin(), solution_.end(),
+              [](const ResolvedDep& a, const ResolvedDep& b) { return a.name < b.name; });
+    return true;
+}
+
+// ============================================================================
+// Explanations
+// ============================================================================
+
+std::string Resolver::set_text(int pkg, const std::vector<uint64_t>& versions) const {
+    const auto& all = packages_[pkg].versions;
+    size_t n = all.size();
+    if (count_bits(versions) == 0) return "(no versions)";
+
+    // Runs of consecutive known versions
+    std::string out;
+    for (size_t i = 0; i < n;) {
+        if (!test_bit(versions, i)) {
+            ++i;
+            continue;
+        }
+        size_t j = i;
+        while (j + 1 < n && test_bit(versions, j + 1)) ++j;
+        if (!out.empty()) out += " or ";
+        if (i == j) out += all[i];
+        else if (i == 0) out += "<=" + all[j];
+        else if (j == n - 1) out += ">=" + all[i];
+        else out += ">=" + all[i] + ", <=" + all[j];
+        i = j + 1;
+    }
+    return out;
+}
+
+std::string Resolver::term_text(const Term& t, bool subject) const {
+    const Package& p = packages_[t.pkg];
+    if (t.pkg == 0) return p.name;
+    if (!p.versions.empty() && count_bits(t.versions) == p.versions.size()) {
+        return (subject ? "every version of " : "any version of ") + p.name;
+    }
+    return p.name + " " + set_text(t.pkg, t.versions);
+}
+
+std::string Resolver::incompatibility_text(int id) const {
+    const Incompatibility& inc = incompatibilities_[id];
+    const auto& terms = inc.terms;
+
+    switch (inc.kind) {
+        case Incompatibility::Kind::Root:
+            return packages_[0].name + " is the project being resolved";
+        case Incompatibility::Kind::Dependency: {
+            const Package& target = packages_[inc.dependency];
+            std::string depender = term_text(terms[0], true);
+            if (target.versions.empty()) {
+                return depender + " depends on " + target.name + ", which does not exist in the registry";
+            }
+            std::string wanted = trim(inc.constraint) == "*" ? "any version of " + target.name
+                                                             : target.name + " " + inc.constraint;
+            if (terms.size() == 1) return depender + " depends on " + wanted + ", which matches no versions";
+            return depender + " depends on " + wanted;
+        }
+        case Incompatibility::Kind::NoVersions:
+            return "no versions of " + packages_[terms[0].pkg].name + " match " +
+                   set_text(terms[0].pkg, terms[0].versions);
+        case Incompatibility::Kind::NotFound:
+            return packages_[terms[0].pkg].name + " does not exist in the registry";
+        case Incompatibility::Kind::Derived:
+            break;
+    }
+
+    if (terms.empty() || (terms.size() == 1 && terms[0].pkg == 0 && !terms[0].none)) {
+        return "version solving failed";
+    }
+    if (terms.size() == 1) {
+        return terms[0].none ? term_text(negate(terms[0])) + " is required"
+                             : term_text(terms[0], true) + " is forbidden";
+    }
+
+    std::vector<const Term*> positive;
+    std::vector<const Term*> negative;
+    for (const auto& t : terms) (t.none ? negative : positive).push_back(&t);
+
+    if (positive.size() == 1 && negative.size() == 1) {
+        return term_text(*positive[0], true) + " depends on " + term_text(negate(*negative[0]));
+    }
+    if (negative.empty()) {
+        if (positive.size() == 2) {
+            return term_text(*positive[0], true) + " is incompatible with " + term_text(*positive[1]);
+        }
+        std::string out = "one of ";
+        for (size_t i = 0; i < positive.size(); ++i) {
+            if (i > 0) out += i + 1 == positive.size() ? " or " : ", ";
+            out += term_text(*positive[i]);
+        }
+        return out + " must be false";
+    }
+
+    std::string required;
+    for (size_t i = 0; i < negative.size(); ++i) {
+        if (i > 0) required += " or ";
+        required += term_text(negate(*negative[i]));
+    }
+    if (positive.empty()) return required + " is required";
+
+    std::string out;
+    for (size_t i = 0; i < positive.size(); ++i) {
+        if (i > 0) out += " and ";
+        out += term_text(*positive[i], true);
+    }
+    return "if " + out + " then " + required + " is required";
+}
+
+void Resolver::explain(int id, std::vector<std::string>& lines, std::unordered_map<int, int>& numbered,
+                       const std::unordered_map<int, int>& uses) const {
+    const Incompatibility& inc = incompatibilities_[id];
+    auto derived = [&](int c) { return incompatibilities_[c].kind == Incompatibility::Kind::Derived; };
+    auto ref = [&](int c) {
+        auto it = numbered.find(c);
+        return it == numbered.end() ? std::string() : " (" + std::to_string(it->second) + ")";
+    };
+    // Gives the line that concluded `c` a number so later lines can cite it
+    auto number = [&](int c) {
+        if (numbered.count(c) || lines.empty()) return;
+        int n = static_cast<int>(numbered.size()) + 1;
+        numbered[c] = n;
+        lines.back() += " (" + std::to_string(n) + ")";
+    };
+
+    int c1 = inc.cause1;
+    int c2 = inc.cause2;
+    std::string conclusion = incompatibility_text(id);
+    std::string line;
+
+    if (derived(c1) && derived(c2)) {
+        bool n1 = numbered.count(c1) > 0;
+        bool n2 = numbered.count(c2) > 0;
+        if (n1 && n2) {
+            line = "Because " + incompatibility_text(c1) + ref(c1) + " and " +
+                   incompatibility_text(c2) + ref(c2) + ", " + conclusion + ".";
+        } else if (n1 || n2) {
+            int cited = n1 ? c1 : c2;
+            explain(n1 ? c2 : c1, lines, numbered, uses);
+            line = "And because " + incompatibility_text(cited) + ref(cited) + ", " + conclusion + ".";
+        } else {
+            explain(c1, lines, numbered, uses);
+            number(c1);
+            explain(c2, lines, numbered, uses);
+            line = "And because " + incompatibility_text(c1) + ref(c1) + ", " + conclusion + ".";
+        }
+    } else if (derived(c1) || derived(c2)) {
+        int inner = derived(c1) ? c1 : c2;
+        int external = derived(c1) ? c2 : c1;
+        if (numbered.count(inner)) {
+            line = "Because " + incompatibility_text(external) + " and " +
+                   incompatibility_text(inner) + ref(inner) + ", " + conclusion + ".";
+        } else {
+            explain(inner, lines, numbered, uses);
+            line = "And because " + incompatibility_text(external) + ", " + conclusion + ".";
+        }
+    } else {
+        line = "Because " + incompatibility_text(c1) + " and " + incompatibility_text(c2) + ", " +
+               conclusion + ".";
+    }
+
+    lines.push_back(line);
+    auto used = uses.find(id);
+    if (used != uses.end() && used->second > 1) number(id);
+}
+
+} // namespace mana::pkg
@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "PackageManager.h"
+
+namespace mana::pkg {
+
+    // Semantic version; a pre-release sorts before its release
+    struct SemVer {
+        int major = 0;
+        int minor = 0;
+        int patch = 0;
+        std::string pre;
+        int parts = 3;  // Components written ("1.2" has 2)
+
+        static std::optional<SemVer> parse(const std::string& text);
+        bool operator<(const SemVer& other) const;
+        bool operator==(const SemVer& other) const;
+    };
+
+    // Whether `version` satisfies `constraint`: "*", "1.2.3" (exact), "=1.2.3",
+    // "^1.2.3", "~1.2", ">=1.0", ">1.0", "<2.0", "<=2.0", or several of
+    // these joined by commas, all of which must hold
+    bool version_matches(const std::string& constraint, const std::string& version);
+
+    // Fetches metadata for a batch of packages, in parallel if it can;
+    // out[i] is empty when names[i] is not in the registry
+    using MetadataFetcher = std::function<void(const std::vector<std::string>& names,
+                                               std::vector<std::optional<RegistryPackage>>& out)>;
+
+    struct ResolverStats {
+        size_t packages = 0;       // Distinct packages whose metadata was fetched
+        size_t fetch_batches = 0;  // Calls to the fetcher
+        size_t decisions = 0;
+        size_t conflicts = 0;
+        size_t learned = 0;        // Incompatibilities derived by conflict resolution
+    };
+
+    // PubGrub version solver (Weizenbaum, as in Dart's pub). Dependencies of
+    // each candidate version become incompatibilities; unit propagation
+    // derives what must hold, and a conflict is resolved back to its root
+    // cause, which is learned so the same dead end is never explored twice.
+    // On failure the derivation of the conflict is reported as an
+    // explanation of why no solution exists.
+    //
+    // Metadata is fetched once per package. A fetch also prefetches the
+    // dependencies of each package's newest version, breadth first, so most
+    // of the graph arrives in a few parallel batches.
+    class Resolver {
+    public:
+        explicit Resolver(MetadataFetcher fetch);
+
+        bool resolve(const std::string& root, const std::vector<Dependency>& dependencies);
+
+        // Selected packages sorted by name (url left empty)
+        const std::vector<ResolvedDep>& solution() const { return solution_; }
+        // Why resolution failed, one sentence per line
+        const std::string& error() const { return error_; }
+        const ResolverStats& stats() const { return stats_; }
+
+    private:
+        // Outcomes allowed for one package: a subset of its versions (bit i
+        // is the i-th oldest) and whether it may be left out of the solution
+        struct Term {
+            int pkg = 0;
+            std::vector<uint64_t> versions;
+            bool none = false;
+        };
+
+        struct Incompatibility {
+            enum class Kind { Root, Dependency, NoVersions, NotFound, Derived };
+            std::vector<Term> terms;  // At most one per package; all holding at once is a conflict
+            Kind kind = Kind::Derived;
+            int cause1 = -1;          // Derived: the two incompatibilities it was resolved from
+            int cause2 = -1;
+            int dependency = -1;      // Dependency: the package depended on
+            std::string constraint;   // Dependency: as written in the manifest
+        };
+
+        struct Assignment {
+            Term term;
+            int level = 0;
+            int cause = -1;  // Incompatibility it was derived from; -1 for decisions
+        };
+
+        struct Package {
+            std::string name;
+            bool fetched = false;
+            std::vector<std::string> versions;  // Oldest first
+            std::vector<std::vector<Dependency>> dependencies;
+            std::vector<std::string> checksums;
+
+            std::vector<std::vector<int>> added;  // Per version: its dependency incompatibilities, once added
+            std::vector<int> incompatibilities;
+            std::vector<int> assignments;
+            Term accumulated;   // Intersection of the assignments
+            int decided = -1;   // Version index once decided
+            int pending = -1;   // Position in pending_
+        };
+
+        MetadataFetcher fetch_;
+        std::vector<Package> packages_;  // [0] is the root
+        std::unordered_map<std::string, int> index_;
+        std::vector<Incompatibility> incompatibilities_;
+        std::unordered_map<std::string, int> dependency_keys_;  // Dependency incompatibilities already added
+        std::vector<Assignment> assignments_;
+        std::vector<int> pending_;  // Packages required by the partial solution but not decided yet
+        int level_ = 0;
+        std::vector<ResolvedDep> solution_;
+        std::string error_;
+        ResolverStats stats_;
+
+        int intern(const std::string& name);
+        void ensure_fetched(const std::vector<int>& pkgs);
+
+        // Term algebra
+        Term any(int pkg) const;
+        Term exactly(int pkg, size_t version) const;
+        Term matching(int pkg, const std::string& constraint) const;
+        Term negate(const Term& t) const;
+        static Term intersect(const Term& a, const Term& b);
+        static bool is_empty(const Term& t);
+        static bool subset(const Term& a, const Term& b);
+        static bool disjoint(const Term& a, const Term& b);
+
+        // Partial solution
+        void assign(Term term, int cause);
+        void backtrack(int level);
+        void recompute(int pkg);
+        void update_pending(int pkg);
+        int satisfier(const Term& term) const;
+
+        int store(Incompatibility incompat);
+        void watch(int id);
+        int add_incompatibility(Incompatibility incompat) { int id = store(std::move(incompat)); watch(id); return id; }
+        void add_dependencies(int pkg, size_t version, std::vector<int>& added);
+        enum class Relation { Satisfied, AlmostSatisfied, None };
+        Relation check(int id, int& unsatisfied) const;
+        bool propagate(int pkg);
+        int resolve_conflict(int id);
+        int choose_version();
+
+        // Explanations
+        std::string set_text(int pkg, const std::vector<uint64_t>& versions) const;
+        std::string term_text(const Term& t, bool subject = false) const;
+        std::string incompatibility_text(int id) const;
+        void explain(int id, std::vector<std::string>& lines, std::unordered_map<int, int>& numbered,
+                     const std::unordered_map<int, int>& uses) const;
+    };
+
+} // namespace mana::pkg
@@ -1,23 +1,98 @@
 #include "Repl.h"
+#include "../test/TestRunner.h"
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <cstdlib>
 #include <algorithm>
+#include <unordered_map>
 
 #ifdef _WIN32
 #include <io.h>
+#include <process.h>
 #define isatty _isatty
 #define fileno _fileno
+#define getpid _getpid
 #else
 #include <unistd.h>
+#include <dlfcn.h>
 #endif
 
 namespace mana::repl {
 
 using namespace frontend;
+namespace fs = std::filesystem;
 
-Repl::Repl() {}
+namespace {
+
+// Same headers the emitter includes ahead of the runtime, so one
+// precompiled header covers everything a snippet pulls in
+const char* PRELUDE_H = R"(#include <cstdint>
+#include <string>
+#include <array>
+#include <vector>
+#include <tuple>
+#include <cmath>
+#include <type_traits>
+#include <variant>
+#include <future>
+#include "mana_runtime.h"
+)";
+
+std::string trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+bool starts_with_word(const std::string& s, const char* word) {
+    size_t n = std::char_traits<char>::length(word);
+    return s.compare(0, n, word) == 0 && (s.size() == n || !(std::isalnum(static_cast<unsigned char>(s[n])) || s[n] == '_'));
+}
+
+bool is_definition(const std::string& s) {
+    for (const char* kw : {"fn", "pub", "struct", "enum", "trait", "impl", "type", "extern", "async", "const"}) {
+        if (starts_with_word(s, kw)) return true;
+    }
+    return s.rfind("#[", 0) == 0;
+}
+
+// A bare expression is printed; anything that reads as a statement is run
+bool is_expression(const std::string& s) {
+    if (s.empty() || s.back() == ';' || s.back() == '}') return false;
+    for (const char* kw : {"let", "if", "while", "for", "loop", "return", "break", "continue", "defer", "scope"}) {
+        if (starts_with_word(s, kw)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+Repl::Repl(ReplOptions options) : options_(std::move(options)) {
+    if (options_.cxx.empty()) {
+        const char* env = std::getenv("CXX");
+        options_.cxx = env && *env ? env : "c++";
+    }
+
+    dir_ = fs::temp_directory_path() / ("mana-repl-" + std::to_string(getpid()));
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    std::ofstream(dir_ / "mana_runtime.h") << options_.runtime_header;
+    std::ofstream(dir_ / "repl_prelude.h") << PRELUDE_H;
+
+    reset();
+    start_prelude_build();
+}
+
+Repl::~Repl() {
+    if (prelude_build_.joinable()) prelude_build_.join();
+#ifndef _WIN32
+    for (auto it = handles_.rbegin(); it != handles_.rend(); ++it) dlclose(*it);
+#endif
+    std::error_code ec;
+    fs::remove_all(dir_, ec);
+}
 
 void Repl::print_banner() {
     std::cout << R"(
@@ -121,8 +196,7 @@ void Repl::run() {
                     std::cout << i + 1 << ": " << history_[i] << "\n";
                 }
             } else if (input == ":reset") {
-                definitions_.clear();
-                variables_.clear();
+                reset();
                 std::cout << "Reset complete.\n";
             } else if (input.substr(0, 6) == ":load ") {
                 std::string filename = input.substr(6);
@@ -135,9 +209,7 @@ void Repl::run() {
                     std::cerr << "Error: Could not open file '" << filename << "'\n";
                 }
             } else if (input.substr(0, 6) == ":type ") {
-                std::string expr = input.substr(6);
-                // TODO: Implement type inference display
-                std::cout << "Type checking not yet implemented\n";
+                show_type(input.substr(6));
             } else {
                 std::cerr << "Unknown command: " << input << "\n";
             }
@@ -149,58 +221,261 @@ void Repl::run() {
     std::cout << "Goodbye!\n";
 }
 
-void Repl::execute(const std::string& input) {
-    // Wrap input for parsing
-    std::string code = "module repl;\n" + definitions_ + "\nfn __repl_main() -> void {\n" + input + "\n}\n";
+void Repl::reset() {
+    session_ = std::make_unique<AstModule>("repl");
+    sema_ = std::make_unique<SemanticAnalyzer>(diag_);
+    sema_->begin_session();
+    compiled_.clear();
+    defined_names_.clear();
+    variables_.clear();
+    // Loaded units stay mapped, but new units no longer link against them
+    units_.clear();
+}
+
+void Repl::execute(const std::string& raw) {
+    std::string input = trim(raw);
+    // Files given to :load start with their module header
+    if (starts_with_word(input, "module")) {
+        size_t semi = input.find(';');
+        input = trim(semi == std::string::npos ? "" : input.substr(semi + 1));
+    }
+    if (input.empty()) return;
+
+    if (is_definition(input)) {
+        if (execute_definitions(input)) std::cout << "Defined.\n";
+        return;
+    }
 
-    // Parse
+    if (is_expression(input)) {
+        // Print the value unless the expression has none
+        Snippet probe;
+        std::string code = "module repl;\nfn __repl_probe() -> void {\nlet __repl_value = " + input + ";\n}\n";
+        if (analyze(code, 2, probe, false)) {
+            auto* fn = static_cast<AstFuncDecl*>(probe.module->decls.front().get());
+            auto* let = static_cast<AstVarDeclStmt*>(fn->body->statements.front().get());
+            if (!let->type_name.empty() && let->type_name != "void") {
+                execute_statements("println(" + input + ");");
+                return;
+            }
+        }
+        execute_statements(input + ";");
+        return;
+    }
+
+    execute_statements(input);
+}
+
+void Repl::report_diagnostics(int line_offset) {
+    for (const auto& d : diag_.all()) {
+        if (d.kind != DiagKind::Error && d.kind != DiagKind::Warning) continue;
+        // Line numbers are relative to what the user typed
+        int line = std::max(1, d.line - line_offset);
+        std::cerr << (d.kind == DiagKind::Error ? "error: " : "warning: ") << d.message << " (line " << line << ")\n";
+    }
+}
+
+bool Repl::analyze(const std::string& code, int line_offset, Snippet& out, bool report) {
+    diag_.clear();
     Lexer lexer(code);
     auto tokens = lexer.tokenize();
+    Parser parser(tokens, diag_);
+    out.module = parser.parse_module();
+    if (!out.module || diag_.has_errors()) {
+        if (report) report_diagnostics(line_offset);
+        return false;
+    }
+
+    // Check against a copy, so a rejected snippet leaves no trace
+    out.sema = std::make_unique<SemanticAnalyzer>(*sema_);
+    out.sema->analyze_incremental(out.module.get());
+    if (report) report_diagnostics(line_offset);
+    return !diag_.has_errors();
+}
 
-    DiagnosticEngine diag;
-    Parser parser(tokens, diag);
-    auto module = parser.parse_module();
-
-    // Check for errors
-    if (!diag.errors().empty()) {
-        for (const auto& err : diag.errors()) {
-            // Adjust line numbers (subtract header lines)
-            int adjusted_line = err.line - 2 - static_cast<int>(std::count(definitions_.begin(), definitions_.end(), '\n'));
-            if (adjusted_line < 1) adjusted_line = 1;
-            std::cerr << "error: " << err.message << " (line " << adjusted_line << ")\n";
+bool Repl::execute_definitions(const std::string& input) {
+    Snippet snippet;
+    if (!analyze("module repl;\n" + input + "\n", 1, snippet, true)) return false;
+
+    // A later unit would still call the first definition, so the name stays bound
+    std::vector<std::string> names;
+    for (const auto& d : snippet.module->decls) {
+        std::string name;
+        if (auto* fn = dynamic_cast<AstFuncDecl*>(d.get())) {
+            if (!fn->is_method()) name = fn->name;
+        } else if (auto* st = dynamic_cast<AstStructDecl*>(d.get())) {
+            name = st->name;
+        } else if (auto* en = dynamic_cast<AstEnumDecl*>(d.get())) {
+            name = en->name;
+        } else if (auto* tr = dynamic_cast<AstTraitDecl*>(d.get())) {
+            name = tr->name;
         }
-        return;
+        if (name.empty()) continue;
+        if (defined_names_.count(name)) {
+            std::cerr << "error: '" << name << "' is already defined in this session (:reset to start over)\n";
+            return false;
+        }
+        names.push_back(name);
     }
 
-    // Semantic analysis
-    DiagnosticEngine sem_diag;
-    SemanticAnalyzer analyzer(sem_diag);
-    analyzer.analyze(module.get());
+    snippet.unit = ++unit_counter_;
+    if (!build_and_load(snippet, "")) return false;
+    defined_names_.insert(names.begin(), names.end());
+    return true;
+}
+
+bool Repl::execute_statements(const std::string& body) {
+    Snippet snippet;
+    snippet.unit = ++unit_counter_;
+    snippet.runner = "__repl_" + std::to_string(snippet.unit);
+    std::string code = "module repl;\nfn " + snippet.runner + "() -> void {\n" + body + "\n}\n";
+    if (!analyze(code, 2, snippet, true)) return false;
 
-    if (!sem_diag.errors().empty()) {
-        for (const auto& err : sem_diag.errors()) {
-            int adjusted_line = err.line - 2 - static_cast<int>(std::count(definitions_.begin(), definitions_.end(), '\n'));
-            if (adjusted_line < 1) adjusted_line = 1;
-            std::cerr << "error: " << err.message << " (line " << adjusted_line << ")\n";
+    // Top-level `let`s outlive the snippet
+    auto* fn = static_cast<AstFuncDecl*>(snippet.module->decls.front().get());
+    for (auto& stmt : fn->body->statements) {
+        if (stmt->kind == NodeKind::VarDeclStmt && !dynamic_cast<AstDestructureStmt*>(stmt.get())) {
+            snippet.lets.push_back(static_cast<AstVarDeclStmt*>(stmt.get()));
         }
-        return;
     }
 
-    for (const auto& warn : sem_diag.warnings()) {
-        int adjusted_line = warn.line - 2 - static_cast<int>(std::count(definitions_.begin(), definitions_.end(), '\n'));
-        if (adjusted_line < 1) adjusted_line = 1;
-        std::cerr << "warning: " << warn.message << " (line " << adjusted_line << ")\n";
+    return build_and_load(snippet, "mana_repl_entry_" + std::to_string(snippet.unit));
+}
+
+void Repl::show_type(const std::string& expr) {
+    Snippet snippet;
+    std::string code = "module repl;\nfn __repl_type() -> void {\nlet __repl_value = " + expr + ";\n}\n";
+    if (!analyze(code, 2, snippet, true)) return;
+    auto* fn = static_cast<AstFuncDecl*>(snippet.module->decls.front().get());
+    auto* let = static_cast<AstVarDeclStmt*>(fn->body->statements.front().get());
+    std::cout << (let->type_name.empty() ? "void" : let->type_name) << "\n";
+}
+
+std::string Repl::prelude_pch() const {
+    // gcc looks for <header>.gch, clang for <header>.pch
+    bool clang = options_.cxx.find("clang") != std::string::npos;
+    return (dir_ / (clang ? "repl_prelude.h.pch" : "repl_prelude.h.gch")).string();
+}
+
+std::vector<std::string> Repl::compile_flags() const {
+    // The precompiled header is only used when these match exactly
+    return {"-std=c++20", "-O0", "-fPIC", "-w"};
+}
+
+void Repl::start_prelude_build() {
+#ifndef _WIN32
+    // The runtime header dominates compile time; precompile it while the
+    // user types the first line
+    prelude_build_ = std::thread([this]() {
+        std::vector<std::string> args = {options_.cxx};
+        for (const auto& f : compile_flags()) args.push_back(f);
+        args.insert(args.end(), {"-x", "c++-header", (dir_ / "repl_prelude.h").string(), "-o", prelude_pch()});
+        test::run_process(args, std::chrono::seconds(120));
+    });
+#endif
+}
+
+bool Repl::build_and_load(Snippet& snippet, const std::string& entry) {
+    // The unit is the whole session (types are needed in full) plus the
+    // snippet; bodies compiled by earlier units are only declared
+    size_t base = session_->decls.size();
+    for (auto& d : snippet.module->decls) session_->decls.push_back(std::move(d));
+    auto rollback = [&]() { session_->decls.resize(base); };
+
+    backend::CppEmitter::IncrementalUnit unit;
+    unit.external.insert(compiled_.begin(), compiled_.end());
+    unit.session_lets.insert(snippet.lets.begin(), snippet.lets.end());
+    unit.session_prefix = "mana_repl_v" + std::to_string(snippet.unit) + "_";
+
+    // Earlier variables are reached through a reference to their unit's global
+    backend::CppEmitter::set_user_types(session_.get());
+    std::unordered_map<std::string, size_t> latest;
+    for (size_t i = 0; i < variables_.size(); ++i) latest[variables_[i].name] = i;
+    std::ostringstream globals;
+    for (size_t i = 0; i < variables_.size(); ++i) {
+        const auto& v = variables_[i];
+        if (latest[v.name] != i) continue;
+        std::string type = backend::CppEmitter::cpp_type(v.type_name);
+        globals << "extern " << type << " " << v.symbol << ";\n";
+        globals << "static " << type << "& " << v.name << " = " << v.symbol << ";\n";
+    }
+    std::unordered_set<std::string> defined;
+    for (const auto* let : snippet.lets) {
+        if (!defined.insert(let->name).second) continue;
+        globals << backend::CppEmitter::cpp_type(let->type_name) << " " << unit.session_prefix << let->name << "{};\n";
+    }
+    unit.globals = globals.str();
+
+    std::ostringstream cpp;
+    backend::CppEmitter emitter;
+    emitter.set_incremental(&unit);
+    emitter.emit(session_.get(), cpp);
+    if (!entry.empty()) {
+        cpp << "extern \"C\" void " << entry << "() {\n    " << snippet.runner << "();\n}\n";
+    }
+
+#ifdef _WIN32
+    // No shared-object loading here: the snippet is checked but not run
+    (void)entry;
+#else
+    std::string stem = "unit_" + std::to_string(snippet.unit);
+    fs::path cpp_file = dir_ / (stem + ".cpp");
+    fs::path so_file = dir_ / (stem + ".so");
+    std::ofstream(cpp_file) << cpp.str();
+
+    if (prelude_build_.joinable()) prelude_build_.join();
+
+    std::vector<std::string> args = {options_.cxx};
+    for (const auto& f : compile_flags()) args.push_back(f);
+    args.insert(args.end(), {"-shared", "-include", (dir_ / "repl_prelude.h").string(),
+                             "-I", dir_.string(), cpp_file.string(), "-o", so_file.string()});
+    // Earlier units, newest first, resolve the declarations above
+    for (auto it = units_.rbegin(); it != units_.rend(); ++it) args.push_back(it->string());
+
+    test::ProcessResult build = test::run_process(args, std::chrono::seconds(120));
+    if (build.exit_code != 0) {
+        std::cerr << "error: C++ compilation failed\n" << build.output;
+        rollback();
+        return false;
     }
 
-    // If input looks like a definition, save it
-    if (input.find("fn ") == 0 || input.find("struct ") == 0 ||
-        input.find("enum ") == 0 || input.find("trait ") == 0 ||
-        input.find("impl ") == 0 || input.find("pub ") == 0) {
-        definitions_ += input + "\n";
-        std::cout << "Defined.\n";
-    } else {
-        std::cout << "OK\n";
+    // RTLD_LOCAL: each unit sees only the units it was linked against, so
+    // after :reset old definitions cannot shadow new ones
+    void* handle = dlopen(so_file.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        std::cerr << "error: " << dlerror() << "\n";
+        rollback();
+        return false;
     }
+    handles_.push_back(handle);
+    units_.push_back(so_file);
+#endif
+
+    // Loaded: the snippet is now part of the session
+    for (size_t i = base; i < session_->decls.size(); ++i) compiled_.insert(session_->decls[i].get());
+    sema_ = std::move(snippet.sema);
+    for (const auto* let : snippet.lets) {
+        sema_->declare_session_variable(let->name, let->type_name, let->is_mutable);
+        variables_.push_back({let->name, let->type_name, unit.session_prefix + let->name});
+    }
+
+#ifndef _WIN32
+    if (!entry.empty()) {
+        auto run = reinterpret_cast<void (*)()>(dlsym(handle, entry.c_str()));
+        if (!run) {
+            std::cerr << "error: " << dlerror() << "\n";
+            return false;
+        }
+        try {
+            run();
+        } catch (const std::exception& e) {
+            std::cout.flush();
+            std::cerr << "error: " << e.what() << "\n";
+        }
+        std::cout.flush();
+        std::fflush(stdout);
+    }
+#endif
+    return true;
 }
 
 } // namespace mana::repl
@@ -1,16 +1,29 @@
 #pragma once
+#include <filesystem>
+#include <memory>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <vector>
-#include <unordered_map>
 #include "../../frontend/Parser.h"
 #include "../../frontend/Semantic.h"
 #include "../../frontend/Diagnostic.h"
+#include "../../backend-cpp/CppEmitter.h"
 
 namespace mana::repl {
 
+    struct ReplOptions {
+        std::string runtime_header;  // mana_runtime.h text written to the session directory
+        std::string cxx;             // C++ compiler for snippets; empty = $CXX, else c++
+    };
+
+    // Interactive session. Definitions and variables are analyzed once and
+    // kept; each input is compiled on its own into a shared object that is
+    // loaded into this process and run, so state survives between lines.
     class Repl {
     public:
-        Repl();
+        explicit Repl(ReplOptions options = {});
+        ~Repl();
         void run();
 
     private:
@@ -18,19 +31,59 @@ namespace mana::repl {
         void print_help();
         std::string read_input();
         void execute(const std::string& input);
-        void execute_expression(const std::string& input);
-        void execute_statement(const std::string& input);
+        bool execute_definitions(const std::string& input);
+        bool execute_statements(const std::string& body);
+        void show_type(const std::string& expr);
+        void reset();
+
+        // Parse and analyze one snippet against the session; the snippet's
+        // declarations are appended to session_ only if it is accepted
+        struct Snippet {
+            std::unique_ptr<frontend::AstModule> module;
+            std::unique_ptr<frontend::SemanticAnalyzer> sema;  // Session state including the snippet
+            int unit = 0;
+            std::string runner;                             // Function wrapping typed statements
+            std::vector<frontend::AstVarDeclStmt*> lets;    // Its top-level lets
+        };
+        bool analyze(const std::string& code, int line_offset, Snippet& out, bool report);
+        void report_diagnostics(int line_offset);
+
+        // Emit the session plus the snippet's declarations as one unit,
+        // compile it to a shared object and load it; runs `entry` if given
+        bool build_and_load(Snippet& snippet, const std::string& entry);
+        std::vector<std::string> compile_flags() const;
+        std::string prelude_pch() const;
+        void start_prelude_build();
+
+        ReplOptions options_;
+        std::filesystem::path dir_;  // Per-session scratch directory
+        std::thread prelude_build_;  // Precompiles the runtime header in the background
+
+        // Session state: every accepted declaration, in order, and the
+        // analyzer that has seen all of them
+        frontend::DiagnosticEngine diag_;
+        std::unique_ptr<frontend::AstModule> session_;
+        std::unique_ptr<frontend::SemanticAnalyzer> sema_;
+        std::unordered_set<const frontend::AstDecl*> compiled_;  // Bodies already in a loaded unit
+        std::unordered_set<std::string> defined_names_;          // Functions and types; no redefinition
+
+        // Variables declared by top-level `let`, stored as globals of the
+        // unit that declared them
+        struct SessionVar {
+            std::string name;
+            std::string type_name;
+            std::string symbol;  // C++ global, e.g. mana_repl_v3_x
+        };
+        std::vector<SessionVar> variables_;
+
+        std::vector<void*> handles_;                  // Loaded units, closed on exit
+        std::vector<std::filesystem::path> units_;    // Units since the last :reset
+        int unit_counter_ = 0;
 
         // History
         std::vector<std::string> history_;
         size_t history_index_ = 0;
 
-        // Variables in scope
-        std::unordered_map<std::string, std::string> variables_;
-
-        // Accumulated definitions (functions, structs, etc.)
-        std::string definitions_;
-
         bool running_ = true;
     };
 
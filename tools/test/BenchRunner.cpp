@@ -0,0 +1,224 @@
+#include "BenchRunner.h"
+#include "../frontend/Parser.h"
+#include "../json/Json.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+
+namespace mana::test {
+
+namespace {
+
+std::string bench_key(const TestInfo& bench) {
+    size_t last_slash = bench.file.find_last_of("/\\");
+    std::string file = last_slash != std::string::npos ? bench.file.substr(last_slash + 1) : bench.file;
+    return file + "::" + bench.name;
+}
+
+} // namespace
+
+BenchRunner::BenchRunner(const BenchConfig& config) : config_(config) {}
+
+int BenchRunner::run(const std::vector<std::string>& files) {
+    TestRunner runner(config_.build);
+
+    std::vector<TestInfo> benches;
+    for (const auto& info : runner.discover_tests(files)) {
+        if (!info.is_bench) continue;
+        if (!config_.build.filter.empty() && !std::regex_search(info.name, std::regex(config_.build.filter))) continue;
+        benches.push_back(info);
+    }
+    std::stable_sort(benches.begin(), benches.end(), [](const TestInfo& a, const TestInfo& b) {
+        return a.file != b.file ? a.file < b.file : a.line < b.line;
+    });
+
+    std::vector<std::string> bench_files;
+    for (const auto& b : benches) {
+        if (bench_files.empty() || bench_files.back() != b.file) bench_files.push_back(b.file);
+    }
+
+    std::cout << "\nRunning " << benches.size() << " benchmark" << (benches.size() != 1 ? "s" : "") << "\n\n";
+
+    // Builds run in parallel; measurements do not
+    auto builds = runner.compile_test_files(bench_files);
+    size_t next = 0;
+    for (size_t f = 0; f < bench_files.size(); ++f) {
+        std::vector<TestInfo> file_benches;
+        while (next < benches.size() && benches[next].file == bench_files[f]) file_benches.push_back(benches[next++]);
+        run_file(file_benches, builds[f]);
+    }
+
+    bool baseline_ok = config_.baseline.empty() || load_baseline();
+    report();
+
+    if (!config_.save_baseline.empty() && !save_baseline()) {
+        std::cerr << "error: cannot write baseline " << config_.save_baseline << "\n";
+        return 1;
+    }
+
+    bool failed = !baseline_ok;
+    for (const auto& r : results_) {
+        if (!r.ok || r.regressed) failed = true;
+    }
+    return failed ? 1 : 0;
+}
+
+void BenchRunner::run_file(const std::vector<TestInfo>& benches, const TestRunner::TestBuild& build) {
+    std::map<std::string, size_t> slot;
+    size_t first = results_.size();
+    for (const auto& b : benches) {
+        BenchResult r;
+        r.name = bench_key(b);
+        r.file = b.file;
+        slot[b.name] = results_.size();
+        results_.push_back(r);
+    }
+
+    if (!build.ok) {
+        for (size_t i = first; i < results_.size(); ++i) {
+            results_[i].message = "failed to compile " + results_[i].file + "\n" + build.output;
+        }
+        return;
+    }
+
+    std::vector<std::string> args = {build.executable,
+                                     "--warmup-ms", std::to_string(config_.warmup.count()),
+                                     "--measure-ms", std::to_string(config_.measure.count())};
+    for (const auto& b : benches) {
+        args.push_back("--bench");
+        args.push_back(b.name);
+    }
+    ProcessResult proc = run_process(args, std::chrono::milliseconds(0));
+
+    std::istringstream lines(proc.output);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.rfind("@@mana-bench ", 0) != 0) continue;
+        std::istringstream marker(line.substr(13));
+        std::string kind, name;
+        marker >> kind >> name;
+        auto it = slot.find(name);
+        if (it == slot.end()) continue;
+        BenchResult& r = results_[it->second];
+        if (kind == "ok") {
+            marker >> r.median_ns >> r.mean_ns >> r.stddev_ns >> r.ci_low_ns >> r.ci_high_ns
+                   >> r.iterations >> r.samples >> r.outliers;
+            r.ok = static_cast<bool>(marker);
+            if (!r.ok) r.message = "malformed result line";
+        } else if (kind == "fail") {
+            std::getline(marker >> std::ws, r.message);
+        }
+    }
+
+    for (size_t i = first; i < results_.size(); ++i) {
+        if (!results_[i].ok && results_[i].message.empty()) {
+            results_[i].message = proc.signal != 0
+                ? "benchmark crashed (signal " + std::to_string(proc.signal) + ")"
+                : "benchmark binary exited with code " + std::to_string(proc.exit_code);
+        }
+    }
+}
+
+bool BenchRunner::load_baseline() {
+    std::ifstream in(config_.baseline);
+    if (!in) {
+        std::cerr << "error: cannot open baseline " << config_.baseline << "\n";
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+
+    json::Document doc;
+    if (!doc.parse(text)) {
+        std::cerr << "error: " << config_.baseline << ": " << doc.error() << "\n";
+        return false;
+    }
+
+    std::map<std::string, json::Value> saved;
+    for (json::Value b : doc.root()["benchmarks"]) {
+        saved[std::string(b["name"].as_string())] = b;
+    }
+
+    // A run is a regression only when it is slower by more than the
+    // threshold and the confidence intervals do not overlap
+    for (auto& r : results_) {
+        auto it = saved.find(r.name);
+        if (!r.ok || it == saved.end()) continue;
+        r.has_baseline = true;
+        r.baseline_mean_ns = it->second["mean_ns"].as_double();
+        r.baseline_ci_low_ns = it->second["ci_low_ns"].as_double(r.baseline_mean_ns);
+        r.baseline_ci_high_ns = it->second["ci_high_ns"].as_double(r.baseline_mean_ns);
+        if (r.baseline_mean_ns > 0) {
+            r.change_pct = (r.mean_ns - r.baseline_mean_ns) / r.baseline_mean_ns * 100.0;
+        }
+        r.regressed = r.change_pct > config_.threshold && r.ci_low_ns > r.baseline_ci_high_ns;
+    }
+    return true;
+}
+
+bool BenchRunner::save_baseline() const {
+    std::string out;
+    json::Writer w(out);
+    w.begin_object().key("benchmarks").begin_array();
+    for (const auto& r : results_) {
+        if (!r.ok) continue;
+        w.begin_object()
+            .key("name").value(r.name)
+            .key("median_ns").value(r.median_ns)
+            .key("mean_ns").value(r.mean_ns)
+            .key("stddev_ns").value(r.stddev_ns)
+            .key("ci_low_ns").value(r.ci_low_ns)
+            .key("ci_high_ns").value(r.ci_high_ns)
+            .key("iterations").value(static_cast<uint64_t>(r.iterations))
+            .key("samples").value(r.samples)
+            .end_object();
+    }
+    w.end_array().end_object();
+    out += "\n";
+
+    std::ofstream file(config_.save_baseline);
+    if (!file) return false;
+    file << out;
+    return static_cast<bool>(file);
+}
+
+void BenchRunner::report() const {
+    size_t width = 0;
+    for (const auto& r : results_) width = std::max(width, r.name.size());
+
+    int ok = 0, failed = 0, regressed = 0;
+    for (const auto& r : results_) {
+        std::printf("  %-*s ", static_cast<int>(width), r.name.c_str());
+        if (!r.ok) {
+            std::printf("FAILED  %s\n", r.message.c_str());
+            failed++;
+            continue;
+        }
+        ok++;
+        double spread = r.mean_ns > 0 ? (r.ci_high_ns - r.mean_ns) / r.mean_ns * 100.0 : 0.0;
+        std::printf("%12.1f ns/iter (+/- %.1f%%)  [%.1f .. %.1f]", r.mean_ns, spread, r.ci_low_ns, r.ci_high_ns);
+        if (r.outliers > 0) std::printf("  %d outlier%s", r.outliers, r.outliers != 1 ? "s" : "");
+        if (r.has_baseline) {
+            std::printf("  %+.1f%%", r.change_pct);
+            if (r.regressed) {
+                std::printf(" REGRESSED");
+                regressed++;
+            } else if (r.change_pct < -config_.threshold && r.ci_high_ns < r.baseline_ci_low_ns) {
+                std::printf(" improved");
+            }
+        }
+        std::printf("\n");
+    }
+
+    std::printf("\nBenchmarks: %d measured", ok);
+    if (failed > 0) std::printf(", %d failed", failed);
+    if (regressed > 0) std::printf(", %d regressed beyond %.1f%%", regressed, config_.threshold);
+    std::printf("\n\n");
+    std::fflush(stdout);
+}
+
+} // namespace mana::test
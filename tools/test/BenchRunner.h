@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "TestRunner.h"
+
+namespace mana::test {
+
+// Benchmark configuration
+struct BenchConfig {
+    TestConfig build;                        // Compiler, build directory, jobs, name filter
+    std::chrono::milliseconds warmup{200};   // Per benchmark, before measuring
+    std::chrono::milliseconds measure{1000}; // Per benchmark, split across samples
+    std::string baseline;                    // Compare against this saved run
+    std::string save_baseline;               // Write this run here
+    double threshold = 5.0;                  // Slowdown (percent) that counts as a regression
+};
+
+// One #[bench] function, measured in ns per iteration
+struct BenchResult {
+    std::string name;        // "<file name>::<function>"
+    std::string file;
+    bool ok = false;
+    std::string message;     // Why the benchmark did not run
+    double median_ns = 0;
+    double mean_ns = 0;
+    double stddev_ns = 0;
+    double ci_low_ns = 0;    // 95% interval of the mean
+    double ci_high_ns = 0;
+    uint64_t iterations = 0; // Per sample
+    int samples = 0;
+    int outliers = 0;
+
+    // Filled in when a baseline is loaded
+    bool has_baseline = false;
+    double baseline_mean_ns = 0;
+    double baseline_ci_high_ns = 0;
+    double baseline_ci_low_ns = 0;
+    double change_pct = 0;
+    bool regressed = false;
+};
+
+// Builds each file's test binary and runs its #[bench] functions one at a
+// time (never in parallel, so they do not disturb each other's timings)
+class BenchRunner {
+public:
+    explicit BenchRunner(const BenchConfig& config);
+
+    int run(const std::vector<std::string>& files);
+
+    const std::vector<BenchResult>& get_results() const { return results_; }
+
+private:
+    BenchConfig config_;
+    std::vector<BenchResult> results_;
+
+    void run_file(const std::vector<TestInfo>& benches, const TestRunner::TestBuild& build);
+    bool load_baseline();
+    bool save_baseline() const;
+    void report() const;
+};
+
+} // namespace mana::test
@@ -2,6 +2,7 @@
 #include "../frontend/Lexer.h"
 #include "../frontend/Parser.h"
 #include "../frontend/Diagnostic.h"
+#include "../common/Parallel.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -9,18 +10,175 @@
 #include <regex>
 #include <map>
 #include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <filesystem>
 
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
 #endif
 
 namespace mana::test {
 
 using namespace frontend;
 
+namespace {
+
+// Captured output beyond this is dropped so a runaway test cannot exhaust memory
+constexpr size_t kMaxCapturedOutput = 1 << 20;
+
+std::string escape_json(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+std::string escape_xml(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default: out += c;
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+#ifdef _WIN32
+ProcessResult run_process(const std::vector<std::string>& args, std::chrono::milliseconds) {
+    // _popen has no timeout; the child runs to completion
+    ProcessResult result;
+    std::string cmd = "\"";
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (i > 0) cmd += " ";
+        cmd += "\"" + args[i] + "\"";
+    }
+    cmd += " 2>&1\"";
+    FILE* pipe = _popen(cmd.c_str(), "r");
+    if (!pipe) {
+        result.output = "cannot start " + args[0];
+        return result;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), pipe)) > 0) {
+        if (result.output.size() < kMaxCapturedOutput) result.output.append(buf, n);
+    }
+    result.exit_code = _pclose(pipe);
+    return result;
+}
+#else
+ProcessResult run_process(const std::vector<std::string>& args, std::chrono::milliseconds timeout) {
+    ProcessResult result;
+    if (args.empty()) return result;
+
+    // Close-on-exec so children started concurrently by other workers never
+    // hold this pipe's write end open
+    int fds[2];
+#ifdef __linux__
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+#else
+    if (pipe(fds) != 0 || fcntl(fds[0], F_SETFD, FD_CLOEXEC) != 0 || fcntl(fds[1], F_SETFD, FD_CLOEXEC) != 0) {
+#endif
+        result.output = "cannot create pipe";
+        return result;
+    }
+
+    std::vector<char*> argv;
+    for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        result.output = "cannot fork";
+        return result;
+    }
+    if (pid == 0) {
+        // Own process group, so a timeout also kills anything the test spawned
+        setpgid(0, 0);
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        execvp(argv[0], argv.data());
+        const char msg[] = "cannot execute test binary\n";
+        ssize_t ignored = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+        (void)ignored;
+        _exit(127);
+    }
+    setpgid(pid, pid);
+    close(fds[1]);
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    char buf[4096];
+    for (;;) {
+        int wait_ms = -1;
+        if (timeout.count() > 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0) {
+                result.timed_out = true;
+                kill(-pid, SIGKILL);
+                break;
+            }
+            wait_ms = static_cast<int>(left.count());
+        }
+        struct pollfd pfd = {fds[0], POLLIN, 0};
+        int ready = poll(&pfd, 1, wait_ms);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready == 0) continue;  // Deadline is checked at the top
+        ssize_t n = read(fds[0], buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        if (result.output.size() < kMaxCapturedOutput) result.output.append(buf, static_cast<size_t>(n));
+    }
+    close(fds[0]);
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    if (WIFEXITED(status)) {
+        result.exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        result.signal = WTERMSIG(status);
+        result.exit_code = 128 + result.signal;
+    }
+    return result;
+}
+#endif
+
 // TestSuite methods
 int TestSuite::passed_count() const {
     int count = 0;
@@ -55,6 +213,8 @@ int TestSuite::error_count() const {
 }
 
 // PrettyReporter implementation
+PrettyReporter::PrettyReporter(bool show_output) : show_output_(show_output) {}
+
 void PrettyReporter::on_run_start(int total_tests) {
     total_tests_ = total_tests;
     current_test_ = 0;
@@ -139,6 +299,15 @@ void PrettyReporter::on_test_end(const TestResult& result) {
             std::cout << "           at " << result.file << ":" << result.line << "\n";
         }
     }
+
+    bool failed = result.status == TestStatus::Failed || result.status == TestStatus::Error;
+    if ((failed || show_output_) && !result.output.empty()) {
+        std::istringstream lines(result.output);
+        std::string line;
+        while (std::getline(lines, line)) {
+            std::cout << "           | " << line << "\n";
+        }
+    }
 }
 
 void PrettyReporter::on_suite_end(const TestSuite& suite) {
@@ -213,8 +382,8 @@ void JsonReporter::on_run_end(const std::vector<TestSuite>& suites) {
         if (i > 0) out_ << ",\n";
         const auto& suite = suites[i];
         out_ << "    {\n";
-        out_ << "      \"name\": \"" << suite.name << "\",\n";
-        out_ << "      \"file\": \"" << suite.file << "\",\n";
+        out_ << "      \"name\": \"" << escape_json(suite.name) << "\",\n";
+        out_ << "      \"file\": \"" << escape_json(suite.file) << "\",\n";
         out_ << "      \"duration\": " << suite.total_duration.count() << ",\n";
         out_ << "      \"tests\": [\n";
 
@@ -222,7 +391,7 @@ void JsonReporter::on_run_end(const std::vector<TestSuite>& suites) {
             if (j > 0) out_ << ",\n";
             const auto& r = suite.results[j];
             out_ << "        {\n";
-            out_ << "          \"name\": \"" << r.name << "\",\n";
+            out_ << "          \"name\": \"" << escape_json(r.name) << "\",\n";
             out_ << "          \"status\": \"";
             switch (r.status) {
                 case TestStatus::Passed: out_ << "passed"; break;
@@ -233,7 +402,10 @@ void JsonReporter::on_run_end(const std::vector<TestSuite>& suites) {
             out_ << "\",\n";
             out_ << "          \"duration\": " << r.duration.count();
             if (!r.message.empty()) {
-                out_ << ",\n          \"message\": \"" << r.message << "\"";
+                out_ << ",\n          \"message\": \"" << escape_json(r.message) << "\"";
+            }
+            if (!r.output.empty()) {
+                out_ << ",\n          \"output\": \"" << escape_json(r.output) << "\"";
             }
             out_ << "\n        }";
         }
@@ -259,7 +431,7 @@ void JUnitReporter::on_run_end(const std::vector<TestSuite>& suites) {
     out_ << "<testsuites>\n";
 
     for (const auto& suite : suites) {
-        out_ << "  <testsuite name=\"" << suite.name << "\" ";
+        out_ << "  <testsuite name=\"" << escape_xml(suite.name) << "\" ";
         out_ << "tests=\"" << suite.results.size() << "\" ";
         out_ << "failures=\"" << suite.failed_count() << "\" ";
         out_ << "errors=\"" << suite.error_count() << "\" ";
@@ -267,7 +439,7 @@ void JUnitReporter::on_run_end(const std::vector<TestSuite>& suites) {
         out_ << "time=\"" << suite.total_duration.count() / 1000000.0 << "\">\n";
 
         for (const auto& r : suite.results) {
-            out_ << "    <testcase name=\"" << r.name << "\" ";
+            out_ << "    <testcase name=\"" << escape_xml(r.name) << "\" ";
             out_ << "time=\"" << r.duration.count() / 1000000.0 << "\"";
 
             if (r.status == TestStatus::Passed) {
@@ -275,12 +447,15 @@ void JUnitReporter::on_run_end(const std::vector<TestSuite>& suites) {
             } else {
                 out_ << ">\n";
                 if (r.status == TestStatus::Failed) {
-                    out_ << "      <failure message=\"" << r.message << "\"/>\n";
+                    out_ << "      <failure message=\"" << escape_xml(r.message) << "\"/>\n";
                 } else if (r.status == TestStatus::Error) {
-                    out_ << "      <error message=\"" << r.message << "\"/>\n";
+                    out_ << "      <error message=\"" << escape_xml(r.message) << "\"/>\n";
                 } else if (r.status == TestStatus::Skipped) {
                     out_ << "      <skipped/>\n";
                 }
+                if (!r.output.empty()) {
+                    out_ << "      <system-out>" << escape_xml(r.output) << "</system-out>\n";
+                }
                 out_ << "    </testcase>\n";
             }
         }
@@ -293,7 +468,7 @@ void JUnitReporter::on_run_end(const std::vector<TestSuite>& suites) {
 
 // TestRunner implementation
 TestRunner::TestRunner(const TestConfig& config) : config_(config) {
-    reporter_ = std::make_unique<PrettyReporter>();
+    reporter_ = std::make_unique<PrettyReporter>(config.show_output);
 }
 
 std::vector<TestInfo> TestRunner::discover_tests(const std::vector<std::string>& files) {
@@ -332,10 +507,11 @@ std::vector<TestInfo> TestRunner::discover_tests(const AstModule* module, const
 
     for (const auto& decl : module->decls) {
         if (auto fn = dynamic_cast<const AstFuncDecl*>(decl.get())) {
-            // Check for #[test] attribute (via is_test flag)
-            if (fn->is_test) {
-                bool should_panic = false;  // TODO: add attribute support
+            // Check for #[test] / #[bench] attributes
+            if (fn->is_test || fn->is_bench) {
+                bool should_panic = fn->should_panic;
                 std::string ignore_reason;
+                if (fn->is_ignored) ignore_reason = fn->ignore_reason.empty() ? "ignored" : fn->ignore_reason;
                 std::vector<std::string> tags;
 
                 TestInfo info;
@@ -345,6 +521,7 @@ std::vector<TestInfo> TestRunner::discover_tests(const AstModule* module, const
                 info.should_panic = should_panic;
                 info.ignore_reason = ignore_reason;
                 info.tags = tags;
+                info.is_bench = !fn->is_test;
                 tests.push_back(info);
             }
         }
@@ -389,50 +566,182 @@ bool TestRunner::should_run_test(const TestInfo& test) const {
     return true;
 }
 
-TestResult TestRunner::run_single_test(const TestInfo& test) {
-    TestResult result;
-    result.name = test.name;
-    result.file = test.file;
-    result.line = test.line;
-
-    if (!test.ignore_reason.empty()) {
-        result.status = TestStatus::Skipped;
-        result.message = test.ignore_reason;
-        return result;
+unsigned TestRunner::worker_count() const {
+    if (config_.jobs > 0 && !(config_.parallel && config_.jobs == 1)) {
+        return static_cast<unsigned>(config_.jobs);
     }
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 4;
+}
 
-    auto start = std::chrono::high_resolution_clock::now();
+std::vector<TestRunner::TestBuild> TestRunner::compile_test_files(const std::vector<std::string>& files) {
+    std::vector<TestBuild> builds(files.size());
+    tools::parallel_for(files.size(), worker_count(), [&](size_t i) {
+        builds[i] = compile_test_file(files[i], i);
+    });
+    return builds;
+}
+
+TestRunner::TestBuild TestRunner::compile_test_file(const std::string& file, size_t index) {
+    namespace fs = std::filesystem;
+    TestBuild build;
+
+    // Each file builds in its own directory: the compiler writes the
+    // generated C++ and runtime header next to the binary
+    std::string stem = fs::path(file).stem().string();
+    fs::path dir = fs::path(config_.build_dir) / (std::to_string(index) + "_" + stem);
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) {
+        build.output = "cannot create " + dir.string() + ": " + ec.message();
+        return build;
+    }
 
-    // Compile and run the test
-    // This is a simplified version - full implementation would compile to executable and run
-    std::string test_exe = "build/test_" + test.name;
+    fs::path exe = dir / stem;
 #ifdef _WIN32
-    test_exe += ".exe";
+    exe += ".exe";
 #endif
+    fs::path cpp = dir / (stem + ".cpp");
 
-    int exit_code = std::system((test_exe + " 2>&1").c_str());
+    ProcessResult gen = run_process({config_.compiler, file, "--test", "-c", "--no-cache", "-o", exe.string()},
+                                    std::chrono::milliseconds(0));
+    if (gen.exit_code != 0) {
+        build.output = gen.output;
+        return build;
+    }
+
+    std::string cxx = config_.cxx;
+    if (cxx.empty()) {
+        const char* env = std::getenv("CXX");
+        cxx = env && *env ? env : "c++";
+    }
+    std::vector<std::string> cxx_args = {cxx, "-std=c++20", config_.optimize, "-I", dir.string(), cpp.string(), "-o", exe.string()};
+#ifndef _WIN32
+    cxx_args.push_back("-pthread");
+#endif
+    ProcessResult cc = run_process(cxx_args, std::chrono::milliseconds(0));
+    if (cc.exit_code != 0) {
+        build.output = cc.output;
+        return build;
+    }
 
-    auto end = std::chrono::high_resolution_clock::now();
-    result.duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    build.executable = exe.string();
+    build.ok = true;
+    return build;
+}
 
-    if (test.should_panic) {
-        // Test should have panicked (non-zero exit)
-        if (exit_code != 0) {
-            result.status = TestStatus::Passed;
+std::vector<TestResult> TestRunner::run_test_batch(const std::vector<TestInfo>& tests, const TestBuild& build) {
+    std::vector<TestResult> results(tests.size());
+    std::map<std::string, size_t> slot;
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < tests.size(); ++i) {
+        results[i].name = tests[i].name;
+        results[i].file = tests[i].file;
+        results[i].line = tests[i].line;
+        slot[tests[i].name] = i;
+        if (!tests[i].ignore_reason.empty()) {
+            results[i].status = TestStatus::Skipped;
+            results[i].message = tests[i].ignore_reason;
+        } else if (!build.ok) {
+            results[i].status = TestStatus::Error;
+            results[i].message = "failed to compile " + tests[i].file;
+            results[i].output = build.output;
         } else {
-            result.status = TestStatus::Failed;
-            result.message = "Expected panic but test passed";
+            pending.push_back(i);
         }
-    } else {
-        if (exit_code == 0) {
-            result.status = TestStatus::Passed;
-        } else {
-            result.status = TestStatus::Failed;
-            result.message = "Test failed with exit code " + std::to_string(exit_code);
+    }
+
+    // One process runs the whole batch in-process. If a test takes the
+    // process down, it is reported as crashed and the rest run in a new one.
+    while (!pending.empty()) {
+        std::vector<std::string> args = {build.executable};
+        if (config_.timeout.count() > 0) {
+            args.push_back("--timeout-ms");
+            args.push_back(std::to_string(config_.timeout.count()));
+        }
+        for (size_t i : pending) {
+            args.push_back("--run");
+            args.push_back(tests[i].name);
+        }
+        // The harness enforces the per-test timeout; this only catches a wedged process
+        std::chrono::milliseconds limit(0);
+        if (config_.timeout.count() > 0) limit = config_.timeout * static_cast<long long>(pending.size() + 1);
+        ProcessResult proc = run_process(args, limit);
+
+        std::vector<char> done(tests.size(), 0);
+        size_t current = tests.size();
+        std::string output;
+        std::istringstream lines(proc.output);
+        std::string line;
+        auto finish = [&](size_t i, TestStatus status, std::string message, long long us) {
+            while (output.size() >= 2 && output.compare(output.size() - 2, 2, "\n\n") == 0) output.pop_back();
+            if (output == "\n") output.clear();
+            results[i].status = status;
+            results[i].message = std::move(message);
+            results[i].output = std::move(output);
+            results[i].duration = std::chrono::microseconds(us);
+            output.clear();
+            done[i] = 1;
+            current = tests.size();
+        };
+        while (std::getline(lines, line)) {
+            if (line.rfind("@@mana-test ", 0) != 0) {
+                if (current < tests.size()) output += line + "\n";
+                continue;
+            }
+            std::istringstream marker(line.substr(12));
+            std::string kind, name;
+            long long us = 0;
+            marker >> kind >> name;
+            auto it = slot.find(name);
+            if (it == slot.end()) continue;
+            if (kind == "start") {
+                current = it->second;
+                output.clear();
+            } else if (kind == "ok") {
+                marker >> us;
+                finish(it->second, TestStatus::Passed, "", us);
+            } else if (kind == "fail") {
+                marker >> us;
+                std::string message;
+                std::getline(marker >> std::ws, message);
+                finish(it->second, TestStatus::Failed, message, us);
+            } else if (kind == "timeout") {
+                finish(it->second, TestStatus::Failed,
+                       "Test '" + name + "' timed out after " + std::to_string(config_.timeout.count()) + " ms",
+                       config_.timeout.count() * 1000);
+            }
+        }
+
+        if (current < tests.size()) {
+            std::string message = proc.timed_out
+                ? "Test '" + tests[current].name + "' timed out after " + std::to_string(limit.count()) +
+                  " ms (limit for the whole batch)"
+                : proc.signal != 0 ? "Test crashed (signal " + std::to_string(proc.signal) + ")"
+                : "Test exited with code " + std::to_string(proc.exit_code);
+            finish(current, TestStatus::Error, message, 0);
+        }
+
+        std::vector<size_t> rest;
+        for (size_t i : pending) {
+            if (!done[i]) rest.push_back(i);
+        }
+        if (rest.size() == pending.size()) {
+            // Nothing ran: the binary itself is broken
+            for (size_t i : rest) {
+                results[i].status = TestStatus::Error;
+                results[i].message = proc.timed_out
+                    ? "Test binary timed out after " + std::to_string(limit.count()) + " ms before running '" +
+                      tests[i].name + "'"
+                    : "Test binary failed with exit code " + std::to_string(proc.exit_code);
+                results[i].output = proc.output;
+            }
+            break;
         }
+        pending = std::move(rest);
     }
 
-    return result;
+    return results;
 }
 
 void TestRunner::add_file(const std::string& file) {
@@ -454,7 +763,7 @@ void TestRunner::add_directory(const std::string& dir, bool recursive) {
             if (recursive) {
                 add_directory(path, true);
             }
-        } else if (name.size() > 6 && name.substr(name.size() - 6) == ".mana") {
+        } else if (name.size() > 5 && name.compare(name.size() - 5, 5, ".mana") == 0) {
             files_.push_back(path);
         }
     } while (FindNextFileA(hFind, &findData));
@@ -476,7 +785,7 @@ void TestRunner::add_directory(const std::string& dir, bool recursive) {
                 if (recursive) {
                     add_directory(path, true);
                 }
-            } else if (name.size() > 6 && name.substr(name.size() - 6) == ".mana") {
+            } else if (name.size() > 5 && name.compare(name.size() - 5, 5, ".mana") == 0) {
                 files_.push_back(path);
             }
         }
@@ -491,7 +800,7 @@ void TestRunner::set_reporter(std::unique_ptr<TestReporter> reporter) {
 }
 
 int TestRunner::run() {
-    return run(files_.empty() ? config_.files : files_);
+    return run(files());
 }
 
 int TestRunner::run(const std::vector<std::string>& files) {
@@ -501,53 +810,110 @@ int TestRunner::run(const std::vector<std::string>& files) {
     // Filter tests
     std::vector<TestInfo> tests_to_run;
     for (const auto& test : all_tests) {
-        if (should_run_test(test)) {
+        if (!test.is_bench && should_run_test(test)) {
             tests_to_run.push_back(test);
         }
     }
 
-    reporter_->on_run_start(static_cast<int>(tests_to_run.size()));
+    // Fixed order (file, then source position) so results and shards are
+    // the same on every run and every machine
+    std::stable_sort(tests_to_run.begin(), tests_to_run.end(), [](const TestInfo& a, const TestInfo& b) {
+        return a.file != b.file ? a.file < b.file : a.line < b.line;
+    });
+    if (config_.shard_count > 1) {
+        std::vector<TestInfo> shard;
+        for (size_t i = 0; i < tests_to_run.size(); ++i) {
+            if (static_cast<int>(i % config_.shard_count) == config_.shard_index) {
+                shard.push_back(tests_to_run[i]);
+            }
+        }
+        tests_to_run = std::move(shard);
+    }
 
-    // Group by file
-    std::map<std::string, std::vector<TestInfo>> tests_by_file;
+    unsigned workers = worker_count();
+
+    // Build one binary per file, all files at once
+    std::vector<std::string> test_files;
+    std::map<std::string, size_t> build_index;
     for (const auto& test : tests_to_run) {
-        tests_by_file[test.file].push_back(test);
+        if (build_index.emplace(test.file, test_files.size()).second) {
+            test_files.push_back(test.file);
+        }
     }
+    std::vector<TestBuild> builds = compile_test_files(test_files);
 
-    // Run tests
-    for (auto it = tests_by_file.begin(); it != tests_by_file.end(); ++it) {
-        const std::string& file = it->first;
-        const std::vector<TestInfo>& file_tests = it->second;
-        
-        TestSuite suite;
-        suite.file = file;
-        // Extract filename without path
-        size_t last_slash = file.find_last_of("/\\");
-        suite.name = (last_slash != std::string::npos) ? file.substr(last_slash + 1) : file;
-
-        reporter_->on_suite_start(suite.name);
+    reporter_->on_run_start(static_cast<int>(tests_to_run.size()));
 
-        for (size_t i = 0; i < file_tests.size(); ++i) {
-            const TestInfo& test = file_tests[i];
+    // Tests finish in any order; results are handed to the reporter in test
+    // order as soon as every earlier test is done. With fail_fast, nothing
+    // after the first failure (in test order) is reported.
+    const size_t count = tests_to_run.size();
+    std::vector<TestResult> results(count);
+    std::vector<char> finished(count, 0);
+    std::mutex report_mutex;
+    size_t next_report = 0;
+    size_t stop_at = count;
+    TestSuite suite;
+
+    auto report_ready = [&] {
+        while (next_report < count && next_report <= stop_at && finished[next_report]) {
+            const TestInfo& test = tests_to_run[next_report];
+            if (next_report == 0 || tests_to_run[next_report - 1].file != test.file) {
+                if (next_report > 0) {
+                    reporter_->on_suite_end(suite);
+                    results_.push_back(std::move(suite));
+                }
+                suite = TestSuite();
+                suite.file = test.file;
+                // Extract filename without path
+                size_t last_slash = test.file.find_last_of("/\\");
+                suite.name = (last_slash != std::string::npos) ? test.file.substr(last_slash + 1) : test.file;
+                reporter_->on_suite_start(suite.name);
+            }
             reporter_->on_test_start(test);
+            reporter_->on_test_end(results[next_report]);
+            suite.total_duration += results[next_report].duration;
+            suite.results.push_back(std::move(results[next_report]));
+            ++next_report;
+        }
+    };
+
+    // Each file's tests are split into at most `workers` contiguous batches,
+    // and every batch runs in one process
+    std::vector<std::pair<size_t, size_t>> batches;  // [first, last) test indices
+    for (size_t first = 0; first < count;) {
+        size_t end = first;
+        while (end < count && tests_to_run[end].file == tests_to_run[first].file) ++end;
+        size_t per_batch = (end - first + workers - 1) / workers;
+        for (size_t b = first; b < end; b += per_batch) {
+            batches.emplace_back(b, std::min(b + per_batch, end));
+        }
+        first = end;
+    }
 
-            TestResult result = run_single_test(test);
-            suite.results.push_back(result);
-            suite.total_duration += result.duration;
-
-            reporter_->on_test_end(result);
-
-            if (config_.fail_fast && result.status == TestStatus::Failed) {
-                break;
-            }
+    tools::parallel_for(batches.size(), workers, [&](size_t b) {
+        size_t first = batches[b].first;
+        {
+            std::lock_guard<std::mutex> lock(report_mutex);
+            if (first > stop_at) return;
+        }
+        std::vector<TestInfo> batch(tests_to_run.begin() + first, tests_to_run.begin() + batches[b].second);
+        auto batch_results = run_test_batch(batch, builds[build_index.at(batch.front().file)]);
+
+        std::lock_guard<std::mutex> lock(report_mutex);
+        for (size_t k = 0; k < batch_results.size(); ++k) {
+            size_t i = first + k;
+            bool failed = batch_results[k].status == TestStatus::Failed || batch_results[k].status == TestStatus::Error;
+            if (config_.fail_fast && failed) stop_at = std::min(stop_at, i);
+            results[i] = std::move(batch_results[k]);
+            finished[i] = 1;
         }
+        report_ready();
+    });
 
+    if (next_report > 0) {
         reporter_->on_suite_end(suite);
-        results_.push_back(suite);
-
-        if (config_.fail_fast && suite.failed_count() > 0) {
-            break;
-        }
+        results_.push_back(std::move(suite));
     }
 
     reporter_->on_run_end(results_);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <chrono>
@@ -24,6 +25,7 @@ struct TestResult {
     int line = 0;
     TestStatus status = TestStatus::Passed;
     std::string message;
+    std::string output;             // Captured stdout and stderr
     std::chrono::microseconds duration{0};
 };
 
@@ -48,6 +50,7 @@ struct TestInfo {
     bool should_panic = false;      // #[should_panic]
     std::string ignore_reason;       // #[ignore] or #[ignore = "reason"]
     std::vector<std::string> tags;   // #[tag("unit")] etc.
+    bool is_bench = false;           // #[bench] rather than #[test]
 };
 
 // Test configuration
@@ -59,12 +62,31 @@ struct TestConfig {
     bool show_output = false;               // Show test output
     bool fail_fast = false;                 // Stop on first failure
     bool parallel = false;                  // Run tests in parallel
-    int jobs = 1;                          // Number of parallel jobs
+    int jobs = 1;                          // Number of parallel jobs (0 = one per core)
     bool no_capture = false;               // Don't capture stdout/stderr
     bool verbose = false;                  // Verbose output
     std::string output_format = "pretty";  // pretty, json, junit
+    std::chrono::milliseconds timeout{60000};  // Per test; 0 disables
+    int shard_index = 0;                   // Run every shard_count-th test starting here
+    int shard_count = 1;
+    std::string compiler = "mana";         // Compiler used to build test binaries
+    std::string cxx;                       // C++ compiler (default: $CXX or c++)
+    std::string optimize = "-O1";          // C++ optimization flag for test binaries
+    std::string build_dir = ".mana_cache/tests";
 };
 
+// Result of a child process run with its output captured through a pipe
+struct ProcessResult {
+    int exit_code = -1;
+    int signal = 0;          // Terminating signal, if any
+    bool timed_out = false;
+    std::string output;      // stdout and stderr, interleaved
+};
+
+// Runs `args[0]` (looked up on PATH) with `args`, killing it after `timeout`
+// (0 waits forever)
+ProcessResult run_process(const std::vector<std::string>& args, std::chrono::milliseconds timeout);
+
 // Test output formats
 class TestReporter {
 public:
@@ -81,6 +103,8 @@ public:
 // Pretty console reporter
 class PrettyReporter : public TestReporter {
 public:
+    explicit PrettyReporter(bool show_output = false);
+
     void on_run_start(int total_tests) override;
     void on_suite_start(const std::string& name) override;
     void on_test_start(const TestInfo& test) override;
@@ -91,6 +115,7 @@ public:
 private:
     int current_test_ = 0;
     int total_tests_ = 0;
+    bool show_output_ = false;
 };
 
 // JSON reporter
@@ -148,6 +173,18 @@ public:
 
     // Get results
     const std::vector<TestSuite>& get_results() const { return results_; }
+    const std::vector<std::string>& files() const { return files_.empty() ? config_.files : files_; }
+
+    // One test binary per source file
+    struct TestBuild {
+        std::string executable;
+        bool ok = false;
+        std::string output;  // Compiler diagnostics when !ok
+    };
+
+    // Builds the test binary of every file, `jobs` at a time; results are in `files` order
+    std::vector<TestBuild> compile_test_files(const std::vector<std::string>& files);
+    unsigned worker_count() const;
 
 private:
     TestConfig config_;
@@ -156,8 +193,9 @@ private:
     std::unique_ptr<TestReporter> reporter_;
 
     bool should_run_test(const TestInfo& test) const;
-    TestResult run_single_test(const TestInfo& test);
-    void compile_test_file(const std::string& file);
+    // Runs `tests` (all from one file) through the binary's harness
+    std::vector<TestResult> run_test_batch(const std::vector<TestInfo>& tests, const TestBuild& build);
+    TestBuild compile_test_file(const std::string& file, size_t index);
 };
 
 // Test assertions (used in generated C++ code)